@@ -17,13 +17,16 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
 
 #include "analog.hpp"
 #include "analogsegment.hpp"
 
 using std::deque;
+using std::lock_guard;
 using std::max;
+using std::min;
 using std::shared_ptr;
 using std::vector;
 
@@ -37,6 +40,7 @@ Analog::Analog() :
 
 void Analog::push_segment(shared_ptr<AnalogSegment> &segment)
 {
+	lock_guard<mutex> lock(segments_mutex_);
 	segments_.push_front(segment);
 }
 
@@ -51,9 +55,33 @@ vector< shared_ptr<Segment> > Analog::segments() const
 		segments_.begin(), segments_.end());
 }
 
+vector< vector< shared_ptr<AnalogSegment> > > Analog::common_segments(
+	const vector< shared_ptr<Analog> > &data)
+{
+	vector< vector< shared_ptr<AnalogSegment> > > result;
+
+	for (size_t d = 0; d < data.size(); d++) {
+		lock_guard<mutex> lock(data[d]->segments_mutex_);
+		const deque< shared_ptr<AnalogSegment> > &segments =
+			data[d]->segments_;
+
+		// The segments are stored newest first
+		const size_t count = (d == 0) ? segments.size() :
+			min(result.size(), segments.size());
+		result.resize(count);
+		for (size_t i = 0; i < count; i++)
+			result[i].push_back(segments[segments.size() - 1 - i]);
+	}
+
+	return result;
+}
+
 void Analog::clear()
 {
-	segments_.clear();
+	{
+		lock_guard<mutex> lock(segments_mutex_);
+		segments_.clear();
+	}
 
 	samples_cleared();
 }
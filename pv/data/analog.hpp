@@ -24,10 +24,12 @@
 
 #include <deque>
 #include <memory>
+#include <mutex>
 
 #include <QObject>
 
 using std::deque;
+using std::mutex;
 using std::shared_ptr;
 using std::vector;
 
@@ -49,6 +51,15 @@ public:
 
 	vector< shared_ptr<Segment> > segments() const;
 
+	/**
+	 * Returns the segments that all of the given data objects have,
+	 * oldest first. Element i holds the i-th segment of every data
+	 * object, in the order of data. Unlike analog_segments(), this may be
+	 * called from worker threads while segments are being added.
+	 */
+	static vector< vector< shared_ptr<AnalogSegment> > > common_segments(
+		const vector< shared_ptr<Analog> > &data);
+
 	void clear();
 
 	uint64_t max_sample_count() const;
@@ -64,6 +75,7 @@ Q_SIGNALS:
 
 private:
 	deque< shared_ptr<AnalogSegment> > segments_;
+	mutable mutex segments_mutex_;  ///< Protects segments_ from workers
 };
 
 } // namespace data
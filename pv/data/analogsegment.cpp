@@ -49,6 +49,7 @@ const uint64_t AnalogSegment::EnvelopeDataUnit = 64 * 1024;	// bytes
 AnalogSegment::AnalogSegment(Analog& owner, uint64_t samplerate) :
 	Segment(samplerate, sizeof(float)),
 	owner_(owner),
+	envelope_mapped_(false),
 	min_value_(0),
 	max_value_(0)
 {
@@ -59,6 +60,10 @@ AnalogSegment::AnalogSegment(Analog& owner, uint64_t samplerate) :
 AnalogSegment::~AnalogSegment()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
+
+	if (envelope_mapped_)
+		return;
+
 	for (Envelope &e : envelope_levels_)
 		free(e.samples);
 }
@@ -70,8 +75,6 @@ void AnalogSegment::append_interleaved_samples(const float *data,
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	uint64_t prev_sample_count = sample_count_;
-
 	for (uint32_t i = 0; i < sample_count; i++) {
 		append_single_sample((void*)data);
 		data += stride;
@@ -80,12 +83,8 @@ void AnalogSegment::append_interleaved_samples(const float *data,
 	// Generate the first mip-map from the data
 	append_payload_to_envelope_levels();
 
-	if (sample_count > 1)
-		owner_.notify_samples_added(this, prev_sample_count + 1,
-			prev_sample_count + 1 + sample_count);
-	else
-		owner_.notify_samples_added(this, prev_sample_count + 1,
-			prev_sample_count + 1);
+	// Listeners are notified by whoever appends the data, which allows
+	// the notifications of several appends to be coalesced
 }
 
 const float* AnalogSegment::get_samples(
@@ -102,11 +101,105 @@ const float* AnalogSegment::get_samples(
 	return (float*)get_raw_samples(start_sample, (end_sample - start_sample));
 }
 
+void AnalogSegment::get_samples(int64_t start_sample, int64_t end_sample,
+	float* dest) const
+{
+	assert(start_sample >= 0);
+	assert(start_sample < (int64_t)sample_count_);
+	assert(end_sample >= 0);
+	assert(end_sample <= (int64_t)sample_count_);
+	assert(start_sample <= end_sample);
+
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	get_raw_samples(start_sample, (end_sample - start_sample), (uint8_t*)dest);
+}
+
 const pair<float, float> AnalogSegment::get_min_max() const
 {
 	return make_pair(min_value_, max_value_);
 }
 
+void AnalogSegment::map_payload(shared_ptr<const void> storage,
+	const vector<Extent> &extents, float min_value, float max_value,
+	const vector< pair<const void*, uint64_t> > &levels)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	map_samples(storage, extents);
+	const uint64_t sample_count = sample_count_;
+
+	// Only use the stored levels if they have exactly the layout that
+	// append_payload_to_envelope_levels() would have produced
+	unsigned int level_count = 0;
+	bool usable = true;
+
+	for (uint64_t length = sample_count / EnvelopeScaleFactor;
+		length > 0 && level_count < ScaleStepCount;
+		length /= EnvelopeScaleFactor, level_count++)
+		if (level_count >= levels.size() || levels[level_count].second !=
+			length * sizeof(EnvelopeSample))
+			usable = false;
+
+	if (!usable) {
+		append_payload_to_envelope_levels();
+		return;
+	}
+
+	uint64_t length = sample_count;
+	for (unsigned int level = 0; level < level_count; level++) {
+		length /= EnvelopeScaleFactor;
+
+		Envelope &e = envelope_levels_[level];
+		e.length = e.data_length = length;
+		e.samples = (EnvelopeSample*)levels[level].first;
+	}
+
+	envelope_mapped_ = true;
+	min_value_ = min_value;
+	max_value_ = max_value;
+}
+
+const void* AnalogSegment::envelope_level(unsigned int level,
+	uint64_t &length) const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	if (level >= ScaleStepCount || !envelope_levels_[level].samples ||
+		envelope_levels_[level].length == 0) {
+		length = 0;
+		return nullptr;
+	}
+
+	length = envelope_levels_[level].length * sizeof(EnvelopeSample);
+	return envelope_levels_[level].samples;
+}
+
+uint64_t AnalogSegment::get_envelope_samples(unsigned int level,
+	uint64_t start, vector<EnvelopeSample> &dest) const
+{
+	assert(level < ScaleStepCount);
+
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	const Envelope &e = envelope_levels_[level];
+	if (!e.samples || start >= e.length)
+		return e.length;
+
+	dest.insert(dest.end(), e.samples + start, e.samples + e.length);
+	return e.length;
+}
+
+uint64_t AnalogSegment::envelope_scale(unsigned int level)
+{
+	return (uint64_t)1 << ((level + 1) * EnvelopeScalePower);
+}
+
+unsigned int AnalogSegment::envelope_level_count()
+{
+	return ScaleStepCount;
+}
+
 SegmentAnalogDataIterator* AnalogSegment::begin_sample_iteration(uint64_t start)
 {
 	return (SegmentAnalogDataIterator*)begin_raw_sample_iteration(start);
@@ -129,10 +222,10 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	assert(start <= end);
 	assert(min_length > 0);
 
-	lock_guard<recursive_mutex> lock(mutex_);
+	s.lock = unique_lock<recursive_mutex>(mutex_);
 
-	const unsigned int min_level = max((int)floorf(logf(min_length) /
-		LogEnvelopeScaleFactor) - 1, 0);
+	const unsigned int min_level = min(max((int)floorf(logf(min_length) /
+		LogEnvelopeScaleFactor) - 1, 0), (int)ScaleStepCount - 1);
 	const unsigned int scale_power = (min_level + 1) *
 		EnvelopeScalePower;
 	start >>= scale_power;
@@ -141,9 +234,7 @@ void AnalogSegment::get_envelope_section(EnvelopeSection &s,
 	s.start = start << scale_power;
 	s.scale = 1 << scale_power;
 	s.length = end - start;
-	s.samples = new EnvelopeSample[s.length];
-	memcpy(s.samples, envelope_levels_[min_level].samples + start,
-		s.length * sizeof(EnvelopeSample));
+	s.samples = envelope_levels_[min_level].samples + start;
 }
 
 void AnalogSegment::reallocate_envelope(Envelope &e)
@@ -22,12 +22,17 @@
 
 #include "segment.hpp"
 
+#include <mutex>
 #include <utility>
 #include <vector>
 
 #include <QObject>
 
 using std::pair;
+using std::recursive_mutex;
+using std::shared_ptr;
+using std::unique_lock;
+using std::vector;
 
 namespace AnalogSegmentTest {
 struct Basic;
@@ -55,12 +60,18 @@ public:
 		float max;
 	};
 
+	/**
+	 * A read-only view of a part of an envelope level. The segment is
+	 * locked while the section exists, so that the envelope can't be
+	 * reallocated while the samples are in use.
+	 */
 	struct EnvelopeSection
 	{
 		uint64_t start;
 		unsigned int scale;
 		uint64_t length;
-		EnvelopeSample *samples;
+		const EnvelopeSample *samples;
+		unique_lock<recursive_mutex> lock;
 	};
 
 private:
@@ -89,8 +100,58 @@ public:
 	const float* get_samples(int64_t start_sample,
 		int64_t end_sample) const;
 
+	/**
+	 * Copies the samples from start_sample up to but excluding end_sample
+	 * into a buffer provided by the caller.
+	 */
+	void get_samples(int64_t start_sample, int64_t end_sample,
+		float* dest) const;
+
 	const pair<float, float> get_min_max() const;
 
+	/**
+	 * Makes the segment use samples and envelope levels that are kept in
+	 * storage it doesn't own, e.g. a memory-mapped capture file. If the
+	 * stored levels don't match the sample count, the envelope is
+	 * generated from the samples instead.
+	 * @param storage Keeps the storage alive while the segment uses it.
+	 * @param extents The samples in order, see Segment::map_samples().
+	 * @param min_value The smallest sample value.
+	 * @param max_value The largest sample value.
+	 * @param levels The start and length in bytes of the stored envelope
+	 * levels, finest first.
+	 */
+	void map_payload(shared_ptr<const void> storage,
+		const vector<Extent> &extents, float min_value, float max_value,
+		const vector< pair<const void*, uint64_t> > &levels);
+
+	/**
+	 * Gives access to a level of the envelope, e.g. to store it.
+	 * @param[out] length The length of the level in bytes.
+	 * @return The level, or nullptr if the segment has too few samples
+	 * for it.
+	 */
+	const void* envelope_level(unsigned int level, uint64_t &length) const;
+
+	/**
+	 * Copies the samples of an envelope level from @c start to the end
+	 * of the level.
+	 * @param[out] dest The vector the samples are appended to.
+	 * @return The length of the level in samples.
+	 */
+	uint64_t get_envelope_samples(unsigned int level, uint64_t start,
+		vector<EnvelopeSample> &dest) const;
+
+	/**
+	 * Returns the number of samples a sample of an envelope level covers.
+	 */
+	static uint64_t envelope_scale(unsigned int level);
+
+	/**
+	 * Returns the number of envelope levels.
+	 */
+	static unsigned int envelope_level_count();
+
 	SegmentAnalogDataIterator* begin_sample_iteration(uint64_t start);
 	void continue_sample_iteration(SegmentAnalogDataIterator* it, uint64_t increase);
 	void end_sample_iteration(SegmentAnalogDataIterator* it);
@@ -107,6 +168,7 @@ private:
 	Analog& owner_;
 
 	struct Envelope envelope_levels_[ScaleStepCount];
+	bool envelope_mapped_;
 
 	float min_value_, max_value_;
 
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CAPTUREFORMAT_HPP
+#define PULSEVIEW_PV_DATA_CAPTUREFORMAT_HPP
+
+#include <cstdint>
+
+namespace pv {
+namespace data {
+
+/**
+ * The layout of the capture recordings written by CaptureRecorder.
+ *
+ * A recording starts with a FileHeader, followed by a sequence of records.
+ * Every record consists of a RecordHeader and a payload of
+ * RecordHeader::length bytes. Records are only ever appended, so a file
+ * that was cut short, e.g. by a crash, can be recovered by reading records
+ * until the first one that is incomplete or has an unknown type, see
+ * CaptureReader.
+ *
+ * All values are stored in the byte order of the machine that wrote the
+ * file, which can be told from FileHeader::byte_order.
+ */
+namespace captureformat {
+
+/// The magic at the start of every recording.
+static const char Magic[8] = {'P', 'V', 'R', 'E', 'C', '\r', '\n', '\x1a'};
+
+static const uint32_t Version = 1;
+
+/// FileHeader::byte_order reads as this value in the byte order of the
+/// writer.
+static const uint32_t ByteOrderMark = 0x01020304;
+
+/// Records and their payloads are padded to this many bytes.
+static const uint64_t RecordAlignment = 8;
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+};
+
+enum RecordType : uint32_t {
+	/// A list of ChannelEntry structures, each followed by the channel
+	/// name without terminating zero, padded to RecordAlignment.
+	ChannelsRecord = 0x43484e4c,    // "CHNL"
+	/// A single uint64_t holding the sample rate in Hz.
+	SamplerateRecord = 0x53524154,  // "SRAT"
+	/// No payload.
+	FrameBeginRecord = 0x46524d42,  // "FRMB"
+	FrameEndRecord = 0x46524d45,    // "FRME"
+	TriggerRecord = 0x54524947,     // "TRIG"
+	/// A LogicHeader, followed by the packed logic samples.
+	LogicRecord = 0x4c4f4743,       // "LOGC"
+	/// An AnalogHeader, followed by channel_count uint32_t channel
+	/// indices, padded to RecordAlignment, followed by the interleaved
+	/// float samples.
+	AnalogRecord = 0x414e4c47,      // "ANLG"
+	/// A GapEntry. Marks where samples are missing because they were
+	/// dropped during the capture.
+	GapRecord = 0x47415020,         // "GAP "
+	/// No payload. Marks a recording that was closed properly.
+	EndRecord = 0x454e4420          // "END "
+};
+
+struct RecordHeader
+{
+	uint32_t type;
+	uint32_t reserved;
+	uint64_t length;  ///< The payload length, excluding padding
+};
+
+enum ChannelType : uint32_t {
+	LogicChannel = 1,
+	AnalogChannel = 2
+};
+
+struct ChannelEntry
+{
+	uint32_t index;
+	uint32_t type;
+	uint32_t enabled;
+	uint32_t name_length;
+};
+
+struct LogicHeader
+{
+	uint32_t unit_size;
+	uint32_t reserved;
+};
+
+struct AnalogHeader
+{
+	uint32_t channel_count;
+	uint32_t reserved;
+	uint64_t sample_count;  ///< Samples per channel
+};
+
+struct GapEntry
+{
+	uint64_t logic_samples;   ///< The number of logic samples missing
+	uint64_t analog_samples;  ///< The number of analog samples missing
+};
+
+/**
+ * Rounds a length up to the record alignment.
+ */
+inline uint64_t padded(uint64_t length)
+{
+	return (length + RecordAlignment - 1) & ~(RecordAlignment - 1);
+}
+
+} // namespace captureformat
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CAPTUREFORMAT_HPP
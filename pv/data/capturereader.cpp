@@ -0,0 +1,293 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include "captureformat.hpp"
+#include "capturereader.hpp"
+
+namespace pv {
+namespace data {
+
+namespace cf = captureformat;
+
+bool CaptureReader::is_recording(const string &path)
+{
+	FILE *const file = fopen(path.c_str(), "rb");
+	if (!file)
+		return false;
+
+	char magic[sizeof(cf::Magic)];
+	const bool result = fread(magic, sizeof(magic), 1, file) == 1 &&
+		memcmp(magic, cf::Magic, sizeof(magic)) == 0;
+
+	fclose(file);
+	return result;
+}
+
+CaptureReader::CaptureReader() :
+	file_(nullptr),
+	size_(0),
+	offset_(0),
+	position_(0),
+	complete_(false)
+{
+}
+
+CaptureReader::~CaptureReader()
+{
+	close();
+}
+
+bool CaptureReader::open(const string &path)
+{
+	close();
+
+	channels_.clear();
+	offset_ = position_ = 0;
+	complete_ = false;
+	error_.clear();
+
+	file_ = fopen(path.c_str(), "rb");
+	if (!file_) {
+		error_ = strerror(errno);
+		return false;
+	}
+
+#ifdef _WIN32
+	const bool sized = _fseeki64(file_, 0, SEEK_END) == 0 &&
+		(size_ = _ftelli64(file_)) != (uint64_t)-1 &&
+		_fseeki64(file_, 0, SEEK_SET) == 0;
+#else
+	const bool sized = fseeko(file_, 0, SEEK_END) == 0 &&
+		(size_ = ftello(file_)) != (uint64_t)-1 &&
+		fseeko(file_, 0, SEEK_SET) == 0;
+#endif
+	if (!sized) {
+		error_ = strerror(errno);
+		close();
+		return false;
+	}
+
+	cf::FileHeader header;
+	if (!read(&header, sizeof(header)) ||
+		memcmp(header.magic, cf::Magic, sizeof(header.magic)) != 0) {
+		error_ = "The file is not a recording";
+		close();
+		return false;
+	}
+
+	if (header.byte_order != cf::ByteOrderMark) {
+		error_ = "The file was written by a machine of different byte order";
+		close();
+		return false;
+	}
+
+	if (header.version != cf::Version) {
+		error_ = "The file was written by an unsupported version";
+		close();
+		return false;
+	}
+
+	// The channels are written when the recording is opened, so even a
+	// recording that was cut short has them
+	cf::RecordHeader record;
+	if (!read(&record, sizeof(record)) || record.type != cf::ChannelsRecord) {
+		error_ = "The recording is damaged";
+		close();
+		return false;
+	}
+
+	for (uint64_t end = offset_ + record.length; offset_ < end;) {
+		cf::ChannelEntry entry;
+		string name;
+		if (!read(&entry, sizeof(entry)) || entry.name_length > end - offset_) {
+			error_ = "The recording is damaged";
+			close();
+			return false;
+		}
+
+		name.resize(entry.name_length);
+		if (!read(&name[0], name.size()) || !skip_padding(name.size())) {
+			error_ = "The recording is damaged";
+			close();
+			return false;
+		}
+
+		channels_.push_back({entry.index, entry.type == cf::AnalogChannel,
+			entry.enabled != 0, name});
+	}
+
+	position_ = offset_;
+
+	return true;
+}
+
+void CaptureReader::close()
+{
+	if (file_)
+		fclose(file_);
+	file_ = nullptr;
+}
+
+const vector<CaptureReader::Channel>& CaptureReader::channels() const
+{
+	return channels_;
+}
+
+bool CaptureReader::next(Record &record)
+{
+	if (!file_ || complete_)
+		return false;
+
+	record.samplerate = 0;
+	record.unit_size = 0;
+	record.channels.clear();
+	record.data.clear();
+	record.gap_logic_samples = record.gap_analog_samples = 0;
+
+	// A record that claims more than is left of the file was cut short
+	cf::RecordHeader header;
+	if (!read(&header, sizeof(header)) ||
+		cf::padded(header.length) > size_ - offset_)
+		return false;
+
+	record.type = header.type;
+
+	switch (header.type) {
+	case cf::SamplerateRecord:
+		if (header.length != sizeof(uint64_t) ||
+			!read(&record.samplerate, sizeof(uint64_t)))
+			return false;
+		break;
+
+	case cf::FrameBeginRecord:
+	case cf::FrameEndRecord:
+	case cf::TriggerRecord:
+	case cf::EndRecord:
+		if (header.length != 0)
+			return false;
+		break;
+
+	case cf::LogicRecord:
+	{
+		cf::LogicHeader logic;
+		if (header.length < sizeof(logic) || !read(&logic, sizeof(logic)) ||
+			logic.unit_size == 0 ||
+			(header.length - sizeof(logic)) % logic.unit_size != 0)
+			return false;
+
+		record.unit_size = logic.unit_size;
+		record.data.resize(header.length - sizeof(logic));
+		if (!read(record.data.data(), record.data.size()) ||
+			!skip_padding(header.length))
+			return false;
+		break;
+	}
+
+	case cf::AnalogRecord:
+	{
+		cf::AnalogHeader analog;
+		if (header.length < sizeof(analog) || !read(&analog, sizeof(analog)))
+			return false;
+
+		const uint64_t index_length =
+			cf::padded(analog.channel_count * sizeof(uint32_t));
+		if (analog.channel_count == 0 ||
+			header.length != sizeof(analog) + index_length +
+				analog.channel_count * analog.sample_count * sizeof(float))
+			return false;
+
+		record.channels.resize(analog.channel_count);
+		record.data.resize(header.length - sizeof(analog) - index_length);
+		if (!read(record.channels.data(),
+				record.channels.size() * sizeof(uint32_t)) ||
+			!skip_padding(record.channels.size() * sizeof(uint32_t)) ||
+			!read(record.data.data(), record.data.size()) ||
+			!skip_padding(record.data.size()))
+			return false;
+		break;
+	}
+
+	case cf::GapRecord:
+	{
+		cf::GapEntry gap;
+		if (header.length != sizeof(gap) || !read(&gap, sizeof(gap)))
+			return false;
+
+		record.gap_logic_samples = gap.logic_samples;
+		record.gap_analog_samples = gap.analog_samples;
+		break;
+	}
+
+	default:
+		// Garbage after the last complete record, e.g. because the
+		// file system didn't write all of the file before a crash
+		return false;
+	}
+
+	position_ = offset_;
+
+	if (header.type == cf::EndRecord)
+		complete_ = true;
+
+	return true;
+}
+
+bool CaptureReader::complete() const
+{
+	return complete_;
+}
+
+uint64_t CaptureReader::position() const
+{
+	return position_;
+}
+
+const string& CaptureReader::error() const
+{
+	return error_;
+}
+
+bool CaptureReader::read(void *data, uint64_t length)
+{
+	if (length == 0)
+		return true;
+
+	if (length > size_ - offset_ || fread(data, 1, length, file_) != length) {
+		if (ferror(file_))
+			error_ = strerror(errno);
+		return false;
+	}
+
+	offset_ += length;
+	return true;
+}
+
+bool CaptureReader::skip_padding(uint64_t length)
+{
+	static const uint8_t padding[cf::RecordAlignment] = {};
+	uint8_t buffer[cf::RecordAlignment];
+
+	const uint64_t count = cf::padded(length) - length;
+	return read(buffer, count) && memcmp(buffer, padding, count) == 0;
+}
+
+} // namespace data
+} // namespace pv
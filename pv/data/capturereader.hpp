@@ -0,0 +1,141 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CAPTUREREADER_HPP
+#define PULSEVIEW_PV_DATA_CAPTUREREADER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Reads a capture recording written by CaptureRecorder, see
+ * captureformat.hpp for its layout.
+ *
+ * The records are read one after the other. A recording that was cut
+ * short, e.g. because PulseView crashed during the capture, is read up to
+ * its last complete record, which recovers everything that reached the
+ * disk. complete() tells such a recording from one that was closed
+ * properly.
+ */
+class CaptureReader
+{
+public:
+	struct Channel
+	{
+		uint32_t index;
+		bool analog;
+		bool enabled;
+		string name;
+	};
+
+	struct Record
+	{
+		/// The captureformat::RecordType of the record.
+		uint32_t type;
+
+		/// The sample rate of a samplerate record.
+		uint64_t samplerate;
+
+		/// The unit size of a logic record.
+		unsigned int unit_size;
+
+		/// The channel indices of an analog record, in the order the
+		/// samples are interleaved.
+		vector<uint32_t> channels;
+
+		/// The packed logic samples or interleaved analog samples.
+		vector<uint8_t> data;
+
+		/// The number of logic and analog samples missing at a gap.
+		uint64_t gap_logic_samples, gap_analog_samples;
+	};
+
+public:
+	/**
+	 * Returns true if the file starts with the magic of a recording.
+	 */
+	static bool is_recording(const string &path);
+
+	CaptureReader();
+	~CaptureReader();
+
+	/**
+	 * Opens the recording and reads its channels.
+	 * @return false if the file is not a recording or could not be read,
+	 * see error().
+	 */
+	bool open(const string &path);
+
+	void close();
+
+	const vector<Channel>& channels() const;
+
+	/**
+	 * Reads the next record.
+	 * @return false at the end of the recording, or if the rest of it is
+	 * cut short or damaged.
+	 */
+	bool next(Record &record);
+
+	/**
+	 * Returns true once the end marker of a recording that was closed
+	 * properly has been read.
+	 */
+	bool complete() const;
+
+	/**
+	 * Returns the number of bytes of the file that have been read as
+	 * complete records.
+	 */
+	uint64_t position() const;
+
+	const string& error() const;
+
+private:
+	bool read(void *data, uint64_t length);
+
+	/**
+	 * Skips the padding after a payload of @c length bytes.
+	 */
+	bool skip_padding(uint64_t length);
+
+private:
+	FILE *file_;
+	vector<Channel> channels_;
+
+	/// The size of the file and the offset that is read next.
+	uint64_t size_, offset_;
+
+	/// The end of the last complete record.
+	uint64_t position_;
+
+	bool complete_;
+	string error_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CAPTUREREADER_HPP
@@ -0,0 +1,348 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include "captureformat.hpp"
+#include "capturerecorder.hpp"
+#include "packetqueue.hpp"
+
+using std::lock_guard;
+using std::unique_lock;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace pv {
+namespace data {
+
+namespace cf = captureformat;
+
+const size_t CaptureRecorder::BufferSize = 4 * 1024 * 1024;
+const uint64_t CaptureRecorder::SyncSize = 64 * 1024 * 1024;
+const milliseconds CaptureRecorder::SyncInterval(1000);
+
+CaptureRecorder::CaptureRecorder() :
+	file_(nullptr),
+	write_pending_(false),
+	closing_(false),
+	bytes_written_(0)
+{
+}
+
+CaptureRecorder::~CaptureRecorder()
+{
+	if (is_open())
+		close();
+}
+
+bool CaptureRecorder::open(const string &path, const vector<Channel> &channels)
+{
+	assert(!is_open());
+
+	path_ = path;
+	error_.clear();
+	bytes_written_ = 0;
+
+	file_ = fopen(path.c_str(), "wb");
+	if (!file_) {
+		error_ = strerror(errno);
+		return false;
+	}
+
+	// We do our own buffering
+	setvbuf(file_, nullptr, _IONBF, 0);
+
+	active_.reserve(BufferSize + (BufferSize / 4));
+	writing_.reserve(active_.capacity());
+
+	cf::FileHeader header;
+	memcpy(header.magic, cf::Magic, sizeof(header.magic));
+	header.version = cf::Version;
+	header.byte_order = cf::ByteOrderMark;
+	append(&header, sizeof(header));
+
+	uint64_t length = 0;
+	for (const Channel &ch : channels)
+		length += sizeof(cf::ChannelEntry) + cf::padded(ch.name.size());
+
+	append_record(cf::ChannelsRecord, length);
+	for (const Channel &ch : channels) {
+		const cf::ChannelEntry entry = {ch.index,
+			ch.analog ? cf::AnalogChannel : cf::LogicChannel,
+			ch.enabled, (uint32_t)ch.name.size()};
+		append(&entry, sizeof(entry));
+		append(ch.name.data(), ch.name.size());
+		append_padding();
+	}
+
+	write_pending_ = false;
+	closing_ = false;
+	last_submit_ = steady_clock::now();
+	writer_thread_ = std::thread(&CaptureRecorder::writer_thread_proc, this);
+
+	return true;
+}
+
+bool CaptureRecorder::is_open() const
+{
+	return file_ != nullptr;
+}
+
+void CaptureRecorder::record(const QueuedPacket &packet)
+{
+	assert(is_open());
+
+	unique_lock<mutex> lock(mutex_);
+
+	// Mark where the samples that were dropped by the packet queue are
+	// missing, so that a replay doesn't join the data around the gap
+	if (packet.dropped_logic_samples || packet.dropped_analog_samples) {
+		const cf::GapEntry gap = {packet.dropped_logic_samples,
+			packet.dropped_analog_samples};
+		append_record(cf::GapRecord, sizeof(gap));
+		append(&gap, sizeof(gap));
+	}
+
+	switch (packet.type) {
+	case QueuedPacket::Meta:
+		if (packet.samplerate) {
+			append_record(cf::SamplerateRecord, sizeof(uint64_t));
+			append(&packet.samplerate, sizeof(uint64_t));
+		}
+		break;
+
+	case QueuedPacket::Trigger:
+		append_record(cf::TriggerRecord, 0);
+		break;
+
+	case QueuedPacket::FrameBegin:
+		append_record(cf::FrameBeginRecord, 0);
+		break;
+
+	case QueuedPacket::FrameEnd:
+		append_record(cf::FrameEndRecord, 0);
+		break;
+
+	case QueuedPacket::Logic:
+	{
+		const cf::LogicHeader header = {packet.unit_size, 0};
+		append_record(cf::LogicRecord, sizeof(header) + packet.data.size());
+		append(&header, sizeof(header));
+		append(packet.data.data(), packet.data.size());
+		append_padding();
+		break;
+	}
+
+	case QueuedPacket::Analog:
+	{
+		const uint32_t channel_count = packet.channels.size();
+		if (channel_count == 0)
+			break;
+
+		const cf::AnalogHeader header = {channel_count, 0,
+			packet.data.size() / (sizeof(float) * channel_count)};
+		const uint64_t index_length =
+			cf::padded(channel_count * sizeof(uint32_t));
+
+		append_record(cf::AnalogRecord,
+			sizeof(header) + index_length + packet.data.size());
+		append(&header, sizeof(header));
+		for (const shared_ptr<sigrok::Channel> &ch : packet.channels) {
+			const uint32_t index = ch->index();
+			append(&index, sizeof(index));
+		}
+		append_padding();
+		append(packet.data.data(), packet.data.size());
+		append_padding();
+		break;
+	}
+
+	case QueuedPacket::Header:
+	case QueuedPacket::End:
+		// The header is written by open(), the end marker by close()
+		break;
+	}
+
+	if (active_.size() >= BufferSize)
+		submit(lock);
+}
+
+bool CaptureRecorder::close()
+{
+	assert(is_open());
+
+	{
+		unique_lock<mutex> lock(mutex_);
+		append_record(cf::EndRecord, 0);
+		submit(lock);
+		closing_ = true;
+	}
+	cond_.notify_all();
+
+	writer_thread_.join();
+
+	fclose(file_);
+	file_ = nullptr;
+
+	// Release the buffers
+	vector<uint8_t>().swap(active_);
+	vector<uint8_t>().swap(writing_);
+
+	return error().empty();
+}
+
+const string& CaptureRecorder::path() const
+{
+	return path_;
+}
+
+string CaptureRecorder::error() const
+{
+	lock_guard<mutex> lock(mutex_);
+	return error_;
+}
+
+uint64_t CaptureRecorder::bytes_written() const
+{
+	return bytes_written_;
+}
+
+void CaptureRecorder::append_record(uint32_t type, uint64_t length)
+{
+	const cf::RecordHeader header = {type, 0, length};
+	append(&header, sizeof(header));
+}
+
+void CaptureRecorder::append(const void *data, size_t size)
+{
+	const uint8_t *const bytes = (const uint8_t*)data;
+	active_.insert(active_.end(), bytes, bytes + size);
+}
+
+void CaptureRecorder::append_padding()
+{
+	active_.resize(cf::padded(active_.size()), 0);
+}
+
+void CaptureRecorder::submit(unique_lock<mutex> &lock)
+{
+	cond_.wait(lock, [&] { return !write_pending_; });
+
+	// The writer may have taken the buffer in the meantime
+	if (active_.empty())
+		return;
+
+	swap_buffers();
+	cond_.notify_all();
+}
+
+void CaptureRecorder::swap_buffers()
+{
+	active_.swap(writing_);
+	active_.clear();
+	write_pending_ = true;
+	last_submit_ = steady_clock::now();
+}
+
+void CaptureRecorder::sync()
+{
+#ifdef _WIN32
+	_commit(_fileno(file_));
+#else
+	fsync(fileno(file_));
+#endif
+}
+
+void CaptureRecorder::writer_thread_proc()
+{
+	uint64_t unsynced = 0;
+	steady_clock::time_point last_sync = steady_clock::now();
+
+	unique_lock<mutex> lock(mutex_);
+
+	while (true) {
+		// A buffer that doesn't fill up is taken over once it has waited
+		// for SyncInterval, so that a slow capture still reaches the disk
+		const bool timed_out = !cond_.wait_until(lock,
+			last_submit_ + SyncInterval,
+			[&] { return write_pending_ || closing_; });
+		if (timed_out) {
+			if (active_.empty()) {
+				last_submit_ = steady_clock::now();
+				continue;
+			}
+
+			swap_buffers();
+		}
+
+		if (!write_pending_)
+			break;
+
+		// Once writing failed, the rest is discarded
+		const bool failed = !error_.empty();
+
+		// Write without holding the lock, the producer fills the other
+		// buffer in the meantime
+		lock.unlock();
+
+		bool ok = true;
+		if (!failed) {
+			ok = fwrite(writing_.data(), 1, writing_.size(), file_) ==
+				writing_.size();
+
+			if (ok) {
+				bytes_written_ += writing_.size();
+				unsynced += writing_.size();
+
+				const steady_clock::time_point now = steady_clock::now();
+				if (timed_out || unsynced >= SyncSize ||
+					now - last_sync >= SyncInterval) {
+					sync();
+					unsynced = 0;
+					last_sync = now;
+				}
+			}
+		}
+		const int err = errno;
+
+		lock.lock();
+
+		if (!ok)
+			error_ = strerror(err);
+
+		write_pending_ = false;
+		cond_.notify_all();
+	}
+
+	lock.unlock();
+
+	if (unsynced > 0)
+		sync();
+}
+
+} // namespace data
+} // namespace pv
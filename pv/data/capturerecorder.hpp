@@ -0,0 +1,141 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CAPTURERECORDER_HPP
+#define PULSEVIEW_PV_DATA_CAPTURERECORDER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::condition_variable;
+using std::mutex;
+using std::string;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+struct QueuedPacket;
+
+/**
+ * Streams the packets of a running acquisition into a recording on disk,
+ * see captureformat.hpp for its layout.
+ *
+ * Packets are serialized into a buffer by the ingest thread. Full buffers
+ * are handed over to a writer thread, which writes them out while the
+ * next buffer is being filled, and syncs the file to disk in batches. A
+ * buffer that doesn't fill up within SyncInterval is taken over by the
+ * writer as it is.
+ */
+class CaptureRecorder
+{
+public:
+	/// The buffer size at which the buffer is handed to the writer.
+	static const size_t BufferSize;
+
+	/// The amount of data written before the file is synced to disk.
+	static const uint64_t SyncSize;
+
+	/// The maximum time the data may stay unwritten or unsynced.
+	static const std::chrono::milliseconds SyncInterval;
+
+	struct Channel
+	{
+		uint32_t index;
+		bool analog;
+		bool enabled;
+		string name;
+	};
+
+public:
+	CaptureRecorder();
+	~CaptureRecorder();
+
+	/**
+	 * Creates the recording and writes its header.
+	 * @return false if the file could not be created, see error().
+	 */
+	bool open(const string &path, const vector<Channel> &channels);
+
+	bool is_open() const;
+
+	/**
+	 * Appends a packet to the recording.
+	 */
+	void record(const QueuedPacket &packet);
+
+	/**
+	 * Marks the end of the recording and waits until all of it is on disk.
+	 * @return false if any part of the recording could not be written,
+	 * see error().
+	 */
+	bool close();
+
+	const string& path() const;
+
+	string error() const;
+
+	uint64_t bytes_written() const;
+
+private:
+	/// The buffer is shared with the writer thread, so these must be
+	/// called with the mutex held once it runs.
+	void append_record(uint32_t type, uint64_t length);
+	void append(const void *data, size_t size);
+	void append_padding();
+
+	/**
+	 * Hands the buffer over to the writer, waiting for it to finish the
+	 * previous one first.
+	 * @param lock The held lock of the mutex.
+	 */
+	void submit(std::unique_lock<mutex> &lock);
+
+	void swap_buffers();
+
+	void sync();
+
+	void writer_thread_proc();
+
+private:
+	string path_;
+	FILE *file_;
+
+	vector<uint8_t> active_, writing_;
+
+	std::thread writer_thread_;
+	mutable mutex mutex_;
+	condition_variable cond_;
+	bool write_pending_, closing_;
+	std::chrono::steady_clock::time_point last_submit_;
+
+	string error_;
+	atomic<uint64_t> bytes_written_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CAPTURERECORDER_HPP
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "channelcompactor.hpp"
+
+using std::max;
+
+namespace pv {
+namespace data {
+
+static unsigned int popcount(uint64_t value)
+{
+	return __builtin_popcountll(value);
+}
+
+ChannelCompactor::ChannelCompactor(unsigned int unit_size, uint64_t mask) :
+	src_unit_size_(unit_size),
+	mask_((unit_size < 8) ?
+		(mask & ((UINT64_C(1) << (unit_size * 8)) - 1)) : mask),
+	unit_size_(1)
+{
+	assert(unit_size > 0 && unit_size <= 8);
+
+	unit_size_ = max(1U, (popcount(mask_) + 7) / 8);
+
+	unsigned int shift = 0;
+	for (unsigned int b = 0; b < src_unit_size_; b++) {
+		const unsigned int byte_mask = (mask_ >> (b * 8)) & 0xFF;
+		if (!byte_mask)
+			continue;
+
+		bytes_.push_back(b);
+
+#ifndef __BMI2__
+		for (unsigned int v = 0; v < 256; v++) {
+			uint64_t bits = 0;
+			for (unsigned int i = 0, o = 0; i < 8; i++)
+				if (byte_mask & (1 << i))
+					bits |= (uint64_t)((v >> i) & 1) << o++;
+			tables_.push_back(bits << shift);
+		}
+#endif
+
+		shift += popcount(byte_mask);
+	}
+}
+
+unsigned int ChannelCompactor::unit_size() const
+{
+	return unit_size_;
+}
+
+uint64_t ChannelCompactor::mask() const
+{
+	return mask_;
+}
+
+bool ChannelCompactor::is_identity() const
+{
+	// The kept bits must be the lowest ones, any bits above them are
+	// simply ignored
+	return (unit_size_ == src_unit_size_) && ((mask_ & (mask_ + 1)) == 0);
+}
+
+unsigned int ChannelCompactor::compacted_bit(unsigned int bit) const
+{
+	assert(bit < 64);
+	assert(mask_ & (UINT64_C(1) << bit));
+
+	return popcount(mask_ & ((UINT64_C(1) << bit) - 1));
+}
+
+void ChannelCompactor::compact(const void *src, void *dest,
+	uint64_t count) const
+{
+	const uint8_t *s = (const uint8_t*)src;
+	uint8_t *d = (uint8_t*)dest;
+
+	if (unit_size_ == 1) {
+		for (uint64_t i = 0; i < count; i++, s += src_unit_size_)
+			d[i] = gather(s);
+		return;
+	}
+
+	for (uint64_t i = 0; i < count; i++) {
+		const uint64_t value = gather(s);
+		for (unsigned int b = 0; b < unit_size_; b++)
+			*d++ = value >> (b * 8);
+		s += src_unit_size_;
+	}
+}
+
+uint64_t ChannelCompactor::gather(const uint8_t *sample) const
+{
+	uint64_t value = 0;
+
+#ifdef __BMI2__
+	// BMI2 is only available on x86, so the samples are little endian
+	memcpy(&value, sample, src_unit_size_);
+	value = _pext_u64(value, mask_);
+#else
+	const uint64_t *table = tables_.data();
+	for (unsigned int b : bytes_) {
+		value |= table[sample[b]];
+		table += 256;
+	}
+#endif
+
+	return value;
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,91 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CHANNELCOMPACTOR_HPP
+#define PULSEVIEW_PV_DATA_CHANNELCOMPACTOR_HPP
+
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Repacks logic samples so that they only hold a subset of the channels,
+ * using the smallest unit size that fits them. The bits that are kept
+ * retain their order and are moved down to the lowest bits of the unit.
+ *
+ * The bits are gathered with the BMI2 PEXT instruction where the build
+ * targets it, and with per-byte lookup tables otherwise.
+ */
+class ChannelCompactor
+{
+public:
+	/**
+	 * Constructor.
+	 * @param unit_size The unit size of the samples to compact, at most 8.
+	 * @param mask The bits of the channels to keep.
+	 */
+	ChannelCompactor(unsigned int unit_size, uint64_t mask);
+
+	/**
+	 * Returns the unit size of the compacted samples.
+	 */
+	unsigned int unit_size() const;
+
+	uint64_t mask() const;
+
+	/**
+	 * Returns true if the compacted samples hold the same channels at the
+	 * same bits in units of the same size, so that the samples can be used
+	 * as they are.
+	 */
+	bool is_identity() const;
+
+	/**
+	 * Returns the bit that the given bit of a sample ends up at.
+	 */
+	unsigned int compacted_bit(unsigned int bit) const;
+
+	/**
+	 * Compacts count samples from src into dest, which must have room for
+	 * count units of unit_size() bytes.
+	 */
+	void compact(const void *src, void *dest, uint64_t count) const;
+
+private:
+	uint64_t gather(const uint8_t *sample) const;
+
+private:
+	const unsigned int src_unit_size_;
+	const uint64_t mask_;
+	unsigned int unit_size_;
+
+	/// The source bytes that hold any of the kept bits.
+	vector<unsigned int> bytes_;
+
+	/// For each of bytes_, the compacted bits of each byte value, already
+	/// shifted to where they go in the compacted sample.
+	vector<uint64_t> tables_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CHANNELCOMPACTOR_HPP
@@ -0,0 +1,148 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CONTAINERFORMAT_HPP
+#define PULSEVIEW_PV_DATA_CONTAINERFORMAT_HPP
+
+#include <cstdint>
+
+namespace pv {
+namespace data {
+
+/**
+ * The layout of the native capture files written by ContainerWriter.
+ *
+ * Unlike the recordings of CaptureRecorder, these files are laid out to be
+ * memory-mapped: the samples of every segment are stored in one or more
+ * blobs, the extents, followed by one blob per pre-computed mip-map or
+ * envelope level. Blobs start at page boundaries, so the segments can refer
+ * to the mapped file directly and the operating system only reads the pages
+ * that are actually looked at.
+ *
+ * A file can be saved again incrementally. The extents of a segment except
+ * the last one hold whole chunks of a Segment, see Segment::chunk_samples(),
+ * so that they can be mapped chunk by chunk. While a segment is growing,
+ * the rest of the chunk after its last extent is left unused, and the
+ * samples added since are written there in place. Samples beyond it are
+ * appended as new extents. Then a new index is written into space that the
+ * header does not refer to, and only then the header is updated to point
+ * at it.
+ *
+ * The file starts with a FileHeader that points at the index, which is
+ * written last. The index consists of an IndexHeader, the channel table
+ * and the segment table:
+ *
+ *  - channel_count ChannelEntry structures, each followed by the channel
+ *    name without terminating zero, padded to IndexAlignment. Only the
+ *    logic channels that were enabled are stored, and their index is the
+ *    bit they occupy in the stored units, so they are renumbered from 0
+ *    when channels were disabled. The analog channels are numbered after
+ *    them, in the order of their original indices.
+ *  - segment_count SegmentEntry structures, each followed by extent_count
+ *    Blob structures holding the samples in order and level_count Blob
+ *    structures describing the stored levels, finest first.
+ *
+ * All values are stored in the byte order of the machine that wrote the
+ * file, which can be told from FileHeader::byte_order. Files of the other
+ * byte order can't be mapped and are rejected.
+ */
+namespace containerformat {
+
+/// The magic at the start of every capture file.
+static const char Magic[8] = {'P', 'V', 'C', 'A', 'P', '\r', '\n', '\x1a'};
+
+static const uint32_t Version = 2;
+
+/// FileHeader::byte_order reads as this value in the byte order of the
+/// writer.
+static const uint32_t ByteOrderMark = 0x01020304;
+
+/// Blobs start at multiples of this many bytes.
+static const uint64_t BlobAlignment = 4096;
+
+/// The index entries are padded to this many bytes.
+static const uint64_t IndexAlignment = 8;
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint64_t index_offset;  ///< 0 if the file was not closed properly
+	uint64_t index_length;
+};
+
+struct IndexHeader
+{
+	uint32_t channel_count;
+	uint32_t segment_count;
+};
+
+enum ChannelType : uint32_t {
+	LogicChannel = 1,
+	AnalogChannel = 2
+};
+
+struct ChannelEntry
+{
+	uint32_t index;  ///< The bit of logic channels, see above
+	uint32_t type;
+	uint32_t enabled;
+	uint32_t name_length;
+};
+
+struct Blob
+{
+	uint64_t offset;
+	uint64_t length;  ///< In bytes
+};
+
+struct SegmentEntry
+{
+	uint32_t type;           ///< The ChannelType of the samples
+	uint32_t channel_index;  ///< The channel of analog segments
+	uint32_t unit_size;
+	uint32_t level_count;
+	uint64_t sample_count;
+	double samplerate;
+	float min_value;         ///< The value range of analog segments
+	float max_value;
+	uint32_t extent_count;
+	uint32_t reserved;
+};
+
+/**
+ * Rounds a length up to the index alignment.
+ */
+inline uint64_t padded(uint64_t length)
+{
+	return (length + IndexAlignment - 1) & ~(IndexAlignment - 1);
+}
+
+/**
+ * Rounds an offset up to the next blob boundary.
+ */
+inline uint64_t blob_aligned(uint64_t offset)
+{
+	return (offset + BlobAlignment - 1) & ~(BlobAlignment - 1);
+}
+
+} // namespace containerformat
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CONTAINERFORMAT_HPP
@@ -0,0 +1,260 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <QFile>
+
+#include "containerformat.hpp"
+#include "containerreader.hpp"
+#include "segment.hpp"
+
+using std::make_shared;
+using std::max;
+using std::min;
+
+namespace pv {
+namespace data {
+
+namespace cf = containerformat;
+
+vector<ContainerReader::Extent> ContainerReader::Segment::extents_in(
+	uint64_t start, uint64_t end) const
+{
+	vector<Extent> pieces;
+	uint64_t first = 0;
+
+	for (const Extent &e : extents) {
+		const uint64_t from = max(start, first);
+		const uint64_t to = min(end, first + e.second);
+
+		if (from < to)
+			pieces.emplace_back(e.first + (from - first) * unit_size,
+				to - from);
+
+		first += e.second;
+	}
+
+	return pieces;
+}
+
+bool ContainerReader::is_container(const string &path)
+{
+	QFile file(QString::fromStdString(path));
+	char magic[sizeof(cf::Magic)];
+
+	return file.open(QIODevice::ReadOnly) &&
+		file.read(magic, sizeof(magic)) == sizeof(magic) &&
+		memcmp(magic, cf::Magic, sizeof(magic)) == 0;
+}
+
+ContainerReader::ContainerReader() :
+	data_(nullptr),
+	size_(0)
+{
+}
+
+ContainerReader::~ContainerReader()
+{
+}
+
+bool ContainerReader::open(const string &path)
+{
+	file_ = make_shared<QFile>(QString::fromStdString(path));
+	channels_.clear();
+	segments_.clear();
+	error_.clear();
+
+	if (!file_->open(QIODevice::ReadOnly)) {
+		error_ = file_->errorString().toStdString();
+		return false;
+	}
+
+	size_ = file_->size();
+	if (size_ < sizeof(cf::FileHeader)) {
+		error_ = "The file is not a capture file";
+		return false;
+	}
+
+	data_ = file_->map(0, size_);
+	if (!data_) {
+		error_ = file_->errorString().toStdString();
+		return false;
+	}
+
+	const cf::FileHeader *const header = (const cf::FileHeader*)data_;
+
+	if (memcmp(header->magic, cf::Magic, sizeof(header->magic)) != 0) {
+		error_ = "The file is not a capture file";
+		return false;
+	}
+
+	if (header->byte_order != cf::ByteOrderMark) {
+		error_ = "The file was written by a machine of different byte order";
+		return false;
+	}
+
+	if (header->version != cf::Version) {
+		error_ = "The file was written by an unsupported version";
+		return false;
+	}
+
+	if (header->index_offset == 0) {
+		error_ = "The file is incomplete, it was not closed properly";
+		return false;
+	}
+
+	return parse_index(header->index_offset, header->index_length);
+}
+
+const string& ContainerReader::error() const
+{
+	return error_;
+}
+
+shared_ptr<const void> ContainerReader::storage() const
+{
+	// The mapping is released when the file is closed
+	return file_;
+}
+
+const vector<ContainerReader::Channel>& ContainerReader::channels() const
+{
+	return channels_;
+}
+
+const vector<ContainerReader::Segment>& ContainerReader::segments() const
+{
+	return segments_;
+}
+
+bool ContainerReader::parse_index(uint64_t offset, uint64_t length)
+{
+	const uint8_t *ptr = data_ + offset;
+	const uint8_t *const end = ptr + length;
+
+	if (!check_blob(offset, length) ||
+		(offset % cf::IndexAlignment) != 0 ||
+		length < sizeof(cf::IndexHeader)) {
+		error_ = "The index of the file is damaged";
+		return false;
+	}
+
+	const cf::IndexHeader *const index = (const cf::IndexHeader*)ptr;
+	ptr += sizeof(cf::IndexHeader);
+
+	for (uint32_t i = 0; i < index->channel_count; i++) {
+		const cf::ChannelEntry *const entry = (const cf::ChannelEntry*)ptr;
+
+		if ((uint64_t)(end - ptr) < sizeof(cf::ChannelEntry) ||
+			(uint64_t)(end - ptr) < sizeof(cf::ChannelEntry) +
+				cf::padded(entry->name_length)) {
+			error_ = "The index of the file is damaged";
+			return false;
+		}
+
+		ptr += sizeof(cf::ChannelEntry);
+		channels_.push_back({entry->index,
+			entry->type == cf::AnalogChannel, entry->enabled != 0,
+			string((const char*)ptr, entry->name_length)});
+		ptr += cf::padded(entry->name_length);
+	}
+
+	for (uint32_t i = 0; i < index->segment_count; i++) {
+		const cf::SegmentEntry *const entry = (const cf::SegmentEntry*)ptr;
+
+		if ((uint64_t)(end - ptr) < sizeof(cf::SegmentEntry) ||
+			(uint64_t)(end - ptr) < sizeof(cf::SegmentEntry) +
+				((uint64_t)entry->extent_count + entry->level_count) *
+				sizeof(cf::Blob)) {
+			error_ = "The index of the file is damaged";
+			return false;
+		}
+
+		ptr += sizeof(cf::SegmentEntry);
+
+		const bool analog = (entry->type == cf::AnalogChannel);
+
+		if (entry->unit_size == 0 ||
+			(analog && entry->unit_size != sizeof(float))) {
+			error_ = "A segment of the file is damaged";
+			return false;
+		}
+
+		Segment s = {analog, entry->channel_index, entry->unit_size,
+			entry->sample_count, entry->samplerate,
+			entry->min_value, entry->max_value,
+			vector<Extent>(), vector<Level>()};
+
+		// Everything is mapped in place, so the extents must be aligned
+		// to their type, lie within the file and, except for the last
+		// one, hold whole chunks
+		const uint64_t chunk_size =
+			data::Segment::chunk_samples(s.unit_size) * s.unit_size;
+		uint64_t sample_count = 0;
+
+		for (uint32_t e = 0; e < entry->extent_count; e++) {
+			const cf::Blob *const extent = (const cf::Blob*)ptr;
+			ptr += sizeof(cf::Blob);
+
+			if ((extent->offset % cf::BlobAlignment) != 0 ||
+				(extent->length % s.unit_size) != 0 ||
+				(e + 1 < entry->extent_count &&
+					(extent->length % chunk_size) != 0) ||
+				!check_blob(extent->offset, extent->length)) {
+				error_ = "A segment of the file is damaged";
+				return false;
+			}
+
+			s.extents.emplace_back(data_ + extent->offset,
+				extent->length / s.unit_size);
+			sample_count += extent->length / s.unit_size;
+		}
+
+		if (sample_count != s.sample_count) {
+			error_ = "A segment of the file is damaged";
+			return false;
+		}
+
+		for (uint32_t l = 0; l < entry->level_count; l++) {
+			const cf::Blob *const level = (const cf::Blob*)ptr;
+			ptr += sizeof(cf::Blob);
+
+			if ((level->offset % cf::BlobAlignment) != 0 ||
+				!check_blob(level->offset, level->length)) {
+				error_ = "A segment of the file is damaged";
+				return false;
+			}
+
+			s.levels.emplace_back(data_ + level->offset, level->length);
+		}
+
+		segments_.push_back(s);
+	}
+
+	return true;
+}
+
+bool ContainerReader::check_blob(uint64_t offset, uint64_t length) const
+{
+	return offset <= size_ && length <= size_ - offset;
+}
+
+} // namespace data
+} // namespace pv
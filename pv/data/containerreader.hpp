@@ -0,0 +1,131 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CONTAINERREADER_HPP
+#define PULSEVIEW_PV_DATA_CONTAINERREADER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+class QFile;
+
+namespace pv {
+namespace data {
+
+/**
+ * Opens a native capture file written by ContainerWriter.
+ *
+ * The file is memory-mapped as a whole and only its index is parsed when
+ * it is opened. The segments refer to the samples and levels in the
+ * mapping, so opening takes the same time regardless of the file size and
+ * the samples are paged in as they are accessed.
+ */
+class ContainerReader
+{
+public:
+	struct Channel
+	{
+		uint32_t index;
+		bool analog;
+		bool enabled;
+		string name;
+	};
+
+	/// The start and the length in bytes of a stored level.
+	typedef pair<const void*, uint64_t> Level;
+
+	/// The start and the number of samples of a stored extent, see
+	/// Segment::map_samples().
+	typedef pair<const uint8_t*, uint64_t> Extent;
+
+	struct Segment
+	{
+		bool analog;
+		uint32_t channel_index;
+		unsigned int unit_size;
+		uint64_t sample_count;
+		double samplerate;
+		float min_value, max_value;
+		vector<Extent> extents;
+		vector<Level> levels;
+
+		/**
+		 * Returns the pieces of the extents that hold a range of samples.
+		 * @param start The index of the first sample.
+		 * @param end The index after the last sample.
+		 */
+		vector<Extent> extents_in(uint64_t start, uint64_t end) const;
+	};
+
+public:
+	/**
+	 * Returns true if the file starts with the magic of a capture file.
+	 */
+	static bool is_container(const string &path);
+
+	ContainerReader();
+	~ContainerReader();
+
+	/**
+	 * Maps the file and parses its index.
+	 * @return false if the file could not be opened, see error().
+	 */
+	bool open(const string &path);
+
+	const string& error() const;
+
+	/**
+	 * Returns a handle that keeps the mapping alive. Everything that
+	 * refers to the mapped samples must hold on to it.
+	 */
+	shared_ptr<const void> storage() const;
+
+	const vector<Channel>& channels() const;
+
+	const vector<Segment>& segments() const;
+
+private:
+	bool parse_index(uint64_t offset, uint64_t length);
+
+	/**
+	 * Checks that a blob lies within the file.
+	 */
+	bool check_blob(uint64_t offset, uint64_t length) const;
+
+private:
+	shared_ptr<QFile> file_;
+	const uint8_t *data_;
+	uint64_t size_;
+
+	vector<Channel> channels_;
+	vector<Segment> segments_;
+
+	string error_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CONTAINERREADER_HPP
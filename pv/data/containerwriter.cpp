@@ -0,0 +1,533 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "containerwriter.hpp"
+#include "segment.hpp"
+
+using std::equal;
+using std::min;
+
+namespace pv {
+namespace data {
+
+namespace cf = containerformat;
+
+/**
+ * Moves to an offset in a file, which may be beyond 2 GiB.
+ */
+static bool seek(FILE *file, uint64_t offset)
+{
+#ifdef _WIN32
+	return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, offset, SEEK_SET) == 0;
+#endif
+}
+
+ContainerWriter::ContainerWriter() :
+	file_(nullptr),
+	offset_(0),
+	in_place_(false),
+	growing_(false),
+	closed_size_(0),
+	closed_index_offset_(0),
+	closed_index_space_{0, 0},
+	free_index_space_{0, 0},
+	current_(0),
+	in_segment_(false),
+	in_samples_(false),
+	new_extent_(false)
+{
+}
+
+ContainerWriter::~ContainerWriter()
+{
+	if (is_open())
+		abort();
+}
+
+bool ContainerWriter::open(const string &path, const vector<Channel> &channels)
+{
+	assert(!is_open());
+
+	path_ = path;
+	temp_path_ = path + ".part";
+	channels_ = channels;
+	segments_.clear();
+	in_segment_ = false;
+	in_place_ = false;
+	closed_size_ = 0;
+	closed_index_offset_ = 0;
+	closed_index_space_ = free_index_space_ = {0, 0};
+	error_.clear();
+	offset_ = 0;
+
+	file_ = fopen(temp_path_.c_str(), "wb");
+	if (!file_) {
+		error_ = strerror(errno);
+		return false;
+	}
+
+	// Without an index the file is recognizably incomplete
+	write_header(0, 0);
+
+	return true;
+}
+
+bool ContainerWriter::reopen(const vector<Channel> &channels)
+{
+	assert(!is_open());
+
+	error_.clear();
+
+	if (closed_size_ == 0) {
+		error_ = "The file was not saved completely";
+		return false;
+	}
+
+	if (channels.size() != channels_.size() ||
+		!equal(channels.begin(), channels.end(), channels_.begin(),
+			[](const Channel &a, const Channel &b) {
+				return a.index == b.index && a.analog == b.analog &&
+					a.enabled == b.enabled && a.name == b.name; })) {
+		error_ = "The channels were changed";
+		return false;
+	}
+
+	file_ = fopen(path_.c_str(), "r+b");
+	if (!file_) {
+		error_ = strerror(errno);
+		return false;
+	}
+
+	// Only add to the file if it is still the one that was written last
+	cf::FileHeader header;
+	if (fread(&header, sizeof(header), 1, file_) != 1 ||
+		header.index_offset != closed_index_offset_ ||
+		fseek(file_, 0, SEEK_END) != 0 ||
+		(uint64_t)ftell(file_) != closed_size_) {
+		error_ = "The file was changed by someone else";
+		fclose(file_);
+		file_ = nullptr;
+		return false;
+	}
+
+	offset_ = closed_size_;
+	in_place_ = true;
+	closed_size_ = 0;
+
+	return true;
+}
+
+bool ContainerWriter::is_open() const
+{
+	return file_ != nullptr;
+}
+
+void ContainerWriter::set_growing(bool growing)
+{
+	growing_ = growing;
+}
+
+size_t ContainerWriter::segment_count() const
+{
+	return segments_.size();
+}
+
+uint64_t ContainerWriter::segment_sample_count(size_t index) const
+{
+	assert(index < segments_.size());
+	return segments_[index].entry.sample_count;
+}
+
+void ContainerWriter::begin_segment(bool analog, uint32_t channel_index,
+	unsigned int unit_size, double samplerate,
+	float min_value, float max_value)
+{
+	assert(is_open());
+	assert(!in_segment_);
+
+	align();
+
+	Segment s;
+	s.entry.type = analog ? cf::AnalogChannel : cf::LogicChannel;
+	s.entry.channel_index = channel_index;
+	s.entry.unit_size = unit_size;
+	s.entry.level_count = 0;
+	s.entry.sample_count = 0;
+	s.entry.samplerate = samplerate;
+	s.entry.min_value = min_value;
+	s.entry.max_value = max_value;
+	s.entry.extent_count = 0;
+	s.entry.reserved = 0;
+	s.reserved = 0;
+
+	segments_.push_back(s);
+	current_ = segments_.size() - 1;
+	in_segment_ = true;
+	in_samples_ = true;
+	new_extent_ = true;
+}
+
+uint64_t ContainerWriter::resumed_sample_count(size_t index) const
+{
+	assert(index < segments_.size());
+
+	const Segment &s = segments_[index];
+	if (s.extents.empty() || s.reserved > 0)
+		return s.entry.sample_count;
+
+	// All but the last extent hold whole chunks, so only the last one
+	// may have to be cut back
+	const uint64_t cut = s.extents.back().length % chunk_size(s.entry);
+	return s.entry.sample_count - cut / s.entry.unit_size;
+}
+
+uint64_t ContainerWriter::resume_segment(size_t index,
+	float min_value, float max_value)
+{
+	assert(in_place_);
+	assert(!in_segment_);
+	assert(index < segments_.size());
+
+	Segment &s = segments_[index];
+
+	const uint64_t kept = resumed_sample_count(index);
+	if (kept != s.entry.sample_count) {
+		s.extents.back().length -=
+			(s.entry.sample_count - kept) * s.entry.unit_size;
+		if (s.extents.back().length == 0)
+			s.extents.pop_back();
+	}
+
+	s.entry.sample_count = kept;
+	s.entry.min_value = min_value;
+	s.entry.max_value = max_value;
+	s.levels.clear();
+
+	current_ = index;
+	in_segment_ = true;
+	in_samples_ = true;
+	new_extent_ = (s.reserved == 0);
+
+	return kept;
+}
+
+void ContainerWriter::append_samples(const void *data, uint64_t sample_count)
+{
+	assert(in_segment_);
+	assert(in_samples_);
+
+	Segment &s = segments_[current_];
+
+	const uint8_t *bytes = (const uint8_t*)data;
+	uint64_t length = sample_count * s.entry.unit_size;
+	if (length == 0)
+		return;
+
+	s.entry.sample_count += sample_count;
+
+	// Fill the space reserved after the last extent first
+	if (s.reserved > 0) {
+		cf::Blob &last = s.extents.back();
+		const uint64_t part = min(length, s.reserved);
+
+		write_at(last.offset + last.length, bytes, part);
+		last.length += part;
+		s.reserved -= part;
+		bytes += part;
+		length -= part;
+
+		// Once the space is used up, the extent ends on a chunk
+		// boundary and the next one can follow it
+		if (s.reserved == 0)
+			new_extent_ = true;
+		if (length == 0)
+			return;
+	}
+
+	if (new_extent_) {
+		align();
+		s.extents.push_back({offset_, 0});
+		new_extent_ = false;
+	}
+
+	write(bytes, length);
+	s.extents.back().length += length;
+}
+
+void ContainerWriter::add_level(const void *data, uint64_t length)
+{
+	assert(in_segment_);
+
+	if (in_samples_)
+		end_samples();
+
+	align();
+
+	Segment &s = segments_[current_];
+	s.levels.push_back({offset_, length});
+
+	write(data, length);
+}
+
+void ContainerWriter::end_segment()
+{
+	assert(in_segment_);
+
+	if (in_samples_)
+		end_samples();
+
+	in_segment_ = false;
+}
+
+bool ContainerWriter::close()
+{
+	assert(is_open());
+	assert(!in_segment_);
+
+	static const uint8_t padding[cf::IndexAlignment] = {};
+
+	vector<uint8_t> index;
+	const auto add = [&](const void *data, uint64_t length) {
+		const uint8_t *const bytes = (const uint8_t*)data;
+		index.insert(index.end(), bytes, bytes + length);
+	};
+
+	const cf::IndexHeader header = {(uint32_t)channels_.size(),
+		(uint32_t)segments_.size()};
+	add(&header, sizeof(header));
+
+	for (const Channel &ch : channels_) {
+		const cf::ChannelEntry entry = {ch.index,
+			ch.analog ? cf::AnalogChannel : cf::LogicChannel,
+			ch.enabled, (uint32_t)ch.name.size()};
+		add(&entry, sizeof(entry));
+		add(ch.name.data(), ch.name.size());
+		add(padding, cf::padded(ch.name.size()) - ch.name.size());
+	}
+
+	for (Segment &s : segments_) {
+		s.entry.extent_count = s.extents.size();
+		s.entry.level_count = s.levels.size();
+
+		add(&s.entry, sizeof(s.entry));
+		for (const cf::Blob &extent : s.extents)
+			add(&extent, sizeof(extent));
+		for (const cf::Blob &level : s.levels)
+			add(&level, sizeof(level));
+	}
+
+	// The header doesn't refer to the index before the current one any
+	// more, so the new index may take its space
+	uint64_t index_offset;
+	cf::Blob index_space;
+	if (index.size() <= free_index_space_.length) {
+		index_offset = free_index_space_.offset;
+		index_space = free_index_space_;
+		write_at(index_offset, index.data(), index.size());
+	} else {
+		align();
+		index_offset = offset_;
+		write(index.data(), index.size());
+
+		// The next blob starts at the following boundary
+		index_space = {index_offset,
+			cf::blob_aligned(offset_) - index_offset};
+	}
+
+	const uint64_t size = offset_;
+
+	// The previous index stays valid until the new one and the samples
+	// it refers to have reached the disk, and the file is only reported
+	// saved once the new header has as well
+	sync();
+	write_header(index_offset, index.size());
+	sync();
+
+	if (fclose(file_) != 0 && error_.empty())
+		error_ = strerror(errno);
+	file_ = nullptr;
+
+	if (in_place_) {
+		in_place_ = false;
+		if (!error_.empty())
+			return false;
+
+		closed_size_ = size;
+		closed_index_offset_ = index_offset;
+		free_index_space_ = closed_index_space_;
+		closed_index_space_ = index_space;
+		return true;
+	}
+
+	if (!error_.empty()) {
+		remove(temp_path_.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	// Windows does not replace existing files when renaming
+	remove(path_.c_str());
+#endif
+
+	if (rename(temp_path_.c_str(), path_.c_str()) != 0) {
+		error_ = strerror(errno);
+		remove(temp_path_.c_str());
+		return false;
+	}
+
+	closed_size_ = size;
+	closed_index_offset_ = index_offset;
+	free_index_space_ = {0, 0};
+	closed_index_space_ = index_space;
+
+	return true;
+}
+
+void ContainerWriter::abort()
+{
+	assert(is_open());
+
+	fclose(file_);
+	file_ = nullptr;
+	in_segment_ = false;
+
+	// A reopened file keeps its old header and index, it only has some
+	// unreferenced data at the end now
+	if (in_place_)
+		in_place_ = false;
+	else
+		remove(temp_path_.c_str());
+}
+
+const string& ContainerWriter::error() const
+{
+	return error_;
+}
+
+void ContainerWriter::write(const void *data, uint64_t length)
+{
+	if (!error_.empty() || length == 0)
+		return;
+
+	if (fwrite(data, 1, length, file_) != length)
+		error_ = strerror(errno);
+
+	offset_ += length;
+}
+
+void ContainerWriter::write_at(uint64_t offset, const void *data,
+	uint64_t length)
+{
+	if (!error_.empty() || length == 0)
+		return;
+
+	if (!seek(file_, offset) ||
+		fwrite(data, 1, length, file_) != length ||
+		!seek(file_, offset_))
+		error_ = strerror(errno);
+}
+
+void ContainerWriter::write_header(uint64_t index_offset,
+	uint64_t index_length)
+{
+	if (!error_.empty())
+		return;
+
+	cf::FileHeader header;
+	memcpy(header.magic, cf::Magic, sizeof(header.magic));
+	header.version = cf::Version;
+	header.byte_order = cf::ByteOrderMark;
+	header.index_offset = index_offset;
+	header.index_length = index_length;
+
+	// The header is rewritten in place once the index is known
+	if (!seek(file_, 0) ||
+		fwrite(&header, sizeof(header), 1, file_) != 1)
+		error_ = strerror(errno);
+
+	if (index_offset == 0)
+		offset_ = sizeof(header);
+}
+
+void ContainerWriter::sync()
+{
+	if (!error_.empty())
+		return;
+
+#ifdef _WIN32
+	if (fflush(file_) != 0 || _commit(_fileno(file_)) != 0)
+#else
+	if (fflush(file_) != 0 || fsync(fileno(file_)) != 0)
+#endif
+		error_ = strerror(errno);
+}
+
+void ContainerWriter::align()
+{
+	static const uint8_t padding[cf::BlobAlignment] = {};
+
+	write(padding, cf::blob_aligned(offset_) - offset_);
+}
+
+void ContainerWriter::end_samples()
+{
+	in_samples_ = false;
+
+	Segment &s = segments_[current_];
+	if (!growing_ || s.extents.empty() || s.reserved > 0)
+		return;
+
+	// Only the extent at the end of the file can have space after it
+	const cf::Blob &last = s.extents.back();
+	if (last.offset + last.length != offset_)
+		return;
+
+	const uint64_t size = chunk_size(s.entry);
+	s.reserved = (size - last.length % size) % size;
+	if (s.reserved == 0)
+		return;
+
+	// The space is skipped rather than written, so it stays a hole in
+	// the file until later saves fill it. Only its last byte is written,
+	// so that the file always ends where the writer does.
+	static const uint8_t zero = 0;
+	offset_ += s.reserved - 1;
+	if (error_.empty() && !seek(file_, offset_))
+		error_ = strerror(errno);
+	write(&zero, 1);
+}
+
+uint64_t ContainerWriter::chunk_size(const cf::SegmentEntry &entry) const
+{
+	return data::Segment::chunk_samples(entry.unit_size) * entry.unit_size;
+}
+
+} // namespace data
+} // namespace pv
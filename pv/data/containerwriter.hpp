@@ -0,0 +1,245 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CONTAINERWRITER_HPP
+#define PULSEVIEW_PV_DATA_CONTAINERWRITER_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "containerformat.hpp"
+
+using std::string;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * Writes a native capture file, see containerformat.hpp for its layout.
+ *
+ * Segments are written one after the other: begin_segment() describes the
+ * segment, append_samples() adds its samples and add_level() its
+ * pre-computed mip-map or envelope levels. The index is written when the
+ * file is closed.
+ *
+ * The file is written under a temporary name and only replaces the target
+ * once it is complete, so the file that is being saved over may still be
+ * mapped by a ContainerReader in the meantime.
+ *
+ * Once closed, the writer remembers what it wrote, so that reopen() can
+ * save the file again incrementally: resume_segment() continues a segment
+ * that has grown and begin_segment() adds new ones. While segments are
+ * still growing, see set_growing(), the rest of the last chunk of every
+ * segment is reserved in the file, so that the samples added later are
+ * written in place and only the new samples cost anything to save.
+ *
+ * Nothing that the current header refers to is overwritten except for the
+ * header itself, which is updated only after the new index has reached the
+ * disk. The new index reuses the space of the index before the current
+ * one if it fits, so repeated saves don't accumulate old indices.
+ */
+class ContainerWriter
+{
+public:
+	struct Channel
+	{
+		uint32_t index;
+		bool analog;
+		bool enabled;
+		string name;
+	};
+
+public:
+	ContainerWriter();
+	~ContainerWriter();
+
+	/**
+	 * Creates the file and writes a preliminary header.
+	 * @return false if the file could not be created, see error().
+	 */
+	bool open(const string &path, const vector<Channel> &channels);
+
+	/**
+	 * Reopens the file that was last written and closed by this writer,
+	 * to add to it in place.
+	 * @param channels The channels, which must be the same as before.
+	 * @return false if the file or the channels were changed in the
+	 * meantime or the file could not be opened, see error(). The file
+	 * must then be written anew.
+	 */
+	bool reopen(const vector<Channel> &channels);
+
+	bool is_open() const;
+
+	/**
+	 * Sets whether the segments that are written may still grow, e.g.
+	 * while saving a capture that is running. If so, the rest of the last
+	 * chunk of each segment is reserved for the samples that are added
+	 * by later incremental saves.
+	 */
+	void set_growing(bool growing);
+
+	/**
+	 * Returns the number of segments in the file.
+	 */
+	size_t segment_count() const;
+
+	/**
+	 * Returns the number of samples stored for a segment.
+	 */
+	uint64_t segment_sample_count(size_t index) const;
+
+	/**
+	 * Starts a new segment.
+	 * @param analog true for the samples of one analog channel, false for
+	 * packed logic samples.
+	 * @param channel_index The index of the analog channel.
+	 * @param min_value The smallest value of an analog segment.
+	 * @param max_value The largest value of an analog segment.
+	 */
+	void begin_segment(bool analog, uint32_t channel_index,
+		unsigned int unit_size, double samplerate,
+		float min_value = 0, float max_value = 0);
+
+	/**
+	 * Returns the number of samples that resume_segment() will keep.
+	 */
+	uint64_t resumed_sample_count(size_t index) const;
+
+	/**
+	 * Continues a segment that was written before the file was reopened.
+	 * The stored levels are dropped. If no space was reserved after the
+	 * samples, they are cut back to the last whole chunk boundary, see
+	 * Segment::chunk_samples(), so that another extent can follow them.
+	 * @param index The index of the segment in the file.
+	 * @param min_value The new smallest value of an analog segment.
+	 * @param max_value The new largest value of an analog segment.
+	 * @return The number of samples kept. The caller continues with
+	 * append_samples() from there on.
+	 */
+	uint64_t resume_segment(size_t index,
+		float min_value = 0, float max_value = 0);
+
+	/**
+	 * Adds samples to the current segment.
+	 */
+	void append_samples(const void *data, uint64_t sample_count);
+
+	/**
+	 * Adds the next level of the mip-map or envelope of the current
+	 * segment. Levels must be added finest first, after all samples.
+	 */
+	void add_level(const void *data, uint64_t length);
+
+	void end_segment();
+
+	/**
+	 * Writes the index and the final header.
+	 * @return false if any part of the file could not be written, see
+	 * error().
+	 */
+	bool close();
+
+	/**
+	 * Closes the file and deletes it, e.g. when saving was cancelled.
+	 */
+	void abort();
+
+	const string& error() const;
+
+private:
+	void write(const void *data, uint64_t length);
+
+	/**
+	 * Writes data before the end of the file.
+	 */
+	void write_at(uint64_t offset, const void *data, uint64_t length);
+
+	void write_header(uint64_t index_offset, uint64_t index_length);
+
+	/**
+	 * Flushes the file and waits until it has reached the disk.
+	 */
+	void sync();
+
+	/**
+	 * Pads the file up to the next blob boundary.
+	 */
+	void align();
+
+	/**
+	 * Called once the samples of the current segment are complete.
+	 * Reserves the rest of the last chunk after them if the segment may
+	 * grow.
+	 */
+	void end_samples();
+
+	/**
+	 * Gets the size in bytes of a chunk of a segment.
+	 */
+	uint64_t chunk_size(const containerformat::SegmentEntry &entry) const;
+
+private:
+	string path_, temp_path_;
+	FILE *file_;
+	uint64_t offset_;
+
+	/// true while adding to a reopened file instead of writing a new one.
+	bool in_place_;
+
+	bool growing_;
+
+	/// The size and index offset of the file when it was last closed, or
+	/// 0 if it can't be reopened.
+	uint64_t closed_size_, closed_index_offset_;
+
+	/// The space taken by the index of the last close, and the space of
+	/// the index before it, which may be reused by the next one.
+	containerformat::Blob closed_index_space_, free_index_space_;
+
+	vector<Channel> channels_;
+
+	struct Segment
+	{
+		containerformat::SegmentEntry entry;
+		vector<containerformat::Blob> extents;
+		vector<containerformat::Blob> levels;
+
+		/// The number of bytes reserved after the last extent.
+		uint64_t reserved;
+	};
+
+	vector<Segment> segments_;
+	size_t current_;
+	bool in_segment_;
+
+	/// true until the first level of the current segment is added.
+	bool in_samples_;
+
+	/// true if the next samples must start a new extent.
+	bool new_extent_;
+
+	string error_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CONTAINERWRITER_HPP
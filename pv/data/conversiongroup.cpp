@@ -0,0 +1,284 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include "analog.hpp"
+#include "analogsegment.hpp"
+#include "conversiongroup.hpp"
+#include "logic.hpp"
+#include "logicsegment.hpp"
+#include "signalbase.hpp"
+
+using std::find;
+using std::lock_guard;
+using std::make_shared;
+using std::min;
+using std::none_of;
+using std::tie;
+using std::unique_lock;
+
+namespace pv {
+namespace data {
+
+const unsigned int ConversionGroup::MaxChannels = 64;
+const uint64_t ConversionGroup::ConversionBlockSize = 4096;
+
+ConversionGroup::ConversionGroup() :
+	logic_data_(make_shared<Logic>(MaxChannels)),
+	pending_(false),
+	interrupt_(false)
+{
+}
+
+ConversionGroup::~ConversionGroup()
+{
+	stop();
+}
+
+shared_ptr<Logic> ConversionGroup::logic_data() const
+{
+	return logic_data_;
+}
+
+bool ConversionGroup::add(SignalBase *member)
+{
+	assert(member);
+
+	if (find(members_.begin(), members_.end(), member) != members_.end())
+		return true;
+
+	auto iter = find(members_.begin(), members_.end(), nullptr);
+	if (iter == members_.end() && members_.size() >= MaxChannels)
+		return false;
+
+	stop();
+
+	if (iter != members_.end())
+		*iter = member;
+	else
+		members_.push_back(member);
+
+	reset_segments();
+	start();
+
+	return true;
+}
+
+void ConversionGroup::remove(SignalBase *member)
+{
+	auto iter = find(members_.begin(), members_.end(), member);
+	if (iter == members_.end())
+		return;
+
+	stop();
+
+	// The other members keep their bits
+	*iter = nullptr;
+	while (!members_.empty() && !members_.back())
+		members_.pop_back();
+
+	reset_segments();
+
+	if (!members_.empty())
+		start();
+}
+
+void ConversionGroup::update(SignalBase *member)
+{
+	assert(find(members_.begin(), members_.end(), member) != members_.end());
+	(void)member;
+
+	stop();
+	reset_segments();
+	start();
+}
+
+unsigned int ConversionGroup::bit_index(const SignalBase *member) const
+{
+	auto iter = find(members_.begin(), members_.end(), member);
+	assert(iter != members_.end());
+
+	return iter - members_.begin();
+}
+
+void ConversionGroup::queue_conversion()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		pending_ = true;
+	}
+	cond_.notify_one();
+}
+
+void ConversionGroup::clear()
+{
+	const bool running = conversion_thread_.joinable();
+
+	// Restart the worker so that it can't touch the discarded segments
+	stop();
+	reset_segments();
+
+	if (running)
+		start();
+}
+
+void ConversionGroup::start()
+{
+	assert(!conversion_thread_.joinable());
+
+	// The worker only uses what the members are now, so that they can
+	// change while it runs
+	bits_.clear();
+	data_.clear();
+	types_.clear();
+	for (unsigned int bit = 0; bit < members_.size(); bit++)
+		if (members_[bit]) {
+			bits_.push_back(bit);
+			data_.push_back(members_[bit]->analog_data());
+			types_.push_back(members_[bit]->conversion_type());
+		}
+
+	interrupt_ = false;
+	pending_ = true;  // Convert the samples that are already there
+	conversion_thread_ = std::thread(&ConversionGroup::conversion_thread_proc,
+		this);
+}
+
+void ConversionGroup::stop()
+{
+	if (!conversion_thread_.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(mutex_);
+		interrupt_ = true;
+	}
+	cond_.notify_one();
+
+	conversion_thread_.join();
+}
+
+void ConversionGroup::reset_segments()
+{
+	assert(!conversion_thread_.joinable());
+
+	segments_.clear();
+	logic_data_->clear();
+}
+
+void ConversionGroup::convert_segment(unsigned int ordinal,
+	const vector< shared_ptr<AnalogSegment> > &asegments,
+	vector<float> &fbuffer, vector<uint8_t> &lbuffer)
+{
+	// Only as many bytes as the highest bit in use needs
+	const unsigned int unit_size = (bits_.back() + 8) / 8;
+
+	uint64_t end_sample = UINT64_MAX;
+	for (const shared_ptr<AnalogSegment> &asegment : asegments)
+		end_sample = min(end_sample, asegment->get_sample_count());
+
+	// Create the logic segment if needed
+	if (ordinal >= segments_.size()) {
+		shared_ptr<LogicSegment> lsegment = make_shared<LogicSegment>(
+			*logic_data_.get(), unit_size, asegments.front()->samplerate());
+		logic_data_->push_segment(lsegment);
+		segments_.push_back(ConvertedSegment{lsegment,
+			vector<uint8_t>(bits_.size(), 0)});
+	}
+
+	ConvertedSegment &converted = segments_[ordinal];
+	const shared_ptr<LogicSegment> &lsegment = converted.segment;
+
+	const uint64_t start_sample = lsegment->get_sample_count();
+	if (start_sample >= end_sample)
+		return;  // Nothing to do
+
+	vector< std::pair<float, float> > ranges;
+	for (const shared_ptr<AnalogSegment> &asegment : asegments)
+		ranges.push_back(asegment->get_min_max());
+
+	uint64_t i = start_sample;
+
+	while ((i < end_sample) && !interrupt_) {
+		// Convert straight into the free space of the logic segment
+		uint64_t space;
+		uint8_t *const dest = lsegment->begin_append(space);
+		const uint64_t count = min(min(end_sample - i, ConversionBlockSize),
+			space);
+
+		memset(dest, 0, count * unit_size);
+
+		for (unsigned int m = 0; m < bits_.size(); m++) {
+			asegments[m]->get_samples(i, i + count, fbuffer.data());
+
+			SignalBase::convert_a2l((SignalBase::ConversionType)types_[m],
+				ranges[m].first, ranges[m].second, fbuffer.data(),
+				lbuffer.data(), count, converted.schmitt_states[m]);
+
+			// Merge the levels into the member's bit
+			uint8_t *d = dest + (bits_[m] / 8);
+			const unsigned int shift = bits_[m] % 8;
+			for (uint64_t j = 0; j < count; j++, d += unit_size)
+				*d |= lbuffer[j] << shift;
+		}
+
+		lsegment->end_append(count);
+		i += count;
+	}
+
+	logic_data_->notify_samples_added(lsegment.get(), start_sample, i);
+}
+
+void ConversionGroup::conversion_thread_proc()
+{
+	vector<float> fbuffer(ConversionBlockSize);
+	vector<uint8_t> lbuffer(ConversionBlockSize);
+
+	// Without analog data for every member there is nothing to convert
+	const bool convertible = !bits_.empty() &&
+		none_of(data_.begin(), data_.end(),
+			[](const shared_ptr<Analog> &d) { return !d; });
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(mutex_);
+			cond_.wait(lock, [&] { return interrupt_ || pending_; });
+
+			if (interrupt_)
+				return;
+
+			pending_ = false;
+		}
+
+		if (!convertible)
+			continue;
+
+		// Only segments that all members have can be converted
+		const vector< vector< shared_ptr<AnalogSegment> > > segments =
+			Analog::common_segments(data_);
+
+		for (size_t ordinal = 0; (ordinal < segments.size()) && !interrupt_;
+			ordinal++)
+			convert_segment(ordinal, segments[ordinal], fbuffer, lbuffer);
+	}
+}
+
+} // namespace data
+} // namespace pv
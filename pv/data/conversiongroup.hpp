@@ -0,0 +1,154 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_CONVERSIONGROUP_HPP
+#define PULSEVIEW_PV_DATA_CONVERSIONGROUP_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::atomic;
+using std::condition_variable;
+using std::mutex;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+class Analog;
+class AnalogSegment;
+class Logic;
+class LogicSegment;
+class SignalBase;
+
+/**
+ * Converts several analog channels to logic and packs the results into the
+ * bits of one multi-channel Logic data object.
+ *
+ * Compared to converting every channel into its own single-channel Logic,
+ * this stores eight converted samples per byte, shares one mip-map among
+ * all members and allows the converted channels to be fed into protocol
+ * decoders as one bus.
+ *
+ * Each member is assigned the lowest free bit when it is added and keeps
+ * it until it is removed. Whenever the membership or the conversion type
+ * of a member changes, all samples are converted again into the same
+ * logic data object, so that the signals and decoders that use it stay
+ * connected.
+ */
+class ConversionGroup
+{
+public:
+	static const unsigned int MaxChannels;
+
+private:
+	static const uint64_t ConversionBlockSize;
+
+	struct ConvertedSegment
+	{
+		shared_ptr<LogicSegment> segment;
+		vector<uint8_t> schmitt_states;  // One per member
+	};
+
+public:
+	ConversionGroup();
+	~ConversionGroup();
+
+	/**
+	 * Returns the logic data that holds the packed conversion results.
+	 */
+	shared_ptr<Logic> logic_data() const;
+
+	/**
+	 * Adds a signal to the group.
+	 * @return false if the group is full.
+	 */
+	bool add(SignalBase *member);
+
+	/**
+	 * Removes a signal from the group.
+	 */
+	void remove(SignalBase *member);
+
+	/**
+	 * Converts the samples of a member again, e.g. after its conversion
+	 * type changed.
+	 */
+	void update(SignalBase *member);
+
+	/**
+	 * Returns the bit the given member is packed into.
+	 */
+	unsigned int bit_index(const SignalBase *member) const;
+
+	/**
+	 * Makes the worker convert whatever samples of the members' analog
+	 * data have not been converted yet.
+	 */
+	void queue_conversion();
+
+	/**
+	 * Discards all converted data.
+	 */
+	void clear();
+
+private:
+	void start();
+	void stop();
+
+	/**
+	 * Discards the converted samples so that they are converted again.
+	 */
+	void reset_segments();
+
+	void convert_segment(unsigned int ordinal,
+		const vector< shared_ptr<AnalogSegment> > &asegments,
+		vector<float> &fbuffer, vector<uint8_t> &lbuffer);
+
+	void conversion_thread_proc();
+
+private:
+	/// The members by bit, nullptr for free bits. Only changed while the
+	/// worker is stopped.
+	vector<SignalBase*> members_;
+
+	/// The bits of the members, their data and conversion types as of
+	/// the last start of the worker.
+	vector<unsigned int> bits_;
+	vector< shared_ptr<Analog> > data_;
+	vector<int> types_;
+
+	const shared_ptr<Logic> logic_data_;
+	vector<ConvertedSegment> segments_;
+
+	std::thread conversion_thread_;
+	mutable mutex mutex_;
+	condition_variable cond_;
+	bool pending_;
+	atomic<bool> interrupt_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CONVERSIONGROUP_HPP
@@ -0,0 +1,271 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cstring>
+
+#include "csvimporter.hpp"
+#include "textscan.hpp"
+
+using std::min;
+
+namespace pv {
+namespace data {
+
+namespace ts = textscan;
+
+namespace {
+
+const char* line_end(const char *p, const char *end)
+{
+	const char *const eol = (const char*)memchr(p, '\n', end - p);
+	return eol ? eol : end;
+}
+
+bool is_comment_or_empty(const char *p, const char *eol)
+{
+	while (p != eol && ts::is_space(*p))
+		p++;
+	return p == eol || *p == ';' || *p == '#';
+}
+
+bool is_number(const string &field)
+{
+	double value;
+	const char *const begin = field.data(), *const end = begin + field.size();
+	return field.empty() || ts::parse_double(begin, end, value) == end;
+}
+
+} // namespace
+
+CsvImporter::CsvImporter(double samplerate) :
+	delimiter_(',')
+{
+	samplerate_ = samplerate;
+}
+
+bool CsvImporter::parse_header(const char *begin, const char *end,
+	const char *&body)
+{
+	// Find the first line that holds data or column names
+	const char *p = begin;
+	while (p != end && is_comment_or_empty(p, line_end(p, end)))
+		p = min(line_end(p, end) + 1, end);
+
+	if (p == end) {
+		error_ = "The file contains no values";
+		return false;
+	}
+
+	const char *eol = line_end(p, end);
+
+	if (!memchr(p, ',', eol - p)) {
+		if (memchr(p, ';', eol - p))
+			delimiter_ = ';';
+		else if (memchr(p, '\t', eol - p))
+			delimiter_ = '\t';
+	}
+
+	const vector<string> first = split_line(p, eol);
+	const bool has_names = !std::all_of(first.begin(), first.end(), is_number);
+
+	body = has_names ? min(eol + 1, end) : p;
+
+	// Inspect all lines to tell logic from analog columns, as a column
+	// that only leaves 0 and 1 late in the file would otherwise have its
+	// values cut to bits. The scan ends once every column is analog.
+	vector<bool> binary(first.size(), true);
+	size_t binary_count = binary.size();
+	vector<double> times;
+
+	for (p = body; p != end && (binary_count > 0 || times.size() < 2);
+		p = min(eol + 1, end)) {
+		eol = line_end(p, end);
+		if (is_comment_or_empty(p, eol))
+			continue;
+
+		const char *f = p;
+		for (size_t c = 0; c < binary.size(); c++) {
+			while (f != eol && (*f == ' ' || *f == '"'))
+				f++;
+
+			double value = 0;
+			f = ts::parse_double(f, eol, value);
+
+			if (binary[c] && value != 0 && value != 1) {
+				binary[c] = false;
+				binary_count--;
+			}
+			if (c == 0 && times.size() < 2)
+				times.push_back(value);
+
+			while (f != eol && *f != delimiter_)
+				f++;
+			if (f == eol)
+				break;
+			f++;
+		}
+	}
+
+	string first_name = has_names ? first.front() : string();
+	std::transform(first_name.begin(), first_name.end(), first_name.begin(),
+		::tolower);
+	const bool has_time = (first.size() > 1) &&
+		(first_name == "t" || first_name.compare(0, 4, "time") == 0);
+
+	if (has_time && samplerate_ == 0 && times.size() == 2 &&
+		times[1] > times[0])
+		samplerate_ = 1 / (times[1] - times[0]);
+
+	// Logic channels come first, so number them in a first pass
+	columns_.assign(first.size(), Column{Column::Skip, 0});
+	unsigned int logic_count = 0, analog_count = 0;
+
+	for (size_t c = has_time ? 1 : 0; c < first.size(); c++) {
+		if (binary[c] && logic_count < MaxLogicChannels)
+			columns_[c] = Column{Column::Logic, logic_count++};
+		else
+			columns_[c] = Column{Column::Analog, analog_count++};
+	}
+
+	for (const bool analog : {false, true})
+		for (size_t c = 0; c < columns_.size(); c++) {
+			if (columns_[c].kind != (analog ? Column::Analog : Column::Logic))
+				continue;
+
+			add_channel(has_names && !first[c].empty() ? first[c] :
+				"CH" + std::to_string(c + 1), analog);
+		}
+
+	return true;
+}
+
+unique_ptr<TextImporter::Piece> CsvImporter::create_piece() const
+{
+	CsvPiece *const piece = new CsvPiece;
+	piece->analog.resize(analog_channel_count());
+	return unique_ptr<Piece>(piece);
+}
+
+void CsvImporter::parse_piece(Piece &piece) const
+{
+	CsvPiece &csv = static_cast<CsvPiece&>(piece);
+	const unsigned int logic_unit_size = unit_size();
+	const bool has_logic = logic_channel_count() > 0;
+	vector<float> analog(csv.analog.size());
+
+	csv.line_count = 0;
+
+	const char *p = csv.begin;
+	const char *const end = csv.end;
+
+	while (p != end) {
+		if (*p == '\n' || *p == '\r' || *p == ';' || *p == '#') {
+			p = (*p == '\n' || *p == '\r') ? (p + 1) :
+				min(line_end(p, end) + 1, end);
+			continue;
+		}
+
+		uint64_t bits = 0;
+		std::fill(analog.begin(), analog.end(), 0.0f);
+
+		for (size_t c = 0; p != end; c++) {
+			while (p != end && (*p == ' ' || *p == '"'))
+				p++;
+
+			double value = 0;
+			p = ts::parse_double(p, end, value);
+
+			// Skip whatever follows the number up to the next field
+			while (p != end && *p != delimiter_ && *p != '\n')
+				p++;
+
+			if (c < columns_.size()) {
+				const Column &col = columns_[c];
+				if (col.kind == Column::Logic && value != 0)
+					bits |= 1ULL << col.index;
+				else if (col.kind == Column::Analog)
+					analog[col.index] = value;
+			}
+
+			if (p == end || *p == '\n')
+				break;
+			p++;
+		}
+
+		if (p != end)
+			p++;
+
+		if (has_logic)
+			for (unsigned int i = 0; i < logic_unit_size; i++)
+				csv.logic.push_back(bits >> (i * 8));
+		for (size_t i = 0; i < analog.size(); i++)
+			csv.analog[i].push_back(analog[i]);
+
+		csv.line_count++;
+	}
+}
+
+void CsvImporter::emit_piece(Piece &piece, const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	CsvPiece &csv = static_cast<CsvPiece&>(piece);
+
+	if (csv.line_count == 0)
+		return;
+
+	if (!csv.logic.empty())
+		logic_sink(csv.logic.data(), csv.line_count);
+	for (size_t i = 0; i < csv.analog.size(); i++)
+		analog_sink(i, csv.analog[i].data(), csv.line_count);
+
+	// Keep the capacity for the next batch
+	csv.logic.clear();
+	for (vector<float> &a : csv.analog)
+		a.clear();
+}
+
+vector<string> CsvImporter::split_line(const char *begin,
+	const char *end) const
+{
+	vector<string> fields;
+
+	while (true) {
+		const char *const next =
+			(const char*)memchr(begin, delimiter_, end - begin);
+		const char *field_end = next ? next : end;
+
+		const char *b = begin;
+		while (b != field_end && (ts::is_space(*b) || *b == '"'))
+			b++;
+		while (field_end != b &&
+			(ts::is_space(field_end[-1]) || field_end[-1] == '"'))
+			field_end--;
+
+		fields.emplace_back(b, field_end);
+
+		if (!next)
+			break;
+		begin = next + 1;
+	}
+
+	return fields;
+}
+
+} // namespace data
+} // namespace pv
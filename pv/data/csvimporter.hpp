@@ -0,0 +1,84 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DATA_CSVIMPORTER_HPP
+#define PULSEVIEW_PV_DATA_CSVIMPORTER_HPP
+
+#include "textimporter.hpp"
+
+namespace pv {
+namespace data {
+
+/**
+ * Imports comma separated values, one sample per line.
+ *
+ * An optional first line of column names is detected automatically, as
+ * are ';' and tab delimiters. Columns that only hold 0 and 1 become logic
+ * channels, all others become analog channels. A first column named
+ * "time" gives the sample rate, the samples are assumed to be evenly
+ * spaced. Lines starting with ';' or '#' are comments.
+ */
+class CsvImporter final : public TextImporter
+{
+private:
+	struct Column
+	{
+		enum Kind { Skip, Logic, Analog };
+
+		Kind kind;
+		unsigned int index;  // The logic bit or analog channel index
+	};
+
+	struct CsvPiece : public Piece
+	{
+		uint64_t line_count;
+		vector<uint8_t> logic;
+		vector< vector<float> > analog;
+	};
+
+public:
+	/**
+	 * Constructor.
+	 * @param samplerate The sample rate to use, or 0 to take it from the
+	 * time column if there is one.
+	 */
+	CsvImporter(double samplerate = 0);
+
+private:
+	bool parse_header(const char *begin, const char *end, const char *&body);
+
+	unique_ptr<Piece> create_piece() const;
+
+	void parse_piece(Piece &piece) const;
+
+	void emit_piece(Piece &piece, const LogicSink &logic_sink,
+		const AnalogSink &analog_sink);
+
+	/**
+	 * Splits a line into its fields, without quotes and surrounding
+	 * white space.
+	 */
+	vector<string> split_line(const char *begin, const char *end) const;
+
+private:
+	char delimiter_;
+	vector<Column> columns_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_CSVIMPORTER_HPP
@@ -135,7 +135,7 @@ srd_decoder_inst* Decoder::create_decoder_inst(srd_session *session) const
 
 	for (const auto& channel : channels_) {
 		shared_ptr<data::SignalBase> b(channel.second);
-		GVariant *const gvar = g_variant_new_int32(b->index());
+		GVariant *const gvar = g_variant_new_int32(b->logic_bit_index());
 		g_variant_ref_sink(gvar);
 		g_hash_table_insert(channels, channel.first->id, gvar);
 	}
@@ -50,6 +50,7 @@ LogicSegment::LogicSegment(pv::data::Logic& owner, unsigned int unit_size,
 	uint64_t samplerate) :
 	Segment(samplerate, unit_size),
 	owner_(owner),
+	mip_map_mapped_(false),
 	last_append_sample_(0)
 {
 	memset(mip_map_, 0, sizeof(mip_map_));
@@ -58,6 +59,10 @@ LogicSegment::LogicSegment(pv::data::Logic& owner, unsigned int unit_size,
 LogicSegment::~LogicSegment()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
+
+	if (mip_map_mapped_)
+		return;
+
 	for (MipMapLevel &l : mip_map_)
 		free(l.data);
 }
@@ -150,7 +155,6 @@ void LogicSegment::append_payload(void *data, uint64_t data_size)
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	uint64_t prev_sample_count = sample_count_;
 	uint64_t sample_count = data_size / unit_size_;
 
 	append_samples(data, sample_count);
@@ -158,12 +162,8 @@ void LogicSegment::append_payload(void *data, uint64_t data_size)
 	// Generate the first mip-map from the data
 	append_payload_to_mipmap();
 
-	if (sample_count > 1)
-		owner_.notify_samples_added(this, prev_sample_count + 1,
-			prev_sample_count + 1 + sample_count);
-	else
-		owner_.notify_samples_added(this, prev_sample_count + 1,
-			prev_sample_count + 1);
+	// Listeners are notified by whoever appends the data, which allows
+	// the notifications of several appends to be coalesced
 }
 
 const uint8_t* LogicSegment::get_samples(int64_t start_sample,
@@ -180,6 +180,101 @@ const uint8_t* LogicSegment::get_samples(int64_t start_sample,
 	return get_raw_samples(start_sample, (end_sample - start_sample));
 }
 
+uint8_t* LogicSegment::begin_append(uint64_t &max_samples)
+{
+	return begin_raw_append(max_samples);
+}
+
+void LogicSegment::end_append(uint64_t sample_count)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	end_raw_append(sample_count);
+
+	append_payload_to_mipmap();
+}
+
+void LogicSegment::map_payload(shared_ptr<const void> storage,
+	const vector<Extent> &extents,
+	const vector< pair<const void*, uint64_t> > &levels)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	map_samples(storage, extents);
+	const uint64_t sample_count = sample_count_;
+
+	// Only use the stored levels if they have exactly the layout that
+	// append_payload_to_mipmap() would have produced
+	unsigned int level_count = 0;
+	bool usable = true;
+
+	for (uint64_t length = sample_count / MipMapScaleFactor;
+		length > 0 && level_count < ScaleStepCount;
+		length /= MipMapScaleFactor, level_count++)
+		if (level_count >= levels.size() ||
+			levels[level_count].second != length * unit_size_)
+			usable = false;
+
+	if (!usable) {
+		append_payload_to_mipmap();
+		return;
+	}
+
+	uint64_t length = sample_count;
+	for (unsigned int level = 0; level < level_count; level++) {
+		length /= MipMapScaleFactor;
+
+		MipMapLevel &m = mip_map_[level];
+		m.length = m.data_length = length;
+		m.data = const_cast<void*>(levels[level].first);
+	}
+
+	mip_map_mapped_ = true;
+}
+
+const void* LogicSegment::mipmap_level(unsigned int level,
+	uint64_t &length) const
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	if (level >= ScaleStepCount || !mip_map_[level].data ||
+		mip_map_[level].length == 0) {
+		length = 0;
+		return nullptr;
+	}
+
+	length = mip_map_[level].length * unit_size_;
+	return mip_map_[level].data;
+}
+
+uint64_t LogicSegment::get_mipmap_samples(unsigned int level,
+	uint64_t start, vector<uint64_t> &dest) const
+{
+	assert(level < ScaleStepCount);
+
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	const MipMapLevel &m = mip_map_[level];
+	if (!m.data || start >= m.length)
+		return m.length;
+
+	const uint8_t *ptr = (const uint8_t*)m.data + start * unit_size_;
+	for (uint64_t i = start; i < m.length; i++, ptr += unit_size_)
+		dest.push_back(unpack_sample(ptr));
+
+	return m.length;
+}
+
+uint64_t LogicSegment::mipmap_scale(unsigned int level)
+{
+	return (uint64_t)1 << ((level + 1) * MipMapScalePower);
+}
+
+unsigned int LogicSegment::mipmap_level_count()
+{
+	return ScaleStepCount;
+}
+
 SegmentLogicDataIterator* LogicSegment::begin_sample_iteration(uint64_t start)
 {
 	return (SegmentLogicDataIterator*)begin_raw_sample_iteration(start);
@@ -86,6 +86,66 @@ public:
 
 	const uint8_t* get_samples(int64_t start_sample, int64_t end_sample) const;
 
+	/**
+	 * Gives access to the free space at the end of the segment so that
+	 * samples can be generated in place rather than appended as a copy.
+	 * Only one thread may append to a segment at a time.
+	 * @param[out] max_samples The number of samples that fit into the
+	 * returned space. Always at least 1.
+	 *
+	 * @return A pointer to where the next sample is to be stored.
+	 */
+	uint8_t* begin_append(uint64_t &max_samples);
+
+	/**
+	 * Adds the samples that were written to the space returned by
+	 * begin_append() to the segment and updates the mip-map.
+	 * @param sample_count The number of samples that were written.
+	 */
+	void end_append(uint64_t sample_count);
+
+	/**
+	 * Makes the segment use samples and a mip-map that are kept in storage
+	 * it doesn't own, e.g. a memory-mapped capture file. If the stored
+	 * levels don't match the sample count, the mip-map is generated from
+	 * the samples instead.
+	 * @param storage Keeps the storage alive while the segment uses it.
+	 * @param extents The samples in order, see Segment::map_samples().
+	 * @param levels The start and length in bytes of the stored mip-map
+	 * levels, finest first.
+	 */
+	void map_payload(shared_ptr<const void> storage,
+		const vector<Extent> &extents,
+		const vector< pair<const void*, uint64_t> > &levels);
+
+	/**
+	 * Gives access to a level of the mip-map, e.g. to store it.
+	 * @param[out] length The length of the level in bytes.
+	 * @return The level, or nullptr if the segment has too few samples
+	 * for it.
+	 */
+	const void* mipmap_level(unsigned int level, uint64_t &length) const;
+
+	/**
+	 * Copies the samples of a level of the mip-map from @c start to the
+	 * end of the level. Each sample is a mask of the channels that change
+	 * within the samples it covers.
+	 * @param[out] dest The vector the samples are appended to.
+	 * @return The length of the level in samples.
+	 */
+	uint64_t get_mipmap_samples(unsigned int level, uint64_t start,
+		vector<uint64_t> &dest) const;
+
+	/**
+	 * Returns the number of samples a sample of a mip-map level covers.
+	 */
+	static uint64_t mipmap_scale(unsigned int level);
+
+	/**
+	 * Returns the number of levels of the mip-map.
+	 */
+	static unsigned int mipmap_level_count();
+
 	SegmentLogicDataIterator* begin_sample_iteration(uint64_t start);
 	void continue_sample_iteration(SegmentLogicDataIterator* it, uint64_t increase);
 	void end_sample_iteration(SegmentLogicDataIterator* it);
@@ -124,6 +184,7 @@ private:
 	Logic& owner_;
 
 	struct MipMapLevel mip_map_[ScaleStepCount];
+	bool mip_map_mapped_;
 	uint64_t last_append_sample_;
 
 	friend struct LogicSegmentTest::Pow2;
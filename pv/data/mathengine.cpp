@@ -0,0 +1,186 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "analog.hpp"
+#include "analogsegment.hpp"
+#include "mathengine.hpp"
+
+using std::lock_guard;
+using std::make_shared;
+using std::min;
+using std::unique_lock;
+
+namespace pv {
+namespace data {
+
+const uint64_t MathEngine::BlockSize = 4096;
+
+MathEngine::MathEngine(const QString &text, const MathExpression &expression,
+	const vector< shared_ptr<Analog> > &inputs) :
+	text_(text),
+	expression_(expression),
+	inputs_(inputs),
+	output_(make_shared<Analog>()),
+	pending_(false),
+	interrupt_(false)
+{
+	assert(inputs_.size() >= expression_.input_count());
+
+	for (const shared_ptr<Analog> &input : inputs_) {
+		connect(input.get(), SIGNAL(samples_added(QObject*, uint64_t, uint64_t)),
+			this, SLOT(on_input_samples_added()));
+		connect(input.get(), SIGNAL(samples_cleared()),
+			this, SLOT(on_input_samples_cleared()));
+	}
+
+	start();
+}
+
+MathEngine::~MathEngine()
+{
+	stop();
+}
+
+QString MathEngine::expression() const
+{
+	return text_;
+}
+
+shared_ptr<Analog> MathEngine::output() const
+{
+	return output_;
+}
+
+void MathEngine::start()
+{
+	assert(!compute_thread_.joinable());
+
+	interrupt_ = false;
+	pending_ = true;  // Compute the samples that are already there
+	compute_thread_ = std::thread(&MathEngine::compute_thread_proc, this);
+}
+
+void MathEngine::stop()
+{
+	if (!compute_thread_.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(mutex_);
+		interrupt_ = true;
+	}
+	cond_.notify_one();
+
+	compute_thread_.join();
+}
+
+void MathEngine::compute_segment(unsigned int ordinal,
+	const vector< shared_ptr<AnalogSegment> > &isegments,
+	vector< vector<float> > &buffers, vector<float> &result)
+{
+	uint64_t end_sample = UINT64_MAX;
+	for (const shared_ptr<AnalogSegment> &isegment : isegments)
+		end_sample = min(end_sample, isegment->get_sample_count());
+
+	const uint64_t samplerate = isegments.front()->samplerate();
+
+	// Create the output segment if needed
+	if (ordinal >= segments_.size()) {
+		shared_ptr<AnalogSegment> segment =
+			make_shared<AnalogSegment>(*output_.get(), samplerate);
+		output_->push_segment(segment);
+		segments_.push_back(OutputSegment{segment,
+			expression_.create_context(BlockSize)});
+	}
+
+	OutputSegment &output = segments_[ordinal];
+
+	const uint64_t start_sample = output.segment->get_sample_count();
+	if (start_sample >= end_sample)
+		return;  // Nothing to do
+
+	vector<const float*> ptrs;
+	for (const vector<float> &b : buffers)
+		ptrs.push_back(b.data());
+
+	uint64_t i = start_sample;
+
+	while ((i < end_sample) && !interrupt_) {
+		const uint64_t count = min(end_sample - i, BlockSize);
+
+		for (unsigned int n = 0; n < isegments.size(); n++)
+			isegments[n]->get_samples(i, i + count, buffers[n].data());
+
+		expression_.evaluate(output.context, ptrs, result.data(), count,
+			samplerate);
+
+		output.segment->append_interleaved_samples(result.data(), count, 1);
+		i += count;
+	}
+
+	output_->notify_samples_added(output.segment.get(), start_sample, i);
+}
+
+void MathEngine::compute_thread_proc()
+{
+	vector< vector<float> > buffers(inputs_.size(), vector<float>(BlockSize));
+	vector<float> result(BlockSize);
+
+	while (true) {
+		{
+			unique_lock<mutex> lock(mutex_);
+			cond_.wait(lock, [&] { return interrupt_ || pending_; });
+
+			if (interrupt_)
+				return;
+
+			pending_ = false;
+		}
+
+		// Only segments that all inputs have can be computed
+		const vector< vector< shared_ptr<AnalogSegment> > > segments =
+			Analog::common_segments(inputs_);
+
+		for (size_t ordinal = 0; (ordinal < segments.size()) && !interrupt_;
+			ordinal++)
+			compute_segment(ordinal, segments[ordinal], buffers, result);
+	}
+}
+
+void MathEngine::on_input_samples_added()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		pending_ = true;
+	}
+	cond_.notify_one();
+}
+
+void MathEngine::on_input_samples_cleared()
+{
+	// Restart the worker so that it can't touch the discarded segments
+	stop();
+	segments_.clear();
+	output_->clear();
+	start();
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,117 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_MATHENGINE_HPP
+#define PULSEVIEW_PV_DATA_MATHENGINE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QObject>
+#include <QString>
+
+#include "mathexpression.hpp"
+
+using std::atomic;
+using std::condition_variable;
+using std::mutex;
+using std::shared_ptr;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+class Analog;
+class AnalogSegment;
+
+/**
+ * Computes the samples of a math channel from the analog data of its input
+ * channels.
+ *
+ * The expression is evaluated in a worker thread, block by block, whenever
+ * samples are added to the inputs, so that the output keeps up with a
+ * running acquisition. The output is a regular Analog data object whose
+ * segments correspond to the segments of the inputs.
+ */
+class MathEngine : public QObject
+{
+	Q_OBJECT
+
+private:
+	static const uint64_t BlockSize;
+
+	struct OutputSegment
+	{
+		shared_ptr<AnalogSegment> segment;
+		MathExpression::Context context;
+	};
+
+public:
+	/**
+	 * Constructor.
+	 * @param text The source text of the expression.
+	 * @param expression The compiled expression.
+	 * @param inputs The input data, in the order the expression
+	 * refers to them.
+	 */
+	MathEngine(const QString &text, const MathExpression &expression,
+		const vector< shared_ptr<Analog> > &inputs);
+
+	~MathEngine();
+
+	QString expression() const;
+
+	shared_ptr<Analog> output() const;
+
+private:
+	void start();
+	void stop();
+
+	void compute_segment(unsigned int ordinal,
+		const vector< shared_ptr<AnalogSegment> > &isegments,
+		vector< vector<float> > &buffers, vector<float> &result);
+
+	void compute_thread_proc();
+
+private Q_SLOTS:
+	void on_input_samples_added();
+
+	void on_input_samples_cleared();
+
+private:
+	const QString text_;
+	const MathExpression expression_;
+	const vector< shared_ptr<Analog> > inputs_;
+	const shared_ptr<Analog> output_;
+
+	vector<OutputSegment> segments_;
+
+	std::thread compute_thread_;
+	mutex mutex_;
+	condition_variable cond_;
+	bool pending_;
+	atomic<bool> interrupt_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_MATHENGINE_HPP
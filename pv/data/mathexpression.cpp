@@ -0,0 +1,547 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+#include "mathexpression.hpp"
+#include "textscan.hpp"
+
+using std::fill;
+using std::max;
+
+namespace pv {
+namespace data {
+
+/**
+ * A recursive descent parser that emits the program of the expression
+ * in postfix order.
+ */
+class MathExpression::Parser
+{
+public:
+	Parser(MathExpression &expression, const string &text,
+		InputResolver resolver) :
+		expression_(expression),
+		text_(text),
+		resolver_(resolver),
+		pos_(0)
+	{
+	}
+
+	bool parse(string &error)
+	{
+		if (!parse_sum())
+			return fail(error);
+
+		skip_space();
+		if (pos_ != text_.size()) {
+			error_ = "Unexpected '" + text_.substr(pos_, 1) + "'";
+			return fail(error);
+		}
+
+		return true;
+	}
+
+private:
+	bool fail(string &error)
+	{
+		error = error_;
+		return false;
+	}
+
+	void skip_space()
+	{
+		while (pos_ < text_.size() && isspace((unsigned char)text_[pos_]))
+			pos_++;
+	}
+
+	bool accept(char c)
+	{
+		skip_space();
+		if (pos_ < text_.size() && text_[pos_] == c) {
+			pos_++;
+			return true;
+		}
+		return false;
+	}
+
+	bool expect(char c)
+	{
+		if (accept(c))
+			return true;
+
+		error_ = string("Expected '") + c + "'";
+		return false;
+	}
+
+	// sum := product (('+' | '-') product)*
+	bool parse_sum()
+	{
+		if (!parse_product())
+			return false;
+
+		while (true) {
+			if (accept('+')) {
+				if (!parse_product())
+					return false;
+				expression_.emit(Add);
+			} else if (accept('-')) {
+				if (!parse_product())
+					return false;
+				expression_.emit(Subtract);
+			} else
+				return true;
+		}
+	}
+
+	// product := unary (('*' | '/') unary)*
+	bool parse_product()
+	{
+		if (!parse_unary())
+			return false;
+
+		while (true) {
+			if (accept('*')) {
+				if (!parse_unary())
+					return false;
+				expression_.emit(Multiply);
+			} else if (accept('/')) {
+				if (!parse_unary())
+					return false;
+				expression_.emit(Divide);
+			} else
+				return true;
+		}
+	}
+
+	// unary := ('-' | '+') unary | primary
+	bool parse_unary()
+	{
+		if (accept('-')) {
+			if (!parse_unary())
+				return false;
+			expression_.emit(Negate);
+			return true;
+		}
+
+		if (accept('+'))
+			return parse_unary();
+
+		return parse_primary();
+	}
+
+	// primary := number | name | function '(' args ')' | '(' sum ')'
+	bool parse_primary()
+	{
+		skip_space();
+
+		if (pos_ == text_.size()) {
+			error_ = "Unexpected end of expression";
+			return false;
+		}
+
+		const char c = text_[pos_];
+
+		if (accept('('))
+			return parse_sum() && expect(')');
+
+		if (isdigit((unsigned char)c) || c == '.')
+			return parse_number();
+
+		if (c == '"') {
+			const size_t end = text_.find('"', pos_ + 1);
+			if (end == string::npos) {
+				error_ = "Unterminated channel name";
+				return false;
+			}
+
+			const string name = text_.substr(pos_ + 1, end - pos_ - 1);
+			pos_ = end + 1;
+			return push_input(name);
+		}
+
+		if (isalpha((unsigned char)c) || c == '_') {
+			const size_t start = pos_;
+			while (pos_ < text_.size() &&
+				(isalnum((unsigned char)text_[pos_]) ||
+				text_[pos_] == '_' || text_[pos_] == '.'))
+				pos_++;
+
+			const string name = text_.substr(start, pos_ - start);
+
+			if (accept('('))
+				return parse_function(name);
+
+			return push_input(name);
+		}
+
+		error_ = string("Unexpected '") + c + "'";
+		return false;
+	}
+
+	bool parse_number()
+	{
+		// Unlike strtod(), this doesn't depend on the locale's decimal
+		// separator
+		const char *const begin = text_.c_str() + pos_;
+		double value;
+		const char *const end = textscan::parse_double(begin,
+			text_.c_str() + text_.size(), value);
+
+		if (end == begin) {
+			error_ = "Invalid number";
+			return false;
+		}
+
+		pos_ += end - begin;
+		expression_.emit(PushConstant, 0, value);
+		return true;
+	}
+
+	bool push_input(const string &name)
+	{
+		const int index = resolver_ ? resolver_(name) : -1;
+
+		if (index < 0) {
+			error_ = "Unknown channel \"" + name + "\"";
+			return false;
+		}
+
+		expression_.emit(PushInput, index);
+		return true;
+	}
+
+	bool parse_constant_argument(double &value)
+	{
+		if (!expect(',') || !parse_sum())
+			return false;
+
+		if (!expression_.pop_constant(value)) {
+			error_ = "Expected a constant argument";
+			return false;
+		}
+
+		return true;
+	}
+
+	bool parse_function(const string &name)
+	{
+		if (!parse_sum())
+			return false;
+
+		if (name == "abs") {
+			expression_.emit(Abs);
+		} else if (name == "scale") {
+			double k;
+			if (!parse_constant_argument(k))
+				return false;
+			expression_.emit(PushConstant, 0, k);
+			expression_.emit(Multiply);
+		} else if (name == "lowpass") {
+			double f;
+			if (!parse_constant_argument(f))
+				return false;
+			if (f <= 0) {
+				error_ = "The cut-off frequency must be positive";
+				return false;
+			}
+			expression_.emit(LowPass, 0, f);
+		} else if (name == "integrate") {
+			expression_.emit(Integrate);
+		} else if (name == "derivative") {
+			expression_.emit(Derivative);
+		} else {
+			error_ = "Unknown function \"" + name + "\"";
+			return false;
+		}
+
+		return expect(')');
+	}
+
+private:
+	MathExpression &expression_;
+	const string &text_;
+	InputResolver resolver_;
+	size_t pos_;
+	string error_;
+};
+
+MathExpression::MathExpression() :
+	input_count_(0),
+	state_count_(0),
+	max_depth_(0)
+{
+}
+
+bool MathExpression::parse(const string &text, InputResolver resolver,
+	string &error)
+{
+	program_.clear();
+	input_count_ = 0;
+	state_count_ = 0;
+	max_depth_ = 0;
+
+	Parser parser(*this, text, resolver);
+	if (!parser.parse(error)) {
+		program_.clear();
+		return false;
+	}
+
+	// Determine the stack depth needed to run the program
+	unsigned int depth = 0;
+	for (const Instruction &i : program_) {
+		if (i.op == PushInput || i.op == PushConstant)
+			max_depth_ = max(max_depth_, ++depth);
+		else if (i.op == Add || i.op == Subtract ||
+			i.op == Multiply || i.op == Divide)
+			depth--;
+	}
+	assert(depth == 1);
+
+	return true;
+}
+
+unsigned int MathExpression::input_count() const
+{
+	return input_count_;
+}
+
+MathExpression::Context MathExpression::create_context(size_t block_size) const
+{
+	Context context;
+	context.state_.assign(state_count_, 0);
+	context.state_valid_.assign(state_count_, false);
+	context.scratch_.resize(max_depth_ * block_size);
+	context.stack_.reserve(max_depth_);
+	context.block_size_ = block_size;
+	return context;
+}
+
+void MathExpression::evaluate(Context &context,
+	const vector<const float*> &inputs, float *out, size_t count,
+	double samplerate) const
+{
+	assert(count <= context.block_size_);
+	assert(inputs.size() >= input_count_);
+	assert(!program_.empty());
+
+	vector<Operand> &stack = context.stack_;
+	stack.clear();
+
+	const double dt = (samplerate > 0) ? (1.0 / samplerate) : 1.0;
+
+	for (const Instruction &ins : program_) {
+		switch (ins.op) {
+		case PushInput:
+			stack.push_back(Operand{inputs[ins.input], 0});
+			break;
+
+		case PushConstant:
+			stack.push_back(Operand{nullptr, (float)ins.constant});
+			break;
+
+		case Add:
+		case Subtract:
+		case Multiply:
+		case Divide:
+		{
+			const Operand b = stack.back();
+			stack.pop_back();
+			Operand &a = stack.back();
+
+			// The result goes into the scratch slot of the left operand,
+			// which is never read after the element it is written to
+			float *const r = slot(context, stack.size() - 1);
+			const float *const x = a.data, *const y = b.data;
+			const float xc = a.constant, yc = b.constant;
+
+			if (ins.op == Add) {
+				if (x && y)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] + y[i];
+				else if (x)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] + yc;
+				else
+					for (size_t i = 0; i < count; i++) r[i] = xc + y[i];
+			} else if (ins.op == Subtract) {
+				if (x && y)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] - y[i];
+				else if (x)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] - yc;
+				else
+					for (size_t i = 0; i < count; i++) r[i] = xc - y[i];
+			} else if (ins.op == Multiply) {
+				if (x && y)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] * y[i];
+				else if (x)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] * yc;
+				else
+					for (size_t i = 0; i < count; i++) r[i] = xc * y[i];
+			} else {
+				if (x && y)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] / y[i];
+				else if (x)
+					for (size_t i = 0; i < count; i++) r[i] = x[i] / yc;
+				else
+					for (size_t i = 0; i < count; i++) r[i] = xc / y[i];
+			}
+
+			a.data = r;
+			break;
+		}
+
+		case Negate:
+		case Abs:
+		case LowPass:
+		case Integrate:
+		case Derivative:
+		{
+			Operand &a = stack.back();
+			float *const r = slot(context, stack.size() - 1);
+
+			// Only the time based operations can see a constant operand,
+			// the others are folded when the program is built
+			if (!a.data) {
+				fill(r, r + count, a.constant);
+				a.data = r;
+			}
+
+			const float *const x = a.data;
+
+			if (ins.op == Negate) {
+				for (size_t i = 0; i < count; i++) r[i] = -x[i];
+			} else if (ins.op == Abs) {
+				for (size_t i = 0; i < count; i++) r[i] = fabsf(x[i]);
+			} else if (ins.op == LowPass) {
+				double &state = context.state_[ins.state_index];
+				const double rc = 1.0 / (2 * M_PI * ins.constant);
+				const double alpha = dt / (rc + dt);
+				if (!context.state_valid_[ins.state_index] && count > 0) {
+					state = x[0];
+					context.state_valid_[ins.state_index] = true;
+				}
+				double y = state;
+				for (size_t i = 0; i < count; i++)
+					r[i] = y += alpha * (x[i] - y);
+				state = y;
+			} else if (ins.op == Integrate) {
+				double &state = context.state_[ins.state_index];
+				double sum = state;
+				for (size_t i = 0; i < count; i++)
+					r[i] = sum += x[i] * dt;
+				state = sum;
+			} else {
+				double &state = context.state_[ins.state_index];
+				if (!context.state_valid_[ins.state_index] && count > 0) {
+					state = x[0];
+					context.state_valid_[ins.state_index] = true;
+				}
+				double prev = state;
+				for (size_t i = 0; i < count; i++) {
+					const double v = x[i];  // r may alias x
+					r[i] = (v - prev) / dt;
+					prev = v;
+				}
+				state = prev;
+			}
+
+			a.data = r;
+			break;
+		}
+		}
+	}
+
+	assert(stack.size() == 1);
+	const Operand &result = stack.back();
+
+	if (result.data)
+		memcpy(out, result.data, count * sizeof(float));
+	else
+		fill(out, out + count, result.constant);
+}
+
+void MathExpression::emit(OpCode op, unsigned int input, double constant)
+{
+	const size_t n = program_.size();
+
+	// Fold operations on constants
+	if (op == Negate && n >= 1 && program_[n - 1].op == PushConstant) {
+		program_[n - 1].constant = -program_[n - 1].constant;
+		return;
+	}
+
+	if ((op == Add || op == Subtract || op == Multiply || op == Divide) &&
+		n >= 2 && program_[n - 1].op == PushConstant &&
+		program_[n - 2].op == PushConstant) {
+		const double b = program_[n - 1].constant;
+		double &a = program_[n - 2].constant;
+		program_.pop_back();
+
+		switch (op) {
+		case Add: a += b; break;
+		case Subtract: a -= b; break;
+		case Multiply: a *= b; break;
+		default: a /= b; break;
+		}
+		return;
+	}
+
+	if (n >= 1 && program_[n - 1].op == PushConstant) {
+		double &a = program_[n - 1].constant;
+
+		if (op == Abs) {
+			a = fabs(a);
+			return;
+		} else if (op == LowPass) {
+			return;
+		} else if (op == Derivative) {
+			a = 0;
+			return;
+		}
+	}
+
+	Instruction ins{op, input, constant, 0};
+
+	if (op == PushInput)
+		input_count_ = max(input_count_, input + 1);
+
+	if (op == LowPass || op == Integrate || op == Derivative)
+		ins.state_index = state_count_++;
+
+	program_.push_back(ins);
+}
+
+bool MathExpression::pop_constant(double &value)
+{
+	if (program_.empty() || program_.back().op != PushConstant)
+		return false;
+
+	value = program_.back().constant;
+	program_.pop_back();
+	return true;
+}
+
+float* MathExpression::slot(Context &context, size_t index) const
+{
+	return context.scratch_.data() + (index * context.block_size_);
+}
+
+} // namespace data
+} // namespace pv
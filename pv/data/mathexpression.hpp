@@ -0,0 +1,158 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_MATHEXPRESSION_HPP
+#define PULSEVIEW_PV_DATA_MATHEXPRESSION_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using std::function;
+using std::string;
+using std::vector;
+
+namespace pv {
+namespace data {
+
+/**
+ * An arithmetic expression over analog channels, compiled into a program
+ * that processes whole blocks of samples per instruction.
+ *
+ * The grammar supports the operators + - * /, parentheses, numeric
+ * constants, channel names (quoted with "" if they contain special
+ * characters) and the following functions:
+ *
+ * - abs(x)
+ * - scale(x, k): x multiplied by the constant k
+ * - lowpass(x, f): first order low-pass filter with cut-off frequency f
+ * - integrate(x): running integral over time
+ * - derivative(x): derivative with respect to time
+ *
+ * Filters keep their state in a Context, so a stream of samples can be
+ * evaluated incrementally, block by block.
+ */
+class MathExpression
+{
+public:
+	/**
+	 * Looks up a channel by name. Returns the index of the channel in the
+	 * inputs passed to evaluate() or -1 if there is no such channel.
+	 */
+	typedef function<int (const string&)> InputResolver;
+
+private:
+	enum OpCode {
+		PushInput,
+		PushConstant,
+		Add,
+		Subtract,
+		Multiply,
+		Divide,
+		Negate,
+		Abs,
+		LowPass,
+		Integrate,
+		Derivative
+	};
+
+	struct Instruction
+	{
+		OpCode op;
+		unsigned int input;        ///< For PushInput
+		double constant;           ///< For PushConstant and LowPass
+		unsigned int state_index;  ///< For stateful operations
+	};
+
+	struct Operand
+	{
+		const float *data;  ///< nullptr for constants
+		float constant;
+	};
+
+	class Parser;
+
+public:
+	/**
+	 * Holds the state of the stateful operations and the scratch space
+	 * for evaluating one stream of samples.
+	 */
+	class Context
+	{
+		friend class MathExpression;
+
+	private:
+		vector<double> state_;
+		vector<bool> state_valid_;
+		vector<float> scratch_;
+		vector<Operand> stack_;
+		size_t block_size_;
+	};
+
+public:
+	MathExpression();
+
+	/**
+	 * Compiles an expression.
+	 * @param text The expression.
+	 * @param resolver Maps channel names to input indices.
+	 * @param[out] error A description of the problem if parsing failed.
+	 * @return true on success.
+	 */
+	bool parse(const string &text, InputResolver resolver, string &error);
+
+	/**
+	 * Returns the number of inputs the expression refers to, i.e. the
+	 * highest resolved input index plus one.
+	 */
+	unsigned int input_count() const;
+
+	/**
+	 * Creates a fresh evaluation context.
+	 * @param block_size The maximum number of samples per evaluate() call.
+	 */
+	Context create_context(size_t block_size) const;
+
+	/**
+	 * Evaluates the expression for a block of samples.
+	 * @param context The context of the stream the block belongs to.
+	 * @param inputs One pointer to count samples per input.
+	 * @param out Receives count samples.
+	 * @param count The number of samples, at most the context block size.
+	 * @param samplerate The sample rate, used by the time based operations.
+	 */
+	void evaluate(Context &context, const vector<const float*> &inputs,
+		float *out, size_t count, double samplerate) const;
+
+private:
+	void emit(OpCode op, unsigned int input = 0, double constant = 0);
+	bool pop_constant(double &value);
+
+	float* slot(Context &context, size_t index) const;
+
+private:
+	vector<Instruction> program_;
+	unsigned int input_count_;
+	unsigned int state_count_;
+	unsigned int max_depth_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_MATHEXPRESSION_HPP
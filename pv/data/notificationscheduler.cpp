@@ -0,0 +1,127 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include <QObject>
+
+#include "notificationscheduler.hpp"
+#include "segment.hpp"
+#include "signaldata.hpp"
+
+using std::max;
+using std::min;
+using std::chrono::microseconds;
+
+namespace pv {
+namespace data {
+
+const int NotificationScheduler::DefaultRate = 25;
+const int NotificationScheduler::MinRate = 1;
+const int NotificationScheduler::MaxRate = 1000;
+
+NotificationScheduler::NotificationScheduler(function<void()> data_received) :
+	data_received_(data_received),
+	rate_(DefaultRate),
+	last_flush_(clock::now())
+{
+	assert(data_received_);
+}
+
+int NotificationScheduler::rate() const
+{
+	return rate_;
+}
+
+void NotificationScheduler::set_rate(int rate)
+{
+	rate_ = min(max(rate, MinRate), MaxRate);
+}
+
+void NotificationScheduler::post(shared_ptr<SignalData> owner,
+	shared_ptr<Segment> segment, uint64_t start_sample, uint64_t end_sample)
+{
+	assert(owner);
+	assert(segment);
+
+	if (start_sample == end_sample)
+		return;
+
+	auto iter = pending_.find(segment.get());
+
+	if (iter == pending_.end()) {
+		pending_.emplace(segment.get(),
+			PendingRange{owner, segment, start_sample, end_sample});
+	} else {
+		PendingRange &r = iter->second;
+		r.start_sample = min(r.start_sample, start_sample);
+		r.end_sample = max(r.end_sample, end_sample);
+	}
+}
+
+bool NotificationScheduler::pending() const
+{
+	return !pending_.empty();
+}
+
+NotificationScheduler::clock::duration
+NotificationScheduler::time_until_due() const
+{
+	const clock::duration elapsed = clock::now() - last_flush_;
+	return (elapsed >= interval()) ? clock::duration::zero() :
+		(interval() - elapsed);
+}
+
+void NotificationScheduler::flush_if_due()
+{
+	if (pending() && time_until_due() == clock::duration::zero())
+		flush();
+}
+
+void NotificationScheduler::flush()
+{
+	last_flush_ = clock::now();
+
+	if (pending_.empty())
+		return;
+
+	// Swap the batch out first so that listeners may post new ranges
+	map<Segment*, PendingRange> batch;
+	batch.swap(pending_);
+
+	for (auto &entry : batch) {
+		PendingRange &r = entry.second;
+		r.owner->notify_samples_added(dynamic_cast<QObject*>(r.segment.get()),
+			r.start_sample, r.end_sample);
+	}
+
+	data_received_();
+}
+
+void NotificationScheduler::clear()
+{
+	pending_.clear();
+}
+
+NotificationScheduler::clock::duration NotificationScheduler::interval() const
+{
+	return microseconds(1000000 / rate_);
+}
+
+} // namespace data
+} // namespace pv
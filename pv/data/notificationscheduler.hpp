@@ -0,0 +1,130 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_NOTIFICATIONSCHEDULER_HPP
+#define PULSEVIEW_PV_DATA_NOTIFICATIONSCHEDULER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+
+using std::atomic;
+using std::function;
+using std::map;
+using std::shared_ptr;
+
+namespace pv {
+namespace data {
+
+class Segment;
+class SignalData;
+
+/**
+ * Coalesces the "samples added" notifications of the segments that are
+ * being filled during an acquisition.
+ *
+ * Instead of notifying listeners for every packet that arrives, the sample
+ * ranges are merged per segment and delivered at most at a configurable
+ * rate, followed by a single "data received" notification for the batch.
+ *
+ * All methods except set_rate() must be called from the same thread.
+ */
+class NotificationScheduler
+{
+public:
+	typedef std::chrono::steady_clock clock;
+
+	/// The default rate at which notifications are delivered.
+	static const int DefaultRate;  // Hz
+	static const int MinRate;
+	static const int MaxRate;
+
+private:
+	struct PendingRange
+	{
+		shared_ptr<SignalData> owner;
+		shared_ptr<Segment> segment;
+		uint64_t start_sample, end_sample;
+	};
+
+public:
+	/**
+	 * Constructor.
+	 * @param data_received Called after each delivered batch.
+	 */
+	NotificationScheduler(function<void()> data_received);
+
+	int rate() const;
+
+	/**
+	 * Sets the maximum number of batches delivered per second.
+	 */
+	void set_rate(int rate);
+
+	/**
+	 * Records that samples were added to a segment.
+	 * @param owner The data object the segment belongs to.
+	 * @param segment The segment the samples were added to.
+	 * @param start_sample The index of the first new sample.
+	 * @param end_sample The index after the last new sample.
+	 */
+	void post(shared_ptr<SignalData> owner, shared_ptr<Segment> segment,
+		uint64_t start_sample, uint64_t end_sample);
+
+	/**
+	 * Returns true if there are notifications waiting to be delivered.
+	 */
+	bool pending() const;
+
+	/**
+	 * Returns the time until the pending notifications are due.
+	 */
+	clock::duration time_until_due() const;
+
+	/**
+	 * Delivers the pending notifications if they are due.
+	 */
+	void flush_if_due();
+
+	/**
+	 * Delivers the pending notifications right away.
+	 */
+	void flush();
+
+	/**
+	 * Discards all pending notifications without delivering them.
+	 */
+	void clear();
+
+private:
+	clock::duration interval() const;
+
+private:
+	function<void()> data_received_;
+	atomic<int> rate_;
+
+	map<Segment*, PendingRange> pending_;
+	clock::time_point last_flush_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_NOTIFICATIONSCHEDULER_HPP
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+
+#include "packetqueue.hpp"
+
+using std::lock_guard;
+using std::memory_order_acquire;
+using std::memory_order_relaxed;
+using std::memory_order_release;
+using std::unique_lock;
+
+namespace pv {
+namespace data {
+
+const size_t PacketQueue::Capacity = 256;
+
+PacketQueue::PacketQueue() :
+	slots_(Capacity),
+	head_(0),
+	tail_(0),
+	closed_(false),
+	consumer_waiting_(false),
+	producer_waiting_(false),
+	max_depth_(0),
+	dropped_packets_(0),
+	dropped_samples_(0)
+{
+}
+
+void PacketQueue::reset()
+{
+	assert(empty());
+
+	closed_ = false;
+	max_depth_ = 0;
+	dropped_packets_ = 0;
+	dropped_samples_ = 0;
+}
+
+void PacketQueue::free_unused_memory()
+{
+	assert(empty());
+
+	for (QueuedPacket &p : slots_) {
+		vector<uint8_t>().swap(p.data);
+		vector< shared_ptr<sigrok::Channel> >().swap(p.channels);
+	}
+}
+
+QueuedPacket* PacketQueue::begin_push()
+{
+	const size_t tail = tail_.load(memory_order_relaxed);
+
+	if (tail - head_.load(memory_order_acquire) >= Capacity)
+		return nullptr;
+
+	return &slots_[tail % Capacity];
+}
+
+QueuedPacket* PacketQueue::begin_push_blocking()
+{
+	QueuedPacket *slot = begin_push();
+
+	if (!slot) {
+		unique_lock<mutex> lock(wait_mutex_);
+		producer_waiting_ = true;
+		space_cond_.wait(lock, [&] { return (slot = begin_push()) != nullptr; });
+		producer_waiting_ = false;
+	}
+
+	return slot;
+}
+
+void PacketQueue::end_push()
+{
+	const size_t tail = tail_.load(memory_order_relaxed) + 1;
+
+	// Sequentially consistent so that the store can't be reordered with
+	// the load of consumer_waiting_ below
+	tail_.store(tail);
+
+	const size_t depth = tail - head_.load(memory_order_relaxed);
+	if (depth > max_depth_.load(memory_order_relaxed))
+		max_depth_.store(depth, memory_order_relaxed);
+
+	if (consumer_waiting_) {
+		lock_guard<mutex> lock(wait_mutex_);
+		data_cond_.notify_one();
+	}
+}
+
+void PacketQueue::close()
+{
+	{
+		lock_guard<mutex> lock(wait_mutex_);
+		closed_ = true;
+	}
+	data_cond_.notify_one();
+}
+
+QueuedPacket* PacketQueue::wait_front()
+{
+	if (empty()) {
+		unique_lock<mutex> lock(wait_mutex_);
+		consumer_waiting_ = true;
+		data_cond_.wait(lock, [&] { return !empty() || closed_; });
+		consumer_waiting_ = false;
+	}
+
+	if (empty())
+		return nullptr;
+
+	return &slots_[head_.load(memory_order_relaxed) % Capacity];
+}
+
+QueuedPacket* PacketQueue::wait_front(std::chrono::nanoseconds timeout)
+{
+	if (empty()) {
+		unique_lock<mutex> lock(wait_mutex_);
+		consumer_waiting_ = true;
+		data_cond_.wait_for(lock, timeout,
+			[&] { return !empty() || closed_; });
+		consumer_waiting_ = false;
+	}
+
+	if (empty())
+		return nullptr;
+
+	return &slots_[head_.load(memory_order_relaxed) % Capacity];
+}
+
+bool PacketQueue::finished() const
+{
+	return closed_ && empty();
+}
+
+void PacketQueue::pop()
+{
+	assert(!empty());
+
+	// Sequentially consistent for the same reason as in end_push()
+	head_.store(head_.load(memory_order_relaxed) + 1);
+
+	if (producer_waiting_) {
+		lock_guard<mutex> lock(wait_mutex_);
+		space_cond_.notify_one();
+	}
+}
+
+void PacketQueue::count_drop(uint64_t sample_count)
+{
+	dropped_packets_.fetch_add(1, memory_order_relaxed);
+	dropped_samples_.fetch_add(sample_count, memory_order_relaxed);
+}
+
+size_t PacketQueue::depth() const
+{
+	// Load head_ first, it can never overtake a later value of tail_
+	const size_t head = head_.load(memory_order_acquire);
+	return tail_.load(memory_order_acquire) - head;
+}
+
+size_t PacketQueue::max_depth() const
+{
+	return max_depth_.load(memory_order_relaxed);
+}
+
+uint64_t PacketQueue::dropped_packets() const
+{
+	return dropped_packets_.load(memory_order_relaxed);
+}
+
+uint64_t PacketQueue::dropped_samples() const
+{
+	return dropped_samples_.load(memory_order_relaxed);
+}
+
+bool PacketQueue::empty() const
+{
+	return tail_ == head_;
+}
+
+} // namespace data
+} // namespace pv
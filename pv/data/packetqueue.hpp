@@ -0,0 +1,181 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_PACKETQUEUE_HPP
+#define PULSEVIEW_PV_DATA_PACKETQUEUE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::atomic;
+using std::condition_variable;
+using std::mutex;
+using std::shared_ptr;
+using std::vector;
+
+namespace sigrok {
+class Channel;
+}
+
+namespace pv {
+namespace data {
+
+/**
+ * A copy of a datafeed packet, detached from the libsigrok packet it was
+ * created from so that it can outlive the datafeed callback.
+ */
+struct QueuedPacket
+{
+	enum Type {
+		Header,
+		Meta,
+		Trigger,
+		FrameBegin,
+		FrameEnd,
+		End,
+		Logic,
+		Analog
+	};
+
+	Type type;
+
+	/// The sample rate carried by a meta packet, or 0 if none was given.
+	uint64_t samplerate;
+
+	/// The unit size of a logic packet.
+	unsigned int unit_size;
+
+	/// The channels of an analog packet, in the order they are interleaved.
+	vector< shared_ptr<sigrok::Channel> > channels;
+
+	/// The raw payload. Holds packed samples for logic packets and
+	/// interleaved floats for analog packets.
+	vector<uint8_t> data;
+
+	/// The number of logic and analog samples that were dropped right
+	/// before this packet because the queue was full.
+	uint64_t dropped_logic_samples, dropped_analog_samples;
+};
+
+/**
+ * A bounded, lock-free single-producer/single-consumer queue of datafeed
+ * packets. The libsigrok session thread fills slots in place while the
+ * ingest worker consumes them; slot buffers keep their capacity between
+ * uses so that the producer does not allocate once the queue has warmed up.
+ */
+class PacketQueue
+{
+public:
+	static const size_t Capacity;
+
+public:
+	PacketQueue();
+
+	/**
+	 * Prepares the queue for a new acquisition, resetting the counters.
+	 */
+	void reset();
+
+	/**
+	 * Releases the memory held by the slot buffers.
+	 */
+	void free_unused_memory();
+
+	/**
+	 * Returns the next free slot for the producer to fill in, or nullptr
+	 * if the queue is full.
+	 */
+	QueuedPacket* begin_push();
+
+	/**
+	 * Like begin_push(), but blocks until the consumer has freed a slot
+	 * instead of returning nullptr.
+	 */
+	QueuedPacket* begin_push_blocking();
+
+	/**
+	 * Publishes the slot returned by the preceding begin_push() call.
+	 */
+	void end_push();
+
+	/**
+	 * Marks the end of the producer's input. The consumer is woken up and
+	 * will drain the remaining packets.
+	 */
+	void close();
+
+	/**
+	 * Blocks until a packet is available and returns it without removing
+	 * it from the queue. Returns nullptr once the queue was closed and
+	 * all packets have been consumed.
+	 */
+	QueuedPacket* wait_front();
+
+	/**
+	 * Like wait_front(), but gives up and returns nullptr once the
+	 * timeout has expired.
+	 */
+	QueuedPacket* wait_front(std::chrono::nanoseconds timeout);
+
+	/**
+	 * Returns true once the queue was closed and all packets have been
+	 * consumed.
+	 */
+	bool finished() const;
+
+	/**
+	 * Releases the slot returned by wait_front().
+	 */
+	void pop();
+
+	/**
+	 * Records a packet that had to be dropped because the queue was full.
+	 * @param sample_count The number of samples the packet contained.
+	 */
+	void count_drop(uint64_t sample_count);
+
+	size_t depth() const;
+	size_t max_depth() const;
+	uint64_t dropped_packets() const;
+	uint64_t dropped_samples() const;
+
+private:
+	bool empty() const;
+
+private:
+	vector<QueuedPacket> slots_;
+
+	atomic<size_t> head_, tail_;
+	atomic<bool> closed_;
+
+	mutex wait_mutex_;
+	condition_variable data_cond_, space_cond_;
+	atomic<bool> consumer_waiting_, producer_waiting_;
+
+	atomic<size_t> max_depth_;
+	atomic<uint64_t> dropped_packets_, dropped_samples_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_PACKETQUEUE_HPP
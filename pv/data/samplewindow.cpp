@@ -0,0 +1,122 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "samplewindow.hpp"
+
+using std::max;
+using std::min;
+using std::numeric_limits;
+
+namespace pv {
+namespace data {
+
+SampleWindow::SampleWindow() :
+	SampleWindow(0, -1, 1)
+{
+}
+
+SampleWindow::SampleWindow(double start, double end,
+	unsigned int decimation) :
+	start_(max(start, 0.0)),
+	end_(end),
+	decimation_(max(decimation, 1u)),
+	resolved_(false),
+	start_sample_(0),
+	end_sample_(numeric_limits<uint64_t>::max())
+{
+}
+
+bool SampleWindow::is_full() const
+{
+	return start_ == 0 && end_ < 0 && decimation_ == 1;
+}
+
+double SampleWindow::start() const
+{
+	return start_;
+}
+
+double SampleWindow::end() const
+{
+	return end_;
+}
+
+unsigned int SampleWindow::decimation() const
+{
+	return decimation_;
+}
+
+void SampleWindow::resolve(double samplerate)
+{
+	// Without a sample rate, the window is given in samples
+	const double scale = (samplerate > 0) ? samplerate : 1.0;
+
+	start_sample_ = (uint64_t)floor(start_ * scale);
+	end_sample_ = (end_ < 0) ? numeric_limits<uint64_t>::max() :
+		max(start_sample_, (uint64_t)ceil(end_ * scale));
+	resolved_ = true;
+}
+
+bool SampleWindow::is_resolved() const
+{
+	return resolved_;
+}
+
+uint64_t SampleWindow::start_sample() const
+{
+	return start_sample_;
+}
+
+uint64_t SampleWindow::end_sample() const
+{
+	return end_sample_;
+}
+
+uint64_t SampleWindow::select(uint64_t position, uint64_t count,
+	uint64_t &first) const
+{
+	assert(resolved_ || is_full());
+
+	first = 0;
+
+	const uint64_t block_end = min(position + count, end_sample_);
+	uint64_t lo = max(position, start_sample_);
+
+	// Round up to the next sample on the decimation grid
+	const uint64_t offset = (lo - start_sample_) % decimation_;
+	if (offset != 0)
+		lo += decimation_ - offset;
+
+	if (lo >= block_end)
+		return 0;
+
+	first = lo - position;
+	return (block_end - lo - 1) / decimation_ + 1;
+}
+
+bool SampleWindow::passed(uint64_t position) const
+{
+	return resolved_ && position >= end_sample_;
+}
+
+} // namespace data
+} // namespace pv
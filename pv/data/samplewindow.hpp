@@ -0,0 +1,107 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DATA_SAMPLEWINDOW_HPP
+#define PULSEVIEW_PV_DATA_SAMPLEWINDOW_HPP
+
+#include <cstdint>
+
+namespace pv {
+namespace data {
+
+/**
+ * Selects the part of an input that is kept when a file is loaded: a time
+ * window and, optionally, only every n-th sample within it, which gives a
+ * decimated overview of files that are too large to load completely.
+ *
+ * The window is given in seconds, or in samples for inputs without a
+ * sample rate, and is resolved into sample indices once the sample rate of
+ * the input is known.
+ */
+class SampleWindow
+{
+public:
+	/**
+	 * Constructs a window that keeps all samples.
+	 */
+	SampleWindow();
+
+	/**
+	 * Constructor.
+	 * @param start The start of the window.
+	 * @param end The end of the window, or a negative value to keep all
+	 * samples after start.
+	 * @param decimation Only every decimation-th sample is kept.
+	 */
+	SampleWindow(double start, double end, unsigned int decimation = 1);
+
+	/**
+	 * Returns true if the window keeps all samples.
+	 */
+	bool is_full() const;
+
+	double start() const;
+	double end() const;
+	unsigned int decimation() const;
+
+	/**
+	 * Resolves the window into sample indices.
+	 * @param samplerate The sample rate of the input, or 0 if unknown.
+	 */
+	void resolve(double samplerate);
+
+	bool is_resolved() const;
+
+	/**
+	 * Returns the index of the first sample of the window. Only valid
+	 * once the window was resolved.
+	 */
+	uint64_t start_sample() const;
+
+	/**
+	 * Returns the index after the last sample of the window.
+	 */
+	uint64_t end_sample() const;
+
+	/**
+	 * Determines the samples of a block of input that are kept.
+	 * @param position The input index of the first sample of the block.
+	 * @param count The number of samples in the block.
+	 * @param[out] first The index within the block of the first sample
+	 * that is kept. Every decimation()-th sample from there on is kept.
+	 * @return The number of samples that are kept.
+	 */
+	uint64_t select(uint64_t position, uint64_t count,
+		uint64_t &first) const;
+
+	/**
+	 * Returns true if no sample at or after an input index is kept.
+	 */
+	bool passed(uint64_t position) const;
+
+private:
+	double start_, end_;
+	unsigned int decimation_;
+
+	bool resolved_;
+	uint64_t start_sample_, end_sample_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_SAMPLEWINDOW_HPP
@@ -44,9 +44,7 @@ Segment::Segment(uint64_t samplerate, unsigned int unit_size) :
 	lock_guard<recursive_mutex> lock(mutex_);
 	assert(unit_size_ > 0);
 
-	// Determine the number of samples we can fit in one chunk
-	// without exceeding MaxChunkSize
-	chunk_size_ = min(MaxChunkSize, (MaxChunkSize / unit_size_) * unit_size_);
+	chunk_size_ = chunk_samples(unit_size_) * unit_size_;
 
 	// Create the initial chunk
 	current_chunk_ = new uint8_t[chunk_size_];
@@ -55,10 +53,21 @@ Segment::Segment(uint64_t samplerate, unsigned int unit_size) :
 	unused_samples_ = chunk_size_ / unit_size_;
 }
 
+uint64_t Segment::chunk_samples(unsigned int unit_size)
+{
+	// Determine the number of samples we can fit in one chunk
+	// without exceeding MaxChunkSize
+	return MaxChunkSize / unit_size;
+}
+
 Segment::~Segment()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
 
+	// Mapped chunks belong to the storage
+	if (storage_)
+		return;
+
 	for (uint8_t* chunk : data_chunks_)
 		delete[] chunk;
 }
@@ -74,6 +83,17 @@ const pv::util::Timestamp& Segment::start_time() const
 	return start_time_;
 }
 
+void Segment::set_start_time(const pv::util::Timestamp& start_time)
+{
+	start_time_ = start_time;
+	fixed_start_time_ = pv::util::FixedTimestamp(start_time);
+}
+
+const pv::util::FixedTimestamp& Segment::fixed_start_time() const
+{
+	return fixed_start_time_;
+}
+
 double Segment::samplerate() const
 {
 	return samplerate_;
@@ -93,6 +113,10 @@ void Segment::free_unused_memory()
 {
 	lock_guard<recursive_mutex> lock(mutex_);
 
+	// Mapped samples don't use more memory than they need
+	if (storage_)
+		return;
+
 	// Do not mess with the data chunks if we have iterators pointing at them
 	if (iterator_count_ > 0) {
 		mem_optimization_requested_ = true;
@@ -110,9 +134,47 @@ void Segment::free_unused_memory()
 	data_chunks_.push_back(resized_chunk);
 }
 
+void Segment::pin_chunks()
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+	iterator_count_++;
+}
+
+void Segment::unpin_chunks()
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+	assert(iterator_count_ > 0);
+
+	iterator_count_--;
+
+	if ((iterator_count_ == 0) && mem_optimization_requested_) {
+		mem_optimization_requested_ = false;
+		free_unused_memory();
+	}
+}
+
+const uint8_t* Segment::contiguous_samples(uint64_t start,
+	uint64_t &count) const
+{
+	assert(start < sample_count_);
+	assert(count > 0);
+
+	lock_guard<recursive_mutex> lock(mutex_);
+	assert(iterator_count_ > 0);
+
+	const uint64_t chunk_num = (start * unit_size_) / chunk_size_;
+	const uint64_t chunk_offs = (start * unit_size_) % chunk_size_;
+
+	count = min(min(count, sample_count_ - start),
+		(chunk_size_ - chunk_offs) / unit_size_);
+
+	return data_chunks_[chunk_num] + chunk_offs;
+}
+
 void Segment::append_single_sample(void *data)
 {
 	lock_guard<recursive_mutex> lock(mutex_);
+	assert(!storage_);
 
 	// There will always be space for at least one sample in
 	// the current chunk, so we do not need to test for space
@@ -134,6 +196,7 @@ void Segment::append_single_sample(void *data)
 void Segment::append_samples(void* data, uint64_t samples)
 {
 	lock_guard<recursive_mutex> lock(mutex_);
+	assert(!storage_);
 
 	const uint8_t* data_byte_ptr = (uint8_t*)data;
 	uint64_t remaining_samples = samples;
@@ -172,6 +235,16 @@ void Segment::append_samples(void* data, uint64_t samples)
 }
 
 uint8_t* Segment::get_raw_samples(uint64_t start, uint64_t count) const
+{
+	uint8_t* dest = new uint8_t[count * unit_size_];
+
+	get_raw_samples(start, count, dest);
+
+	return dest;
+}
+
+void Segment::get_raw_samples(uint64_t start, uint64_t count,
+	uint8_t *dest) const
 {
 	assert(start < sample_count_);
 	assert(start + count <= sample_count_);
@@ -179,7 +252,6 @@ uint8_t* Segment::get_raw_samples(uint64_t start, uint64_t count) const
 
 	lock_guard<recursive_mutex> lock(mutex_);
 
-	uint8_t* dest = new uint8_t[count * unit_size_];
 	uint8_t* dest_ptr = dest;
 
 	uint64_t chunk_num = (start * unit_size_) / chunk_size_;
@@ -199,8 +271,78 @@ uint8_t* Segment::get_raw_samples(uint64_t start, uint64_t count) const
 		chunk_num++;
 		chunk_offs = 0;
 	}
+}
 
-	return dest;
+uint8_t* Segment::begin_raw_append(uint64_t &max_samples)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+	assert(!storage_);
+
+	// There is always space for at least one sample in the current chunk
+	max_samples = unused_samples_;
+
+	return current_chunk_ + (used_samples_ * unit_size_);
+}
+
+void Segment::end_raw_append(uint64_t samples)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	assert(samples <= unused_samples_);
+
+	used_samples_ += samples;
+	unused_samples_ -= samples;
+	sample_count_ += samples;
+
+	if (unused_samples_ == 0) {
+		// If we're out of memory, this will throw std::bad_alloc
+		current_chunk_ = new uint8_t[chunk_size_];
+		data_chunks_.push_back(current_chunk_);
+		used_samples_ = 0;
+		unused_samples_ = chunk_size_ / unit_size_;
+	}
+}
+
+void Segment::map_samples(shared_ptr<const void> storage,
+	const vector<Extent> &extents)
+{
+	lock_guard<recursive_mutex> lock(mutex_);
+
+	assert(storage);
+	assert(sample_count_ == 0);
+	assert(iterator_count_ == 0);
+
+	for (uint8_t* chunk : data_chunks_)
+		delete[] chunk;
+	data_chunks_.clear();
+
+	storage_ = storage;
+	used_samples_ = 0;
+	unused_samples_ = 0;
+
+	// Slice the samples into chunks as if they had been appended, so that
+	// the chunk arithmetic stays the same. Like with appended samples, the
+	// last chunk is empty if the samples fill up the chunks exactly.
+	for (size_t i = 0; i < extents.size(); i++) {
+		const uint8_t *const data = extents[i].first;
+		const uint64_t length = extents[i].second * unit_size_;
+		const bool last = (i + 1 == extents.size());
+
+		assert(last || (length % chunk_size_) == 0);
+
+		for (uint64_t offset = 0; offset < length ||
+			(last && offset == length); offset += chunk_size_)
+			data_chunks_.push_back(const_cast<uint8_t*>(data) + offset);
+
+		if (last)
+			used_samples_ = (length % chunk_size_) / unit_size_;
+		sample_count_ += extents[i].second;
+	}
+
+	if (data_chunks_.empty())
+		data_chunks_.push_back(nullptr);
+
+	current_chunk_ = data_chunks_.back();
 }
 
 SegmentRawDataIterator* Segment::begin_raw_sample_iteration(uint64_t start)
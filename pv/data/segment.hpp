@@ -23,11 +23,15 @@
 
 #include "pv/util.hpp"
 
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <utility>
 #include <vector>
 
+using std::pair;
 using std::recursive_mutex;
+using std::shared_ptr;
 using std::vector;
 
 namespace SegmentTest {
@@ -41,6 +45,7 @@ struct MediumSize32Multi;
 struct MaxSize32Multi;
 struct MaxSize32MultiAtOnce;
 struct MaxSize32MultiIterated;
+struct ContiguousSamples;
 }  // namespace SegmentTest
 
 namespace pv {
@@ -57,14 +62,31 @@ class Segment
 private:
 	static const uint64_t MaxChunkSize;
 
+public:
+	/// The start and the number of samples of a contiguous piece of
+	/// samples kept in storage the segment doesn't own.
+	typedef pair<const uint8_t*, uint64_t> Extent;
+
 public:
 	Segment(uint64_t samplerate, unsigned int unit_size);
 
+	/**
+	 * Returns the number of samples in each chunk of a segment with the
+	 * given unit size.
+	 */
+	static uint64_t chunk_samples(unsigned int unit_size);
+
 	virtual ~Segment();
 
 	uint64_t get_sample_count() const;
 
 	const pv::util::Timestamp& start_time() const;
+	void set_start_time(const pv::util::Timestamp& start_time);
+
+	/**
+	 * Returns the start time as a fixed-point value for painting.
+	 */
+	const pv::util::FixedTimestamp& fixed_start_time() const;
 
 	double samplerate() const;
 	void set_samplerate(double samplerate);
@@ -73,10 +95,41 @@ public:
 
 	void free_unused_memory();
 
+	/**
+	 * Keeps the sample chunks in place until unpin_chunks() is called, so
+	 * that the pointers returned by contiguous_samples() stay valid.
+	 */
+	void pin_chunks();
+	void unpin_chunks();
+
+	/**
+	 * Returns a pointer to the samples from index start on without copying
+	 * them. The chunks must be pinned while the pointer is used.
+	 * @param count The number of samples wanted. Is reduced to the number
+	 *  of samples that follow contiguously if they span several chunks.
+	 */
+	const uint8_t* contiguous_samples(uint64_t start, uint64_t &count) const;
+
 protected:
 	void append_single_sample(void *data);
 	void append_samples(void *data, uint64_t samples);
 	uint8_t* get_raw_samples(uint64_t start, uint64_t count) const;
+	void get_raw_samples(uint64_t start, uint64_t count, uint8_t *dest) const;
+
+	uint8_t* begin_raw_append(uint64_t &max_samples);
+	void end_raw_append(uint64_t samples);
+
+	/**
+	 * Makes the segment refer to samples that are kept in storage it
+	 * doesn't own, e.g. a memory-mapped capture file, instead of copying
+	 * them into chunks of its own. The segment must be empty and can't be
+	 * appended to afterwards.
+	 * @param storage Keeps the storage alive while the segment uses it.
+	 * @param extents The samples in order. All extents but the last must
+	 * hold a multiple of chunk_samples() samples.
+	 */
+	void map_samples(shared_ptr<const void> storage,
+		const vector<Extent> &extents);
 
 	SegmentRawDataIterator* begin_raw_sample_iteration(uint64_t start);
 	void continue_raw_sample_iteration(SegmentRawDataIterator* it, uint64_t increase);
@@ -88,11 +141,13 @@ protected:
 	uint64_t used_samples_, unused_samples_;
 	uint64_t sample_count_;
 	pv::util::Timestamp start_time_;
+	pv::util::FixedTimestamp fixed_start_time_;
 	double samplerate_;
 	uint64_t chunk_size_;
 	unsigned int unit_size_;
 	int iterator_count_;
 	bool mem_optimization_requested_;
+	shared_ptr<const void> storage_;
 
 	friend struct SegmentTest::SmallSize8Single;
 	friend struct SegmentTest::MediumSize8Single;
@@ -104,6 +159,7 @@ protected:
 	friend struct SegmentTest::MaxSize32Multi;
 	friend struct SegmentTest::MaxSize32MultiAtOnce;
 	friend struct SegmentTest::MaxSize32MultiIterated;
+	friend struct SegmentTest::ContiguousSamples;
 };
 
 } // namespace data
@@ -18,11 +18,21 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 #include "analog.hpp"
 #include "analogsegment.hpp"
+#include "conversiongroup.hpp"
 #include "decode/row.hpp"
 #include "logic.hpp"
 #include "logicsegment.hpp"
+#include "mathengine.hpp"
 #include "signalbase.hpp"
 #include "signaldata.hpp"
 
@@ -30,19 +40,25 @@
 #include <pv/session.hpp>
 
 using std::dynamic_pointer_cast;
+using std::lock_guard;
 using std::make_shared;
+using std::min;
 using std::shared_ptr;
 using std::tie;
+using std::unique_lock;
 
 namespace pv {
 namespace data {
 
 const int SignalBase::ColourBGAlpha = 8 * 256 / 100;
+const uint64_t SignalBase::ConversionBlockSize = 4096;
 
 SignalBase::SignalBase(shared_ptr<sigrok::Channel> channel, ChannelType channel_type) :
 	channel_(channel),
 	channel_type_(channel_type),
-	conversion_type_(NoConversion)
+	conversion_type_(NoConversion),
+	logic_bit_(-1),
+	conversion_interrupt_(false)
 {
 	if (channel_)
 		internal_name_ = QString::fromStdString(channel_->name());
@@ -50,9 +66,7 @@ SignalBase::SignalBase(shared_ptr<sigrok::Channel> channel, ChannelType channel_
 
 SignalBase::~SignalBase()
 {
-	// Wait for the currently ongoing conversion to finish
-	if (conversion_thread_.joinable())
-		conversion_thread_.join();
+	end_conversion();
 }
 
 shared_ptr<sigrok::Channel> SignalBase::channel() const
@@ -144,13 +158,18 @@ void SignalBase::set_data(shared_ptr<pv::data::SignalData> data)
 		connect(analog_data.get(), SIGNAL(samples_added(QObject*, uint64_t, uint64_t)),
 			this, SLOT(on_samples_added(QObject*, uint64_t, uint64_t)));
 	}
+
+	// The group converts the data its members had when it started
+	if (conversion_group_ && channel_type_ == AnalogChannel &&
+		is_a2l_conversion())
+		conversion_group_->update(this);
 }
 
 shared_ptr<data::Analog> SignalBase::analog_data() const
 {
 	shared_ptr<Analog> result = nullptr;
 
-	if (channel_type_ == AnalogChannel)
+	if (channel_type_ == AnalogChannel || channel_type_ == MathChannel)
 		result = dynamic_pointer_cast<Analog>(data_);
 
 	return result;
@@ -163,42 +182,82 @@ shared_ptr<data::Logic> SignalBase::logic_data() const
 	if (channel_type_ == LogicChannel)
 		result = dynamic_pointer_cast<Logic>(data_);
 
-	if (((conversion_type_ == A2LConversionByTreshold) ||
-		(conversion_type_ == A2LConversionBySchmittTrigger)))
-		result = dynamic_pointer_cast<Logic>(converted_data_);
+	if (is_a2l_conversion())
+		result = conversion_group_ ? conversion_group_->logic_data() :
+			dynamic_pointer_cast<Logic>(converted_data_);
 
 	return result;
 }
 
 void SignalBase::set_conversion_type(ConversionType t)
 {
-	if (conversion_type_ != NoConversion) {
-		// Wait for the currently ongoing conversion to finish
-		if (conversion_thread_.joinable())
-			conversion_thread_.join();
-
-		// Discard converted data
-		converted_data_.reset();
+	// A member of a group keeps its bit, the group just converts again
+	if (conversion_group_ && channel_type_ == AnalogChannel &&
+		is_a2l_conversion() && (t == A2LConversionByTreshold || t == A2LConversionBySchmittTrigger)) {
+		conversion_type_ = t;
+		conversion_group_->update(this);
+		conversion_type_changed(t);
+		return;
 	}
 
+	// Wait for the currently ongoing conversion to finish
+	end_conversion();
+
 	conversion_type_ = t;
 
-	if ((channel_type_ == AnalogChannel) &&
-		((conversion_type_ == A2LConversionByTreshold) ||
-		(conversion_type_ == A2LConversionBySchmittTrigger))) {
+	begin_conversion();
 
-		shared_ptr<Analog> analog_data = dynamic_pointer_cast<Analog>(data_);
+	conversion_type_changed(t);
+}
 
-		if (analog_data->analog_segments().size() > 0) {
-			AnalogSegment *asegment = analog_data->analog_segments().front().get();
+SignalBase::ConversionType SignalBase::conversion_type() const
+{
+	return (ConversionType)conversion_type_;
+}
 
-			// Begin conversion of existing sample data
-			// TODO Support for multiple segments is missing
-			on_samples_added(asegment, 0, 0);
-		}
-	}
+void SignalBase::set_conversion_group(shared_ptr<ConversionGroup> group)
+{
+	if (group == conversion_group_)
+		return;
 
-	conversion_type_changed(t);
+	end_conversion();
+
+	conversion_group_ = group;
+
+	begin_conversion();
+
+	conversion_type_changed((ConversionType)conversion_type_);
+}
+
+shared_ptr<ConversionGroup> SignalBase::conversion_group() const
+{
+	return conversion_group_;
+}
+
+void SignalBase::set_math_engine(shared_ptr<MathEngine> engine)
+{
+	assert(channel_type_ == MathChannel);
+
+	math_engine_ = engine;
+	set_data(engine ? engine->output() : nullptr);
+}
+
+shared_ptr<MathEngine> SignalBase::math_engine() const
+{
+	return math_engine_;
+}
+
+unsigned int SignalBase::logic_bit_index() const
+{
+	if (channel_type_ == AnalogChannel && is_a2l_conversion())
+		return conversion_group_ ? conversion_group_->bit_index(this) : 0;
+
+	return (logic_bit_ >= 0) ? logic_bit_ : index();
+}
+
+void SignalBase::set_logic_bit_index(int bit)
+{
+	logic_bit_ = bit;
 }
 
 #ifdef ENABLE_DECODE
@@ -235,165 +294,344 @@ void SignalBase::restore_settings(QSettings &settings)
 	set_conversion_type((ConversionType)settings.value("conversion_type").toInt());
 }
 
-uint8_t SignalBase::convert_a2l_threshold(float threshold, float value)
+bool SignalBase::is_a2l_conversion() const
 {
-	return (value >= threshold) ? 1 : 0;
+	return (conversion_type_ == A2LConversionByTreshold) ||
+		(conversion_type_ == A2LConversionBySchmittTrigger);
 }
 
-uint8_t SignalBase::convert_a2l_schmitt_trigger(float lo_thr, float hi_thr,
-	float value, uint8_t &state)
+void SignalBase::begin_conversion()
 {
-	if (value < lo_thr)
-		state = 0;
-	else if (value > hi_thr)
-		state = 1;
+	if ((channel_type_ != AnalogChannel) || !is_a2l_conversion())
+		return;
+
+	if (conversion_group_) {
+		if (conversion_group_->add(this))
+			return;
 
-	return state;
+		// The group is full, convert on our own
+		conversion_group_.reset();
+	}
+
+	converted_data_ = make_shared<Logic>(1);  // Contains only one channel
+
+	start_conversion();
+
+	// Begin conversion of existing sample data
+	shared_ptr<Analog> analog_data = dynamic_pointer_cast<Analog>(data_);
+	if (analog_data)
+		for (const shared_ptr<AnalogSegment> &asegment :
+			analog_data->analog_segments())
+			queue_conversion(asegment);
 }
 
-void SignalBase::conversion_thread_proc(QObject* segment, uint64_t start_sample,
-	uint64_t end_sample)
+void SignalBase::end_conversion()
 {
-	const uint64_t block_size = 4096;
+	if (conversion_group_)
+		conversion_group_->remove(this);
 
-	// TODO Support for multiple segments is missing
+	stop_conversion();
 
-	if ((channel_type_ == AnalogChannel) &&
-		((conversion_type_ == A2LConversionByTreshold) ||
-		(conversion_type_ == A2LConversionBySchmittTrigger))) {
+	// Discard converted data
+	converted_data_.reset();
+}
 
-		AnalogSegment *asegment = qobject_cast<AnalogSegment*>(segment);
+void SignalBase::convert_a2l(ConversionType type, float min_v, float max_v,
+	const float *in, uint8_t *out, uint64_t count, uint8_t &state)
+{
+	if (type == A2LConversionByTreshold) {
+		const float threshold = (min_v + max_v) * 0.5;  // middle between min and max
+		convert_a2l_threshold(threshold, in, out, count);
+	} else {
+		const float amplitude = max_v - min_v;
+		const float lo_thr = min_v + (amplitude * 0.1);  // 10% above min
+		const float hi_thr = max_v - (amplitude * 0.1);  // 10% below max
+		convert_a2l_schmitt_trigger(lo_thr, hi_thr, in, out, count, state);
+	}
+}
 
-		// Create the logic data container if needed
-		shared_ptr<Logic> logic_data;
-		if (!converted_data_) {
-			logic_data = make_shared<Logic>(1);  // Contains only one channel
-			converted_data_ = logic_data;
-		} else
-			 logic_data = dynamic_pointer_cast<Logic>(converted_data_);
+void SignalBase::convert_a2l_threshold(float threshold, const float *in,
+	uint8_t *out, uint64_t count)
+{
+	uint64_t i = 0;
+
+#ifdef __SSE2__
+	const __m128 thr = _mm_set1_ps(threshold);
+	const __m128i one = _mm_set1_epi8(1);
+
+	// Compare 16 samples at a time and narrow the 32-bit masks to bytes
+	for (; i + 16 <= count; i += 16) {
+		const __m128i m0 = _mm_castps_si128(
+			_mm_cmpge_ps(_mm_loadu_ps(in + i), thr));
+		const __m128i m1 = _mm_castps_si128(
+			_mm_cmpge_ps(_mm_loadu_ps(in + i + 4), thr));
+		const __m128i m2 = _mm_castps_si128(
+			_mm_cmpge_ps(_mm_loadu_ps(in + i + 8), thr));
+		const __m128i m3 = _mm_castps_si128(
+			_mm_cmpge_ps(_mm_loadu_ps(in + i + 12), thr));
+
+		const __m128i m = _mm_packs_epi16(
+			_mm_packs_epi32(m0, m1), _mm_packs_epi32(m2, m3));
+
+		_mm_storeu_si128((__m128i*)(out + i), _mm_and_si128(m, one));
+	}
+#endif
 
-		// Create the initial logic data segment if needed
-		if (logic_data->segments().size() == 0) {
-			shared_ptr<LogicSegment> lsegment =
-				make_shared<LogicSegment>(*logic_data.get(), 1, asegment->samplerate());
-			logic_data->push_segment(lsegment);
-		}
+	convert_a2l_threshold_scalar(threshold, in + i, out + i, count - i);
+}
 
-		LogicSegment *lsegment = dynamic_cast<LogicSegment*>(logic_data->segments().front().get());
+void SignalBase::convert_a2l_threshold_scalar(float threshold,
+	const float *in, uint8_t *out, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++)
+		out[i] = (in[i] >= threshold) ? 1 : 0;
+}
 
-		// start_sample=end_sample=0 means we need to figure out the unprocessed range
-		if ((start_sample == 0) && (end_sample == 0)) {
-			start_sample = lsegment->get_sample_count();
-			end_sample = asegment->get_sample_count();
+void SignalBase::convert_a2l_schmitt_trigger(float lo_thr, float hi_thr,
+	const float *in, uint8_t *out, uint64_t count, uint8_t &state)
+{
+	uint64_t i = 0;
+
+#ifdef __SSE2__
+	const __m128 lo = _mm_set1_ps(lo_thr);
+	const __m128 hi = _mm_set1_ps(hi_thr);
+
+	// The output only depends on the previous state where a sample lies
+	// between the thresholds, so blocks of 16 samples that are entirely
+	// inside, above or below the hysteresis band are filled in one go
+	for (; i + 16 <= count; i += 16) {
+		unsigned int above = 0, below = 0;
+
+		for (unsigned int j = 0; j < 4; j++) {
+			const __m128 v = _mm_loadu_ps(in + i + (j * 4));
+			above |= _mm_movemask_ps(_mm_cmpgt_ps(v, hi)) << (j * 4);
+			below |= _mm_movemask_ps(_mm_cmplt_ps(v, lo)) << (j * 4);
+		}
+
+		if (above == 0xFFFF)
+			state = 1;
+		else if (below == 0xFFFF)
+			state = 0;
+		else if ((above | below) != 0) {
+			for (unsigned int j = 0; j < 16; j++) {
+				if (below & (1 << j))
+					state = 0;
+				else if (above & (1 << j))
+					state = 1;
+				out[i + j] = state;
+			}
+			continue;
 		}
 
-		if (start_sample == end_sample)
-			return;  // Nothing to do
+		memset(out + i, state, 16);
+	}
+#endif
 
-		float min_v, max_v;
-		tie(min_v, max_v) = asegment->get_min_max();
+	convert_a2l_schmitt_trigger_scalar(lo_thr, hi_thr, in + i, out + i,
+		count - i, state);
+}
 
-		vector<uint8_t> lsamples;
-		lsamples.reserve(block_size);
+void SignalBase::convert_a2l_schmitt_trigger_scalar(float lo_thr,
+	float hi_thr, const float *in, uint8_t *out, uint64_t count,
+	uint8_t &state)
+{
+	for (uint64_t i = 0; i < count; i++) {
+		if (in[i] < lo_thr)
+			state = 0;
+		else if (in[i] > hi_thr)
+			state = 1;
 
-		uint64_t i = start_sample;
+		out[i] = state;
+	}
+}
 
-		if (conversion_type_ == A2LConversionByTreshold) {
-			const float threshold = (min_v + max_v) * 0.5;  // middle between min and max
+void SignalBase::start_conversion()
+{
+	assert(!conversion_thread_.joinable());
 
-			// Convert as many sample blocks as we can
-			while ((end_sample - i) > block_size) {
-				const float* asamples = asegment->get_samples(i, i + block_size);
-				for (uint32_t j = 0; j < block_size; j++)
-					lsamples.push_back(convert_a2l_threshold(threshold, asamples[j]));
-				lsegment->append_payload(lsamples.data(), lsamples.size());
-				i += block_size;
-				lsamples.clear();
-				delete[] asamples;
-			}
+	conversion_interrupt_ = false;
+	conversion_thread_ = std::thread(&SignalBase::conversion_thread_proc, this);
+}
+
+void SignalBase::stop_conversion()
+{
+	if (!conversion_thread_.joinable())
+		return;
+
+	{
+		lock_guard<mutex> lock(conversion_mutex_);
+		conversion_interrupt_ = true;
+	}
+	conversion_cond_.notify_one();
+
+	conversion_thread_.join();
+
+	conversion_queue_.clear();
+	converted_segments_.clear();
+}
+
+void SignalBase::queue_conversion(shared_ptr<AnalogSegment> segment)
+{
+	{
+		lock_guard<mutex> lock(conversion_mutex_);
+
+		// The worker always converts all samples that are available, so
+		// a segment only needs to be queued once
+		for (const shared_ptr<AnalogSegment> &s : conversion_queue_)
+			if (s == segment)
+				return;
 
-			// Convert remaining samples
-			const float* asamples = asegment->get_samples(i, end_sample);
-			for (uint32_t j = 0; j < (end_sample - i); j++)
-				lsamples.push_back(convert_a2l_threshold(threshold, asamples[j]));
-			lsegment->append_payload(lsamples.data(), lsamples.size());
-			delete[] asamples;
+		conversion_queue_.push_back(segment);
+	}
+	conversion_cond_.notify_one();
+}
+
+void SignalBase::convert_segment(shared_ptr<AnalogSegment> asegment,
+	vector<float> &buffer)
+{
+	shared_ptr<Logic> logic_data = dynamic_pointer_cast<Logic>(converted_data_);
+	assert(logic_data);
+
+	shared_ptr<LogicSegment> lsegment;
+	uint8_t state;
+
+	{
+		lock_guard<mutex> lock(conversion_mutex_);
+
+		// Create the logic segment if needed
+		auto iter = converted_segments_.find(asegment.get());
+		if (iter == converted_segments_.end()) {
+			lsegment = make_shared<LogicSegment>(*logic_data.get(), 1,
+				asegment->samplerate());
+			logic_data->push_segment(lsegment);
+			iter = converted_segments_.emplace(asegment.get(),
+				ConvertedSegment{lsegment, 0}).first;
 		}
 
-		if (conversion_type_ == A2LConversionBySchmittTrigger) {
-			const float amplitude = max_v - min_v;
-			const float lo_thr = min_v + (amplitude * 0.1);  // 10% above min
-			const float hi_thr = max_v - (amplitude * 0.1);  // 10% below max
-			uint8_t state = 0;  // TODO Use value of logic sample n-1 instead of 0
-
-			// Convert as many sample blocks as we can
-			while ((end_sample - i) > block_size) {
-				const float* asamples = asegment->get_samples(i, i + block_size);
-				for (uint32_t j = 0; j < block_size; j++)
-					lsamples.push_back(convert_a2l_schmitt_trigger(lo_thr, hi_thr, asamples[j], state));
-				lsegment->append_payload(lsamples.data(), lsamples.size());
-				i += block_size;
-				lsamples.clear();
-				delete[] asamples;
-			}
+		lsegment = iter->second.segment;
+		state = iter->second.schmitt_state;
+	}
+
+	const uint64_t start_sample = lsegment->get_sample_count();
+	const uint64_t end_sample = asegment->get_sample_count();
 
-			// Convert remaining samples
-			const float* asamples = asegment->get_samples(i, end_sample);
-			for (uint32_t j = 0; j < (end_sample - i); j++)
-				lsamples.push_back(convert_a2l_schmitt_trigger(lo_thr, hi_thr, asamples[j], state));
-			lsegment->append_payload(lsamples.data(), lsamples.size());
-			delete[] asamples;
+	if (start_sample >= end_sample)
+		return;  // Nothing to do
+
+	float min_v, max_v;
+	tie(min_v, max_v) = asegment->get_min_max();
+
+	uint64_t i = start_sample;
+
+	while ((i < end_sample) && !conversion_interrupt_) {
+		// Convert straight into the free space of the logic segment
+		uint64_t space;
+		uint8_t *const dest = lsegment->begin_append(space);
+		const uint64_t count = min(min(end_sample - i, ConversionBlockSize),
+			space);
+
+		asegment->get_samples(i, i + count, buffer.data());
+
+		convert_a2l((ConversionType)conversion_type_, min_v, max_v,
+			buffer.data(), dest, count, state);
+
+		lsegment->end_append(count);
+		i += count;
+	}
+
+	{
+		lock_guard<mutex> lock(conversion_mutex_);
+		auto iter = converted_segments_.find(asegment.get());
+		if (iter != converted_segments_.end())
+			iter->second.schmitt_state = state;
+	}
+
+	logic_data->notify_samples_added(lsegment.get(), start_sample, i);
+}
+
+void SignalBase::conversion_thread_proc()
+{
+	vector<float> buffer(ConversionBlockSize);
+
+	while (true) {
+		shared_ptr<AnalogSegment> asegment;
+
+		{
+			unique_lock<mutex> lock(conversion_mutex_);
+			conversion_cond_.wait(lock, [&] {
+				return conversion_interrupt_ || !conversion_queue_.empty(); });
+
+			if (conversion_interrupt_)
+				return;
+
+			asegment = conversion_queue_.front();
+			conversion_queue_.pop_front();
 		}
+
+		convert_segment(asegment, buffer);
 	}
 }
 
 void SignalBase::on_samples_cleared()
 {
-	if (converted_data_)
-		converted_data_->clear();
+	if (conversion_group_) {
+		conversion_group_->clear();
+		return;
+	}
+
+	if (!conversion_thread_.joinable()) {
+		if (converted_data_)
+			converted_data_->clear();
+		return;
+	}
+
+	// Restart the worker so that it can't touch the discarded segments
+	stop_conversion();
+	converted_data_->clear();
+	start_conversion();
 }
 
 void SignalBase::on_samples_added(QObject* segment, uint64_t start_sample,
 	uint64_t end_sample)
 {
-	(void)segment;
 	(void)start_sample;
 	(void)end_sample;
 
-	if (conversion_type_ != NoConversion) {
+	if (conversion_group_) {
+		conversion_group_->queue_conversion();
+		return;
+	}
 
-		// Wait for the currently ongoing conversion to finish
-		if (conversion_thread_.joinable())
-			conversion_thread_.join();
+	if (!conversion_thread_.joinable())
+		return;
 
-		conversion_thread_ = std::thread(
-			&SignalBase::conversion_thread_proc, this,
-			segment, start_sample, end_sample);
-	}
+	shared_ptr<Analog> analog_data = dynamic_pointer_cast<Analog>(data_);
+	if (!analog_data)
+		return;
+
+	for (const shared_ptr<AnalogSegment> &asegment :
+		analog_data->analog_segments())
+		if (asegment.get() == segment) {
+			queue_conversion(asegment);
+			break;
+		}
 }
 
 void SignalBase::on_capture_state_changed(int state)
 {
-	return;
 	if (state == Session::Stopped) {
 		// Make sure that all data is converted
 
-		if ((channel_type_ == AnalogChannel) &&
-			((conversion_type_ == A2LConversionByTreshold) ||
-			(conversion_type_ == A2LConversionBySchmittTrigger))) {
+		if (conversion_group_)
+			conversion_group_->queue_conversion();
 
+		if ((channel_type_ == AnalogChannel) && conversion_thread_.joinable()) {
 			shared_ptr<Analog> analog_data = dynamic_pointer_cast<Analog>(data_);
 
-			if (analog_data->analog_segments().size() > 0) {
-				// TODO Support for multiple segments is missing
-				AnalogSegment *asegment = analog_data->analog_segments().front().get();
-
-				if (conversion_thread_.joinable())
-					conversion_thread_.join();
-
-				conversion_thread_ = std::thread(
-					&SignalBase::conversion_thread_proc, this, asegment, 0, 0);
-			}
+			if (analog_data)
+				for (const shared_ptr<AnalogSegment> &asegment :
+					analog_data->analog_segments())
+					queue_conversion(asegment);
 		}
 	}
 }
@@ -21,7 +21,13 @@
 #ifndef PULSEVIEW_PV_DATA_SIGNALBASE_HPP
 #define PULSEVIEW_PV_DATA_SIGNALBASE_HPP
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <QColor>
 #include <QObject>
@@ -30,7 +36,13 @@
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
+using std::atomic;
+using std::condition_variable;
+using std::deque;
+using std::map;
+using std::mutex;
 using std::shared_ptr;
+using std::vector;
 
 namespace sigrok {
 class Channel;
@@ -40,8 +52,12 @@ namespace pv {
 namespace data {
 
 class Analog;
+class AnalogSegment;
+class ConversionGroup;
 class DecoderStack;
 class Logic;
+class LogicSegment;
+class MathEngine;
 class SignalData;
 
 class SignalBase : public QObject
@@ -65,6 +81,15 @@ public:
 
 private:
 	static const int ColourBGAlpha;
+	static const uint64_t ConversionBlockSize;
+
+	/// The logic segment an analog segment is converted into, along
+	/// with the conversion state carried over from one range to the next.
+	struct ConvertedSegment
+	{
+		shared_ptr<LogicSegment> segment;
+		uint8_t schmitt_state;
+	};
 
 public:
 	SignalBase(shared_ptr<sigrok::Channel> channel, ChannelType channel_type);
@@ -133,7 +158,8 @@ public:
 	void set_data(shared_ptr<pv::data::SignalData> data);
 
 	/**
-	 * Get the internal data as analog data object in case of analog type.
+	 * Get the internal data as analog data object in case of analog or
+	 * math type.
 	 */
 	shared_ptr<pv::data::Analog> analog_data() const;
 
@@ -147,6 +173,72 @@ public:
 	 */
 	void set_conversion_type(ConversionType t);
 
+	ConversionType conversion_type() const;
+
+	/**
+	 * Makes the conversion results of this channel be packed into the
+	 * logic data of a group, or into a logic data object of its own if
+	 * group is null.
+	 */
+	void set_conversion_group(shared_ptr<ConversionGroup> group);
+
+	shared_ptr<ConversionGroup> conversion_group() const;
+
+	/**
+	 * Sets the engine that computes the data of a math channel.
+	 */
+	void set_math_engine(shared_ptr<MathEngine> engine);
+
+	shared_ptr<MathEngine> math_engine() const;
+
+	/**
+	 * Returns the bit that holds this signal in the unit of logic_data().
+	 */
+	unsigned int logic_bit_index() const;
+
+	/**
+	 * Makes a logic channel use another bit of the unit of logic_data(),
+	 * e.g. after its data was compacted. A negative bit restores the bit
+	 * given by index().
+	 */
+	void set_logic_bit_index(int bit);
+
+	/**
+	 * Converts count analog samples to logic levels.
+	 * @param type The kind of conversion to perform.
+	 * @param min_v The lowest value of the segment the samples belong to.
+	 * @param max_v The highest value of the segment the samples belong to.
+	 * @param state The schmitt trigger state, carried from one call to
+	 * the next.
+	 */
+	static void convert_a2l(ConversionType type, float min_v, float max_v,
+		const float *in, uint8_t *out, uint64_t count, uint8_t &state);
+
+	/**
+	 * Converts count samples to logic levels using a fixed threshold.
+	 */
+	static void convert_a2l_threshold(float threshold, const float *in,
+		uint8_t *out, uint64_t count);
+
+	/**
+	 * Converts count samples to logic levels using a schmitt trigger.
+	 * @param state The output level of the preceding sample. Is updated
+	 * to the output level of the last converted sample.
+	 */
+	static void convert_a2l_schmitt_trigger(float lo_thr, float hi_thr,
+		const float *in, uint8_t *out, uint64_t count, uint8_t &state);
+
+	/**
+	 * The scalar versions of the conversions. They convert the samples
+	 * that don't fill a vector, and are the reference the vectorized
+	 * conversions must match.
+	 */
+	static void convert_a2l_threshold_scalar(float threshold,
+		const float *in, uint8_t *out, uint64_t count);
+	static void convert_a2l_schmitt_trigger_scalar(float lo_thr,
+		float hi_thr, const float *in, uint8_t *out, uint64_t count,
+		uint8_t &state);
+
 #ifdef ENABLE_DECODE
 	bool is_decode_signal() const;
 
@@ -160,12 +252,23 @@ public:
 	void restore_settings(QSettings &settings);
 
 private:
-	uint8_t convert_a2l_threshold(float threshold, float value);
-	uint8_t convert_a2l_schmitt_trigger(float lo_thr, float hi_thr,
-		float value, uint8_t &state);
+	bool is_a2l_conversion() const;
 
-	void conversion_thread_proc(QObject* segment, uint64_t start_sample,
-		uint64_t end_sample);
+	void begin_conversion();
+	void end_conversion();
+
+	void start_conversion();
+	void stop_conversion();
+
+	/**
+	 * Queues the unconverted samples of a segment for conversion.
+	 */
+	void queue_conversion(shared_ptr<AnalogSegment> segment);
+
+	void convert_segment(shared_ptr<AnalogSegment> asegment,
+		vector<float> &buffer);
+
+	void conversion_thread_proc();
 
 Q_SIGNALS:
 	void enabled_changed(const bool &value);
@@ -190,12 +293,20 @@ private:
 	shared_ptr<pv::data::SignalData> data_;
 	shared_ptr<pv::data::SignalData> converted_data_;
 	int conversion_type_;
+	shared_ptr<ConversionGroup> conversion_group_;
+	shared_ptr<MathEngine> math_engine_;
+	int logic_bit_;
 
 #ifdef ENABLE_DECODE
 	shared_ptr<pv::data::DecoderStack> decoder_stack_;
 #endif
 
 	std::thread conversion_thread_;
+	mutex conversion_mutex_;
+	condition_variable conversion_cond_;
+	deque< shared_ptr<AnalogSegment> > conversion_queue_;
+	map<const AnalogSegment*, ConvertedSegment> converted_segments_;
+	atomic<bool> conversion_interrupt_;
 
 	QString internal_name_, name_;
 	QColor colour_, bgcolour_;
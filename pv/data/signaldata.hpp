@@ -27,6 +27,8 @@
 using std::shared_ptr;
 using std::vector;
 
+class QObject;
+
 namespace pv {
 namespace data {
 
@@ -44,6 +46,9 @@ public:
 	virtual void clear() = 0;
 
 	virtual uint64_t max_sample_count() const = 0;
+
+	virtual void notify_samples_added(QObject* segment, uint64_t start_sample,
+		uint64_t end_sample) = 0;
 };
 
 } // namespace data
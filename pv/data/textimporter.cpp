@@ -0,0 +1,212 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <QFile>
+
+#include "textimporter.hpp"
+
+using std::bad_alloc;
+using std::max;
+using std::min;
+using std::thread;
+
+namespace pv {
+namespace data {
+
+const uint64_t TextImporter::PieceSize = 4 * 1024 * 1024;
+const unsigned int TextImporter::MaxLogicChannels = 64;
+
+TextImporter::TextImporter() :
+	samplerate_(0),
+	data_(nullptr),
+	body_(nullptr),
+	size_(0),
+	bytes_processed_(0),
+	logic_channel_count_(0)
+{
+}
+
+TextImporter::~TextImporter()
+{
+}
+
+bool TextImporter::open(const string &path)
+{
+	file_.reset(new QFile(QString::fromStdString(path)));
+	channels_.clear();
+	logic_channel_count_ = 0;
+	bytes_processed_ = 0;
+	error_.clear();
+
+	if (!file_->open(QIODevice::ReadOnly)) {
+		error_ = file_->errorString().toStdString();
+		return false;
+	}
+
+	size_ = file_->size();
+	if (size_ == 0) {
+		error_ = "The file is empty";
+		return false;
+	}
+
+	data_ = (const char*)file_->map(0, size_);
+	if (!data_) {
+		error_ = file_->errorString().toStdString();
+		return false;
+	}
+
+	if (!parse_header(data_, data_ + size_, body_))
+		return false;
+
+	bytes_processed_ = body_ - data_;
+	return true;
+}
+
+const string& TextImporter::error() const
+{
+	return error_;
+}
+
+const vector<TextImporter::Channel>& TextImporter::channels() const
+{
+	return channels_;
+}
+
+unsigned int TextImporter::logic_channel_count() const
+{
+	return logic_channel_count_;
+}
+
+unsigned int TextImporter::analog_channel_count() const
+{
+	return channels_.size() - logic_channel_count_;
+}
+
+unsigned int TextImporter::unit_size() const
+{
+	return max((logic_channel_count_ + 7) / 8, 1U);
+}
+
+double TextImporter::samplerate() const
+{
+	return samplerate_;
+}
+
+uint64_t TextImporter::file_size() const
+{
+	return size_;
+}
+
+uint64_t TextImporter::bytes_processed() const
+{
+	return bytes_processed_;
+}
+
+bool TextImporter::run(LogicSink logic_sink, AnalogSink analog_sink,
+	const atomic<bool> &interrupt)
+{
+	assert(data_);
+
+	const char *const end = data_ + size_;
+	const char *pos = body_;
+
+	const unsigned int thread_count = max(thread::hardware_concurrency(), 1U);
+
+	vector< unique_ptr<Piece> > pieces;
+	for (unsigned int i = 0; i < thread_count; i++)
+		pieces.push_back(create_piece());
+
+	while (pos != end && !interrupt) {
+		// Cut the next batch into one piece per thread
+		unsigned int count = 0;
+		while (count < thread_count && pos != end) {
+			Piece &piece = *pieces[count++];
+			piece.begin = pos;
+			piece.end = ((uint64_t)(end - pos) > PieceSize) ?
+				piece_boundary(pos + PieceSize, end) : end;
+			piece.out_of_memory = false;
+			pos = piece.end;
+		}
+
+		// Parse the first piece in this thread while the others run
+		vector<thread> workers;
+		for (unsigned int i = 1; i < count; i++)
+			workers.emplace_back(&TextImporter::parse_piece_guarded, this,
+				std::ref(*pieces[i]));
+
+		parse_piece_guarded(*pieces[0]);
+
+		for (thread &t : workers)
+			t.join();
+
+		for (unsigned int i = 0; i < count; i++) {
+			if (pieces[i]->out_of_memory)
+				throw bad_alloc();
+
+			emit_piece(*pieces[i], logic_sink, analog_sink);
+			bytes_processed_ = pieces[i]->end - data_;
+		}
+
+		if (!error_.empty())
+			return false;
+	}
+
+	finish(logic_sink, analog_sink);
+
+	return true;
+}
+
+const char* TextImporter::piece_boundary(const char *pos,
+	const char *end) const
+{
+	const char *const eol = (const char*)memchr(pos, '\n', end - pos);
+	return eol ? (eol + 1) : end;
+}
+
+void TextImporter::finish(const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	(void)logic_sink;
+	(void)analog_sink;
+}
+
+void TextImporter::add_channel(const string &name, bool analog)
+{
+	assert(analog || logic_channel_count_ == channels_.size());
+	assert(analog || logic_channel_count_ < MaxLogicChannels);
+
+	channels_.push_back({name, analog});
+	if (!analog)
+		logic_channel_count_++;
+}
+
+void TextImporter::parse_piece_guarded(Piece &piece) const
+{
+	try {
+		parse_piece(piece);
+	} catch (bad_alloc) {
+		piece.out_of_memory = true;
+	}
+}
+
+} // namespace data
+} // namespace pv
@@ -0,0 +1,192 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DATA_TEXTIMPORTER_HPP
+#define PULSEVIEW_PV_DATA_TEXTIMPORTER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using std::atomic;
+using std::function;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+class QFile;
+
+namespace pv {
+namespace data {
+
+/**
+ * The base class of PulseView's own importers for text files.
+ *
+ * The file is mapped and cut into pieces at line boundaries. The pieces
+ * of a batch are parsed in parallel, one per thread, and the results are
+ * then passed on in file order.
+ */
+class TextImporter
+{
+public:
+	struct Channel
+	{
+		string name;
+		bool analog;
+	};
+
+	/**
+	 * Receives logic samples, packed into unit_size() bytes each.
+	 */
+	typedef function<void (const uint8_t *data, uint64_t count)> LogicSink;
+
+	/**
+	 * Receives the samples of one analog channel. The index counts the
+	 * analog channels only.
+	 */
+	typedef function<void (unsigned int index, const float *data,
+		uint64_t count)> AnalogSink;
+
+	/// The amount of text parsed by one thread at a time.
+	static const uint64_t PieceSize;
+
+	/// The maximum number of logic channels, see LogicSegment.
+	static const unsigned int MaxLogicChannels;
+
+protected:
+	/**
+	 * A piece of the file along with what was parsed from it.
+	 */
+	struct Piece
+	{
+		virtual ~Piece() = default;
+
+		const char *begin, *end;
+		bool out_of_memory;
+	};
+
+public:
+	virtual ~TextImporter();
+
+	/**
+	 * Opens a file and parses its header.
+	 * @return false if the file could not be opened, see error().
+	 */
+	bool open(const string &path);
+
+	const string& error() const;
+
+	/**
+	 * Returns the channels, the logic channels first.
+	 */
+	const vector<Channel>& channels() const;
+
+	unsigned int logic_channel_count() const;
+	unsigned int analog_channel_count() const;
+
+	/**
+	 * Returns the number of bytes per logic sample.
+	 */
+	unsigned int unit_size() const;
+
+	/**
+	 * Returns the sample rate, or 0 if the file doesn't specify one.
+	 */
+	double samplerate() const;
+
+	uint64_t file_size() const;
+
+	/**
+	 * Returns the number of bytes that were parsed and passed on.
+	 */
+	uint64_t bytes_processed() const;
+
+	/**
+	 * Parses the samples and passes them on in file order. Blocks until
+	 * the whole file was parsed or interrupt was set.
+	 * @return false if parsing failed, see error().
+	 * @throws std::bad_alloc if memory ran out.
+	 */
+	bool run(LogicSink logic_sink, AnalogSink analog_sink,
+		const atomic<bool> &interrupt);
+
+protected:
+	TextImporter();
+
+	/**
+	 * Parses the header of the file.
+	 * @param body Receives the position where the samples begin.
+	 * @return false if the file can't be parsed, with error_ set.
+	 */
+	virtual bool parse_header(const char *begin, const char *end,
+		const char *&body) = 0;
+
+	/**
+	 * Returns the first position at or after pos at which parsing can
+	 * resume, by default the beginning of the next line.
+	 */
+	virtual const char* piece_boundary(const char *pos,
+		const char *end) const;
+
+	virtual unique_ptr<Piece> create_piece() const = 0;
+
+	/**
+	 * Parses a piece. Called concurrently for the pieces of a batch.
+	 */
+	virtual void parse_piece(Piece &piece) const = 0;
+
+	/**
+	 * Passes the results of a piece on. Called in file order.
+	 */
+	virtual void emit_piece(Piece &piece, const LogicSink &logic_sink,
+		const AnalogSink &analog_sink) = 0;
+
+	/**
+	 * Called after the last piece was passed on.
+	 */
+	virtual void finish(const LogicSink &logic_sink,
+		const AnalogSink &analog_sink);
+
+	/**
+	 * Adds a channel. Logic channels must be added before analog ones.
+	 */
+	void add_channel(const string &name, bool analog);
+
+private:
+	void parse_piece_guarded(Piece &piece) const;
+
+protected:
+	string error_;
+	double samplerate_;
+
+private:
+	unique_ptr<QFile> file_;
+	const char *data_, *body_;
+	uint64_t size_;
+	atomic<uint64_t> bytes_processed_;
+
+	vector<Channel> channels_;
+	unsigned int logic_channel_count_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_TEXTIMPORTER_HPP
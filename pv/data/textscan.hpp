@@ -0,0 +1,207 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DATA_TEXTSCAN_HPP
+#define PULSEVIEW_PV_DATA_TEXTSCAN_HPP
+
+#include <cstdint>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace pv {
+namespace data {
+
+/**
+ * Locale independent helpers to scan numbers in text files quickly.
+ *
+ * Runs of digits are measured 16 bytes at a time and converted 8 digits
+ * at a time, which is what dominates parsing numeric text.
+ */
+namespace textscan {
+
+inline bool is_digit(char c)
+{
+	return (unsigned char)(c - '0') < 10;
+}
+
+inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/**
+ * Returns the number of consecutive decimal digits at p.
+ */
+inline unsigned int digit_run(const char *p, const char *end)
+{
+	const char *const start = p;
+
+#ifdef __SSE2__
+	const __m128i lo = _mm_set1_epi8('0' - 1);
+	const __m128i hi = _mm_set1_epi8('9' + 1);
+
+	while (end - p >= 16) {
+		const __m128i c = _mm_loadu_si128((const __m128i*)p);
+		const unsigned int digits = _mm_movemask_epi8(_mm_and_si128(
+			_mm_cmpgt_epi8(c, lo), _mm_cmplt_epi8(c, hi)));
+
+		if (digits != 0xFFFF)
+			return (p - start) + __builtin_ctz(~digits);
+		p += 16;
+	}
+#endif
+
+	while (p != end && is_digit(*p))
+		p++;
+
+	return p - start;
+}
+
+/**
+ * Reads eight bytes as a little-endian integer, so that the first digit
+ * ends up in the lowest byte on any host. Compilers turn this into a
+ * single load on little-endian hosts.
+ */
+inline uint64_t load_le64(const char *p)
+{
+	const unsigned char *const b = (const unsigned char*)p;
+	return (uint64_t)b[0] | ((uint64_t)b[1] << 8) |
+		((uint64_t)b[2] << 16) | ((uint64_t)b[3] << 24) |
+		((uint64_t)b[4] << 32) | ((uint64_t)b[5] << 40) |
+		((uint64_t)b[6] << 48) | ((uint64_t)b[7] << 56);
+}
+
+/**
+ * Converts a run of at most 19 digits into an integer.
+ */
+inline uint64_t digits_value(const char *p, unsigned int count,
+	const char *end)
+{
+	uint64_t value = 0;
+
+	// Convert eight digits at once within a register where the input
+	// can be read eight bytes at a time
+	while (count >= 8 && end - p >= 8) {
+		uint64_t chunk = load_le64(p);
+		chunk -= 0x3030303030303030ULL;
+		chunk = (chunk * 10) + (chunk >> 8);
+		chunk = (((chunk & 0x000000FF000000FFULL) * 0x000F424000000064ULL) +
+			(((chunk >> 16) & 0x000000FF000000FFULL) *
+				0x0000271000000001ULL)) >> 32;
+		value = value * 100000000 + chunk;
+		p += 8;
+		count -= 8;
+	}
+
+	while (count--)
+		value = value * 10 + (*p++ - '0');
+
+	return value;
+}
+
+/**
+ * Parses an unsigned decimal integer.
+ * @return The position after the number, or p if there is none.
+ */
+inline const char* parse_uint(const char *p, const char *end,
+	uint64_t &value)
+{
+	unsigned int count = digit_run(p, end);
+	value = digits_value(p, (count > 19) ? 19 : count, end);
+	return p + count;
+}
+
+/**
+ * Parses a decimal floating point number with an optional sign, fraction
+ * and exponent.
+ * @return The position after the number, or p if there is none.
+ */
+inline const char* parse_double(const char *p, const char *end,
+	double &value)
+{
+	static const double powers[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char *const start = p;
+	bool negative = false;
+
+	if (p != end && (*p == '-' || *p == '+'))
+		negative = (*p++ == '-');
+
+	// Digits beyond the precision of a double only scale the value
+	unsigned int int_count = digit_run(p, end);
+	const unsigned int int_used = (int_count > 19) ? 19 : int_count;
+	uint64_t mantissa = digits_value(p, int_used, end);
+	int exponent = int_count - int_used;
+	p += int_count;
+
+	unsigned int frac_count = 0;
+	if (p != end && *p == '.') {
+		p++;
+		frac_count = digit_run(p, end);
+		const unsigned int frac_used = (frac_count > 19 - int_used) ?
+			(19 - int_used) : frac_count;
+		for (unsigned int i = 0; i < frac_used; i++)
+			mantissa = mantissa * 10 + (p[i] - '0');
+		exponent -= frac_used;
+		p += frac_count;
+	}
+
+	if (int_count == 0 && frac_count == 0) {
+		value = 0;
+		return start;
+	}
+
+	if (p != end && (*p == 'e' || *p == 'E')) {
+		const char *q = p + 1;
+		bool exp_negative = false;
+		if (q != end && (*q == '-' || *q == '+'))
+			exp_negative = (*q++ == '-');
+
+		uint64_t e;
+		const char *const e_end = parse_uint(q, end, e);
+		if (e_end != q) {
+			if (e > 1000)
+				e = 1000;
+			exponent += exp_negative ? -(int)e : (int)e;
+			p = e_end;
+		}
+	}
+
+	double v = mantissa;
+	while (exponent > 22) {
+		v *= 1e22;
+		exponent -= 22;
+	}
+	while (exponent < -22) {
+		v /= 1e22;
+		exponent += 22;
+	}
+	v = (exponent < 0) ? (v / powers[-exponent]) : (v * powers[exponent]);
+
+	value = negative ? -v : v;
+	return p;
+}
+
+} // namespace textscan
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_TEXTSCAN_HPP
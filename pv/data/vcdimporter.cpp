@@ -0,0 +1,459 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+#include "textscan.hpp"
+#include "vcdimporter.hpp"
+
+using std::min;
+using std::to_string;
+
+namespace pv {
+namespace data {
+
+namespace ts = textscan;
+
+const uint64_t VcdImporter::BlockSamples = 1024 * 1024;
+const uint32_t VcdImporter::TimeMarker = UINT32_MAX;
+const int32_t VcdImporter::NoVariable = -1;
+
+namespace {
+
+const char* token_end(const char *p, const char *end)
+{
+	while (p != end && !ts::is_space(*p))
+		p++;
+	return p;
+}
+
+const char* skip_space(const char *p, const char *end)
+{
+	while (p != end && ts::is_space(*p))
+		p++;
+	return p;
+}
+
+bool is_token(const char *begin, const char *end, const char *token)
+{
+	const size_t length = strlen(token);
+	return (size_t)(end - begin) == length && memcmp(begin, token, length) == 0;
+}
+
+/**
+ * Returns the index of an identifier of one or two characters in the
+ * table of short identifiers, or -1 for longer identifiers.
+ */
+int short_id_index(const char *begin, const char *end)
+{
+	if (end - begin == 1)
+		return (uint8_t)begin[0] & 0x7F;
+	if (end - begin == 2)
+		return 128 + (((uint8_t)begin[0] & 0x7F) << 7) +
+			((uint8_t)begin[1] & 0x7F);
+	return -1;
+}
+
+uint64_t long_id_key(const char *begin, const char *end)
+{
+	uint64_t key = 0;
+	memcpy(&key, begin, min<size_t>(end - begin, sizeof(key)));
+	return key;
+}
+
+/**
+ * Parses a time scale such as "1 ns" or "100ps" into seconds.
+ */
+double parse_timescale(const string &text)
+{
+	double value;
+	const char *const begin = text.data(), *const end = begin + text.size();
+	const char *p = ts::parse_double(begin, end, value);
+	if (p == begin)
+		return 0;
+
+	const string unit(skip_space(p, end), end);
+
+	if (unit == "s")
+		return value;
+	if (unit == "ms")
+		return value * 1e-3;
+	if (unit == "us")
+		return value * 1e-6;
+	if (unit == "ns")
+		return value * 1e-9;
+	if (unit == "ps")
+		return value * 1e-12;
+	if (unit == "fs")
+		return value * 1e-15;
+	return 0;
+}
+
+} // namespace
+
+VcdImporter::VcdImporter(uint64_t downsample, uint64_t compress) :
+	downsample_(std::max<uint64_t>(downsample, 1)),
+	compress_(compress),
+	started_(false),
+	time_(0),
+	logic_state_(0),
+	pending_samples_(0)
+{
+}
+
+bool VcdImporter::parse_header(const char *begin, const char *end,
+	const char *&body)
+{
+	struct Declaration
+	{
+		string id, name;
+		bool analog;
+		unsigned int width;
+	};
+
+	vector<Declaration> declarations;
+	double timescale = 0;
+	bool complete = false;
+
+	const char *p = begin;
+	while (!complete) {
+		p = skip_space(p, end);
+		if (p == end)
+			break;
+
+		const char *const keyword = p;
+		const char *const keyword_end = token_end(p, end);
+
+		if (*keyword != '$') {
+			error_ = "Unexpected \"" + string(keyword, keyword_end) +
+				"\" in the header";
+			return false;
+		}
+
+		// Collect the arguments up to $end
+		vector<string> args;
+		bool closed = false;
+		p = keyword_end;
+
+		while (!closed && (p = skip_space(p, end)) != end) {
+			const char *const arg_end = token_end(p, end);
+			closed = is_token(p, arg_end, "$end");
+			if (!closed)
+				args.emplace_back(p, arg_end);
+			p = arg_end;
+		}
+
+		if (!closed)
+			break;
+
+		if (is_token(keyword, keyword_end, "$enddefinitions")) {
+			complete = true;
+		} else if (is_token(keyword, keyword_end, "$timescale")) {
+			string text;
+			for (const string &a : args)
+				text += a;
+			timescale = parse_timescale(text);
+		} else if (is_token(keyword, keyword_end, "$var") &&
+			args.size() >= 4) {
+			declarations.push_back({args[2], args[3],
+				args[0] == "real" || args[0] == "realtime",
+				(unsigned int)strtoul(args[1].c_str(), nullptr, 10)});
+		}
+
+		// Scopes, comments, the date and the version are not needed
+	}
+
+	if (!complete) {
+		error_ = "The header is incomplete, $enddefinitions is missing";
+		return false;
+	}
+
+	body = p;
+
+	if (timescale > 0)
+		samplerate_ = 1 / (timescale * downsample_);
+
+	// Logic channels come first, so number them in a first pass
+	short_ids_.assign(128 + 128 * 128, NoVariable);
+	ids_.clear();
+	long_ids_.clear();
+	variables_.clear();
+
+	unsigned int logic_count = 0, analog_count = 0;
+
+	for (const bool analog : {false, true})
+		for (const Declaration &d : declarations) {
+			const char *const id = d.id.data(), *const id_end = id + d.id.size();
+
+			// Aliases share the variable of the first declaration
+			if (d.analog != analog || find_variable(id, id_end) != NoVariable)
+				continue;
+
+			if (analog) {
+				variables_.push_back({true, analog_count++, 1});
+				add_channel(d.name, true);
+			} else {
+				if (d.width == 0)
+					continue;
+
+				// Leaving out bits would silently lose data
+				if (d.width > MaxLogicChannels - logic_count) {
+					error_ = "The variables need more than " +
+						to_string(MaxLogicChannels) + " logic channels";
+					return false;
+				}
+
+				variables_.push_back({false, logic_count, d.width});
+				logic_count += d.width;
+
+				for (unsigned int i = 0; i < d.width; i++)
+					add_channel((d.width == 1) ? d.name :
+						(d.name + "[" + to_string(i) + "]"), false);
+			}
+
+			const int index = short_id_index(id, id_end);
+			if (index >= 0)
+				short_ids_[index] = variables_.size() - 1;
+			else if (d.id.size() <= sizeof(uint64_t))
+				ids_[long_id_key(id, id_end)] = variables_.size() - 1;
+			else
+				long_ids_[d.id] = variables_.size() - 1;
+		}
+
+	if (variables_.empty()) {
+		error_ = "The file contains no variables";
+		return false;
+	}
+
+	started_ = false;
+	time_ = 0;
+	logic_state_ = 0;
+	analog_state_.assign(analog_count, 0);
+	analog_out_.assign(analog_count, vector<float>());
+	logic_out_.clear();
+	pending_samples_ = 0;
+
+	return true;
+}
+
+const char* VcdImporter::piece_boundary(const char *pos,
+	const char *end) const
+{
+	// Pieces start at timestamps so that no change is cut in half
+	while (pos != end) {
+		const char *const eol = (const char*)memchr(pos, '\n', end - pos);
+		if (!eol)
+			break;
+
+		pos = eol + 1;
+		if (pos != end && *pos == '#')
+			return pos;
+	}
+
+	return end;
+}
+
+unique_ptr<TextImporter::Piece> VcdImporter::create_piece() const
+{
+	return unique_ptr<Piece>(new VcdPiece);
+}
+
+void VcdImporter::parse_piece(Piece &piece) const
+{
+	VcdPiece &vcd = static_cast<VcdPiece&>(piece);
+	vector<Change> &changes = vcd.changes;
+
+	changes.clear();
+
+	const char *p = vcd.begin;
+	const char *const end = vcd.end;
+
+	while ((p = skip_space(p, end)) != end) {
+		const char c = *p;
+
+		if (c == '#') {
+			uint64_t time;
+			p = ts::parse_uint(p + 1, end, time);
+			changes.push_back({TimeMarker, time});
+			p = token_end(p, end);
+			continue;
+		}
+
+		if (c == '$') {
+			const char *const keyword_end = token_end(p, end);
+			const bool comment = is_token(p, keyword_end, "$comment");
+			p = keyword_end;
+
+			// Keywords like $dumpvars only enclose changes
+			while (comment && (p = skip_space(p, end)) != end) {
+				const char *const e = token_end(p, end);
+				const bool closed = is_token(p, e, "$end");
+				p = e;
+				if (closed)
+					break;
+			}
+			continue;
+		}
+
+		uint64_t value = 0;
+		const char *id;
+
+		if (c == 'b' || c == 'B') {
+			const char *const bits_end = token_end(p, end);
+			for (p++; p != bits_end; p++)
+				value = (value << 1) | (*p == '1');
+			id = skip_space(p, end);
+		} else if (c == 'r' || c == 'R') {
+			double real;
+			ts::parse_double(p + 1, end, real);
+			const float f = real;
+			memcpy(&value, &f, sizeof(f));
+			id = skip_space(token_end(p, end), end);
+		} else {
+			// A scalar: the value is followed by the identifier
+			value = (c == '1' || c == 'h' || c == 'H');
+			id = p + 1;
+		}
+
+		p = token_end(id, end);
+
+		const int32_t variable = find_variable(id, p);
+		if (variable != NoVariable)
+			changes.push_back({(uint32_t)variable, value});
+	}
+}
+
+void VcdImporter::emit_piece(Piece &piece, const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	VcdPiece &vcd = static_cast<VcdPiece&>(piece);
+
+	for (const Change &c : vcd.changes) {
+		if (c.variable == TimeMarker) {
+			const uint64_t time = c.value / downsample_;
+
+			// The samples begin at the first timestamp
+			if (!started_) {
+				started_ = true;
+				time_ = time;
+			} else if (time > time_) {
+				uint64_t count = time - time_;
+				if (compress_ != 0 && count > compress_)
+					count = compress_;
+
+				append_samples(count, logic_sink, analog_sink);
+				time_ = time;
+			}
+			continue;
+		}
+
+		const Variable &v = variables_[c.variable];
+
+		if (v.analog) {
+			memcpy(&analog_state_[v.offset], &c.value, sizeof(float));
+		} else {
+			const uint64_t mask = ((v.width == 64) ? ~0ULL :
+				((1ULL << v.width) - 1)) << v.offset;
+			logic_state_ = (logic_state_ & ~mask) | ((c.value << v.offset) & mask);
+		}
+	}
+
+	flush(logic_sink, analog_sink);
+}
+
+void VcdImporter::finish(const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	// Show the final values as well
+	if (started_)
+		append_samples(1, logic_sink, analog_sink);
+
+	flush(logic_sink, analog_sink);
+}
+
+int32_t VcdImporter::find_variable(const char *begin, const char *end) const
+{
+	const int index = short_id_index(begin, end);
+	if (index >= 0)
+		return short_ids_[index];
+
+	if (end - begin > (ptrdiff_t)sizeof(uint64_t)) {
+		const auto iter = long_ids_.find(string(begin, end));
+		return (iter == long_ids_.end()) ? NoVariable : iter->second;
+	}
+
+	const auto iter = ids_.find(long_id_key(begin, end));
+	return (iter == ids_.end()) ? NoVariable : iter->second;
+}
+
+void VcdImporter::append_samples(uint64_t count, const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	const unsigned int logic_unit_size = unit_size();
+	const bool has_logic = logic_channel_count() > 0;
+
+	uint8_t pattern[sizeof(logic_state_)];
+	for (unsigned int i = 0; i < logic_unit_size; i++)
+		pattern[i] = logic_state_ >> (i * 8);
+
+	while (count > 0) {
+		const uint64_t n = min(count, BlockSamples - pending_samples_);
+
+		if (has_logic) {
+			const size_t prev_size = logic_out_.size();
+			logic_out_.resize(prev_size + n * logic_unit_size);
+
+			uint8_t *dest = logic_out_.data() + prev_size;
+			if (logic_unit_size == 1)
+				memset(dest, pattern[0], n);
+			else
+				for (uint64_t i = 0; i < n; i++, dest += logic_unit_size)
+					memcpy(dest, pattern, logic_unit_size);
+		}
+
+		for (size_t i = 0; i < analog_out_.size(); i++)
+			analog_out_[i].insert(analog_out_[i].end(), n, analog_state_[i]);
+
+		pending_samples_ += n;
+		count -= n;
+
+		if (pending_samples_ == BlockSamples)
+			flush(logic_sink, analog_sink);
+	}
+}
+
+void VcdImporter::flush(const LogicSink &logic_sink,
+	const AnalogSink &analog_sink)
+{
+	if (pending_samples_ == 0)
+		return;
+
+	if (logic_channel_count() > 0)
+		logic_sink(logic_out_.data(), pending_samples_);
+	for (size_t i = 0; i < analog_out_.size(); i++)
+		analog_sink(i, analog_out_[i].data(), pending_samples_);
+
+	logic_out_.clear();
+	for (vector<float> &a : analog_out_)
+		a.clear();
+	pending_samples_ = 0;
+}
+
+} // namespace data
+} // namespace pv
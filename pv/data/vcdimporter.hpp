@@ -0,0 +1,128 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DATA_VCDIMPORTER_HPP
+#define PULSEVIEW_PV_DATA_VCDIMPORTER_HPP
+
+#include <unordered_map>
+
+#include "textimporter.hpp"
+
+using std::string;
+using std::unordered_map;
+
+namespace pv {
+namespace data {
+
+/**
+ * Imports value change dumps as written by HDL simulators.
+ *
+ * Every time unit of the dump becomes a sample, optionally downsampled,
+ * and idle periods can be shortened. Wires, registers and other vectors
+ * become one logic channel per bit, real variables become analog channels.
+ * Files whose vectors need more than MaxLogicChannels logic channels are
+ * rejected, so that they can be imported by other means.
+ *
+ * The pieces of the file start at timestamps. Each is parsed into a list
+ * of value changes concurrently, and the changes are then expanded into
+ * samples in file order.
+ */
+class VcdImporter final : public TextImporter
+{
+private:
+	/// The number of samples passed on at a time.
+	static const uint64_t BlockSamples;
+
+	static const uint32_t TimeMarker;
+	static const int32_t NoVariable;
+
+	struct Variable
+	{
+		bool analog;
+		unsigned int offset;  // The first logic bit or the analog index
+		unsigned int width;
+	};
+
+	struct Change
+	{
+		uint32_t variable;  // or TimeMarker
+		uint64_t value;     // The time, the bits or the float
+	};
+
+	struct VcdPiece : public Piece
+	{
+		vector<Change> changes;
+	};
+
+public:
+	/**
+	 * Constructor.
+	 * @param downsample The number of time units combined into a sample.
+	 * @param compress Idle periods longer than this many samples are
+	 * shortened to it, or 0 to keep them.
+	 */
+	VcdImporter(uint64_t downsample = 1, uint64_t compress = 0);
+
+private:
+	bool parse_header(const char *begin, const char *end, const char *&body);
+
+	const char* piece_boundary(const char *pos, const char *end) const;
+
+	unique_ptr<Piece> create_piece() const;
+
+	void parse_piece(Piece &piece) const;
+
+	void emit_piece(Piece &piece, const LogicSink &logic_sink,
+		const AnalogSink &analog_sink);
+
+	void finish(const LogicSink &logic_sink, const AnalogSink &analog_sink);
+
+	/**
+	 * Returns the variable an identifier refers to, or NoVariable.
+	 */
+	int32_t find_variable(const char *begin, const char *end) const;
+
+	/**
+	 * Appends samples that hold the current values.
+	 */
+	void append_samples(uint64_t count, const LogicSink &logic_sink,
+		const AnalogSink &analog_sink);
+
+	void flush(const LogicSink &logic_sink, const AnalogSink &analog_sink);
+
+private:
+	const uint64_t downsample_;
+	const uint64_t compress_;
+
+	vector<Variable> variables_;
+	vector<int32_t> short_ids_;
+	unordered_map<uint64_t, int32_t> ids_;
+	unordered_map<string, int32_t> long_ids_;  // Longer than 8 characters
+
+	// The state while the changes are expanded into samples
+	bool started_;
+	uint64_t time_;
+	uint64_t logic_state_;
+	vector<float> analog_state_;
+	uint64_t pending_samples_;
+	vector<uint8_t> logic_out_;
+	vector< vector<float> > analog_out_;
+};
+
+} // namespace data
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DATA_VCDIMPORTER_HPP
@@ -0,0 +1,93 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QString>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include <pv/data/containerreader.hpp>
+
+#include "containerfile.hpp"
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+using sigrok::ChannelType;
+
+namespace pv {
+namespace devices {
+
+ContainerFile::ContainerFile(const shared_ptr<sigrok::Context> context,
+	const string &file_name) :
+	File(file_name),
+	context_(context)
+{
+}
+
+shared_ptr<data::ContainerReader> ContainerFile::reader() const
+{
+	return reader_;
+}
+
+void ContainerFile::open()
+{
+	if (session_)
+		close();
+	else
+		session_ = context_->create_session();
+
+	reader_ = make_shared<data::ContainerReader>();
+	if (!reader_->open(file_name_))
+		throw QString::fromStdString(reader_->error());
+
+	// The device only provides the channels, the samples come from the
+	// reader
+	auto device = context_->create_user_device("PulseView", "Capture", "");
+
+	for (const data::ContainerReader::Channel &ch : reader_->channels()) {
+		device->add_channel(ch.index, ch.analog ?
+			ChannelType::ANALOG : ChannelType::LOGIC, ch.name);
+		device->channels().back()->set_enabled(ch.enabled);
+	}
+
+	device_ = device;
+	session_->add_device(device_);
+}
+
+void ContainerFile::close()
+{
+	if (session_)
+		session_->remove_devices();
+
+	reader_.reset();
+}
+
+void ContainerFile::start()
+{
+}
+
+void ContainerFile::run()
+{
+}
+
+void ContainerFile::stop()
+{
+}
+
+} // namespace devices
+} // namespace pv
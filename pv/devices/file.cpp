@@ -22,12 +22,18 @@
 #include "file.hpp"
 
 using std::string;
+using std::chrono::duration;
+using std::chrono::steady_clock;
 
 namespace pv {
 namespace devices {
 
 File::File(const string &file_name) :
-	file_name_(file_name)
+	file_name_(file_name),
+	file_size_(0),
+	bytes_processed_(0),
+	timer_start_bytes_(0),
+	timer_start_(0)
 {
 }
 
@@ -41,5 +47,58 @@ string File::display_name(const DeviceManager&) const
 	return boost::filesystem::path(file_name_).filename().string();
 }
 
+uint64_t File::file_size() const
+{
+	return file_size_;
+}
+
+uint64_t File::bytes_processed() const
+{
+	return bytes_processed_;
+}
+
+double File::throughput() const
+{
+	const steady_clock::rep start = timer_start_;
+	if (start == 0)
+		return 0;
+
+	const double elapsed = duration<double>(steady_clock::now() -
+		steady_clock::time_point(steady_clock::duration(start))).count();
+	const uint64_t bytes = bytes_processed_ - timer_start_bytes_;
+
+	return (elapsed > 0 && bytes > 0) ? (bytes / elapsed) : 0;
+}
+
+double File::remaining_time() const
+{
+	const double rate = throughput();
+	const uint64_t processed = bytes_processed_;
+	const uint64_t size = file_size_;
+
+	if (rate <= 0 || size == 0)
+		return -1;
+
+	return (size > processed) ? ((size - processed) / rate) : 0;
+}
+
+void File::reset_progress(uint64_t file_size)
+{
+	file_size_ = file_size;
+	bytes_processed_ = 0;
+	timer_start_ = 0;
+}
+
+void File::start_progress_timer()
+{
+	timer_start_bytes_ = bytes_processed_.load();
+	timer_start_ = steady_clock::now().time_since_epoch().count();
+}
+
+void File::set_bytes_processed(uint64_t bytes)
+{
+	bytes_processed_ = bytes;
+}
+
 } // namespace devices
 } // namespace pv
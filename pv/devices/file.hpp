@@ -20,10 +20,14 @@
 #ifndef PULSEVIEW_PV_DEVICES_FILE_HPP
 #define PULSEVIEW_PV_DEVICES_FILE_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 
 #include "device.hpp"
 
+using std::atomic;
 using std::string;
 
 namespace pv {
@@ -45,8 +49,48 @@ public:
 	 */
 	string display_name(const DeviceManager&) const;
 
+	/**
+	 * Returns the size of the file if the progress of reading it is
+	 * tracked, or 0 otherwise.
+	 */
+	uint64_t file_size() const;
+
+	/**
+	 * Returns the number of bytes that were read and processed.
+	 */
+	uint64_t bytes_processed() const;
+
+	/**
+	 * Returns the average number of bytes processed per second since
+	 * the file is being read, or 0 if that isn't known yet.
+	 */
+	double throughput() const;
+
+	/**
+	 * Returns the estimated time in seconds until the whole file is
+	 * processed, or a negative value if that isn't known yet.
+	 */
+	double remaining_time() const;
+
+protected:
+	/**
+	 * Starts tracking the progress of reading the file anew.
+	 */
+	void reset_progress(uint64_t file_size);
+
+	/**
+	 * Marks the moment from which the throughput is measured.
+	 */
+	void start_progress_timer();
+
+	void set_bytes_processed(uint64_t bytes);
+
 protected:
 	const string file_name_;
+
+private:
+	atomic<uint64_t> file_size_, bytes_processed_, timer_start_bytes_;
+	atomic<std::chrono::steady_clock::rep> timer_start_;
 };
 
 } // namespace devices
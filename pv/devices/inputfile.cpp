@@ -17,24 +17,32 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
-#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
 
 #include <QString>
 
 #include "inputfile.hpp"
 
+#include <pv/globalsettings.hpp>
+
 using std::map;
+using std::max;
+using std::min;
 using std::shared_ptr;
-using std::streamsize;
 using std::string;
-using std::ifstream;
-using std::ios;
 
 namespace pv {
 namespace devices {
 
-const streamsize InputFile::BufferSize = 16384;
+const uint64_t InputFile::DefaultBlockSize = 1024 * 1024;
+const uint64_t InputFile::MinBlockSize = 64 * 1024;
+const uint64_t InputFile::MaxBlockSize = 64 * 1024 * 1024;
 
 InputFile::InputFile(const shared_ptr<sigrok::Context> &context,
 	const string &file_name,
@@ -44,6 +52,9 @@ InputFile::InputFile(const shared_ptr<sigrok::Context> &context,
 	context_(context),
 	format_(format),
 	options_(options),
+	map_(nullptr),
+	size_(0),
+	block_size_(DefaultBlockSize),
 	interrupt_(false)
 {
 }
@@ -60,18 +71,20 @@ void InputFile::open()
 	if (!input_)
 		throw QString("Failed to create input");
 
+	GlobalSettings settings;
+	block_size_ = settings.value(GlobalSettings::Key_Import_BlockSize,
+		(qulonglong)(DefaultBlockSize / 1024)).toULongLong() * 1024;
+	block_size_ = min(max(block_size_, MinBlockSize), MaxBlockSize);
+
 	// open() should add the input device to the session but
 	// we can't open the device without sending some data first
-	f = new ifstream(file_name_, ios::binary);
+	if (!open_file())
+		throw QString("Failed to open %1").arg(
+			QString::fromStdString(file_name_));
 
-	char buffer[BufferSize];
-	f->read(buffer, BufferSize);
-	const streamsize size = f->gcount();
-	if (size == 0)
+	if (!send_block())
 		return;
 
-	input_->send(buffer, size);
-
 	try {
 		device_ = input_->device();
 	} catch (sigrok::Error) {
@@ -93,31 +106,21 @@ void InputFile::start()
 
 void InputFile::run()
 {
-	char buffer[BufferSize];
-
-	if (!f) {
+	if (!file_.isOpen()) {
 		// Previous call to run() processed the entire file already
-		f = new ifstream(file_name_, ios::binary);
+		if (!open_file())
+			return;
 		input_->reset();
 	}
 
-	interrupt_ = false;
-	while (!interrupt_ && !f->eof()) {
-		f->read(buffer, BufferSize);
-		const streamsize size = f->gcount();
-		if (size == 0)
-			break;
-
-		input_->send(buffer, size);
+	start_progress_timer();
 
-		if (size != BufferSize)
-			break;
-	}
+	interrupt_ = false;
+	while (!interrupt_ && send_block()) {}
 
 	input_->end();
 
-	delete f;
-	f = nullptr;
+	close_file();
 }
 
 void InputFile::stop()
@@ -125,5 +128,67 @@ void InputFile::stop()
 	interrupt_ = true;
 }
 
+bool InputFile::open_file()
+{
+	file_.setFileName(QString::fromStdString(file_name_));
+	if (!file_.open(QIODevice::ReadOnly))
+		return false;
+
+	size_ = file_.size();
+	reset_progress(size_);
+
+	// Mapping the file saves copying it through a buffer and lets the
+	// kernel read ahead. Large reads are the fallback for files that
+	// can't be mapped, e.g. pipes.
+	map_ = (size_ > 0) ? file_.map(0, size_) : nullptr;
+
+	if (map_) {
+#ifndef _WIN32
+		posix_madvise((void*)map_, size_, POSIX_MADV_SEQUENTIAL);
+#endif
+		vector<char>().swap(buffer_);
+	} else {
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+		posix_fadvise(file_.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		buffer_.resize(block_size_);
+	}
+
+	return true;
+}
+
+void InputFile::close_file()
+{
+	if (map_)
+		file_.unmap((uchar*)map_);
+	map_ = nullptr;
+
+	file_.close();
+	vector<char>().swap(buffer_);
+}
+
+bool InputFile::send_block()
+{
+	const uint64_t offset = bytes_processed();
+
+	if (map_) {
+		if (offset >= size_)
+			return false;
+
+		const uint64_t size = min(block_size_, size_ - offset);
+		input_->send((void*)(map_ + offset), size);
+		set_bytes_processed(offset + size);
+	} else {
+		const qint64 size = file_.read(buffer_.data(), buffer_.size());
+		if (size <= 0)
+			return false;
+
+		input_->send(buffer_.data(), size);
+		set_bytes_processed(offset + size);
+	}
+
+	return true;
+}
+
 } // namespace devices
 } // namespace pv
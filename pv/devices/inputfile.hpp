@@ -21,25 +21,39 @@
 #define PULSEVIEW_PV_DEVICE_INPUTFILE_HPP
 
 #include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <QFile>
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
 #include "file.hpp"
 
 using std::atomic;
-using std::ifstream;
 using std::map;
 using std::shared_ptr;
-using std::streamsize;
 using std::string;
+using std::vector;
 
 namespace pv {
 namespace devices {
 
+/**
+ * A file that is read by a libsigrok input module.
+ *
+ * The file is memory-mapped where possible and read with a large buffer
+ * otherwise. It is fed to the input module in blocks of a configurable
+ * size, so that the progress can be followed and loading can be
+ * cancelled between blocks.
+ */
 class InputFile final : public File
 {
-private:
-	static const streamsize BufferSize;
+public:
+	/// The default size of the blocks fed to the input module.
+	static const uint64_t DefaultBlockSize;
+	static const uint64_t MinBlockSize;
+	static const uint64_t MaxBlockSize;
 
 public:
 	InputFile(const shared_ptr<sigrok::Context> &context,
@@ -57,13 +71,27 @@ public:
 
 	void stop();
 
+private:
+	bool open_file();
+	void close_file();
+
+	/**
+	 * Feeds the next block of the file to the input module.
+	 * @return false if the end of the file was reached.
+	 */
+	bool send_block();
+
 private:
 	const shared_ptr<sigrok::Context> context_;
 	const shared_ptr<sigrok::InputFormat> format_;
 	const map<string, Glib::VariantBase> options_;
 	shared_ptr<sigrok::Input> input_;
 
-	ifstream *f;
+	QFile file_;
+	const uint8_t *map_;
+	vector<char> buffer_;
+	uint64_t size_, block_size_;
+
 	atomic<bool> interrupt_;
 };
 
@@ -71,4 +99,3 @@ private:
 } // namespace pv
 
 #endif // PULSEVIEW_PV_SESSIONS_INPUTFILE_HPP
-
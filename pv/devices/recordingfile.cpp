@@ -0,0 +1,93 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QString>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include <pv/data/capturereader.hpp>
+
+#include "recordingfile.hpp"
+
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+
+using sigrok::ChannelType;
+
+namespace pv {
+namespace devices {
+
+RecordingFile::RecordingFile(const shared_ptr<sigrok::Context> context,
+	const string &file_name) :
+	File(file_name),
+	context_(context)
+{
+}
+
+shared_ptr<data::CaptureReader> RecordingFile::reader() const
+{
+	return reader_;
+}
+
+void RecordingFile::open()
+{
+	if (session_)
+		close();
+	else
+		session_ = context_->create_session();
+
+	reader_ = make_shared<data::CaptureReader>();
+	if (!reader_->open(file_name_))
+		throw QString::fromStdString(reader_->error());
+
+	// The device only provides the channels, the samples are replayed
+	// from the reader
+	auto device = context_->create_user_device("PulseView", "Capture", "");
+
+	for (const data::CaptureReader::Channel &ch : reader_->channels()) {
+		device->add_channel(ch.index, ch.analog ?
+			ChannelType::ANALOG : ChannelType::LOGIC, ch.name);
+		device->channels().back()->set_enabled(ch.enabled);
+	}
+
+	device_ = device;
+	session_->add_device(device_);
+}
+
+void RecordingFile::close()
+{
+	if (session_)
+		session_->remove_devices();
+
+	reader_.reset();
+}
+
+void RecordingFile::start()
+{
+}
+
+void RecordingFile::run()
+{
+}
+
+void RecordingFile::stop()
+{
+}
+
+} // namespace devices
+} // namespace pv
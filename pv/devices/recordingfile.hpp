@@ -0,0 +1,71 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_DEVICES_RECORDINGFILE_HPP
+#define PULSEVIEW_PV_DEVICES_RECORDINGFILE_HPP
+
+#include <memory>
+
+#include "file.hpp"
+
+using std::shared_ptr;
+using std::string;
+
+namespace sigrok {
+class Context;
+} // sigrok
+
+namespace pv {
+
+namespace data {
+class CaptureReader;
+}
+
+namespace devices {
+
+/**
+ * A capture recording written during an acquisition. The records are
+ * replayed as packets by Session::load_recording(), which also recovers a
+ * recording that was cut short.
+ */
+class RecordingFile final : public File
+{
+public:
+	RecordingFile(const shared_ptr<sigrok::Context> context,
+		const string &file_name);
+
+	shared_ptr<data::CaptureReader> reader() const;
+
+	void open();
+
+	void close();
+
+	void start();
+
+	void run();
+
+	void stop();
+
+private:
+	const shared_ptr<sigrok::Context> context_;
+	shared_ptr<data::CaptureReader> reader_;
+};
+
+} // namespace devices
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DEVICES_RECORDINGFILE_HPP
@@ -0,0 +1,193 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <algorithm>
+
+#include <cassert>
+#include <set>
+
+#include <QString>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include <pv/data/csvimporter.hpp>
+#include <pv/data/vcdimporter.hpp>
+
+#include "textfile.hpp"
+
+using std::make_shared;
+using std::map;
+using std::set;
+using std::shared_ptr;
+using std::string;
+
+using sigrok::ChannelType;
+
+namespace pv {
+namespace devices {
+
+namespace {
+
+uint64_t option_value(const map<string, Glib::VariantBase> &options,
+	const string &key)
+{
+	const auto iter = options.find(key);
+	if (iter == options.end())
+		return 0;
+
+	const Glib::VariantBase &value = iter->second;
+
+	if (value.is_of_type(Glib::VARIANT_TYPE_UINT64))
+		return Glib::VariantBase::cast_dynamic<Glib::Variant<guint64>>(
+			value).get();
+	if (value.is_of_type(Glib::VARIANT_TYPE_INT32))
+		return std::max(Glib::VariantBase::cast_dynamic<
+			Glib::Variant<gint32>>(value).get(), 0);
+	return 0;
+}
+
+} // namespace
+
+TextFile::TextFile(const shared_ptr<sigrok::Context> &context,
+	const string &file_name, const string &format,
+	const map<string, Glib::VariantBase> &options) :
+	File(file_name),
+	context_(context),
+	format_(format),
+	options_(options),
+	imported_(false),
+	interrupt_(false)
+{
+}
+
+bool TextFile::is_supported(const shared_ptr<sigrok::InputFormat> &format,
+	const map<string, Glib::VariantBase> &options)
+{
+	assert(format);
+
+	set<string> implemented;
+	if (format->name() == "csv")
+		implemented = {"samplerate"};
+	else if (format->name() == "vcd")
+		implemented = {"downsample", "compress"};
+	else
+		return false;
+
+	// Any other option changes how the file is read in a way only the
+	// libsigrok input module knows about
+	const auto format_options = format->options();
+	for (const auto &entry : options) {
+		if (implemented.count(entry.first))
+			continue;
+
+		const auto iter = format_options.find(entry.first);
+		if (iter == format_options.end() ||
+			!entry.second.equal(iter->second->default_value()))
+			return false;
+	}
+
+	return true;
+}
+
+shared_ptr<data::TextImporter> TextFile::importer() const
+{
+	return importer_;
+}
+
+void TextFile::open()
+{
+	if (session_)
+		close();
+	else
+		session_ = context_->create_session();
+
+	if (format_ == "vcd")
+		importer_ = make_shared<data::VcdImporter>(
+			option_value(options_, "downsample"),
+			option_value(options_, "compress"));
+	else
+		importer_ = make_shared<data::CsvImporter>(
+			option_value(options_, "samplerate"));
+
+	if (!importer_->open(file_name_))
+		throw QString::fromStdString(importer_->error());
+
+	imported_ = false;
+	reset_progress(importer_->file_size());
+
+	// The device only provides the channels, the samples come from the
+	// importer
+	auto device = context_->create_user_device("PulseView", "Import", "");
+
+	unsigned int index = 0;
+	for (const data::TextImporter::Channel &ch : importer_->channels())
+		device->add_channel(index++, ch.analog ?
+			ChannelType::ANALOG : ChannelType::LOGIC, ch.name);
+
+	device_ = device;
+	session_->add_device(device_);
+}
+
+void TextFile::close()
+{
+	if (session_)
+		session_->remove_devices();
+
+	importer_.reset();
+}
+
+void TextFile::start()
+{
+}
+
+void TextFile::run()
+{
+}
+
+void TextFile::stop()
+{
+	interrupt_ = true;
+}
+
+bool TextFile::import(data::TextImporter::LogicSink logic_sink,
+	data::TextImporter::AnalogSink analog_sink)
+{
+	// The importer has to start over to read the file again
+	if (imported_ && !importer_->open(file_name_))
+		return false;
+
+	imported_ = true;
+	interrupt_ = false;
+
+	reset_progress(importer_->file_size());
+	start_progress_timer();
+
+	const bool result = importer_->run(
+		[&](const uint8_t *data, uint64_t count) {
+			logic_sink(data, count);
+			set_bytes_processed(importer_->bytes_processed()); },
+		[&](unsigned int index, const float *data, uint64_t count) {
+			analog_sink(index, data, count);
+			set_bytes_processed(importer_->bytes_processed()); },
+		interrupt_);
+
+	set_bytes_processed(importer_->bytes_processed());
+
+	return result;
+}
+
+} // namespace devices
+} // namespace pv
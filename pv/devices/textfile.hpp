@@ -0,0 +1,105 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DEVICES_TEXTFILE_HPP
+#define PULSEVIEW_PV_DEVICES_TEXTFILE_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+
+#include <pv/data/textimporter.hpp>
+
+#include "file.hpp"
+
+using std::atomic;
+using std::map;
+using std::shared_ptr;
+using std::string;
+
+namespace Glib {
+class VariantBase;
+}
+
+namespace sigrok {
+class Context;
+class InputFormat;
+} // sigrok
+
+namespace pv {
+namespace devices {
+
+/**
+ * A VCD or CSV file that is parsed by PulseView's own importers instead of
+ * a libsigrok input module. The samples are put into the segments
+ * directly, see Session::load_text().
+ */
+class TextFile final : public File
+{
+public:
+	/**
+	 * Constructor.
+	 * @param format The name of the libsigrok input format the file
+	 * would otherwise be imported with, see is_supported().
+	 * @param options The options of that input format. The sample rate
+	 * of CSV files and the downsampling and idle compression of VCD files
+	 * are honoured.
+	 */
+	TextFile(const shared_ptr<sigrok::Context> &context,
+		const string &file_name, const string &format,
+		const map<string, Glib::VariantBase> &options);
+
+	/**
+	 * Returns true if files of a libsigrok input format can be imported
+	 * natively with the given options. Options the native importers don't
+	 * implement must keep their default values.
+	 */
+	static bool is_supported(const shared_ptr<sigrok::InputFormat> &format,
+		const map<string, Glib::VariantBase> &options);
+
+	shared_ptr<data::TextImporter> importer() const;
+
+	void open();
+
+	void close();
+
+	void start();
+
+	void run();
+
+	void stop();
+
+	/**
+	 * Parses the file and passes the samples on.
+	 * @return false if parsing failed, see importer().
+	 */
+	bool import(data::TextImporter::LogicSink logic_sink,
+		data::TextImporter::AnalogSink analog_sink);
+
+private:
+	const shared_ptr<sigrok::Context> context_;
+	const string format_;
+	const map<string, Glib::VariantBase> options_;
+	shared_ptr<data::TextImporter> importer_;
+
+	bool imported_;
+	atomic<bool> interrupt_;
+};
+
+} // namespace devices
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DEVICES_TEXTFILE_HPP
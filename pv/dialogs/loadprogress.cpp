@@ -0,0 +1,102 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <cassert>
+
+#include <QFileInfo>
+
+#include "loadprogress.hpp"
+
+#include <pv/session.hpp>
+#include <pv/util.hpp>
+#include <pv/devices/file.hpp>
+
+namespace pv {
+namespace dialogs {
+
+const int LoadProgress::UpdateInterval = 100;
+
+LoadProgress::LoadProgress(Session &session,
+	shared_ptr<devices::File> file, QWidget *parent) :
+	QProgressDialog(tr("Loading..."), tr("Cancel"), 0, 1000, parent),
+	session_(session),
+	file_(file)
+{
+	assert(file_);
+
+	setWindowTitle(tr("Loading %1").arg(QFileInfo(
+		QString::fromStdString(file_->full_name())).fileName()));
+	setMinimumDuration(500);
+	setAutoClose(false);
+	setAutoReset(false);
+
+	// The dialog closes itself as soon as the capture has stopped, which
+	// may already be the case here
+	setAttribute(Qt::WA_DeleteOnClose);
+
+	connect(&session_, SIGNAL(capture_state_changed(int)),
+		this, SLOT(on_capture_state_changed(int)));
+	connect(this, SIGNAL(canceled()), this, SLOT(on_canceled()));
+	connect(&timer_, SIGNAL(timeout()), this, SLOT(on_timer()));
+
+	timer_.start(UpdateInterval);
+	on_capture_state_changed(session_.get_capture_state());
+}
+
+void LoadProgress::on_timer()
+{
+	const double MiB = 1024 * 1024;
+
+	const uint64_t size = file_->file_size();
+	const uint64_t processed = file_->bytes_processed();
+	const double throughput = file_->throughput();
+	const double remaining = file_->remaining_time();
+
+	QString text = (size > 0) ?
+		tr("%1 of %2 MiB read").arg(processed / MiB, 0, 'f', 1)
+			.arg(size / MiB, 0, 'f', 1) :
+		tr("%1 MiB read").arg(processed / MiB, 0, 'f', 1);
+
+	if (throughput > 0)
+		text += tr(" at %1 MiB/s").arg(throughput / MiB, 0, 'f', 1);
+
+	if (remaining >= 0)
+		text += tr(", %1 remaining").arg(util::format_time_minutes(
+			util::Timestamp(remaining), 0, false));
+
+	setLabelText(text);
+
+	if (size > 0)
+		setValue((int)(processed * 1000 / size));
+}
+
+void LoadProgress::on_capture_state_changed(int state)
+{
+	if (state != Session::Stopped)
+		return;
+
+	timer_.stop();
+	close();
+}
+
+void LoadProgress::on_canceled()
+{
+	// The samples read so far are kept
+	session_.stop_capture();
+}
+
+} // namespace dialogs
+} // namespace pv
@@ -0,0 +1,66 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DIALOGS_LOADPROGRESS_HPP
+#define PULSEVIEW_PV_DIALOGS_LOADPROGRESS_HPP
+
+#include <memory>
+
+#include <QProgressDialog>
+#include <QTimer>
+
+using std::shared_ptr;
+
+namespace pv {
+
+class Session;
+
+namespace devices {
+class File;
+}
+
+namespace dialogs {
+
+/**
+ * Shows the progress of a file while it is read, and allows reading to be
+ * cancelled. The dialog deletes itself when it is closed.
+ */
+class LoadProgress : public QProgressDialog
+{
+	Q_OBJECT
+
+private:
+	static const int UpdateInterval; // ms
+
+public:
+	LoadProgress(Session &session, shared_ptr<devices::File> file,
+		QWidget *parent = nullptr);
+
+private Q_SLOTS:
+	void on_timer();
+	void on_capture_state_changed(int state);
+	void on_canceled();
+
+private:
+	Session &session_;
+	const shared_ptr<devices::File> file_;
+	QTimer timer_;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DIALOGS_LOADPROGRESS_HPP
@@ -0,0 +1,74 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <QFileInfo>
+
+#include "loadrange.hpp"
+
+namespace pv {
+namespace dialogs {
+
+LoadRange::LoadRange(const QString &file_name, QWidget *parent) :
+	QDialog(parent),
+	layout_(this),
+	button_box_(QDialogButtonBox::Ok | QDialogButtonBox::Cancel,
+		Qt::Horizontal, this)
+{
+	setWindowTitle(tr("Open Range"));
+
+	description_.setText(tr("Only the samples within the given time range "
+		"of %1 are loaded. For files without a sample rate the range is "
+		"given in samples.").arg(QFileInfo(file_name).fileName()));
+	description_.setWordWrap(true);
+
+	start_.setDecimals(6);
+	start_.setRange(0, 1e9);
+	start_.setSuffix(tr(" s"));
+
+	// The minimum of the end is shown as "End of file"
+	end_.setDecimals(6);
+	end_.setRange(0, 1e9);
+	end_.setSuffix(tr(" s"));
+	end_.setSpecialValueText(tr("End of file"));
+
+	decimation_.setRange(1, 1000000);
+	decimation_.setToolTip(tr("Loads only every n-th sample, which gives "
+		"an overview of files that are too large to load completely"));
+
+	form_.addRow(tr("Start"), &start_);
+	form_.addRow(tr("End"), &end_);
+	form_.addRow(tr("Keep every n-th sample"), &decimation_);
+
+	connect(&button_box_, SIGNAL(accepted()), this, SLOT(accept()));
+	connect(&button_box_, SIGNAL(rejected()), this, SLOT(reject()));
+
+	layout_.addWidget(&description_);
+	layout_.addLayout(&form_);
+	layout_.addWidget(&button_box_);
+}
+
+data::SampleWindow LoadRange::window() const
+{
+	const double end = (end_.value() == end_.minimum()) ? -1 : end_.value();
+
+	if (start_.value() == 0 && end < 0 && decimation_.value() == 1)
+		return data::SampleWindow();
+
+	return data::SampleWindow(start_.value(), end, decimation_.value());
+}
+
+} // namespace dialogs
+} // namespace pv
@@ -0,0 +1,60 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef PULSEVIEW_PV_DIALOGS_LOADRANGE_HPP
+#define PULSEVIEW_PV_DIALOGS_LOADRANGE_HPP
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QLabel>
+#include <QSpinBox>
+#include <QVBoxLayout>
+
+#include <pv/data/samplewindow.hpp>
+
+namespace pv {
+namespace dialogs {
+
+/**
+ * Asks for the part of a file that should be loaded.
+ */
+class LoadRange : public QDialog
+{
+	Q_OBJECT
+
+public:
+	LoadRange(const QString &file_name, QWidget *parent = nullptr);
+
+	/**
+	 * Returns the window that was entered.
+	 */
+	data::SampleWindow window() const;
+
+private:
+	QVBoxLayout layout_;
+	QLabel description_;
+	QFormLayout form_;
+	QDoubleSpinBox start_, end_;
+	QSpinBox decimation_;
+	QDialogButtonBox button_box_;
+};
+
+} // namespace dialogs
+} // namespace pv
+
+#endif // PULSEVIEW_PV_DIALOGS_LOADRANGE_HPP
@@ -24,6 +24,8 @@
 #include <QGroupBox>
 #include <QHBoxLayout>
 #include <QLabel>
+#include <QLineEdit>
+#include <QSpinBox>
 #include <QString>
 #include <QTextBrowser>
 #include <QTextDocument>
@@ -33,6 +35,8 @@
 
 #include "pv/devicemanager.hpp"
 #include "pv/globalsettings.hpp"
+#include "pv/data/notificationscheduler.hpp"
+#include "pv/devices/inputfile.hpp"
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
@@ -96,6 +100,15 @@ void Settings::create_pages()
 	viewButton->setTextAlignment(Qt::AlignHCenter);
 	viewButton->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
 
+	// Capture page
+	pages->addWidget(get_capture_settings_form(pages));
+
+	QListWidgetItem *captureButton = new QListWidgetItem(page_list);
+	captureButton->setIcon(QIcon(":/icons/document-open.png"));
+	captureButton->setText(tr("Capture"));
+	captureButton->setTextAlignment(Qt::AlignHCenter);
+	captureButton->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+
 	// About page
 	pages->addWidget(get_about_page(pages));
 
@@ -145,6 +158,79 @@ QWidget *Settings::get_view_settings_form(QWidget *parent) const
 	connect(show_analog_minor_grid_cb, SIGNAL(stateChanged(int)), this, SLOT(on_view_showAnalogMinorGrid_changed(int)));
 	trace_view_layout->addRow(tr("Show analog minor grid in addition to vdiv grid"), show_analog_minor_grid_cb);
 
+	QCheckBox *show_render_profile_cb = new QCheckBox();
+	show_render_profile_cb->setChecked(settings.value(GlobalSettings::Key_View_ShowRenderProfile).toBool());
+	connect(show_render_profile_cb, SIGNAL(stateChanged(int)), this, SLOT(on_view_showRenderProfile_changed(int)));
+	trace_view_layout->addRow(tr("Show the time spent &painting the view"), show_render_profile_cb);
+
+	return form;
+}
+
+QWidget *Settings::get_capture_settings_form(QWidget *parent) const
+{
+	GlobalSettings settings;
+
+	QWidget *form = new QWidget(parent);
+	QVBoxLayout *form_layout = new QVBoxLayout(form);
+
+	// Capture settings
+	QGroupBox *capture_group = new QGroupBox(tr("Capture"));
+	form_layout->addWidget(capture_group);
+
+	QFormLayout *capture_layout = new QFormLayout();
+	capture_group->setLayout(capture_layout);
+
+	QCheckBox *record_to_disk_cb = new QCheckBox();
+	record_to_disk_cb->setChecked(settings.value(GlobalSettings::Key_Capture_RecordToDisk).toBool());
+	connect(record_to_disk_cb, SIGNAL(stateChanged(int)), this, SLOT(on_capture_recordToDisk_changed(int)));
+	capture_layout->addRow(tr("&Record captures to disk while they run"), record_to_disk_cb);
+
+	QLineEdit *record_directory_le = new QLineEdit();
+	record_directory_le->setText(settings.value(GlobalSettings::Key_Capture_RecordDirectory).toString());
+	record_directory_le->setPlaceholderText(tr("Documents folder"));
+	connect(record_directory_le, SIGNAL(textChanged(const QString&)),
+		this, SLOT(on_capture_recordDirectory_changed(const QString&)));
+	capture_layout->addRow(tr("Recording &directory"), record_directory_le);
+
+	QSpinBox *autosave_interval_sb = new QSpinBox();
+	autosave_interval_sb->setRange(0, 3600);
+	autosave_interval_sb->setSuffix(tr(" s"));
+	autosave_interval_sb->setSpecialValueText(tr("Off"));
+	autosave_interval_sb->setValue(settings.value(GlobalSettings::Key_Capture_AutosaveInterval).toInt());
+	connect(autosave_interval_sb, SIGNAL(valueChanged(int)), this, SLOT(on_capture_autosaveInterval_changed(int)));
+	capture_layout->addRow(tr("&Autosave captures to the recording directory every"), autosave_interval_sb);
+
+	QSpinBox *notification_rate_sb = new QSpinBox();
+	notification_rate_sb->setRange(data::NotificationScheduler::MinRate,
+		data::NotificationScheduler::MaxRate);
+	notification_rate_sb->setSuffix(tr(" Hz"));
+	notification_rate_sb->setValue(settings.value(GlobalSettings::Key_Data_NotificationRate,
+		data::NotificationScheduler::DefaultRate).toInt());
+	connect(notification_rate_sb, SIGNAL(valueChanged(int)), this, SLOT(on_data_notificationRate_changed(int)));
+	capture_layout->addRow(tr("Maximum &update rate for new data during capture"), notification_rate_sb);
+
+	// Import settings
+	QGroupBox *import_group = new QGroupBox(tr("Import"));
+	form_layout->addWidget(import_group);
+
+	QFormLayout *import_layout = new QFormLayout();
+	import_group->setLayout(import_layout);
+
+	QSpinBox *block_size_sb = new QSpinBox();
+	block_size_sb->setRange(devices::InputFile::MinBlockSize / 1024,
+		devices::InputFile::MaxBlockSize / 1024);
+	block_size_sb->setSingleStep(64);
+	block_size_sb->setSuffix(tr(" KiB"));
+	block_size_sb->setValue(settings.value(GlobalSettings::Key_Import_BlockSize,
+		(qulonglong)(devices::InputFile::DefaultBlockSize / 1024)).toInt());
+	connect(block_size_sb, SIGNAL(valueChanged(int)), this, SLOT(on_import_blockSize_changed(int)));
+	import_layout->addRow(tr("&Block size for reading imported files"), block_size_sb);
+
+	QCheckBox *native_import_cb = new QCheckBox();
+	native_import_cb->setChecked(settings.value(GlobalSettings::Key_Import_Native, true).toBool());
+	connect(native_import_cb, SIGNAL(stateChanged(int)), this, SLOT(on_import_native_changed(int)));
+	import_layout->addRow(tr("Import VCD and CSV files with the built-in &parallel importer"), native_import_cb);
+
 	return form;
 }
 
@@ -309,5 +395,47 @@ void Settings::on_view_showAnalogMinorGrid_changed(int state)
 	settings.setValue(GlobalSettings::Key_View_ShowAnalogMinorGrid, state ? true : false);
 }
 
+void Settings::on_view_showRenderProfile_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_View_ShowRenderProfile, state ? true : false);
+}
+
+void Settings::on_data_notificationRate_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Data_NotificationRate, value);
+}
+
+void Settings::on_capture_recordToDisk_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Capture_RecordToDisk, state ? true : false);
+}
+
+void Settings::on_capture_recordDirectory_changed(const QString &text)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Capture_RecordDirectory, text);
+}
+
+void Settings::on_capture_autosaveInterval_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Capture_AutosaveInterval, value);
+}
+
+void Settings::on_import_blockSize_changed(int value)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Import_BlockSize, value);
+}
+
+void Settings::on_import_native_changed(int state)
+{
+	GlobalSettings settings;
+	settings.setValue(GlobalSettings::Key_Import_Native, state ? true : false);
+}
+
 } // namespace dialogs
 } // namespace pv
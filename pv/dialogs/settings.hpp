@@ -40,6 +40,7 @@ public:
 	void create_pages();
 
 	QWidget *get_view_settings_form(QWidget *parent) const;
+	QWidget *get_capture_settings_form(QWidget *parent) const;
 	QWidget *get_about_page(QWidget *parent) const;
 
 	void accept();
@@ -52,6 +53,13 @@ private Q_SLOTS:
 	void on_view_stickyScrolling_changed(int state);
 	void on_view_showSamplingPoints_changed(int state);
 	void on_view_showAnalogMinorGrid_changed(int state);
+	void on_view_showRenderProfile_changed(int state);
+	void on_data_notificationRate_changed(int value);
+	void on_capture_recordToDisk_changed(int state);
+	void on_capture_recordDirectory_changed(const QString &text);
+	void on_capture_autosaveInterval_changed(int value);
+	void on_import_blockSize_changed(int value);
+	void on_import_native_changed(int state);
 
 private:
 	DeviceManager &device_manager_;
@@ -30,6 +30,13 @@ const QString GlobalSettings::Key_View_ColouredBG = "View_ColouredBG";
 const QString GlobalSettings::Key_View_StickyScrolling = "View_StickyScrolling";
 const QString GlobalSettings::Key_View_ShowSamplingPoints = "View_ShowSamplingPoints";
 const QString GlobalSettings::Key_View_ShowAnalogMinorGrid = "View_ShowAnalogMinorGrid";
+const QString GlobalSettings::Key_View_ShowRenderProfile = "View_ShowRenderProfile";
+const QString GlobalSettings::Key_Data_NotificationRate = "Data_NotificationRate";
+const QString GlobalSettings::Key_Capture_RecordToDisk = "Capture_RecordToDisk";
+const QString GlobalSettings::Key_Capture_RecordDirectory = "Capture_RecordDirectory";
+const QString GlobalSettings::Key_Capture_AutosaveInterval = "Capture_AutosaveInterval";
+const QString GlobalSettings::Key_Import_BlockSize = "Import_BlockSize";
+const QString GlobalSettings::Key_Import_Native = "Import_Native";
 
 multimap< QString, function<void(QVariant)> > GlobalSettings::callbacks_;
 bool GlobalSettings::tracking_ = false;
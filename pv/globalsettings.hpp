@@ -43,6 +43,13 @@ public:
 	static const QString Key_View_StickyScrolling;
 	static const QString Key_View_ShowSamplingPoints;
 	static const QString Key_View_ShowAnalogMinorGrid;
+	static const QString Key_View_ShowRenderProfile;
+	static const QString Key_Data_NotificationRate;
+	static const QString Key_Capture_RecordToDisk;
+	static const QString Key_Capture_RecordDirectory;
+	static const QString Key_Capture_AutosaveInterval;
+	static const QString Key_Import_BlockSize;
+	static const QString Key_Import_Native;
 
 public:
 	GlobalSettings();
@@ -91,6 +91,9 @@ MainWindow::MainWindow(DeviceManager &device_manager,
 	GlobalSettings::register_change_handler(GlobalSettings::Key_View_ShowAnalogMinorGrid,
 		bind(&MainWindow::on_settingViewShowAnalogMinorGrid_changed, this, _1));
 
+	GlobalSettings::register_change_handler(GlobalSettings::Key_View_ShowRenderProfile,
+		bind(&MainWindow::on_settingViewShowRenderProfile_changed, this, _1));
+
 	setup_ui();
 	restore_ui_settings();
 
@@ -209,6 +212,7 @@ shared_ptr<views::ViewBase> MainWindow::add_view(const QString &title,
 		tv->enable_coloured_bg(settings.value(GlobalSettings::Key_View_ColouredBG).toBool());
 		tv->enable_show_sampling_points(settings.value(GlobalSettings::Key_View_ShowSamplingPoints).toBool());
 		tv->enable_show_analog_minor_grid(settings.value(GlobalSettings::Key_View_ShowAnalogMinorGrid).toBool());
+		tv->enable_show_render_profile(settings.value(GlobalSettings::Key_View_ShowRenderProfile).toBool());
 
 		if (!main_bar) {
 			/* Initial view, create the main bar */
@@ -805,6 +809,21 @@ void MainWindow::on_settingViewShowAnalogMinorGrid_changed(const QVariant new_va
 	}
 }
 
+void MainWindow::on_settingViewShowRenderProfile_changed(const QVariant new_value)
+{
+	bool state = new_value.toBool();
+
+	for (auto entry : view_docks_) {
+		shared_ptr<views::ViewBase> viewbase = entry.second;
+
+		// Only trace views have this setting
+		views::TraceView::View* view =
+				qobject_cast<views::TraceView::View*>(viewbase.get());
+		if (view)
+			view->enable_show_render_profile(state);
+	}
+}
+
 void MainWindow::on_close_current_tab()
 {
 	int tab = session_selector_.currentIndex();
@@ -134,6 +134,7 @@ private Q_SLOTS:
 	void on_settingViewColouredBg_changed(const QVariant new_value);
 	void on_settingViewShowSamplingPoints_changed(const QVariant new_value);
 	void on_settingViewShowAnalogMinorGrid_changed(const QVariant new_value);
+	void on_settingViewShowRenderProfile_changed(const QVariant new_value);
 
 	void on_close_current_tab();
 
@@ -19,6 +19,7 @@
 
 #include <map>
 
+#include <QApplication>
 #include <QCheckBox>
 #include <QFormLayout>
 #include <QGridLayout>
@@ -57,6 +58,7 @@ Channels::Channels(Session &session, QWidget *parent) :
 	updating_channels_(false),
 	enable_all_channels_(tr("Enable All"), this),
 	disable_all_channels_(tr("Disable All"), this),
+	compact_data_(tr("Compact Data"), this),
 	check_box_mapper_(this)
 {
 	// Create the layout
@@ -111,13 +113,19 @@ Channels::Channels(Session &session, QWidget *parent) :
 		this, SLOT(enable_all_channels()));
 	connect(&disable_all_channels_, SIGNAL(clicked()),
 		this, SLOT(disable_all_channels()));
+	connect(&compact_data_, SIGNAL(clicked()),
+		this, SLOT(compact_data()));
 
 	enable_all_channels_.setFlat(true);
 	disable_all_channels_.setFlat(true);
+	compact_data_.setFlat(true);
+	compact_data_.setToolTip(tr("Free the memory used by the samples of "
+		"the disabled logic channels"));
 
 	buttons_bar_.addWidget(&enable_all_channels_);
 	buttons_bar_.addWidget(&disable_all_channels_);
 	buttons_bar_.addStretch(1);
+	buttons_bar_.addWidget(&compact_data_);
 
 	layout_.addRow(&buttons_bar_);
 
@@ -244,5 +252,12 @@ void Channels::disable_all_channels()
 	set_all_channels(false);
 }
 
+void Channels::compact_data()
+{
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	session_.compact_logic_data();
+	QApplication::restoreOverrideCursor();
+}
+
 }  // namespace popups
 }  // namespace pv
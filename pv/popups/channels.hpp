@@ -85,6 +85,8 @@ private Q_SLOTS:
 	void enable_all_channels();
 	void disable_all_channels();
 
+	void compact_data();
+
 private:
 	pv::Session &session_;
 
@@ -99,6 +101,7 @@ private:
 	QHBoxLayout buttons_bar_;
 	QPushButton enable_all_channels_;
 	QPushButton disable_all_channels_;
+	QPushButton compact_data_;
 
 	QSignalMapper check_box_mapper_;
 };
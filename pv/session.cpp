@@ -17,28 +17,43 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QDateTime>
+#include <QDir>
 #include <QFileInfo>
+#include <QStandardPaths>
 
 #include <cassert>
+#include <cstring>
 #include <mutex>
 #include <stdexcept>
 
 #include <sys/stat.h>
 
 #include "devicemanager.hpp"
+#include "globalsettings.hpp"
 #include "session.hpp"
+#include "storesession.hpp"
 
 #include "data/analog.hpp"
 #include "data/analogsegment.hpp"
+#include "data/captureformat.hpp"
+#include "data/capturereader.hpp"
+#include "data/channelcompactor.hpp"
+#include "data/containerreader.hpp"
+#include "data/conversiongroup.hpp"
 #include "data/decode/decoder.hpp"
 #include "data/decoderstack.hpp"
 #include "data/logic.hpp"
 #include "data/logicsegment.hpp"
+#include "data/mathengine.hpp"
 #include "data/signalbase.hpp"
 
+#include "devices/containerfile.hpp"
 #include "devices/hardwaredevice.hpp"
 #include "devices/inputfile.hpp"
+#include "devices/recordingfile.hpp"
 #include "devices/sessionfile.hpp"
+#include "devices/textfile.hpp"
 
 #include "toolbars/mainbar.hpp"
 
@@ -54,7 +69,9 @@
 #include <libsigrokdecode/libsigrokdecode.h>
 #endif
 
+using std::any_of;
 using std::bad_alloc;
+using std::deque;
 using std::dynamic_pointer_cast;
 using std::find_if;
 using std::function;
@@ -64,8 +81,10 @@ using std::make_pair;
 using std::make_shared;
 using std::map;
 using std::max;
+using std::min;
 using std::move;
 using std::mutex;
+using std::none_of;
 using std::pair;
 using std::recursive_mutex;
 using std::runtime_error;
@@ -94,14 +113,34 @@ Session::Session(DeviceManager &device_manager, QString name) :
 	name_(name),
 	capture_state_(Stopped),
 	cur_samplerate_(0),
-	data_saved_(true)
+	logic_position_(0),
+	load_window_passed_(false),
+	drop_when_full_(false),
+	dropped_logic_samples_(0),
+	dropped_analog_samples_(0),
+	notification_scheduler_([this]() { data_received(); }),
+	out_of_memory_(false),
+	data_saved_(true),
+	saved_container_(make_shared<SavedContainer>()),
+	autosave_running_(false),
+	autosave_again_(false),
+	autosave_error_reported_(false)
 {
+	connect(&autosave_timer_, SIGNAL(timeout()),
+		this, SLOT(on_autosave_timeout()));
+	connect(this, SIGNAL(capture_state_changed(int)),
+		this, SLOT(on_capture_state_changed(int)));
 }
 
 Session::~Session()
 {
 	// Stop and join to the thread
 	stop_capture();
+
+	if (autosave_) {
+		autosave_->cancel();
+		autosave_.reset();
+	}
 }
 
 DeviceManager& Session::device_manager()
@@ -170,7 +209,6 @@ void Session::save_settings(QSettings &settings) const
 {
 	map<string, string> dev_info;
 	list<string> key_list;
-	int stacks = 0, views = 0;
 
 	if (device_) {
 		shared_ptr<devices::HardwareDevice> hw_device =
@@ -210,45 +248,29 @@ void Session::save_settings(QSettings &settings) const
 			settings.endGroup();
 		}
 
-		// Save channels and decoders
-		for (shared_ptr<data::SignalBase> base : signalbases_) {
-#ifdef ENABLE_DECODE
-			if (base->is_decode_signal()) {
-				shared_ptr<pv::data::DecoderStack> decoder_stack =
-						base->decoder_stack();
-				shared_ptr<data::decode::Decoder> top_decoder =
-						decoder_stack->stack().front();
-
-				settings.beginGroup("decoder_stack" + QString::number(stacks++));
-				settings.setValue("id", top_decoder->decoder()->id);
-				settings.setValue("name", top_decoder->decoder()->name);
-				settings.endGroup();
-			} else
-#endif
-			{
-				settings.beginGroup(base->internal_name());
-				base->save_settings(settings);
-				settings.endGroup();
-			}
-		}
+		shared_ptr<devices::ContainerFile> container_device =
+			dynamic_pointer_cast< devices::ContainerFile >(device_);
 
-		settings.setValue("decoder_stacks", stacks);
+		if (container_device) {
+			settings.setValue("device_type", "containerfile");
+			settings.beginGroup("device");
+			settings.setValue("filename", QString::fromStdString(
+				container_device->full_name()));
+			settings.endGroup();
+		}
 
-		// Save view states and their signal settings
-		// Note: main_view must be saved as view0
-		settings.beginGroup("view" + QString::number(views++));
-		main_view_->save_settings(settings);
-		settings.endGroup();
+		shared_ptr<devices::RecordingFile> recording_device =
+			dynamic_pointer_cast< devices::RecordingFile >(device_);
 
-		for (shared_ptr<views::ViewBase> view : views_) {
-			if (view != main_view_) {
-				settings.beginGroup("view" + QString::number(views++));
-				view->save_settings(settings);
-				settings.endGroup();
-			}
+		if (recording_device) {
+			settings.setValue("device_type", "recordingfile");
+			settings.beginGroup("device");
+			settings.setValue("filename", QString::fromStdString(
+				recording_device->full_name()));
+			settings.endGroup();
 		}
 
-		settings.setValue("views", views);
+		save_setup(settings, false);
 	}
 }
 
@@ -289,14 +311,22 @@ void Session::restore_settings(QSettings &settings)
 		settings.endGroup();
 	}
 
-	if (device_type == "sessionfile") {
+	if (device_type == "sessionfile" || device_type == "containerfile" ||
+		device_type == "recordingfile") {
 		settings.beginGroup("device");
 		QString filename = settings.value("filename").toString();
 		settings.endGroup();
 
 		if (QFileInfo(filename).isReadable()) {
-			device = make_shared<devices::SessionFile>(device_manager_.context(),
-				filename.toStdString());
+			if (device_type == "containerfile")
+				device = make_shared<devices::ContainerFile>(
+					device_manager_.context(), filename.toStdString());
+			else if (device_type == "recordingfile")
+				device = make_shared<devices::RecordingFile>(
+					device_manager_.context(), filename.toStdString());
+			else
+				device = make_shared<devices::SessionFile>(
+					device_manager_.context(), filename.toStdString());
 			set_device(device);
 
 			// TODO Perform error handling
@@ -306,46 +336,183 @@ void Session::restore_settings(QSettings &settings)
 		}
 	}
 
-	if (device) {
-		// Restore channels
-		for (shared_ptr<data::SignalBase> base : signalbases_) {
-			settings.beginGroup(base->internal_name());
-			base->restore_settings(settings);
+	if (device)
+		restore_setup(settings);
+}
+
+void Session::save_capture_setup(const QString &capture_file) const
+{
+	// The channels of a capture file are named after the signals
+	QSettings settings(capture_file + ".pvs", QSettings::IniFormat);
+	settings.clear();
+	save_setup(settings, true);
+}
+
+shared_ptr<SavedContainer> Session::saved_container() const
+{
+	return saved_container_;
+}
+
+void Session::save_setup(QSettings &settings, bool key_by_name) const
+{
+	int stacks = 0, views = 0, math_channels = 0;
+
+	// Save channels and decoders
+	for (shared_ptr<data::SignalBase> base : signalbases_) {
+		// Math channels have no internal name, their expression recreates
+		// them
+		if (base->type() == data::SignalBase::MathChannel) {
+			settings.beginGroup("math_channel" +
+				QString::number(math_channels++));
+			settings.setValue("expression",
+				base->math_engine()->expression());
+			base->save_settings(settings);
 			settings.endGroup();
+			continue;
 		}
 
-		// Restore decoders
 #ifdef ENABLE_DECODE
-		int stacks = settings.value("decoder_stacks").toInt();
+		if (base->is_decode_signal()) {
+			shared_ptr<pv::data::DecoderStack> decoder_stack =
+					base->decoder_stack();
+			shared_ptr<data::decode::Decoder> top_decoder =
+					decoder_stack->stack().front();
+
+			settings.beginGroup("decoder_stack" + QString::number(stacks++));
+			settings.setValue("id", top_decoder->decoder()->id);
+			settings.setValue("name", top_decoder->decoder()->name);
+			settings.endGroup();
+		} else
+#endif
+		{
+			settings.beginGroup(key_by_name ?
+				base->name() : base->internal_name());
+			base->save_settings(settings);
+			settings.endGroup();
+		}
+	}
 
-		for (int i = 0; i < stacks; i++) {
-			settings.beginGroup("decoder_stack" + QString::number(i++));
+	settings.setValue("decoder_stacks", stacks);
+	settings.setValue("math_channels", math_channels);
 
-			QString id = settings.value("id").toString();
-			add_decoder(srd_decoder_get_by_id(id.toStdString().c_str()));
+	// Save view states and their signal settings
+	// Note: main_view must be saved as view0
+	settings.beginGroup("view" + QString::number(views++));
+	main_view_->save_settings(settings);
+	settings.endGroup();
 
+	for (shared_ptr<views::ViewBase> view : views_) {
+		if (view != main_view_) {
+			settings.beginGroup("view" + QString::number(views++));
+			view->save_settings(settings);
 			settings.endGroup();
 		}
+	}
+
+	settings.setValue("views", views);
+}
+
+void Session::restore_setup(QSettings &settings)
+{
+	// Restore channels
+	const QStringList groups = settings.childGroups();
+	for (shared_ptr<data::SignalBase> base : signalbases_) {
+		if (base->type() == data::SignalBase::MathChannel ||
+			!groups.contains(base->internal_name()))
+			continue;
+
+		settings.beginGroup(base->internal_name());
+		base->restore_settings(settings);
+		settings.endGroup();
+	}
+
+	restore_math_signals(settings);
+
+	// Restore decoders
+#ifdef ENABLE_DECODE
+	int stacks = settings.value("decoder_stacks").toInt();
+
+	for (int i = 0; i < stacks; i++) {
+		settings.beginGroup("decoder_stack" + QString::number(i++));
+
+		QString id = settings.value("id").toString();
+		add_decoder(srd_decoder_get_by_id(id.toStdString().c_str()));
+
+		settings.endGroup();
+	}
 #endif
 
-		// Restore views
-		int views = settings.value("views").toInt();
+	// Restore views
+	int views = settings.value("views").toInt();
 
-		for (int i = 0; i < views; i++) {
-			settings.beginGroup("view" + QString::number(i));
+	for (int i = 0; i < views; i++) {
+		settings.beginGroup("view" + QString::number(i));
 
-			if (i > 0) {
-				views::ViewType type = (views::ViewType)settings.value("type").toInt();
-				add_view(name_, type, this);
-				views_.back()->restore_settings(settings);
-			} else
-				main_view_->restore_settings(settings);
+		if (i > 0) {
+			views::ViewType type = (views::ViewType)settings.value("type").toInt();
+			add_view(name_, type, this);
+			views_.back()->restore_settings(settings);
+		} else
+			main_view_->restore_settings(settings);
+
+		settings.endGroup();
+	}
+}
+
+void Session::restore_math_signals(QSettings &settings)
+{
+	// Math channels may refer to each other, so keep trying the ones
+	// whose inputs don't exist yet as long as others could be added
+	list<int> pending;
+	for (int i = 0; i < settings.value("math_channels").toInt(); i++)
+		pending.push_back(i);
+
+	bool progress = true;
+	while (progress && !pending.empty()) {
+		progress = false;
+
+		for (auto i = pending.begin(); i != pending.end();) {
+			settings.beginGroup("math_channel" + QString::number(*i));
+
+			const QString expression = settings.value("expression").toString();
+			const QString name = settings.value("name").toString();
+
+			// Math channels are kept when the device changes
+			const bool exists = any_of(signalbases_.begin(),
+				signalbases_.end(),
+				[&](const shared_ptr<data::SignalBase> &b) {
+					return b->type() == data::SignalBase::MathChannel &&
+						b->name() == name &&
+						b->math_engine()->expression() == expression; });
+
+			QString error;
+			shared_ptr<data::SignalBase> base;
+			if (!exists)
+				base = add_math_signal(expression, error);
+			if (base)
+				base->restore_settings(settings);
 
 			settings.endGroup();
+
+			if (exists || base) {
+				i = pending.erase(i);
+				progress = true;
+			} else
+				i++;
 		}
 	}
 }
 
+void Session::restore_capture_setup(const QString &capture_file)
+{
+	const QString path = capture_file + ".pvs";
+	if (!QFileInfo(path).isReadable())
+		return;
+
+	QSettings settings(path, QSettings::IniFormat);
+	restore_setup(settings);
+}
+
 void Session::select_device(shared_ptr<devices::Device> device)
 {
 	try {
@@ -394,6 +561,8 @@ void Session::set_device(shared_ptr<devices::Device> device)
 	}
 
 	logic_data_.reset();
+	load_window_ = data::SampleWindow();
+	saved_container_ = make_shared<SavedContainer>();
 
 	signals_changed();
 
@@ -456,18 +625,49 @@ void Session::load_init_file(const string &file_name, const string &format)
 
 void Session::load_file(QString file_name,
 	shared_ptr<sigrok::InputFormat> format,
-	const map<string, Glib::VariantBase> &options)
+	const map<string, Glib::VariantBase> &options,
+	const data::SampleWindow &window)
 {
 	const QString errorMessage(
 		QString("Failed to load file %1").arg(file_name));
 
+	GlobalSettings settings;
+	const bool native_import = settings.value(
+		GlobalSettings::Key_Import_Native, true).toBool();
+
 	try {
-		if (format)
+		if (format) {
+			// The native importers don't implement load windows
+			bool native = false;
+			if (native_import && window.is_full() &&
+				devices::TextFile::is_supported(format, options)) {
+				set_device(shared_ptr<devices::Device>(
+					new devices::TextFile(
+						device_manager_.context(),
+						file_name.toStdString(),
+						format->name(), options)));
+				native = (device_ != nullptr);
+			}
+
+			// Leave files they can't read to the libsigrok input module
+			if (!native)
+				set_device(shared_ptr<devices::Device>(
+					new devices::InputFile(
+						device_manager_.context(),
+						file_name.toStdString(),
+						format, options)));
+		} else if (data::ContainerReader::is_container(
+				file_name.toStdString()))
+			set_device(shared_ptr<devices::Device>(
+				new devices::ContainerFile(
+					device_manager_.context(),
+					file_name.toStdString())));
+		else if (data::CaptureReader::is_recording(
+				file_name.toStdString()))
 			set_device(shared_ptr<devices::Device>(
-				new devices::InputFile(
+				new devices::RecordingFile(
 					device_manager_.context(),
-					file_name.toStdString(),
-					format, options)));
+					file_name.toStdString())));
 		else
 			set_device(shared_ptr<devices::Device>(
 				new devices::SessionFile(
@@ -482,12 +682,36 @@ void Session::load_file(QString file_name,
 
 	main_bar_->update_device_list();
 
+	load_window_ = window;
+
 	start_capture([&, errorMessage](QString infoMessage) {
 		main_bar_->session_error(errorMessage, infoMessage); });
 
+	if (dynamic_pointer_cast<devices::ContainerFile>(device_))
+		restore_capture_setup(file_name);
+
 	set_name(QFileInfo(file_name).fileName());
 }
 
+void Session::reload_file(const data::SampleWindow &window,
+	function<void (const QString)> error_handler)
+{
+	if (!dynamic_pointer_cast<devices::File>(device_)) {
+		error_handler(tr("Only files can be reloaded."));
+		return;
+	}
+
+	// Keep the name, start_capture() only reverts it for hardware devices
+	stop_capture();
+	load_window_ = window;
+	start_capture(error_handler);
+}
+
+const data::SampleWindow& Session::load_window() const
+{
+	return load_window_;
+}
+
 Session::capture_state Session::get_capture_state() const
 {
 	lock_guard<mutex> lock(sampling_mutex_);
@@ -515,15 +739,58 @@ void Session::start_capture(function<void (const QString)> error_handler)
 		}
 	}
 
+	restore_logic_data();
+
 	// Clear signal data
 	for (const shared_ptr<data::SignalData> d : all_signal_data_)
 		d->clear();
 
+	logic_position_ = 0;
+	analog_positions_.clear();
+	load_window_passed_ = false;
+
+	// The new capture has not been saved anywhere yet. A previous
+	// autosave still refers to the old data and is left to finish.
+	saved_container_ = make_shared<SavedContainer>();
+	autosave_timer_.stop();
+	autosave_.reset();
+	autosave_running_ = false;
+	autosave_again_ = false;
+
+	GlobalSettings settings;
+	notification_scheduler_.set_rate(settings.value(
+		GlobalSettings::Key_Data_NotificationRate,
+		data::NotificationScheduler::DefaultRate).toInt());
+
 	// Revert name back to default name (e.g. "Session 1") for real devices
 	// as the (possibly saved) data is gone. File devices keep their name.
 	shared_ptr<devices::HardwareDevice> hw_device =
 		dynamic_pointer_cast< devices::HardwareDevice >(device_);
 
+	// Stream the samples of real devices to disk and autosave them if
+	// requested
+	record_path_.clear();
+	autosave_path_.clear();
+	autosave_error_reported_ = false;
+	if (hw_device) {
+		QString dir = settings.value(GlobalSettings::Key_Capture_RecordDirectory).toString();
+		if (dir.isEmpty())
+			dir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
+
+		const QString path = QDir(dir).filePath(QString("pulseview-%1").arg(
+			QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+
+		if (settings.value(GlobalSettings::Key_Capture_RecordToDisk).toBool())
+			record_path_ = path + ".pvrec";
+
+		const int interval = settings.value(
+			GlobalSettings::Key_Capture_AutosaveInterval).toInt();
+		if (interval > 0) {
+			autosave_path_ = path + ".pvcap";
+			autosave_timer_.start(interval * 1000);
+		}
+	}
+
 	if (hw_device) {
 		name_ = default_name_;
 		name_changed();
@@ -599,6 +866,217 @@ const unordered_set< shared_ptr<data::SignalBase> > Session::signalbases() const
 	return signalbases_;
 }
 
+const data::PacketQueue& Session::packet_queue() const
+{
+	return packet_queue_;
+}
+
+QString Session::record_path() const
+{
+	return record_path_;
+}
+
+shared_ptr<data::ConversionGroup> Session::conversion_group()
+{
+	if (!conversion_group_)
+		conversion_group_ = make_shared<data::ConversionGroup>();
+
+	return conversion_group_;
+}
+
+shared_ptr<data::SignalBase> Session::add_math_signal(
+	const QString &expression, QString &error)
+{
+	vector< shared_ptr<data::Analog> > inputs;
+	vector< shared_ptr<data::SignalBase> > input_signals;
+
+	// Look up the channels by name, assigning input indices in the order
+	// they appear in the expression
+	auto resolver = [&](const string &name) -> int {
+		for (unsigned int i = 0; i < input_signals.size(); i++)
+			if (input_signals[i]->name().toStdString() == name)
+				return i;
+
+		for (const shared_ptr<data::SignalBase> b : signalbases_)
+			if (b->analog_data() && b->name().toStdString() == name) {
+				input_signals.push_back(b);
+				inputs.push_back(b->analog_data());
+				return inputs.size() - 1;
+			}
+
+		return -1;
+	};
+
+	data::MathExpression compiled;
+	string parse_error;
+
+	if (!compiled.parse(expression.toStdString(), resolver, parse_error)) {
+		error = QString::fromStdString(parse_error);
+		return nullptr;
+	}
+
+	// Without inputs there is no time base to compute samples for
+	if (compiled.input_count() == 0) {
+		error = tr("The expression refers to no channel");
+		return nullptr;
+	}
+
+	// Take the first free name, so that no two channels share one after
+	// math channels were removed
+	QString name;
+	for (unsigned int i = 1; name.isEmpty(); i++) {
+		name = QString("M%1").arg(i);
+		for (const shared_ptr<data::SignalBase> b : signalbases_)
+			if (b->name() == name)
+				name.clear();
+	}
+
+	shared_ptr<data::SignalBase> signalbase =
+		make_shared<data::SignalBase>(nullptr, data::SignalBase::MathChannel);
+	signalbase->set_name(name);
+	signalbase->set_math_engine(make_shared<data::MathEngine>(
+		expression, compiled, inputs));
+
+	signalbases_.insert(signalbase);
+
+	for (shared_ptr<views::ViewBase> view : views_)
+		view->add_math_signal(signalbase);
+
+	signals_changed();
+
+	return signalbase;
+}
+
+void Session::remove_math_signal(shared_ptr<data::SignalBase> signalbase)
+{
+	// Math channels that depend on this one keep computing from its data
+	signalbases_.erase(signalbase);
+
+	for (shared_ptr<views::ViewBase> view : views_)
+		view->remove_math_signal(signalbase);
+
+	signals_changed();
+}
+
+bool Session::compact_logic_data()
+{
+	if (capture_state_ != Stopped)
+		return false;
+
+	vector< shared_ptr<data::SignalBase> > kept, dropped;
+	unordered_set<const data::SignalBase*> decoded;
+	shared_ptr<data::Logic> logic;
+	uint64_t mask = 0;
+
+#ifdef ENABLE_DECODE
+	// Channels that are decoded keep their samples even when disabled
+	for (const shared_ptr<data::SignalBase> &b : signalbases_) {
+		if (!b->is_decode_signal())
+			continue;
+
+		for (const shared_ptr<data::decode::Decoder> &dec :
+			b->decoder_stack()->stack())
+			for (const auto &ch : dec->channels())
+				decoded.insert(ch.second.get());
+	}
+#endif
+
+	for (const shared_ptr<data::SignalBase> &b : signalbases_) {
+		if (b->type() != data::SignalBase::LogicChannel || !b->channel())
+			continue;
+
+		// Channels that were dropped before hold data of their own
+		if (b->logic_data()->logic_segments().empty())
+			continue;
+
+		logic = b->logic_data();
+
+		if (b->enabled() || decoded.count(b.get())) {
+			mask |= UINT64_C(1) << b->logic_bit_index();
+			kept.push_back(b);
+		} else
+			dropped.push_back(b);
+	}
+
+	if (!logic)
+		return false;
+
+	const deque< shared_ptr<data::LogicSegment> > &segments =
+		logic->logic_segments();
+	const data::ChannelCompactor compactor(
+		segments.front()->unit_size(), mask);
+
+	// Nothing would be gained if the kept channels already are the lowest
+	// bits of the units
+	if (compactor.is_identity())
+		return false;
+
+	shared_ptr<data::Logic> compacted =
+		make_shared<data::Logic>(kept.size());
+
+	try {
+		// Segments are kept newest first, push them oldest first
+		for (auto i = segments.rbegin(); i != segments.rend(); i++) {
+			const shared_ptr<data::LogicSegment> &src = *i;
+			const uint64_t count = src->get_sample_count();
+
+			shared_ptr<data::LogicSegment> dest =
+				make_shared<data::LogicSegment>(*compacted,
+					compactor.unit_size(), src->samplerate());
+			dest->set_start_time(src->start_time());
+
+			src->pin_chunks();
+			for (uint64_t n, pos = 0; pos < count; pos += n) {
+				n = count - pos;
+				const uint8_t *const samples = src->contiguous_samples(pos, n);
+
+				uint64_t space;
+				uint8_t *const out = dest->begin_append(space);
+				n = min(n, space);
+
+				compactor.compact(samples, out, n);
+				dest->end_append(n);
+			}
+			src->unpin_chunks();
+
+			dest->free_unused_memory();
+			compacted->push_segment(dest);
+		}
+	} catch (bad_alloc) {
+		// The original data is still intact
+		return false;
+	}
+
+	for (const shared_ptr<data::SignalBase> &b : kept) {
+		b->set_logic_bit_index(compactor.compacted_bit(b->logic_bit_index()));
+		b->set_data(compacted);
+	}
+
+	// The samples of the disabled channels are gone, so they get data of
+	// their own that has no segments
+	const shared_ptr<data::Logic> empty = make_shared<data::Logic>(1);
+	for (const shared_ptr<data::SignalBase> &b : dropped) {
+		b->set_logic_bit_index(-1);
+		b->set_data(empty);
+	}
+
+	all_signal_data_.insert(compacted);
+	if (logic != logic_data_)
+		all_signal_data_.erase(logic);
+	logic->clear();
+
+#ifdef ENABLE_DECODE
+	// The decoders still refer to the old segments and bits
+	for (const shared_ptr<data::SignalBase> &b : signalbases_)
+		if (b->is_decode_signal())
+			b->decoder_stack()->begin_decode();
+#endif
+
+	data_received();
+
+	return true;
+}
+
 #ifdef ENABLE_DECODE
 bool Session::add_decoder(srd_decoder *const dec)
 {
@@ -809,12 +1287,45 @@ void Session::update_signals()
 					}
 				}
 			}
+
+			// Keep the math channels, they don't belong to the device
+			for (const shared_ptr<data::SignalBase> b : signalbases_) {
+				if (b->type() != data::SignalBase::MathChannel)
+					continue;
+
+				const auto iter = find_if(
+					prev_sigs.cbegin(), prev_sigs.cend(),
+					[&](const shared_ptr<views::TraceView::Signal> &s) {
+						return s->base() == b;
+					});
+
+				if (iter != prev_sigs.end())
+					trace_view->add_signal(*iter);
+				else
+					trace_view->add_signal(shared_ptr<views::TraceView::Signal>(
+						new views::TraceView::AnalogSignal(*this, b)));
+			}
 		}
 	}
 
 	signals_changed();
 }
 
+void Session::restore_logic_data()
+{
+	for (const shared_ptr<data::SignalBase> &b : signalbases_) {
+		if (b->type() != data::SignalBase::LogicChannel || !b->channel())
+			continue;
+
+		b->set_logic_bit_index(-1);
+
+		if (logic_data_ && b->logic_data() != logic_data_) {
+			all_signal_data_.erase(b->logic_data());
+			b->set_data(logic_data_);
+		}
+	}
+}
+
 shared_ptr<data::SignalBase> Session::signalbase_from_channel(
 	shared_ptr<sigrok::Channel> channel) const
 {
@@ -833,13 +1344,87 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 	if (!device_)
 		return;
 
+	// Native capture files are mapped rather than fed through libsigrok
+	shared_ptr<devices::ContainerFile> container_device =
+		dynamic_pointer_cast<devices::ContainerFile>(device_);
+	if (container_device) {
+		try {
+			load_container(container_device->reader());
+		} catch (bad_alloc) {
+			error_handler(tr("Out of memory, loading stopped."));
+		}
+		set_capture_state(Stopped);
+		return;
+	}
+
+	// Recordings are replayed without libsigrok as well
+	shared_ptr<devices::RecordingFile> recording_device =
+		dynamic_pointer_cast<devices::RecordingFile>(device_);
+	if (recording_device) {
+		out_of_memory_ = false;
+		try {
+			load_recording(recording_device->reader());
+		} catch (bad_alloc) {
+			error_handler(tr("Out of memory, loading stopped."));
+		} catch (QString e) {
+			error_handler(e);
+		}
+		free_unused_memory();
+		set_capture_state(Stopped);
+		return;
+	}
+
+	// So are text files that PulseView imports by itself
+	shared_ptr<devices::TextFile> text_device =
+		dynamic_pointer_cast<devices::TextFile>(device_);
+	if (text_device) {
+		try {
+			load_text(text_device);
+		} catch (bad_alloc) {
+			error_handler(tr("Out of memory, loading stopped."));
+		} catch (QString e) {
+			error_handler(e);
+		}
+		free_unused_memory();
+		set_capture_state(Stopped);
+		return;
+	}
+
 	cur_samplerate_ = device_->read_config<uint64_t>(ConfigKey::SAMPLERATE);
 
 	out_of_memory_ = false;
 
+	// Files can be read at whatever pace we can store the data, so only
+	// hardware devices may drop packets if the ingest worker falls behind
+	drop_when_full_ =
+		(dynamic_pointer_cast<devices::HardwareDevice>(device_) != nullptr);
+
+	packet_queue_.reset();
+	dropped_logic_samples_ = dropped_analog_samples_ = 0;
+
+	if (!record_path_.isEmpty()) {
+		vector<data::CaptureRecorder::Channel> channels;
+		for (const shared_ptr<Channel> &ch : device_->device()->channels())
+			channels.push_back({ch->index(),
+				ch->type()->id() == SR_CHANNEL_ANALOG, ch->enabled(),
+				ch->name()});
+
+		if (!recorder_.open(record_path_.toStdString(), channels)) {
+			error_handler(tr("Can't record to %1: %2").arg(record_path_,
+				QString::fromStdString(recorder_.error())));
+			record_path_.clear();
+		}
+	}
+
+	ingest_thread_ = std::thread(&Session::ingest_thread_proc, this);
+
 	try {
 		device_->start();
 	} catch (Error e) {
+		packet_queue_.close();
+		ingest_thread_.join();
+		if (recorder_.is_open())
+			recorder_.close();
 		error_handler(e.what());
 		return;
 	}
@@ -848,6 +1433,16 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 		AwaitingTrigger : Running);
 
 	device_->run();
+
+	// Let the ingest worker store what is still queued up
+	packet_queue_.close();
+	ingest_thread_.join();
+
+	// Make sure the recording is complete on disk
+	if (recorder_.is_open() && !recorder_.close())
+		error_handler(tr("Recording to %1 failed: %2").arg(record_path_,
+			QString::fromStdString(recorder_.error())));
+
 	set_capture_state(Stopped);
 
 	// Confirm that SR_DF_END was received
@@ -868,6 +1463,336 @@ void Session::sample_thread_proc(function<void (const QString)> error_handler)
 
 	if (out_of_memory_)
 		error_handler(tr("Out of memory, acquisition stopped."));
+
+	if (packet_queue_.dropped_packets() > 0)
+		error_handler(tr("%1 samples were dropped because they could not "
+			"be stored fast enough.").arg(packet_queue_.dropped_samples()));
+}
+
+void Session::ingest_thread_proc()
+{
+	while (!packet_queue_.finished()) {
+		data::QueuedPacket *packet;
+
+		// Don't sleep past the moment the pending notifications are due
+		if (notification_scheduler_.pending())
+			packet = packet_queue_.wait_front(
+				notification_scheduler_.time_until_due());
+		else
+			packet = packet_queue_.wait_front();
+
+		if (packet) {
+			try {
+				if (recorder_.is_open())
+					recorder_.record(*packet);
+
+				feed_in_packet(*packet);
+			} catch (bad_alloc) {
+				out_of_memory_ = true;
+				device_->stop();
+			}
+
+			packet_queue_.pop();
+		}
+
+		notification_scheduler_.flush_if_due();
+	}
+
+	notification_scheduler_.flush();
+
+	qDebug("Ingest queue: maximum depth %zu of %zu, %llu packets dropped",
+		packet_queue_.max_depth(), data::PacketQueue::Capacity,
+		(unsigned long long)packet_queue_.dropped_packets());
+}
+
+void Session::load_container(shared_ptr<data::ContainerReader> reader)
+{
+	assert(reader);
+
+	set_capture_state(Running);
+
+	bool frame_open = false;
+
+	{
+		lock_guard<recursive_mutex> lock(data_mutex_);
+
+		if (signalbases_.empty())
+			update_signals();
+
+		for (const data::ContainerReader::Segment &s : reader->segments()) {
+			// Mapping costs nothing, so the load window only restricts
+			// the range and is never decimated. The stored levels only
+			// fit if the segment is used as a whole.
+			data::SampleWindow window = load_window_;
+			window.resolve(s.samplerate);
+
+			const uint64_t start = min(window.start_sample(), s.sample_count);
+			const uint64_t end = min(window.end_sample(), s.sample_count);
+			const bool whole = (start == 0 && end == s.sample_count);
+			const vector<data::ContainerReader::Level> levels =
+				whole ? s.levels : vector<data::ContainerReader::Level>();
+
+			// A range that is cut out of several extents doesn't fall on
+			// chunk boundaries, so it is copied instead of mapped
+			const vector<data::ContainerReader::Extent> extents =
+				whole ? s.extents : s.extents_in(start, end);
+			const bool mapped = whole || extents.size() <= 1;
+			const double samplerate = (s.samplerate > 0) ? s.samplerate : 1.0;
+
+			shared_ptr<data::Segment> segment;
+			shared_ptr<data::SignalData> signal_data;
+
+			if (!s.analog) {
+				if (!logic_data_)
+					continue;
+
+				shared_ptr<data::LogicSegment> lsegment =
+					make_shared<data::LogicSegment>(*logic_data_,
+						s.unit_size, s.samplerate);
+				if (mapped)
+					lsegment->map_payload(reader->storage(), extents, levels);
+				else
+					for (const data::ContainerReader::Extent &e : extents)
+						lsegment->append_payload((void*)e.first,
+							e.second * s.unit_size);
+				logic_data_->push_segment(lsegment);
+
+				segment = lsegment;
+				signal_data = logic_data_;
+				frame_began();
+				frame_open = true;
+			} else {
+				const auto iter = find_if(signalbases_.begin(),
+					signalbases_.end(),
+					[&](const shared_ptr<data::SignalBase> &b) {
+						return b->type() == data::SignalBase::AnalogChannel &&
+							b->index() == s.channel_index; });
+				if (iter == signalbases_.end())
+					continue;
+
+				shared_ptr<data::Analog> analog_data = (*iter)->analog_data();
+				assert(analog_data);
+
+				shared_ptr<data::AnalogSegment> asegment =
+					make_shared<data::AnalogSegment>(*analog_data,
+						s.samplerate);
+				if (mapped)
+					asegment->map_payload(reader->storage(), extents,
+						s.min_value, s.max_value, levels);
+				else
+					for (const data::ContainerReader::Extent &e : extents)
+						asegment->append_interleaved_samples(
+							(const float*)e.first, e.second, 1);
+				analog_data->push_segment(asegment);
+
+				segment = asegment;
+				signal_data = analog_data;
+			}
+
+			segment->set_start_time(pv::util::Timestamp(start) / samplerate);
+
+			notification_scheduler_.post(signal_data, segment, 0,
+				end - start);
+		}
+	}
+
+	notification_scheduler_.flush();
+
+	// The segments are complete as soon as they are mapped
+	if (frame_open)
+		frame_ended();
+}
+
+void Session::load_recording(shared_ptr<data::CaptureReader> reader)
+{
+	namespace cf = data::captureformat;
+
+	assert(reader);
+
+	// The sample rate is taken from the recording, not the device
+	cur_samplerate_ = 0;
+
+	set_capture_state(Running);
+
+	{
+		lock_guard<recursive_mutex> lock(data_mutex_);
+		if (signalbases_.empty())
+			update_signals();
+	}
+
+	map< uint32_t, shared_ptr<Channel> > channels;
+	for (const shared_ptr<Channel> &ch : device_->device()->channels())
+		channels[ch->index()] = ch;
+
+	uint64_t missing_samples = 0;
+	bool ended = false, unknown_channels = false;
+
+	data::QueuedPacket packet;
+	data::CaptureReader::Record record;
+
+	while (reader->next(record)) {
+		switch (record.type) {
+		case cf::SamplerateRecord:
+			packet.type = data::QueuedPacket::Meta;
+			packet.samplerate = record.samplerate;
+			break;
+
+		case cf::TriggerRecord:
+			packet.type = data::QueuedPacket::Trigger;
+			break;
+
+		case cf::FrameBeginRecord:
+			packet.type = data::QueuedPacket::FrameBegin;
+			break;
+
+		case cf::FrameEndRecord:
+			packet.type = data::QueuedPacket::FrameEnd;
+			break;
+
+		case cf::EndRecord:
+			packet.type = data::QueuedPacket::End;
+			ended = true;
+			break;
+
+		case cf::LogicRecord:
+			packet.type = data::QueuedPacket::Logic;
+			packet.unit_size = record.unit_size;
+			packet.data.swap(record.data);
+			break;
+
+		case cf::AnalogRecord:
+			packet.type = data::QueuedPacket::Analog;
+			packet.channels.clear();
+			for (uint32_t index : record.channels) {
+				const auto iter = channels.find(index);
+				if (iter != channels.end())
+					packet.channels.push_back(iter->second);
+			}
+			if (packet.channels.size() != record.channels.size()) {
+				unknown_channels = true;
+				continue;
+			}
+			packet.data.swap(record.data);
+			break;
+
+		case cf::GapRecord:
+			missing_samples += max(record.gap_logic_samples,
+				record.gap_analog_samples);
+			continue;
+
+		default:
+			continue;
+		}
+
+		feed_in_packet(packet);
+	}
+
+	// Close the segments of a recording that was cut short
+	if (!ended) {
+		packet.type = data::QueuedPacket::End;
+		feed_in_packet(packet);
+	}
+
+	if (unknown_channels)
+		throw tr("The recording refers to channels it doesn't list.");
+
+	if (!reader->error().empty())
+		throw tr("Failed to read the recording: %1").arg(
+			QString::fromStdString(reader->error()));
+
+	if (!reader->complete())
+		throw tr("The recording was not closed properly, "
+			"everything up to the last complete record was recovered "
+			"(%1 bytes).").arg(reader->position());
+
+	if (missing_samples > 0)
+		throw tr("%1 samples are missing from the recording "
+			"because they could not be stored fast enough during the "
+			"capture.").arg(missing_samples);
+}
+
+void Session::load_text(shared_ptr<devices::TextFile> device)
+{
+	assert(device);
+
+	shared_ptr<data::TextImporter> importer = device->importer();
+	assert(importer);
+
+	cur_samplerate_ = importer->samplerate();
+
+	set_capture_state(Running);
+
+	shared_ptr<data::LogicSegment> logic_segment;
+	vector< shared_ptr<data::AnalogSegment> > analog_segments;
+	vector< shared_ptr<data::Analog> > analog_data;
+
+	{
+		lock_guard<recursive_mutex> lock(data_mutex_);
+
+		if (signalbases_.empty())
+			update_signals();
+
+		if (logic_data_ && importer->logic_channel_count() > 0) {
+			logic_segment = make_shared<data::LogicSegment>(*logic_data_,
+				importer->unit_size(), cur_samplerate_);
+			logic_data_->push_segment(logic_segment);
+			frame_began();
+		}
+
+		// The analog channels follow the logic channels on the device
+		for (unsigned int i = 0; i < importer->analog_channel_count(); i++) {
+			const unsigned int index = importer->logic_channel_count() + i;
+			const auto iter = find_if(signalbases_.begin(),
+				signalbases_.end(),
+				[&](const shared_ptr<data::SignalBase> &b) {
+					return b->type() == data::SignalBase::AnalogChannel &&
+						b->index() == index; });
+
+			shared_ptr<data::Analog> data = (iter != signalbases_.end()) ?
+				(*iter)->analog_data() : nullptr;
+			analog_data.push_back(data);
+			analog_segments.push_back(data ?
+				make_shared<data::AnalogSegment>(*data, cur_samplerate_) :
+				nullptr);
+			if (data)
+				data->push_segment(analog_segments.back());
+		}
+	}
+
+	const bool result = device->import(
+		[&](const uint8_t *data, uint64_t count) {
+			if (!logic_segment)
+				return;
+
+			const uint64_t prev_sample_count =
+				logic_segment->get_sample_count();
+			logic_segment->append_payload((void*)data,
+				count * importer->unit_size());
+			notification_scheduler_.post(logic_data_, logic_segment,
+				prev_sample_count, logic_segment->get_sample_count());
+			notification_scheduler_.flush_if_due();
+		},
+		[&](unsigned int index, const float *data, uint64_t count) {
+			const shared_ptr<data::AnalogSegment> &segment =
+				analog_segments[index];
+			if (!segment)
+				return;
+
+			const uint64_t prev_sample_count = segment->get_sample_count();
+			segment->append_interleaved_samples(data, count, 1);
+			notification_scheduler_.post(analog_data[index], segment,
+				prev_sample_count, segment->get_sample_count());
+			notification_scheduler_.flush_if_due();
+		});
+
+	notification_scheduler_.flush();
+
+	// The segments are complete, also if the import failed half way
+	if (logic_segment)
+		frame_ended();
+
+	if (!result)
+		throw QString::fromStdString(importer->error());
 }
 
 void Session::free_unused_memory()
@@ -879,24 +1804,40 @@ void Session::free_unused_memory()
 			segment->free_unused_memory();
 		}
 	}
+
+	packet_queue_.free_unused_memory();
 }
 
-void Session::feed_in_header()
+data::QueuedPacket* Session::queue_slot(bool may_drop)
 {
-	cur_samplerate_ = device_->read_config<uint64_t>(ConfigKey::SAMPLERATE);
+	data::QueuedPacket *const p = (may_drop && drop_when_full_) ?
+		packet_queue_.begin_push() : packet_queue_.begin_push_blocking();
+
+	// Slots are reused, so the drop counts are set for every packet
+	if (p) {
+		p->dropped_logic_samples = dropped_logic_samples_;
+		p->dropped_analog_samples = dropped_analog_samples_;
+		dropped_logic_samples_ = dropped_analog_samples_ = 0;
+	}
+
+	return p;
+}
+
+void Session::queue_control_packet(data::QueuedPacket::Type type)
+{
+	data::QueuedPacket *const p = queue_slot(false);
+	p->type = type;
+	packet_queue_.end_push();
 }
 
-void Session::feed_in_meta(shared_ptr<Meta> meta)
+void Session::queue_meta(shared_ptr<Meta> meta)
 {
+	uint64_t samplerate = 0;
+
 	for (auto entry : meta->config()) {
 		switch (entry.first->id()) {
 		case SR_CONF_SAMPLERATE:
-			// We can't rely on the header to always contain the sample rate,
-			// so in case it's supplied via a meta packet, we use it.
-			if (!cur_samplerate_)
-				cur_samplerate_ = g_variant_get_uint64(entry.second.gobj());
-
-			/// @todo handle samplerate changes
+			samplerate = g_variant_get_uint64(entry.second.gobj());
 			break;
 		default:
 			// Unknown metadata is not an error.
@@ -904,11 +1845,71 @@ void Session::feed_in_meta(shared_ptr<Meta> meta)
 		}
 	}
 
+	data::QueuedPacket *const p = queue_slot(false);
+	p->type = data::QueuedPacket::Meta;
+	p->samplerate = samplerate;
+	packet_queue_.end_push();
+}
+
+void Session::queue_logic(shared_ptr<Logic> logic)
+{
+	data::QueuedPacket *const p = queue_slot(true);
+
+	if (!p) {
+		const uint64_t count = logic->data_length() / logic->unit_size();
+		packet_queue_.count_drop(count);
+		dropped_logic_samples_ += count;
+		return;
+	}
+
+	const uint8_t *const data = (const uint8_t*)logic->data_pointer();
+
+	p->type = data::QueuedPacket::Logic;
+	p->unit_size = logic->unit_size();
+	p->data.assign(data, data + logic->data_length());
+	packet_queue_.end_push();
+}
+
+void Session::queue_analog(shared_ptr<Analog> analog)
+{
+	data::QueuedPacket *const p = queue_slot(true);
+
+	if (!p) {
+		packet_queue_.count_drop(analog->num_samples());
+		dropped_analog_samples_ += analog->num_samples();
+		return;
+	}
+
+	const uint8_t *const data = (const uint8_t*)analog->data_pointer();
+
+	p->type = data::QueuedPacket::Analog;
+	p->channels = analog->channels();
+	p->data.assign(data, data + analog->num_samples() * sizeof(float));
+	packet_queue_.end_push();
+}
+
+void Session::feed_in_header()
+{
+	cur_samplerate_ = device_->read_config<uint64_t>(ConfigKey::SAMPLERATE);
+}
+
+void Session::feed_in_meta(uint64_t samplerate)
+{
+	// We can't rely on the header to always contain the sample rate,
+	// so in case it's supplied via a meta packet, we use it.
+	if (!cur_samplerate_)
+		cur_samplerate_ = samplerate;
+
+	/// @todo handle samplerate changes
+
 	signals_changed();
 }
 
 void Session::feed_in_trigger()
 {
+	// Make sure that listeners know about all samples before the trigger
+	notification_scheduler_.flush();
+
 	// The channel containing most samples should be most accurate
 	uint64_t sample_count = 0;
 
@@ -936,7 +1937,7 @@ void Session::feed_in_frame_begin()
 		frame_began();
 }
 
-void Session::feed_in_logic(shared_ptr<Logic> logic)
+void Session::feed_in_logic(const data::QueuedPacket &packet)
 {
 	lock_guard<recursive_mutex> lock(data_mutex_);
 
@@ -947,13 +1948,30 @@ void Session::feed_in_logic(shared_ptr<Logic> logic)
 		update_signals();
 	}
 
+	if (!load_window_.is_resolved())
+		load_window_.resolve(cur_samplerate_);
+
+	// Only store the samples inside the load window
+	const unsigned int unit_size = packet.unit_size;
+	uint64_t first;
+	const uint64_t sample_count = load_window_.select(logic_position_,
+		packet.data.size() / unit_size, first);
+
+	logic_position_ += packet.data.size() / unit_size;
+
+	if (sample_count == 0) {
+		check_load_window_passed();
+		return;
+	}
+
 	if (!cur_logic_segment_) {
 		// This could be the first packet after a trigger
 		set_capture_state(Running);
 
 		// Create a new data segment
 		cur_logic_segment_ = make_shared<data::LogicSegment>(
-			*logic_data_, logic->unit_size(), cur_samplerate_);
+			*logic_data_, unit_size, cur_samplerate_);
+		apply_load_window(cur_logic_segment_);
 		logic_data_->push_segment(cur_logic_segment_);
 
 		// @todo Putting this here means that only listeners querying
@@ -963,27 +1981,66 @@ void Session::feed_in_logic(shared_ptr<Logic> logic)
 		frame_began();
 	}
 
-	cur_logic_segment_->append_payload(logic);
+	const uint64_t prev_sample_count = cur_logic_segment_->get_sample_count();
+	const uint8_t *const data = packet.data.data() + first * unit_size;
+	const unsigned int decimation = load_window_.decimation();
+
+	if (decimation == 1) {
+		cur_logic_segment_->append_payload((void*)data,
+			sample_count * unit_size);
+	} else {
+		decimation_buffer_.resize(sample_count * unit_size);
+		for (uint64_t i = 0; i < sample_count; i++)
+			memcpy(&decimation_buffer_[i * unit_size],
+				data + i * decimation * unit_size, unit_size);
+		cur_logic_segment_->append_payload(decimation_buffer_.data(),
+			decimation_buffer_.size());
+	}
 
-	data_received();
+	notification_scheduler_.post(logic_data_, cur_logic_segment_,
+		prev_sample_count, cur_logic_segment_->get_sample_count());
 }
 
-void Session::feed_in_analog(shared_ptr<Analog> analog)
+void Session::feed_in_analog(const data::QueuedPacket &packet)
 {
 	lock_guard<recursive_mutex> lock(data_mutex_);
 
-	const vector<shared_ptr<Channel>> channels = analog->channels();
+	const vector<shared_ptr<Channel>> &channels = packet.channels;
 	const unsigned int channel_count = channels.size();
-	const size_t sample_count = analog->num_samples() / channel_count;
-	const float *data = static_cast<const float *>(analog->data_pointer());
+	const size_t sample_count =
+		packet.data.size() / sizeof(float) / channel_count;
+	const float *data = (const float*)packet.data.data();
 	bool sweep_beginning = false;
 
 	if (signalbases_.empty())
 		update_signals();
 
+	if (!load_window_.is_resolved())
+		load_window_.resolve(cur_samplerate_);
+
 	for (auto channel : channels) {
 		shared_ptr<data::AnalogSegment> segment;
 
+		// Only store the samples inside the load window
+		uint64_t &position = analog_positions_[channel];
+		uint64_t first;
+		const uint64_t kept_count = load_window_.select(position,
+			sample_count, first);
+
+		position += sample_count;
+
+		if (kept_count == 0) {
+			data++;
+			continue;
+		}
+
+		// Find the analog data associated with the channel
+		shared_ptr<data::SignalBase> base = signalbase_from_channel(channel);
+		assert(base);
+
+		shared_ptr<data::Analog> analog_data(base->analog_data());
+		assert(analog_data);
+
 		// Try to get the segment of the channel
 		const map< shared_ptr<Channel>, shared_ptr<data::AnalogSegment> >::
 			iterator iter = cur_analog_segments_.find(channel);
@@ -995,27 +2052,27 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 			// in the sweep containing this segment.
 			sweep_beginning = true;
 
-			// Find the analog data associated with the channel
-			shared_ptr<data::SignalBase> base = signalbase_from_channel(channel);
-			assert(base);
-
-			shared_ptr<data::Analog> data(base->analog_data());
-			assert(data);
-
 			// Create a segment, keep it in the maps of channels
 			segment = make_shared<data::AnalogSegment>(
-				*data, cur_samplerate_);
+				*analog_data, cur_samplerate_);
+			apply_load_window(segment);
 			cur_analog_segments_[channel] = segment;
 
 			// Push the segment into the analog data.
-			data->push_segment(segment);
+			analog_data->push_segment(segment);
 		}
 
 		assert(segment);
 
+		const uint64_t prev_sample_count = segment->get_sample_count();
+
 		// Append the samples in the segment
-		segment->append_interleaved_samples(data++, sample_count,
-			channel_count);
+		segment->append_interleaved_samples(data + first * channel_count,
+			kept_count, channel_count * load_window_.decimation());
+		data++;
+
+		notification_scheduler_.post(analog_data, segment,
+			prev_sample_count, segment->get_sample_count());
 	}
 
 	if (sweep_beginning) {
@@ -1023,63 +2080,96 @@ void Session::feed_in_analog(shared_ptr<Analog> analog)
 		set_capture_state(Running);
 	}
 
-	data_received();
+	check_load_window_passed();
 }
 
-void Session::data_feed_in(shared_ptr<sigrok::Device> device,
-	shared_ptr<Packet> packet)
+void Session::apply_load_window(shared_ptr<data::Segment> segment) const
 {
-	static bool frame_began = false;
+	if (load_window_.is_full())
+		return;
 
-	(void)device;
+	// Decimated samples are spaced further apart and the segment starts
+	// at the beginning of the window
+	const double samplerate = (cur_samplerate_ > 0) ? cur_samplerate_ : 1.0;
 
-	assert(device);
-	assert(device == device_->device());
-	assert(packet);
+	segment->set_samplerate(samplerate / load_window_.decimation());
+	segment->set_start_time(pv::util::Timestamp(
+		load_window_.start_sample()) / samplerate);
+}
+
+void Session::check_load_window_passed()
+{
+	if (load_window_.is_full() || load_window_passed_)
+		return;
+
+	// Inputs may deliver the logic and analog samples of the same time at
+	// different times, so every enabled channel must be past the window
+	for (const shared_ptr<data::SignalBase> &b : signalbases_) {
+		if (!b->channel() || !b->enabled())
+			continue;
+
+		if (b->type() == data::SignalBase::LogicChannel) {
+			if (logic_position_ == 0 ||
+				!load_window_.passed(logic_position_))
+				return;
+		} else if (b->type() == data::SignalBase::AnalogChannel) {
+			const auto iter = analog_positions_.find(b->channel());
+			if (iter == analog_positions_.end() ||
+				!load_window_.passed(iter->second))
+				return;
+		}
+	}
+
+	// Nothing that follows is kept, so don't bother reading it
+	load_window_passed_ = true;
+	QMetaObject::invokeMethod(this, "on_load_window_passed",
+		Qt::QueuedConnection);
+}
 
-	switch (packet->type()->id()) {
-	case SR_DF_HEADER:
+void Session::feed_in_packet(const data::QueuedPacket &packet)
+{
+	static bool frame_began = false;
+
+	switch (packet.type) {
+	case data::QueuedPacket::Header:
 		feed_in_header();
 		break;
 
-	case SR_DF_META:
-		feed_in_meta(dynamic_pointer_cast<Meta>(packet->payload()));
+	case data::QueuedPacket::Meta:
+		feed_in_meta(packet.samplerate);
 		break;
 
-	case SR_DF_TRIGGER:
+	case data::QueuedPacket::Trigger:
 		feed_in_trigger();
 		break;
 
-	case SR_DF_FRAME_BEGIN:
+	case data::QueuedPacket::FrameBegin:
 		feed_in_frame_begin();
 		frame_began = true;
 		break;
 
-	case SR_DF_LOGIC:
-		try {
-			feed_in_logic(dynamic_pointer_cast<Logic>(packet->payload()));
-		} catch (bad_alloc) {
-			out_of_memory_ = true;
-			device_->stop();
-		}
+	case data::QueuedPacket::Logic:
+		if (!out_of_memory_)
+			feed_in_logic(packet);
 		break;
 
-	case SR_DF_ANALOG:
-		try {
-			feed_in_analog(dynamic_pointer_cast<Analog>(packet->payload()));
-		} catch (bad_alloc) {
-			out_of_memory_ = true;
-			device_->stop();
-		}
+	case data::QueuedPacket::Analog:
+		if (!out_of_memory_)
+			feed_in_analog(packet);
 		break;
 
-	case SR_DF_FRAME_END:
-	case SR_DF_END:
+	case data::QueuedPacket::FrameEnd:
+	case data::QueuedPacket::End:
 	{
+		// Deliver the remaining notifications before the frame ends
+		notification_scheduler_.flush();
+
 		{
 			lock_guard<recursive_mutex> lock(data_mutex_);
 			cur_logic_segment_.reset();
 			cur_analog_segments_.clear();
+			logic_position_ = 0;
+			analog_positions_.clear();
 		}
 		if (frame_began) {
 			frame_began = false;
@@ -1087,8 +2177,61 @@ void Session::data_feed_in(shared_ptr<sigrok::Device> device,
 		}
 		break;
 	}
-	default:
-		break;
+	}
+}
+
+void Session::data_feed_in(shared_ptr<sigrok::Device> device,
+	shared_ptr<Packet> packet)
+{
+	(void)device;
+
+	assert(device);
+	assert(device == device_->device());
+	assert(packet);
+
+	// This runs on the libsigrok session thread, so all we do here is to
+	// hand a copy of the packet over to the ingest worker. Anything that
+	// takes longer would stall the acquisition.
+	try {
+		switch (packet->type()->id()) {
+		case SR_DF_HEADER:
+			queue_control_packet(data::QueuedPacket::Header);
+			break;
+
+		case SR_DF_META:
+			queue_meta(dynamic_pointer_cast<Meta>(packet->payload()));
+			break;
+
+		case SR_DF_TRIGGER:
+			queue_control_packet(data::QueuedPacket::Trigger);
+			break;
+
+		case SR_DF_FRAME_BEGIN:
+			queue_control_packet(data::QueuedPacket::FrameBegin);
+			break;
+
+		case SR_DF_LOGIC:
+			queue_logic(dynamic_pointer_cast<Logic>(packet->payload()));
+			break;
+
+		case SR_DF_ANALOG:
+			queue_analog(dynamic_pointer_cast<Analog>(packet->payload()));
+			break;
+
+		case SR_DF_FRAME_END:
+			queue_control_packet(data::QueuedPacket::FrameEnd);
+			break;
+
+		case SR_DF_END:
+			queue_control_packet(data::QueuedPacket::End);
+			break;
+
+		default:
+			break;
+		}
+	} catch (bad_alloc) {
+		out_of_memory_ = true;
+		device_->stop();
 	}
 }
 
@@ -1097,4 +2240,79 @@ void Session::on_data_saved()
 	data_saved_ = true;
 }
 
+void Session::autosave()
+{
+	if (autosave_path_.isEmpty())
+		return;
+
+	// Save again once the running save has finished
+	if (autosave_running_) {
+		autosave_again_ = true;
+		return;
+	}
+	autosave_again_ = false;
+
+	// Wait for the first samples
+	{
+		lock_guard<recursive_mutex> lock(data_mutex_);
+		if (none_of(all_signal_data_.begin(), all_signal_data_.end(),
+			[](const shared_ptr<data::SignalData> &d) {
+				return d->max_sample_count() > 0; }))
+			return;
+	}
+
+	save_capture_setup(autosave_path_);
+
+	autosave_ = make_shared<StoreSession>(autosave_path_.toStdString(),
+		shared_ptr<sigrok::OutputFormat>(), map<string, VariantBase>(),
+		make_pair(0, 0), *this);
+	connect(autosave_.get(), SIGNAL(progress_updated()),
+		this, SLOT(on_autosave_progress()));
+
+	autosave_running_ = autosave_->start();
+	if (!autosave_running_)
+		on_autosave_progress();
+}
+
+void Session::on_capture_state_changed(int state)
+{
+	// Save the rest of the capture and its levels once it has stopped
+	if (state == Stopped && autosave_timer_.isActive()) {
+		autosave_timer_.stop();
+		autosave();
+	}
+}
+
+void Session::on_load_window_passed()
+{
+	// A capture that was started since has a window of its own
+	if (load_window_passed_ && device_ && get_capture_state() != Stopped)
+		device_->stop();
+}
+
+void Session::on_autosave_timeout()
+{
+	// Saves that take longer than the interval skip a turn
+	if (!autosave_running_)
+		autosave();
+}
+
+void Session::on_autosave_progress()
+{
+	if (!autosave_ || autosave_->progress().second != 0)
+		return;
+
+	autosave_running_ = false;
+
+	// Only the first failure is reported, later saves write the file anew
+	const QString err = autosave_->error();
+	if (!err.isEmpty() && !autosave_error_reported_) {
+		autosave_error_reported_ = true;
+		main_bar_->session_error(tr("Autosave failed"), err);
+	}
+
+	if (autosave_again_)
+		autosave();
+}
+
 } // namespace pv
@@ -20,6 +20,7 @@
 #ifndef PULSEVIEW_PV_SESSION_HPP
 #define PULSEVIEW_PV_SESSION_HPP
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -32,8 +33,13 @@
 #include <QObject>
 #include <QSettings>
 #include <QString>
+#include <QTimer>
 
 #include "util.hpp"
+#include "data/capturerecorder.hpp"
+#include "data/notificationscheduler.hpp"
+#include "data/packetqueue.hpp"
+#include "data/samplewindow.hpp"
 #include "views/viewbase.hpp"
 
 using std::function;
@@ -63,18 +69,25 @@ class Session;
 namespace pv {
 
 class DeviceManager;
+class StoreSession;
+struct SavedContainer;
 
 namespace data {
 class Analog;
 class AnalogSegment;
+class CaptureReader;
+class ContainerReader;
+class ConversionGroup;
 class Logic;
 class LogicSegment;
+class Segment;
 class SignalBase;
 class SignalData;
 }
 
 namespace devices {
 class Device;
+class TextFile;
 }
 
 namespace toolbars {
@@ -130,6 +143,20 @@ public:
 
 	void restore_settings(QSettings &settings);
 
+	/**
+	 * Writes the channel, decoder and view setup to a file next to a
+	 * native capture file, from where it is restored when the capture
+	 * file is opened.
+	 */
+	void save_capture_setup(const QString &capture_file) const;
+
+	/**
+	 * Returns what was saved of the current capture to a native capture
+	 * file, so that saving it to the same file again only adds what is
+	 * new.
+	 */
+	shared_ptr<SavedContainer> saved_container() const;
+
 	/**
 	 * Attempts to set device instance, may fall back to demo if needed
 	 */
@@ -144,10 +171,27 @@ public:
 
 	void load_init_file(const string &file_name, const string &format);
 
+	/**
+	 * Loads a file.
+	 * @param window The part of the file to load.
+	 */
 	void load_file(QString file_name,
 		shared_ptr<sigrok::InputFormat> format = nullptr,
 		const map<string, Glib::VariantBase> &options =
-			map<string, Glib::VariantBase>());
+			map<string, Glib::VariantBase>(),
+		const data::SampleWindow &window = data::SampleWindow());
+
+	/**
+	 * Loads a different part of the current file, e.g. the visible range
+	 * at full resolution after an overview was loaded.
+	 */
+	void reload_file(const data::SampleWindow &window,
+		function<void (const QString)> error_handler);
+
+	/**
+	 * Returns the part of the current file that is loaded.
+	 */
+	const data::SampleWindow& load_window() const;
 
 	capture_state get_capture_state() const;
 
@@ -165,6 +209,46 @@ public:
 
 	const unordered_set< shared_ptr<data::SignalBase> > signalbases() const;
 
+	/**
+	 * Returns the queue that decouples the datafeed callback from the
+	 * storage of the sample data, e.g. to inspect its counters.
+	 */
+	const data::PacketQueue& packet_queue() const;
+
+	/**
+	 * Returns the path of the file the current or last capture was
+	 * recorded to, or an empty string if it wasn't recorded.
+	 */
+	QString record_path() const;
+
+	/**
+	 * Returns the group that packs the analog-to-logic conversion results
+	 * of several channels into one logic data object.
+	 */
+	shared_ptr<data::ConversionGroup> conversion_group();
+
+	/**
+	 * Adds a math channel whose samples are computed from other channels.
+	 * @param expression The expression, see data::MathExpression.
+	 * @param[out] error A description of the problem if the expression
+	 * is invalid.
+	 * @return The signal of the math channel or nullptr on error.
+	 */
+	shared_ptr<data::SignalBase> add_math_signal(const QString &expression,
+		QString &error);
+
+	void remove_math_signal(shared_ptr<data::SignalBase> signalbase);
+
+	/**
+	 * Repacks the logic data so that it only holds the enabled logic
+	 * channels, using the smallest unit size that fits them. The samples
+	 * of the disabled channels are discarded until the next acquisition,
+	 * except for those that are decoded. The decoders are restarted on
+	 * the repacked data.
+	 * @return false if there was nothing to compact or not enough memory.
+	 */
+	bool compact_logic_data();
+
 #ifdef ENABLE_DECODE
 	bool add_decoder(srd_decoder *const dec);
 
@@ -172,29 +256,103 @@ public:
 #endif
 
 private:
+	/**
+	 * Saves or restores the channels, decoders and views.
+	 * @param key_by_name Whether the channel settings are stored under
+	 * the channel names instead of the internal names.
+	 */
+	void save_setup(QSettings &settings, bool key_by_name) const;
+	void restore_setup(QSettings &settings);
+
+	/**
+	 * Recreates the math channels saved by save_setup().
+	 */
+	void restore_math_signals(QSettings &settings);
+
+	void restore_capture_setup(const QString &capture_file);
+
+	/**
+	 * Saves the running capture to the autosave file, adding to what was
+	 * saved before.
+	 */
+	void autosave();
+
 	void set_capture_state(capture_state state);
 
 	void update_signals();
 
+	/**
+	 * Makes the logic channels use the uncompacted logic data again.
+	 */
+	void restore_logic_data();
+
 	shared_ptr<data::SignalBase> signalbase_from_channel(
 		shared_ptr<sigrok::Channel> channel) const;
 
 private:
 	void sample_thread_proc(function<void (const QString)> error_handler);
 
+	void ingest_thread_proc();
+
+	/**
+	 * Puts the segments of a native capture file into the signal data,
+	 * referring to the mapped file instead of copying the samples.
+	 */
+	void load_container(shared_ptr<data::ContainerReader> reader);
+
+	/**
+	 * Replays the packets of a capture recording. A recording that was
+	 * cut short is read up to its last complete record.
+	 * @throws QString if the recording is incomplete or samples are
+	 * missing, after everything that could be read was loaded.
+	 */
+	void load_recording(shared_ptr<data::CaptureReader> reader);
+
+	/**
+	 * Parses a text file with PulseView's own importer, putting the
+	 * samples into the segments directly.
+	 * @throws QString if the file could not be parsed.
+	 */
+	void load_text(shared_ptr<devices::TextFile> device);
+
 	void free_unused_memory();
 
+	data::QueuedPacket* queue_slot(bool may_drop);
+
+	void queue_control_packet(data::QueuedPacket::Type type);
+
+	void queue_meta(shared_ptr<sigrok::Meta> meta);
+
+	void queue_logic(shared_ptr<sigrok::Logic> logic);
+
+	void queue_analog(shared_ptr<sigrok::Analog> analog);
+
 	void feed_in_header();
 
-	void feed_in_meta(shared_ptr<sigrok::Meta> meta);
+	void feed_in_meta(uint64_t samplerate);
 
 	void feed_in_trigger();
 
 	void feed_in_frame_begin();
 
-	void feed_in_logic(shared_ptr<sigrok::Logic> logic);
+	void feed_in_logic(const data::QueuedPacket &packet);
 
-	void feed_in_analog(shared_ptr<sigrok::Analog> analog);
+	void feed_in_analog(const data::QueuedPacket &packet);
+
+	/**
+	 * Sets the sample rate and start time of a new segment according to
+	 * the load window.
+	 */
+	void apply_load_window(shared_ptr<data::Segment> segment) const;
+
+	/**
+	 * Stops reading the input once the data of every enabled channel has
+	 * passed the load window. The device is stopped from the thread of
+	 * the session, see on_load_window_passed().
+	 */
+	void check_load_window_passed();
+
+	void feed_in_packet(const data::QueuedPacket &packet);
 
 	void data_feed_in(shared_ptr<sigrok::Device> device,
 		shared_ptr<sigrok::Packet> packet);
@@ -222,11 +380,41 @@ private:
 	map< shared_ptr<sigrok::Channel>, shared_ptr<data::AnalogSegment> >
 		cur_analog_segments_;
 
+	/// The part of the input that is stored, and the number of input
+	/// samples that were seen in the current frame
+	data::SampleWindow load_window_;
+	uint64_t logic_position_;
+	map< shared_ptr<sigrok::Channel>, uint64_t > analog_positions_;
+	std::atomic<bool> load_window_passed_;
+	vector<uint8_t> decimation_buffer_;
+
 	std::thread sampling_thread_;
 
-	bool out_of_memory_;
+	data::PacketQueue packet_queue_;
+	std::thread ingest_thread_;
+	bool drop_when_full_;
+
+	/// The samples dropped since the last packet that was queued. Only
+	/// used by the datafeed thread.
+	uint64_t dropped_logic_samples_, dropped_analog_samples_;
+
+	data::NotificationScheduler notification_scheduler_;
+
+	data::CaptureRecorder recorder_;
+	QString record_path_;  //!< Empty if the capture is not recorded
+
+	shared_ptr<data::ConversionGroup> conversion_group_;
+
+	std::atomic<bool> out_of_memory_;
 	bool data_saved_;
 
+	shared_ptr<SavedContainer> saved_container_;
+
+	QTimer autosave_timer_;
+	QString autosave_path_;  //!< Empty if the capture is not autosaved
+	shared_ptr<StoreSession> autosave_;
+	bool autosave_running_, autosave_again_, autosave_error_reported_;
+
 Q_SIGNALS:
 	void capture_state_changed(int state);
 	void device_changed();
@@ -248,6 +436,15 @@ Q_SIGNALS:
 
 public Q_SLOTS:
 	void on_data_saved();
+
+private Q_SLOTS:
+	void on_capture_state_changed(int state);
+
+	void on_load_window_passed();
+
+	void on_autosave_timeout();
+
+	void on_autosave_progress();
 };
 
 } // namespace pv
@@ -17,12 +17,16 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
 
 #include "storesession.hpp"
 
 #include <pv/data/analog.hpp>
 #include <pv/data/analogsegment.hpp>
+#include <pv/data/channelcompactor.hpp>
+#include <pv/data/containerwriter.hpp>
 #include <pv/data/logic.hpp>
 #include <pv/data/logicsegment.hpp>
 #include <pv/data/signalbase.hpp>
@@ -32,21 +36,29 @@
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
+using std::count;
+using std::count_if;
 using std::deque;
+using std::function;
 using std::ios_base;
 using std::lock_guard;
 using std::make_pair;
+using std::make_shared;
 using std::map;
+using std::max;
 using std::min;
 using std::mutex;
 using std::pair;
 using std::shared_ptr;
+using std::sort;
 using std::string;
+using std::unique_lock;
 using std::unordered_set;
 using std::vector;
 
 using Glib::VariantBase;
 
+using sigrok::ChannelType;
 using sigrok::ConfigKey;
 using sigrok::Error;
 using sigrok::OutputFormat;
@@ -55,6 +67,13 @@ using sigrok::OutputFlag;
 namespace pv {
 
 const size_t StoreSession::BlockSize = 10 * 1024 * 1024;
+const size_t StoreSession::WriteQueueDepth = 4;
+
+SavedContainer::SavedContainer() :
+	with_levels(false),
+	busy(false)
+{
+}
 
 StoreSession::StoreSession(const string &file_name,
 	const shared_ptr<OutputFormat> &output_format,
@@ -66,9 +85,11 @@ StoreSession::StoreSession(const string &file_name,
 	options_(options),
 	sample_range_(sample_range),
 	session_(session),
+	store_levels_(false),
 	interrupt_(false),
 	units_stored_(0),
-	unit_count_(0)
+	unit_count_(0),
+	write_done_(false)
 {
 }
 
@@ -90,11 +111,14 @@ const QString& StoreSession::error() const
 
 bool StoreSession::start()
 {
+	if (!output_format_)
+		return start_container();
+
 	const unordered_set< shared_ptr<data::SignalBase> > sigs(session_.signalbases());
 
 	shared_ptr<data::Segment> any_segment;
 	shared_ptr<data::LogicSegment> lsegment;
-	vector< shared_ptr<data::SignalBase> > achannel_list;
+	vector< shared_ptr<data::SignalBase> > lchannel_list, achannel_list;
 	vector< shared_ptr<data::AnalogSegment> > asegment_list;
 
 	for (shared_ptr<data::SignalBase> signal : sigs) {
@@ -115,6 +139,8 @@ bool StoreSession::start()
 
 			lsegment = lsegments.front();
 			any_segment = lsegment;
+
+			lchannel_list.push_back(signal);
 		}
 
 		if (signal->type() == data::SignalBase::AnalogChannel) {
@@ -159,10 +185,53 @@ bool StoreSession::start()
 		}
 	}
 
+	// Only the enabled logic channels are exported, packed into the
+	// smallest unit size that holds them
+	bool renumbered = false;
+	if (lsegment) {
+		uint64_t mask = 0;
+		for (const shared_ptr<data::SignalBase> &signal : lchannel_list) {
+			mask |= UINT64_C(1) << signal->logic_bit_index();
+			renumbered |= (signal->logic_bit_index() != signal->index());
+		}
+
+		compactor_ = make_shared<data::ChannelCompactor>(
+			lsegment->unit_size(), mask);
+		renumbered |= !compactor_->is_identity();
+	}
+
 	// Begin storing
+	vector< shared_ptr<sigrok::Channel> > achannels;
+
 	try {
 		const auto context = session_.device_manager().context();
-		auto device = session_.device()->device();
+		shared_ptr<sigrok::Device> device = session_.device()->device();
+
+		if (renumbered) {
+			// Outputs take the bit of a logic channel from its index, so
+			// they get a device of their own with the exported channels
+			auto user_device =
+				context->create_user_device("PulseView", "Export", "");
+
+			sort(lchannel_list.begin(), lchannel_list.end(),
+				[](const shared_ptr<data::SignalBase> &a,
+					const shared_ptr<data::SignalBase> &b) {
+					return a->logic_bit_index() < b->logic_bit_index(); });
+
+			for (const shared_ptr<data::SignalBase> &signal : lchannel_list)
+				user_device->add_channel(
+					compactor_->compacted_bit(signal->logic_bit_index()),
+					ChannelType::LOGIC, signal->name().toStdString());
+
+			unsigned int index = lchannel_list.size();
+			for (const shared_ptr<data::SignalBase> &signal : achannel_list)
+				achannels.push_back(user_device->add_channel(index++,
+					ChannelType::ANALOG, signal->name().toStdString()));
+
+			device = user_device;
+		} else
+			for (const shared_ptr<data::SignalBase> &signal : achannel_list)
+				achannels.push_back(signal->channel());
 
 		map<string, Glib::VariantBase> options = options_;
 
@@ -181,7 +250,7 @@ bool StoreSession::start()
 	}
 
 	thread_ = std::thread(&StoreSession::store_proc, this,
-		achannel_list, asegment_list, lsegment);
+		achannels, asegment_list, lsegment);
 	return true;
 }
 
@@ -196,7 +265,7 @@ void StoreSession::cancel()
 	interrupt_ = true;
 }
 
-void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_list,
+void StoreSession::store_proc(vector< shared_ptr<sigrok::Channel> > achannel_list,
 	vector< shared_ptr<data::AnalogSegment> > asegment_list,
 	shared_ptr<data::LogicSegment> lsegment)
 {
@@ -227,49 +296,64 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 	const unsigned int samples_per_block =
 		min(asamples_per_block, lsamples_per_block);
 
+	// The samples are passed to the output straight from the segments, so
+	// their chunks must stay in place until we're done
+	for (const shared_ptr<data::AnalogSegment> &asegment : asegment_list)
+		asegment->pin_chunks();
+	if (lsegment)
+		lsegment->pin_chunks();
+
+	// Writing the formatted data is left to a thread of its own so that
+	// formatting the next block overlaps with the disk I/O
+	write_done_ = false;
+	if (output_stream_.is_open())
+		writer_thread_ = std::thread(&StoreSession::write_proc, this);
+
+	vector<const float*> adata(asegment_list.size());
+	vector<uint8_t> lbuffer;
+
 	while (!interrupt_ && sample_count_) {
 		progress_updated();
 
-		const uint64_t packet_len =
-			min((uint64_t)samples_per_block, sample_count_);
+		// The block is shortened if it would cross the end of a chunk in
+		// any of the segments
+		uint64_t packet_len = min((uint64_t)samples_per_block, sample_count_);
+
+		for (unsigned int i = 0; i < asegment_list.size(); i++)
+			adata[i] = (const float*)asegment_list[i]->contiguous_samples(
+				start_sample_, packet_len);
+
+		const uint8_t *const ldata = lsegment ?
+			lsegment->contiguous_samples(start_sample_, packet_len) : nullptr;
 
 		try {
 			const auto context = session_.device_manager().context();
 
 			for (unsigned int i = 0; i < achannel_list.size(); i++) {
-				shared_ptr<sigrok::Channel> achannel = (achannel_list.at(i))->channel();
-				shared_ptr<data::AnalogSegment> asegment = asegment_list.at(i);
-
-				const float *adata =
-					asegment->get_samples(start_sample_, start_sample_ + packet_len);
-
 				auto analog = context->create_analog_packet(
-					vector<shared_ptr<sigrok::Channel> >{achannel},
-					(float *)adata, packet_len,
+					vector<shared_ptr<sigrok::Channel> >{achannel_list[i]},
+					(float *)adata[i], packet_len,
 					sigrok::Quantity::VOLTAGE, sigrok::Unit::VOLT,
 					vector<const sigrok::QuantityFlag *>());
-				const string adata_str = output_->receive(analog);
-
-				if (output_stream_.is_open())
-					output_stream_ << adata_str;
-
-				delete[] adata;
+				queue_write(output_->receive(analog));
 			}
 
 			if (lsegment) {
-				const uint8_t* ldata =
-					lsegment->get_samples(start_sample_, start_sample_ + packet_len);
-
-				const size_t length = packet_len * lunit_size;
-				auto logic = context->create_logic_packet((void*)ldata, length, lunit_size);
-				const string ldata_str = output_->receive(logic);
-
-				if (output_stream_.is_open())
-					output_stream_ << ldata_str;
-
-				delete[] ldata;
+				const unsigned int unit_size = compactor_->unit_size();
+				const uint8_t *data = ldata;
+
+				if (!compactor_->is_identity()) {
+					lbuffer.resize(packet_len * unit_size);
+					compactor_->compact(ldata, lbuffer.data(), packet_len);
+					data = lbuffer.data();
+				}
+
+				const size_t length = packet_len * unit_size;
+				auto logic = context->create_logic_packet((void*)data, length, unit_size);
+				queue_write(output_->receive(logic));
 			}
 		} catch (Error error) {
+			lock_guard<mutex> lock(mutex_);
 			error_ = tr("Error while saving: ") + error.what();
 			break;
 		}
@@ -279,6 +363,21 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 		units_stored_ = unit_count_ - (sample_count_ >> progress_scale);
 	}
 
+	// Let the writer drain the queue
+	{
+		lock_guard<mutex> lock(write_mutex_);
+		write_done_ = true;
+	}
+	write_data_cond_.notify_one();
+
+	if (writer_thread_.joinable())
+		writer_thread_.join();
+
+	for (const shared_ptr<data::AnalogSegment> &asegment : asegment_list)
+		asegment->unpin_chunks();
+	if (lsegment)
+		lsegment->unpin_chunks();
+
 	// Zeroing the progress variables indicates completion
 	units_stored_ = unit_count_ = 0;
 
@@ -289,4 +388,379 @@ void StoreSession::store_proc(vector< shared_ptr<data::SignalBase> > achannel_li
 	output_stream_.close();
 }
 
+void StoreSession::queue_write(string &&data)
+{
+	if (data.empty() || !writer_thread_.joinable())
+		return;
+
+	{
+		unique_lock<mutex> lock(write_mutex_);
+		write_space_cond_.wait(lock, [&] {
+			return write_queue_.size() < WriteQueueDepth || interrupt_; });
+		write_queue_.push_back(std::move(data));
+	}
+	write_data_cond_.notify_one();
+}
+
+void StoreSession::write_proc()
+{
+	while (true) {
+		string data;
+
+		{
+			unique_lock<mutex> lock(write_mutex_);
+			write_data_cond_.wait(lock, [&] {
+				return !write_queue_.empty() || write_done_; });
+
+			if (write_queue_.empty())
+				break;
+
+			data = std::move(write_queue_.front());
+			write_queue_.pop_front();
+		}
+		write_space_cond_.notify_one();
+
+		// Drop what's left if the store was cancelled
+		if (interrupt_)
+			continue;
+
+		output_stream_.write(data.data(), data.size());
+
+		if (!output_stream_) {
+			{
+				lock_guard<mutex> lock(mutex_);
+				error_ = tr("Error while saving: ") +
+					tr("Could not write to file.");
+			}
+
+			// Wake up the formatting thread in case it waits for space
+			{
+				lock_guard<mutex> lock(write_mutex_);
+				interrupt_ = true;
+			}
+			write_space_cond_.notify_one();
+		}
+	}
+}
+
+bool StoreSession::start_container()
+{
+	vector<data::ContainerWriter::Channel> channels;
+	vector< shared_ptr<data::LogicSegment> > lsegments;
+	vector< pair< uint32_t, shared_ptr<data::AnalogSegment> > > asegments;
+	vector< shared_ptr<data::SignalBase> > lsignals, asignals;
+	const bool partial = (sample_range_.first != sample_range_.second);
+
+	for (shared_ptr<data::SignalBase> signal : session_.signalbases()) {
+		// Decoded and computed signals can't be stored
+		if (!signal->channel())
+			continue;
+
+		if (signal->type() == data::SignalBase::AnalogChannel)
+			asignals.push_back(signal);
+		else if (signal->enabled() &&
+			!signal->logic_data()->logic_segments().empty())
+			lsignals.push_back(signal);
+	}
+
+	sort(lsignals.begin(), lsignals.end(),
+		[](const shared_ptr<data::SignalBase> &a,
+			const shared_ptr<data::SignalBase> &b) {
+			return a->logic_bit_index() < b->logic_bit_index(); });
+	sort(asignals.begin(), asignals.end(),
+		[](const shared_ptr<data::SignalBase> &a,
+			const shared_ptr<data::SignalBase> &b) {
+			return a->index() < b->index(); });
+
+	// Only the enabled logic channels are stored, packed into the smallest
+	// unit size that holds them. Their indices are the bits they end up
+	// at, the analog channels are numbered after them.
+	if (!lsignals.empty()) {
+		// Segments are stored oldest first. When a sample range is
+		// saved, it refers to the latest segment like with exports.
+		const deque< shared_ptr<data::LogicSegment> > &segments =
+			lsignals.front()->logic_data()->logic_segments();
+		if (partial)
+			lsegments.push_back(segments.front());
+		else
+			lsegments.assign(segments.rbegin(), segments.rend());
+
+		uint64_t mask = 0;
+		for (const shared_ptr<data::SignalBase> &signal : lsignals)
+			mask |= UINT64_C(1) << signal->logic_bit_index();
+
+		compactor_ = make_shared<data::ChannelCompactor>(
+			lsegments.front()->unit_size(), mask);
+
+		for (const shared_ptr<data::SignalBase> &signal : lsignals)
+			channels.push_back({
+				compactor_->compacted_bit(signal->logic_bit_index()),
+				false, true, signal->name().toStdString()});
+	}
+
+	uint32_t index = lsignals.size();
+	for (const shared_ptr<data::SignalBase> &signal : asignals) {
+		channels.push_back({index, true, signal->enabled(),
+			signal->name().toStdString()});
+
+		if (signal->enabled()) {
+			const deque< shared_ptr<data::AnalogSegment> > &segments =
+				signal->analog_data()->analog_segments();
+			for (auto i = segments.rbegin(); i != segments.rend(); i++)
+				if (!partial || i == segments.rend() - 1)
+					asegments.emplace_back(index, *i);
+		}
+
+		index++;
+	}
+
+	if (lsegments.empty() && asegments.empty()) {
+		error_ = tr("No channels with data enabled.");
+		return false;
+	}
+
+	// Only whole captures are remembered, and only by one save at a time
+	if (!partial) {
+		saved_ = session_.saved_container();
+		if (saved_ && saved_->busy.exchange(true))
+			saved_.reset();
+	}
+
+	// If the file was saved before, every segment stored in it must
+	// still be there to add to it
+	saved_index_.clear();
+	if (saved_ && saved_->writer && saved_->file_name == file_name_) {
+		size_t found = 0;
+		for (size_t i = 0; i < saved_->segments.size(); i++) {
+			const shared_ptr<data::Segment> &s = saved_->segments[i];
+			found += count(lsegments.begin(), lsegments.end(), s) +
+				count_if(asegments.begin(), asegments.end(),
+					[&](const pair< uint32_t,
+						shared_ptr<data::AnalogSegment> > &a) {
+						return a.second == s; });
+			saved_index_[s.get()] = i;
+		}
+
+		if (found == saved_->segments.size() &&
+			saved_->writer->reopen(channels))
+			container_ = saved_->writer;
+		else
+			saved_index_.clear();
+	}
+
+	// Levels would have to be written again with every save while the
+	// capture grows, so they are left out until it has stopped
+	store_levels_ = !partial && (!saved_ ||
+		session_.get_capture_state() == Session::Stopped);
+
+	if (!container_) {
+		container_ = make_shared<data::ContainerWriter>();
+		if (!container_->open(file_name_, channels)) {
+			error_ = tr("Error while saving: ") +
+				QString::fromStdString(container_->error());
+			if (saved_) {
+				saved_->busy = false;
+				saved_.reset();
+			}
+			return false;
+		}
+	}
+
+	// Leave room for the samples that later saves of a running capture
+	// add, so that they are written in place
+	container_->set_growing(!partial &&
+		session_.get_capture_state() != Session::Stopped);
+
+	thread_ = std::thread(&StoreSession::store_container_proc, this,
+		lsegments, asegments);
+	return true;
+}
+
+void StoreSession::store_container_proc(
+	vector< shared_ptr<data::LogicSegment> > lsegments,
+	vector< pair< uint32_t, shared_ptr<data::AnalogSegment> > > asegments)
+{
+	unsigned progress_scale = 0;
+	uint64_t total = 0, stored = 0;
+
+	// The segments of the file in its order. Segments that are added to
+	// keep their place, new ones are appended.
+	vector< shared_ptr<data::Segment> > file_segments;
+	if (!saved_index_.empty())
+		file_segments = saved_->segments;
+
+	// Segments that were saved before are skipped if nothing changed
+	const auto unchanged = [&](const shared_ptr<data::Segment> &segment) {
+		const auto iter = saved_index_.find(segment.get());
+		return iter != saved_index_.end() &&
+			container_->segment_sample_count(iter->second) ==
+				sample_range_of(segment).second &&
+			(saved_->with_levels || !store_levels_);
+	};
+
+	// Returns where saving a segment starts. Segments that are added to
+	// keep the samples that were saved, see
+	// ContainerWriter::resume_segment().
+	const auto first_sample = [&](const shared_ptr<data::Segment> &segment) {
+		const pair<uint64_t, uint64_t> range = sample_range_of(segment);
+		const auto iter = saved_index_.find(segment.get());
+		if (iter == saved_index_.end())
+			return range.first;
+		if (unchanged(segment))
+			return range.second;
+
+		return container_->resumed_sample_count(iter->second);
+	};
+
+	for (const shared_ptr<data::LogicSegment> &s : lsegments)
+		total += sample_range_of(s).second - first_sample(s);
+	for (const auto &entry : asegments)
+		total += sample_range_of(entry.second).second -
+			first_sample(entry.second);
+
+	// Qt needs the progress values to fit inside an int. If they would
+	// not, scale the current and max values down until they do.
+	while ((total >> progress_scale) > INT_MAX)
+		progress_scale++;
+
+	unit_count_ = total >> progress_scale;
+
+	// Writes a range of samples in blocks straight from the segment's
+	// chunks and stores the mip-map levels if the whole segment is saved.
+	// Logic samples and their mip-map are compacted on the way.
+	vector<uint8_t> buffer;
+	const auto store_segment = [&](shared_ptr<data::Segment> segment,
+		const data::ChannelCompactor *compactor, bool analog,
+		uint32_t channel_index, unsigned int unit_size,
+		float min_value, float max_value,
+		function<const void* (unsigned int, uint64_t&)> level) {
+		if (compactor && compactor->is_identity())
+			compactor = nullptr;
+
+		if (unchanged(segment))
+			return;
+
+		const pair<uint64_t, uint64_t> range = sample_range_of(segment);
+		const uint64_t samples_per_block = BlockSize / segment->unit_size();
+		uint64_t first = range.first;
+
+		const auto iter = saved_index_.find(segment.get());
+		if (iter == saved_index_.end()) {
+			container_->begin_segment(analog, channel_index, unit_size,
+				segment->samplerate(), min_value, max_value);
+			file_segments.push_back(segment);
+		} else
+			first = container_->resume_segment(iter->second,
+				min_value, max_value);
+
+		segment->pin_chunks();
+
+		for (uint64_t i = first; !interrupt_ && i < range.second;) {
+			progress_updated();
+
+			uint64_t count = min(samples_per_block, range.second - i);
+			const uint8_t *data = segment->contiguous_samples(i, count);
+
+			if (compactor) {
+				buffer.resize(count * compactor->unit_size());
+				compactor->compact(data, buffer.data(), count);
+				data = buffer.data();
+			}
+
+			container_->append_samples(data, count);
+
+			i += count;
+			stored += count;
+			units_stored_ = stored >> progress_scale;
+		}
+
+		segment->unpin_chunks();
+
+		if (store_levels_ && range.first == 0 &&
+			range.second == segment->get_sample_count()) {
+			uint64_t length;
+			const void *data;
+			for (unsigned int l = 0; (data = level(l, length)); l++) {
+				if (compactor) {
+					const uint64_t entries = length / segment->unit_size();
+					buffer.resize(entries * compactor->unit_size());
+					compactor->compact(data, buffer.data(), entries);
+					container_->add_level(buffer.data(), buffer.size());
+				} else
+					container_->add_level(data, length);
+			}
+		}
+
+		container_->end_segment();
+	};
+
+	for (const shared_ptr<data::LogicSegment> &s : lsegments) {
+		if (interrupt_)
+			break;
+
+		store_segment(s, compactor_.get(), false, 0,
+			compactor_->unit_size(), 0, 0,
+			[&](unsigned int l, uint64_t &length) {
+				return s->mipmap_level(l, length); });
+	}
+
+	for (const auto &entry : asegments) {
+		if (interrupt_)
+			break;
+
+		const shared_ptr<data::AnalogSegment> &s = entry.second;
+		const pair<float, float> min_max = s->get_min_max();
+
+		store_segment(s, nullptr, true, entry.first, s->unit_size(),
+			min_max.first, min_max.second,
+			[&](unsigned int l, uint64_t &length) {
+				return s->envelope_level(l, length); });
+	}
+
+	bool success = false;
+	if (interrupt_)
+		container_->abort();
+	else if (!(success = container_->close())) {
+		lock_guard<mutex> lock(mutex_);
+		error_ = tr("Error while saving: ") +
+			QString::fromStdString(container_->error());
+	}
+
+	// A failed or cancelled save leaves the writer out of step with the
+	// file, so the next save writes it anew
+	if (saved_) {
+		if (success) {
+			saved_->file_name = file_name_;
+			saved_->writer = container_;
+			saved_->segments = file_segments;
+			saved_->with_levels = store_levels_;
+		} else
+			saved_->writer.reset();
+		saved_->busy = false;
+	}
+
+	container_.reset();
+
+	// Zeroing the progress variables indicates completion
+	units_stored_ = unit_count_ = 0;
+
+	if (success)
+		store_successful();
+	progress_updated();
+}
+
+pair<uint64_t, uint64_t> StoreSession::sample_range_of(
+	const shared_ptr<data::Segment> &segment) const
+{
+	const uint64_t count = segment->get_sample_count();
+
+	if (sample_range_.first == sample_range_.second)
+		return make_pair(0, count);
+
+	const uint64_t start = min(sample_range_.first, sample_range_.second);
+	const uint64_t end = max(sample_range_.first, sample_range_.second);
+
+	return make_pair(min(start, count), min(end, count));
+}
+
 }  // namespace pv
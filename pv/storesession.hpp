@@ -21,7 +21,9 @@
 #define PULSEVIEW_PV_STORESESSION_HPP
 
 #include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <fstream>
 #include <map>
 #include <memory>
@@ -34,6 +36,8 @@
 #include <QObject>
 
 using std::atomic;
+using std::condition_variable;
+using std::deque;
 using std::string;
 using std::shared_ptr;
 using std::pair;
@@ -44,6 +48,7 @@ using std::mutex;
 using std::ofstream;
 
 namespace sigrok {
+class Channel;
 class Output;
 class OutputFormat;
 }
@@ -55,9 +60,33 @@ class Session;
 namespace data {
 class SignalBase;
 class AnalogSegment;
+class ChannelCompactor;
+class ContainerWriter;
 class LogicSegment;
+class Segment;
 }
 
+/**
+ * Remembers what was saved to a native capture file, so that saving the
+ * same capture to the same file again only adds what is new.
+ */
+struct SavedContainer
+{
+	SavedContainer();
+
+	string file_name;
+	shared_ptr<data::ContainerWriter> writer;
+
+	/// The saved segments in the order of the file.
+	vector< shared_ptr<data::Segment> > segments;
+
+	/// true if the levels of all segments were saved.
+	bool with_levels;
+
+	/// Set while a StoreSession adds to the file.
+	atomic<bool> busy;
+};
+
 class StoreSession : public QObject
 {
 	Q_OBJECT
@@ -65,7 +94,15 @@ class StoreSession : public QObject
 private:
 	static const size_t BlockSize;
 
+	/// The number of formatted blocks that may wait to be written.
+	static const size_t WriteQueueDepth;
+
 public:
+	/**
+	 * Constructor.
+	 * @param output_format The format to export to, or nullptr to save a
+	 * native capture file.
+	 */
 	StoreSession(const string &file_name,
 		const shared_ptr<sigrok::OutputFormat> &output_format,
 		const map<string, Glib::VariantBase> &options,
@@ -85,10 +122,49 @@ public:
 	void cancel();
 
 private:
-	void store_proc(vector< shared_ptr<data::SignalBase> > achannel_list,
+	void store_proc(vector< shared_ptr<sigrok::Channel> > achannel_list,
 		vector< shared_ptr<pv::data::AnalogSegment> > asegment_list,
 		shared_ptr<pv::data::LogicSegment> lsegment);
 
+	/**
+	 * Hands formatted output data over to the writer thread, blocking while
+	 * the queue is full.
+	 */
+	void queue_write(string &&data);
+
+	/**
+	 * Writes the queued output data to the file until the formatting
+	 * thread is done.
+	 */
+	void write_proc();
+
+	/**
+	 * Prepares saving a native capture file. If the whole capture is
+	 * saved to the file it was last saved to, the file is reopened to
+	 * add to it, see SavedContainer.
+	 *
+	 * Disabled logic channels are left out of the file and the channels
+	 * are renumbered as described in containerformat.hpp, so a reloaded
+	 * capture doesn't keep the original channel indices.
+	 */
+	bool start_container();
+
+	/**
+	 * Writes the segments into a native capture file. The segments are
+	 * stored with their mip-maps unless only a part of them is saved or
+	 * the file is added to while the capture is still running.
+	 */
+	void store_container_proc(
+		vector< shared_ptr<pv::data::LogicSegment> > lsegments,
+		vector< pair< uint32_t, shared_ptr<pv::data::AnalogSegment> > >
+			asegments);
+
+	/**
+	 * Returns the part of a segment that is to be saved.
+	 */
+	pair<uint64_t, uint64_t> sample_range_of(
+		const shared_ptr<data::Segment> &segment) const;
+
 Q_SIGNALS:
 	void progress_updated();
 
@@ -103,8 +179,19 @@ private:
 
 	shared_ptr<sigrok::Output> output_;
 	ofstream output_stream_;
+	shared_ptr<data::ContainerWriter> container_;
+	shared_ptr<data::ChannelCompactor> compactor_;
+
+	shared_ptr<SavedContainer> saved_;
+	map<const data::Segment*, size_t> saved_index_;
+	bool store_levels_;
+
+	std::thread thread_, writer_thread_;
 
-	std::thread thread_;
+	mutex write_mutex_;
+	condition_variable write_data_cond_, write_space_cond_;
+	deque<string> write_queue_;
+	bool write_done_;
 
 	atomic<bool> interrupt_;
 
@@ -26,6 +26,7 @@
 #include <QDebug>
 #include <QFileDialog>
 #include <QHelpEvent>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMessageBox>
 #include <QSettings>
@@ -41,6 +42,8 @@
 #include <pv/devices/sessionfile.hpp>
 #include <pv/dialogs/connect.hpp>
 #include <pv/dialogs/inputoutputoptions.hpp>
+#include <pv/dialogs/loadprogress.hpp>
+#include <pv/dialogs/loadrange.hpp>
 #include <pv/dialogs/storeprogress.hpp>
 #include <pv/mainwindow.hpp>
 #include <pv/popups/channels.hpp>
@@ -57,6 +60,7 @@
 
 using std::back_inserter;
 using std::copy;
+using std::dynamic_pointer_cast;
 using std::list;
 using std::make_pair;
 using std::map;
@@ -91,9 +95,12 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	StandardBar(session, parent, view, false),
 	action_new_view_(new QAction(this)),
 	action_open_(new QAction(this)),
+	action_open_range_(new QAction(this)),
+	action_load_visible_range_(new QAction(this)),
 	action_save_as_(new QAction(this)),
 	action_save_selection_as_(new QAction(this)),
 	action_connect_(new QAction(this)),
+	action_add_math_channel_(new QAction(this)),
 	open_button_(new QToolButton()),
 	save_button_(new QToolButton()),
 	device_selector_(parent, session.device_manager(),
@@ -128,6 +135,17 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	connect(action_open_, SIGNAL(triggered(bool)),
 		this, SLOT(on_actionOpen_triggered()));
 
+	action_open_range_->setText(tr("Open &Range..."));
+	action_open_range_->setToolTip(tr("Open only a part of a file"));
+	connect(action_open_range_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionOpenRange_triggered()));
+
+	action_load_visible_range_->setText(tr("Load &Visible Range"));
+	action_load_visible_range_->setToolTip(tr("Reload the file, keeping "
+		"all samples of the time range that is currently visible"));
+	connect(action_load_visible_range_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionLoadVisibleRange_triggered()));
+
 	action_save_as_->setText(tr("&Save As..."));
 	action_save_as_->setIcon(QIcon::fromTheme("document-save-as",
 		QIcon(":/icons/document-save-as.png")));
@@ -160,9 +178,20 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	connect(action_connect_, SIGNAL(triggered(bool)),
 		this, SLOT(on_actionConnect_triggered()));
 
+	action_add_math_channel_->setText(tr("Add &Math Channel..."));
+	action_add_math_channel_->setToolTip(tr("Add a channel computed from "
+		"other analog channels"));
+	connect(action_add_math_channel_, SIGNAL(triggered(bool)),
+		this, SLOT(on_actionAddMathChannel_triggered()));
+
 	// Open button
+	vector<QAction *> open_actions;
+	open_actions.push_back(action_open_);
+	open_actions.push_back(action_open_range_);
+	open_actions.push_back(action_load_visible_range_);
+
 	widgets::ImportMenu *import_menu = new widgets::ImportMenu(this,
-		session.device_manager().context(), action_open_);
+		session.device_manager().context(), open_actions);
 	connect(import_menu,
 		SIGNAL(format_selected(shared_ptr<sigrok::InputFormat>)),
 		this,
@@ -173,13 +202,13 @@ MainBar::MainBar(Session &session, QWidget *parent,
 	open_button_->setPopupMode(QToolButton::MenuButtonPopup);
 
 	// Save button
-	vector<QAction *> open_actions;
-	open_actions.push_back(action_save_as_);
-	open_actions.push_back(action_save_selection_as_);
+	vector<QAction *> save_actions;
+	save_actions.push_back(action_save_as_);
+	save_actions.push_back(action_save_selection_as_);
 
 	widgets::ExportMenu *export_menu = new widgets::ExportMenu(this,
 		session.device_manager().context(),
-		open_actions);
+		save_actions);
 	connect(export_menu,
 		SIGNAL(format_selected(shared_ptr<sigrok::OutputFormat>)),
 		this,
@@ -286,6 +315,11 @@ QAction* MainBar::action_connect() const
 	return action_connect_;
 }
 
+QAction* MainBar::action_add_math_channel() const
+{
+	return action_add_math_channel_;
+}
+
 void MainBar::update_sample_rate_selector()
 {
 	Glib::VariantContainerBase gvar_dict;
@@ -618,6 +652,11 @@ void MainBar::export_file(shared_ptr<OutputFormat> format, bool selection_only)
 		sample_range = make_pair(0, 0);
 	}
 
+	// Sessions can also be saved as native capture files, which open
+	// without reading in all of the samples
+	const bool offer_container = (format->name() == "srzip");
+	const QString container_filter = tr("PulseView Captures (*.pvcap)");
+
 	// Construct the filter
 	const vector<string> exts = format->extensions();
 	QString filter = tr("%1 files ").arg(
@@ -626,23 +665,31 @@ void MainBar::export_file(shared_ptr<OutputFormat> format, bool selection_only)
 	if (exts.empty())
 		filter += "(*.*)";
 	else
-		filter += QString("(*.%1);;%2 (*.*)").arg(
+		filter += QString("(*.%1);;%2%3 (*.*)").arg(
 			QString::fromStdString(join(exts, ", *.")),
+			offer_container ? container_filter + ";;" : QString(),
 			tr("All Files"));
 
 	// Show the file dialog
-	const QString file_name = QFileDialog::getSaveFileName(
-		this, tr("Save File"), dir, filter);
+	QString selected_filter;
+	QString file_name = QFileDialog::getSaveFileName(
+		this, tr("Save File"), dir, filter, &selected_filter);
 
 	if (file_name.isEmpty())
 		return;
 
+	const bool save_container = offer_container &&
+		(selected_filter == container_filter ||
+		file_name.endsWith(".pvcap", Qt::CaseInsensitive));
+	if (save_container && !file_name.endsWith(".pvcap", Qt::CaseInsensitive))
+		file_name += ".pvcap";
+
 	const QString abs_path = QFileInfo(file_name).absolutePath();
 	settings.setValue(SettingSaveDirectory, abs_path);
 
 	// Show the options dialog
 	map<string, Glib::VariantBase> options;
-	if (!format->options().empty()) {
+	if (!save_container && !format->options().empty()) {
 		dialogs::InputOutputOptions dlg(
 			tr("Export %1").arg(QString::fromStdString(
 				format->description())),
@@ -655,7 +702,12 @@ void MainBar::export_file(shared_ptr<OutputFormat> format, bool selection_only)
 	if (!selection_only)
 		session_.set_name(QFileInfo(file_name).fileName());
 
-	StoreProgress *dlg = new StoreProgress(file_name, format, options,
+	// The setup of a whole capture is restored when it is opened again
+	if (save_container && !selection_only)
+		session_.save_capture_setup(file_name);
+
+	StoreProgress *dlg = new StoreProgress(file_name,
+		save_container ? shared_ptr<OutputFormat>() : format, options,
 		sample_range, session_, this);
 	dlg->run();
 }
@@ -696,6 +748,7 @@ void MainBar::import_file(shared_ptr<InputFormat> format)
 	}
 
 	session_.load_file(file_name, format, options);
+	show_load_progress();
 
 	const QString abs_path = QFileInfo(file_name).absolutePath();
 	settings.setValue(SettingOpenDirectory, abs_path);
@@ -741,6 +794,18 @@ void MainBar::on_config_changed()
 	commit_sample_rate();
 }
 
+void MainBar::show_load_progress()
+{
+	shared_ptr<devices::File> file =
+		dynamic_pointer_cast<devices::File>(session_.device());
+
+	// Only imported files track how far they were read
+	if (!file || file->file_size() == 0)
+		return;
+
+	new dialogs::LoadProgress(session_, file, this);
+}
+
 void MainBar::on_actionNewView_triggered()
 {
 	new_view(&session_);
@@ -755,6 +820,8 @@ void MainBar::on_actionOpen_triggered()
 	const QString file_name = QFileDialog::getOpenFileName(
 		this, tr("Open File"), dir, tr(
 			"Sigrok Sessions (*.sr);;"
+			"PulseView Captures (*.pvcap);;"
+			"PulseView Recordings (*.pvrec);;"
 			"All Files (*.*)"));
 
 	if (!file_name.isEmpty()) {
@@ -765,6 +832,49 @@ void MainBar::on_actionOpen_triggered()
 	}
 }
 
+void MainBar::on_actionOpenRange_triggered()
+{
+	QSettings settings;
+	const QString dir = settings.value(SettingOpenDirectory).toString();
+
+	const QString file_name = QFileDialog::getOpenFileName(
+		this, tr("Open Range of File"), dir, tr(
+			"Sigrok Sessions (*.sr);;"
+			"PulseView Captures (*.pvcap);;"
+			"PulseView Recordings (*.pvrec);;"
+			"All Files (*.*)"));
+
+	if (file_name.isEmpty())
+		return;
+
+	dialogs::LoadRange dlg(file_name, this);
+	if (!dlg.exec())
+		return;
+
+	session_.load_file(file_name, nullptr, {}, dlg.window());
+
+	const QString abs_path = QFileInfo(file_name).absolutePath();
+	settings.setValue(SettingOpenDirectory, abs_path);
+}
+
+void MainBar::on_actionLoadVisibleRange_triggered()
+{
+	views::TraceView::View *trace_view =
+		qobject_cast<views::TraceView::View*>(session_.main_view().get());
+
+	if (!trace_view)
+		return;
+
+	const double start = max(0.0, trace_view->offset().convert_to<double>());
+	const double end = trace_view->offset().convert_to<double>() +
+		trace_view->scale() * trace_view->viewport()->width();
+
+	session_.reload_file(data::SampleWindow(start, end),
+		[&](const QString infoText) {
+			session_error(tr("Failed to load file"), infoText); });
+	show_load_progress();
+}
+
 void MainBar::on_actionSaveAs_triggered()
 {
 	export_file(session_.device_manager().context()->output_formats()["srzip"]);
@@ -790,6 +900,24 @@ void MainBar::on_actionConnect_triggered()
 	update_device_list();
 }
 
+void MainBar::on_actionAddMathChannel_triggered()
+{
+	QString expression;
+	QString error;
+
+	do {
+		bool ok;
+		expression = QInputDialog::getText(this, tr("Add Math Channel"),
+			error.isEmpty() ? tr("Expression, e.g. (CH1 - CH2) * 10 or "
+				"lowpass(CH1, 1000):") :
+				tr("Invalid expression: %1").arg(error),
+			QLineEdit::Normal, expression, &ok);
+
+		if (!ok || expression.isEmpty())
+			return;
+	} while (!session_.add_math_signal(expression, error));
+}
+
 void MainBar::add_toolbar_widgets()
 {
 	addAction(action_new_view_);
@@ -805,6 +933,8 @@ void MainBar::add_toolbar_widgets()
 	channels_button_action_ = addWidget(&channels_button_);
 	addWidget(&sample_count_);
 	addWidget(&sample_rate_);
+	addSeparator();
+	addAction(action_add_math_channel_);
 #ifdef ENABLE_DECODE
 	addSeparator();
 	addWidget(add_decoder_button_);
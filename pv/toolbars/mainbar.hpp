@@ -99,6 +99,7 @@ public:
 	QAction* action_save_as() const;
 	QAction* action_save_selection_as() const;
 	QAction* action_connect() const;
+	QAction* action_add_math_channel() const;
 
 	void session_error(const QString text, const QString info_text);
 
@@ -116,11 +117,20 @@ private:
 	void commit_sample_rate();
 	void commit_sample_count();
 
+	/**
+	 * Shows the progress of the current device if it is a file that is
+	 * being imported.
+	 */
+	void show_load_progress();
+
 	QAction *const action_new_view_;
 	QAction *const action_open_;
+	QAction *const action_open_range_;
+	QAction *const action_load_visible_range_;
 	QAction *const action_save_as_;
 	QAction *const action_save_selection_as_;
 	QAction *const action_connect_;
+	QAction *const action_add_math_channel_;
 
 private Q_SLOTS:
 	void show_session_error(const QString text, const QString info_text);
@@ -142,11 +152,15 @@ private Q_SLOTS:
 	void on_actionNewView_triggered();
 
 	void on_actionOpen_triggered();
+	void on_actionOpenRange_triggered();
+	void on_actionLoadVisibleRange_triggered();
 	void on_actionSaveAs_triggered();
 	void on_actionSaveSelectionAs_triggered();
 
 	void on_actionConnect_triggered();
 
+	void on_actionAddMathChannel_triggered();
+
 protected:
 	void add_toolbar_widgets();
 
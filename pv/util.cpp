@@ -41,6 +41,21 @@ using namespace Qt;
 namespace pv {
 namespace util {
 
+// 2^64, the number of fraction units in a second of a FixedTimestamp
+static const Timestamp FractionUnits("18446744073709551616");
+
+FixedTimestamp::FixedTimestamp(const Timestamp &t)
+{
+	const Timestamp seconds = floor(t);
+	seconds_ = seconds.convert_to<int64_t>();
+	fraction_ = ((t - seconds) * FractionUnits).convert_to<uint64_t>();
+}
+
+Timestamp FixedTimestamp::to_timestamp() const
+{
+	return Timestamp(seconds_) + Timestamp(fraction_) / FractionUnits;
+}
+
 static QTextStream& operator<<(QTextStream& stream, SIPrefix prefix)
 {
 	switch (prefix) {
@@ -21,6 +21,7 @@
 #define PULSEVIEW_UTIL_HPP
 
 #include <cmath>
+#include <cstdint>
 
 #ifndef Q_MOC_RUN
 #include <boost/multiprecision/cpp_dec_float.hpp>
@@ -56,6 +57,96 @@ typedef boost::multiprecision::number<
 	boost::multiprecision::cpp_dec_float<24>,
 	boost::multiprecision::et_off> Timestamp;
 
+/**
+ * A 128-bit fixed-point time value, made of whole seconds and a binary
+ * fraction with a resolution of 2^-64 seconds.
+ *
+ * Unlike Timestamp, adding, subtracting and comparing values only takes a
+ * few integer operations, so it is used in the painting code, where the
+ * offsets of the view and the segments are subtracted for every trace.
+ * Values are converted from and to Timestamp where they enter or leave
+ * the painting code.
+ */
+class FixedTimestamp
+{
+public:
+	FixedTimestamp() :
+		seconds_(0),
+		fraction_(0)
+	{
+	}
+
+	explicit FixedTimestamp(const Timestamp &t);
+
+	Timestamp to_timestamp() const;
+
+	double to_double() const {
+		// Negative values are converted from their magnitude, so that
+		// small negative differences don't lose their precision
+		if (seconds_ < 0 && fraction_ != 0)
+			return (seconds_ + 1) - std::ldexp((double)(0 - fraction_), -64);
+		return seconds_ + std::ldexp((double)fraction_, -64);
+	}
+
+	FixedTimestamp& operator+=(const FixedTimestamp &other) {
+		const uint64_t fraction = fraction_ + other.fraction_;
+		seconds_ += other.seconds_ + ((fraction < fraction_) ? 1 : 0);
+		fraction_ = fraction;
+		return *this;
+	}
+
+	FixedTimestamp& operator-=(const FixedTimestamp &other) {
+		const uint64_t fraction = fraction_ - other.fraction_;
+		seconds_ -= other.seconds_ + ((fraction > fraction_) ? 1 : 0);
+		fraction_ = fraction;
+		return *this;
+	}
+
+	FixedTimestamp operator+(const FixedTimestamp &other) const {
+		return FixedTimestamp(*this) += other;
+	}
+
+	FixedTimestamp operator-(const FixedTimestamp &other) const {
+		return FixedTimestamp(*this) -= other;
+	}
+
+	FixedTimestamp operator-() const {
+		return FixedTimestamp() -= *this;
+	}
+
+	bool operator==(const FixedTimestamp &other) const {
+		return seconds_ == other.seconds_ && fraction_ == other.fraction_;
+	}
+
+	bool operator!=(const FixedTimestamp &other) const {
+		return !(*this == other);
+	}
+
+	bool operator<(const FixedTimestamp &other) const {
+		return (seconds_ < other.seconds_) || (seconds_ == other.seconds_ &&
+			fraction_ < other.fraction_);
+	}
+
+	bool operator>(const FixedTimestamp &other) const {
+		return other < *this;
+	}
+
+	bool operator<=(const FixedTimestamp &other) const {
+		return !(other < *this);
+	}
+
+	bool operator>=(const FixedTimestamp &other) const {
+		return !(*this < other);
+	}
+
+private:
+	/// The whole seconds, rounded towards negative infinity.
+	int64_t seconds_;
+
+	/// The fraction of a second in units of 2^-64 seconds.
+	uint64_t fraction_;
+};
+
 /**
  * Formats a given timestamp with the specified SI prefix.
  *
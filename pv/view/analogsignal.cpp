@@ -19,6 +19,10 @@
 
 #include <extdef.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
@@ -28,6 +32,7 @@
 #include <QApplication>
 #include <QCheckBox>
 #include <QComboBox>
+#include <QElapsedTimer>
 #include <QFormLayout>
 #include <QGridLayout>
 #include <QLabel>
@@ -40,7 +45,7 @@
 #include "pv/data/logic.hpp"
 #include "pv/data/logicsegment.hpp"
 #include "pv/data/signalbase.hpp"
-#include "pv/globalsettings.hpp"
+#include "pv/session.hpp"
 #include "pv/view/logicsignal.hpp"
 #include "pv/view/view.hpp"
 
@@ -61,6 +66,13 @@ namespace pv {
 namespace views {
 namespace TraceView {
 
+// Scratch buffers for painting the traces, so that painting doesn't
+// allocate memory every frame. They are kept per thread, as the tiles
+// of a trace may be rendered by several threads at once.
+static thread_local vector<float> sample_scratch;
+static thread_local vector<QPointF> point_scratch;
+static thread_local vector<QRectF> rect_scratch;
+
 const QColor AnalogSignal::SignalColours[4] = {
 	QColor(0xC4, 0xA0, 0x00),	// Yellow
 	QColor(0x87, 0x20, 0x7A),	// Magenta
@@ -74,6 +86,7 @@ const QColor AnalogSignal::GridMinorColor = QColor(0, 0, 0, 20 * 256 / 100);
 const QColor AnalogSignal::SamplingPointColour(0x77, 0x77, 0x77);
 
 const int64_t AnalogSignal::TracePaintBlockSize = 1024 * 1024;  // 4 MiB (due to float)
+const float AnalogSignal::ReductionThreshold = 4.0f;
 const float AnalogSignal::EnvelopeThreshold = 64.0f;
 
 const int AnalogSignal::MaximumVDivs = 10;
@@ -118,6 +131,7 @@ void AnalogSignal::save_settings(QSettings &settings) const
 	settings.setValue("neg_vdivs", neg_vdivs_);
 	settings.setValue("scale_index", scale_index_);
 	settings.setValue("conversion_type", conversion_type_);
+	settings.setValue("conversion_packed", (bool)base_->conversion_group());
 	settings.setValue("display_type", display_type_);
 	settings.setValue("autoranging", autoranging_);
 }
@@ -135,6 +149,10 @@ void AnalogSignal::restore_settings(QSettings &settings)
 		update_scale();
 	}
 
+	if (settings.contains("conversion_packed") &&
+		settings.value("conversion_packed").toBool())
+		base_->set_conversion_group(session_.conversion_group());
+
 	if (settings.contains("conversion_type")) {
 		conversion_type_ = (data::SignalBase::ConversionType)(settings.value("conversion_type").toInt());
 		update_conversion_type();
@@ -184,59 +202,76 @@ void AnalogSignal::paint_back(QPainter &p, ViewItemPaintParams &pp)
 	}
 }
 
-void AnalogSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
+void AnalogSignal::paint_mid_at(QPainter &p, ViewItemPaintParams &pp, int y,
+	const PaintState &state,
+	const vector< shared_ptr<pv::data::Segment> > &segments)
 {
-	assert(base_->analog_data());
-	assert(owner_);
-
-	const int y = get_visual_y();
-
-	if (!base_->enabled())
+	if (!state.enabled)
 		return;
 
 	if ((display_type_ == DisplayAnalog) || (display_type_ == DisplayBoth)) {
-		paint_grid(p, y, pp.left(), pp.right());
+		paint_grid(p, pp, y);
 
-		const deque< shared_ptr<pv::data::AnalogSegment> > &segments =
-			base_->analog_data()->analog_segments();
-		if (segments.empty())
+		const shared_ptr<pv::data::AnalogSegment> segment =
+			find_segment<pv::data::AnalogSegment>(segments);
+		if (!segment)
 			return;
 
-		const shared_ptr<pv::data::AnalogSegment> &segment =
-			segments.front();
-
 		const double pixels_offset = pp.pixels_offset();
 		const double samplerate = max(1.0, segment->samplerate());
-		const pv::util::Timestamp& start_time = segment->start_time();
 		const int64_t last_sample = segment->get_sample_count() - 1;
 		const double samples_per_pixel = samplerate * pp.scale();
-		const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-		const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+		const double start = samplerate *
+			(pp.fixed_offset() - segment->fixed_start_time()).to_double();
+		const double end = start + samples_per_pixel * pp.width();
 
-		const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
+		const int64_t start_sample = min(max((int64_t)floor(start),
 			(int64_t)0), last_sample);
-		const int64_t end_sample = min(max((ceil(end) + 1).convert_to<int64_t>(),
+		const int64_t end_sample = min(max((int64_t)ceil(end) + 1,
 			(int64_t)0), last_sample);
 
-		if (samples_per_pixel < EnvelopeThreshold)
-			paint_trace(p, segment, y, pp.left(),
+		// Lower render qualities select the painting method as if the
+		// view was zoomed out further
+		const double detail = samples_per_pixel * pp.detail_reduction();
+
+		if (detail < ReductionThreshold)
+			paint_trace(p, pp, segment, state.colour, y, pp.left(),
+				start_sample, end_sample,
+				pixels_offset, samples_per_pixel,
+				pp.quality() == ViewItemPaintParams::QualityFull);
+		else if (detail < EnvelopeThreshold)
+			paint_reduced_trace(p, pp, segment, state.colour,
+				y, pp.left(),
 				start_sample, end_sample,
 				pixels_offset, samples_per_pixel);
 		else
-			paint_envelope(p, segment, y, pp.left(),
+			paint_envelope(p, pp, segment, state.colour, y, pp.left(),
 				start_sample, end_sample,
-				pixels_offset, samples_per_pixel);
+				pixels_offset, samples_per_pixel, detail);
 	}
 
 	if ((display_type_ == DisplayConverted) || (display_type_ == DisplayBoth)) {
 		if (((conversion_type_ == data::SignalBase::A2LConversionByTreshold) ||
 			(conversion_type_ == data::SignalBase::A2LConversionBySchmittTrigger))) {
 
-			paint_logic_mid(p, pp);
+			paint_logic_mid(p, pp, y, state,
+				find_segment<pv::data::LogicSegment>(segments));
 		}
 	}
 }
 
+vector< shared_ptr<pv::data::Segment> > AnalogSignal::painted_segments() const
+{
+	vector< shared_ptr<pv::data::Segment> > painted =
+		Signal::painted_segments();
+
+	const shared_ptr<pv::data::Logic> logic_data = base_->logic_data();
+	if (logic_data && !logic_data->logic_segments().empty())
+		painted.push_back(logic_data->logic_segments().front());
+
+	return painted;
+}
+
 void AnalogSignal::paint_fore(QPainter &p, ViewItemPaintParams &pp)
 {
 	if (!enabled())
@@ -260,13 +295,15 @@ void AnalogSignal::paint_fore(QPainter &p, ViewItemPaintParams &pp)
 	}
 }
 
-void AnalogSignal::paint_grid(QPainter &p, int y, int left, int right)
+void AnalogSignal::paint_grid(QPainter &p, const ViewItemPaintParams &pp,
+	int y)
 {
+	const bool antialiasing = p.testRenderHint(QPainter::Antialiasing);
 	p.setRenderHint(QPainter::Antialiasing, false);
 
-	GlobalSettings settings;
+	const int left = pp.left(), right = pp.right();
 	const bool show_analog_minor_grid =
-		settings.value(GlobalSettings::Key_View_ShowAnalogMinorGrid).toBool();
+		pp.display_settings().show_analog_minor_grid;
 
 	if (pos_vdivs_ > 0) {
 		p.setPen(QPen(GridMajorColor, 1, Qt::DashLine));
@@ -310,89 +347,262 @@ void AnalogSignal::paint_grid(QPainter &p, int y, int left, int right)
 		}
 	}
 
-	p.setRenderHint(QPainter::Antialiasing, true);
+	p.setRenderHint(QPainter::Antialiasing, antialiasing);
 }
 
-void AnalogSignal::paint_trace(QPainter &p,
+void AnalogSignal::paint_trace(QPainter &p, ViewItemPaintParams &pp,
 	const shared_ptr<pv::data::AnalogSegment> &segment,
-	int y, int left, const int64_t start, const int64_t end,
-	const double pixels_offset, const double samples_per_pixel)
+	const QColor &colour, int y, int left, const int64_t start, const int64_t end,
+	const double pixels_offset, const double samples_per_pixel,
+	bool sampling_points)
 {
 	if (end <= start)
 		return;
 
 	// Calculate and paint the sampling points if enabled and useful
-	GlobalSettings settings;
-	const bool show_sampling_points =
-		settings.value(GlobalSettings::Key_View_ShowSamplingPoints).toBool() &&
+	const bool show_sampling_points = sampling_points &&
+		pp.display_settings().show_sampling_points &&
 		(samples_per_pixel < 0.25);
 
-	p.setPen(base_->colour());
+	vector<float> &samples = sample_scratch;
+	vector<QPointF> &points = point_scratch;
+	vector<QRectF> &sampling_points = rect_scratch;
+	points.clear();
+	sampling_points.clear();
 
-	const int64_t points_count = end - start;
+	const int w = 2;
+	for (int64_t block_start = start; block_start < end;
+		block_start += TracePaintBlockSize) {
+		const int64_t block_end = min(block_start + TracePaintBlockSize, end);
 
-	QPointF *points = new QPointF[points_count];
-	QPointF *point = points;
+		samples.resize(block_end - block_start);
 
-	QRectF *sampling_points = nullptr;
-	if (show_sampling_points)
-		 sampling_points = new QRectF[points_count];
-	QRectF *sampling_point = sampling_points;
+		QElapsedTimer fetch_timer;
+		if (pp.profiling())
+			fetch_timer.start();
+		segment->get_samples(block_start, block_end, samples.data());
+		if (pp.profiling())
+			pp.add_fetched(samples.size(), fetch_timer.nsecsElapsed());
 
-	int64_t sample_count = min(points_count, TracePaintBlockSize);
-	int64_t block_sample = 0;
-	const float *sample_block = segment->get_samples(start, start + sample_count);
+		for (int64_t sample = block_start; sample < block_end; sample++) {
+			const float x = (sample / samples_per_pixel -
+				pixels_offset) + left;
+			const float value = y - samples[sample - block_start] * scale_;
 
-	const int w = 2;
-	for (int64_t sample = start; sample != end; sample++, block_sample++) {
+			points.push_back(QPointF(x, value));
 
-		if (block_sample == TracePaintBlockSize) {
-			block_sample = 0;
-			delete[] sample_block;
-			sample_count = min(points_count - sample, TracePaintBlockSize);
-			sample_block = segment->get_samples(sample, sample + sample_count);
+			if (show_sampling_points)
+				sampling_points.push_back(
+					QRectF(x - (w / 2), value - (w / 2), w, w));
 		}
+	}
+
+	p.setPen(colour);
+	p.drawPolyline(points.data(), points.size());
 
-		const float x = (sample / samples_per_pixel -
-			pixels_offset) + left;
+	if (show_sampling_points) {
+		p.setPen(SamplingPointColour);
+		p.drawRects(sampling_points.data(), sampling_points.size());
+	}
+}
+
+void AnalogSignal::split_columns(int64_t start, int64_t end,
+	double pixels_offset, double samples_per_pixel, vector<int64_t> &bounds)
+{
+	bounds.assign(1, start);
+	for (int64_t column = floor(start / samples_per_pixel - pixels_offset) + 1;
+		bounds.back() < end; column++) {
+		const int64_t first = ceil((column + pixels_offset) * samples_per_pixel);
+		bounds.push_back(min(max(first, bounds.back() + 1), end));
+	}
+}
+
+int AnalogSignal::reduce_column(const float *samples, int64_t count,
+	int64_t indices[4])
+{
+	assert(count > 0);
 
-		*point++ = QPointF(x, y - sample_block[block_sample] * scale_);
+	int64_t min_index, max_index;
+	find_min_max(samples, count, min_index, max_index);
 
-		if (show_sampling_points)
-			*sampling_point++ =
-				QRectF(x - (w / 2), y - sample_block[block_sample] * scale_ - (w / 2), w, w);
+	const int64_t candidates[4] = {0, min(min_index, max_index),
+		max(min_index, max_index), count - 1};
+
+	int n = 0;
+	for (int i = 0; i < 4; i++)
+		if (n == 0 || candidates[i] != indices[n - 1])
+			indices[n++] = candidates[i];
+
+	return n;
+}
+
+void AnalogSignal::find_min_max(const float *samples, int64_t count,
+	int64_t &min_index, int64_t &max_index)
+{
+#ifdef __SSE2__
+	assert(count > 0);
+
+	if (count < 8) {
+		find_min_max_scalar(samples, count, min_index, max_index);
+		return;
 	}
-	delete[] sample_block;
 
-	p.drawPolyline(points, points_count);
+	// Every lane starts out with the first sample and keeps the first
+	// occurrence of its extremes, so that NaNs are skipped like in the
+	// scalar version. The lanes are merged preferring the lower index on
+	// ties.
+	__m128 vmin = _mm_set1_ps(samples[0]), vmax = vmin;
+	__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i imin = _mm_setzero_si128(), imax = imin;
+	const __m128i step = _mm_set1_epi32(4);
+
+	int64_t i;
+	for (i = 0; i + 4 <= count; i += 4) {
+		const __m128 v = _mm_loadu_ps(samples + i);
+
+		const __m128 lt = _mm_cmplt_ps(v, vmin);
+		const __m128 gt = _mm_cmpgt_ps(v, vmax);
+		vmin = _mm_or_ps(_mm_and_ps(lt, v), _mm_andnot_ps(lt, vmin));
+		vmax = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, vmax));
+		imin = _mm_or_si128(_mm_and_si128(_mm_castps_si128(lt), idx),
+			_mm_andnot_si128(_mm_castps_si128(lt), imin));
+		imax = _mm_or_si128(_mm_and_si128(_mm_castps_si128(gt), idx),
+			_mm_andnot_si128(_mm_castps_si128(gt), imax));
+
+		idx = _mm_add_epi32(idx, step);
+	}
 
-	if (show_sampling_points) {
-		p.setPen(SamplingPointColour);
-		p.drawRects(sampling_points, points_count);
-		delete[] sampling_points;
+	float mins[4], maxs[4];
+	int32_t min_indices[4], max_indices[4];
+	_mm_storeu_ps(mins, vmin);
+	_mm_storeu_ps(maxs, vmax);
+	_mm_storeu_si128((__m128i*)min_indices, imin);
+	_mm_storeu_si128((__m128i*)max_indices, imax);
+
+	float min_value = mins[0], max_value = maxs[0];
+	min_index = min_indices[0], max_index = max_indices[0];
+	for (int j = 1; j < 4; j++) {
+		if (mins[j] < min_value || (mins[j] == min_value &&
+			min_indices[j] < min_index))
+			min_value = mins[j], min_index = min_indices[j];
+		if (maxs[j] > max_value || (maxs[j] == max_value &&
+			max_indices[j] < max_index))
+			max_value = maxs[j], max_index = max_indices[j];
 	}
 
-	delete[] points;
+	for (; i < count; i++) {
+		if (samples[i] < min_value)
+			min_value = samples[i], min_index = i;
+		if (samples[i] > max_value)
+			max_value = samples[i], max_index = i;
+	}
+#else
+	find_min_max_scalar(samples, count, min_index, max_index);
+#endif
+}
+
+void AnalogSignal::find_min_max_scalar(const float *samples, int64_t count,
+	int64_t &min_index, int64_t &max_index)
+{
+	assert(count > 0);
+
+	float min_value = samples[0], max_value = samples[0];
+	min_index = max_index = 0;
+
+	for (int64_t i = 1; i < count; i++) {
+		if (samples[i] < min_value)
+			min_value = samples[i], min_index = i;
+		if (samples[i] > max_value)
+			max_value = samples[i], max_index = i;
+	}
 }
 
-void AnalogSignal::paint_envelope(QPainter &p,
+void AnalogSignal::paint_reduced_trace(QPainter &p, ViewItemPaintParams &pp,
 	const shared_ptr<pv::data::AnalogSegment> &segment,
-	int y, int left, const int64_t start, const int64_t end,
+	const QColor &colour, int y, int left, const int64_t start, const int64_t end,
 	const double pixels_offset, const double samples_per_pixel)
+{
+	if (end <= start)
+		return;
+
+	vector<int64_t> bounds;
+	split_columns(start, end, pixels_offset, samples_per_pixel, bounds);
+
+	// Lines drawn between the reduced samples of a column span the same
+	// range of the column as the lines between all of its samples
+	vector<float> &samples = sample_scratch;
+	vector<QPointF> &points = point_scratch;
+	points.clear();
+
+	size_t column = 0;
+	while (column + 1 < bounds.size()) {
+		// Fetch the samples of as many whole columns as fit into a block
+		size_t block_end = column + 1;
+		while (block_end + 1 < bounds.size() &&
+			bounds[block_end + 1] - bounds[column] <= TracePaintBlockSize)
+			block_end++;
+
+		const int64_t block_start = bounds[column];
+		samples.resize(bounds[block_end] - block_start);
+
+		QElapsedTimer fetch_timer;
+		if (pp.profiling())
+			fetch_timer.start();
+		segment->get_samples(block_start, bounds[block_end], samples.data());
+		if (pp.profiling())
+			pp.add_fetched(samples.size(), fetch_timer.nsecsElapsed());
+
+		for (; column < block_end; column++) {
+			const int64_t first = bounds[column] - block_start;
+			const int64_t count = bounds[column + 1] - bounds[column];
+
+			int64_t indices[4];
+			const int n = reduce_column(samples.data() + first, count,
+				indices);
+
+			for (int i = 0; i < n; i++) {
+				const int64_t sample = bounds[column] + indices[i];
+				const float x = (sample / samples_per_pixel -
+					pixels_offset) + left;
+				points.push_back(QPointF(x,
+					y - samples[first + indices[i]] * scale_));
+			}
+		}
+	}
+
+	p.setPen(colour);
+	p.drawPolyline(points.data(), points.size());
+}
+
+void AnalogSignal::paint_envelope(QPainter &p, ViewItemPaintParams &pp,
+	const shared_ptr<pv::data::AnalogSegment> &segment,
+	const QColor &colour, int y, int left, const int64_t start, const int64_t end,
+	const double pixels_offset, const double samples_per_pixel,
+	float min_length)
 {
 	using pv::data::AnalogSegment;
 
+	QElapsedTimer fetch_timer;
+	if (pp.profiling())
+		fetch_timer.start();
+
 	AnalogSegment::EnvelopeSection e;
-	segment->get_envelope_section(e, start, end, samples_per_pixel);
+	segment->get_envelope_section(e, start, end, min_length);
+
+	if (pp.profiling())
+		pp.add_fetched(e.length, fetch_timer.nsecsElapsed());
 
 	if (e.length < 2)
 		return;
 
 	p.setPen(QPen(Qt::NoPen));
-	p.setBrush(base_->colour());
+	p.setBrush(colour);
+
+	vector<QRectF> &rects = rect_scratch;
+	rects.clear();
 
-	QRectF *const rects = new QRectF[e.length];
-	QRectF *rect = rects;
+	// The envelope samples of a coarser level cover more than a pixel
+	const float width = max(1.0, e.scale / samples_per_pixel);
 
 	for (uint64_t sample = 0; sample < e.length - 1; sample++) {
 		const float x = ((e.scale * sample + e.start) /
@@ -411,26 +621,24 @@ void AnalogSignal::paint_envelope(QPainter &p,
 		if (h <= 0.0f && h >= -1.0f)
 			h = -1.0f;
 
-		*rect++ = QRectF(x, t, 1.0f, h);
+		rects.push_back(QRectF(x, t, width, h));
 	}
 
-	p.drawRects(rects, e.length);
+	// Let the acquisition continue while painting
+	e.lock.unlock();
 
-	delete[] rects;
-	delete[] e.samples;
+	p.drawRects(rects.data(), rects.size());
 }
 
-void AnalogSignal::paint_logic_mid(QPainter &p, ViewItemPaintParams &pp)
+void AnalogSignal::paint_logic_mid(QPainter &p, ViewItemPaintParams &pp,
+	int y, const PaintState &state,
+	const shared_ptr<pv::data::LogicSegment> &segment)
 {
 	QLineF *line;
 
 	vector< pair<int64_t, bool> > edges;
 
-	assert(base_);
-
-	const int y = get_visual_y();
-
-	if (!base_->enabled() || !base_->logic_data())
+	if (!state.enabled || !segment)
 		return;
 
 	const int signal_margin =
@@ -441,15 +649,6 @@ void AnalogSignal::paint_logic_mid(QPainter &p, ViewItemPaintParams &pp)
 	const float high_offset = y - ph + signal_margin + 0.5f;
 	const float low_offset = y + nh - signal_margin - 0.5f;
 
-	const deque< shared_ptr<pv::data::LogicSegment> > &segments =
-		base_->logic_data()->logic_segments();
-
-	if (segments.empty())
-		return;
-
-	const shared_ptr<pv::data::LogicSegment> &segment =
-		segments.front();
-
 	double samplerate = segment->samplerate();
 
 	// Show sample rate as 1Hz when it is unknown
@@ -457,21 +656,29 @@ void AnalogSignal::paint_logic_mid(QPainter &p, ViewItemPaintParams &pp)
 		samplerate = 1.0;
 
 	const double pixels_offset = pp.pixels_offset();
-	const pv::util::Timestamp& start_time = segment->start_time();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
-	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+	const double start = samplerate *
+		(pp.fixed_offset() - segment->fixed_start_time()).to_double();
+	const double end = start + samples_per_pixel * pp.width();
 
-	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
+	const int64_t start_sample = min(max((int64_t)floor(start),
 		(int64_t)0), last_sample);
-	const uint64_t end_sample = min(max(ceil(end).convert_to<int64_t>(),
+	const uint64_t end_sample = min(max((int64_t)ceil(end),
 		(int64_t)0), last_sample);
 
+	QElapsedTimer fetch_timer;
+	if (pp.profiling())
+		fetch_timer.start();
+
 	segment->get_subsampled_edges(edges, start_sample, end_sample,
-		samples_per_pixel / LogicSignal::Oversampling, 0);
+		samples_per_pixel * pp.detail_reduction() / LogicSignal::Oversampling,
+		state.logic_bit_index);
 	assert(edges.size() >= 2);
 
+	if (pp.profiling())
+		pp.add_fetched(edges.size(), fetch_timer.nsecsElapsed());
+
 	// Paint the edges
 	const unsigned int edge_count = edges.size() - 2;
 	QLineF *const edge_lines = new QLineF[edge_count];
@@ -501,11 +708,9 @@ void AnalogSignal::paint_logic_mid(QPainter &p, ViewItemPaintParams &pp)
 	delete[] cap_lines;
 
 	// Return if we don't need to paint the sampling points
-	GlobalSettings settings;
-	const bool show_sampling_points =
-		settings.value(GlobalSettings::Key_View_ShowSamplingPoints).toBool();
-
-	if (!show_sampling_points || (samples_per_pixel >= 0.25))
+	if (!pp.display_settings().show_sampling_points ||
+		(samples_per_pixel >= 0.25) ||
+		(pp.quality() != ViewItemPaintParams::QualityFull))
 		return;
 
 	// Paint the sampling points
@@ -689,6 +894,18 @@ void AnalogSignal::populate_popup_form(QWidget *parent, QFormLayout *form)
 	connect(conversion_cb_, SIGNAL(currentIndexChanged(int)),
 		this, SLOT(on_conversion_changed(int)));
 
+	// Add the conversion packing checkbox
+	QCheckBox* packed_cb = new QCheckBox();
+	packed_cb->setCheckState(base_->conversion_group() ?
+		Qt::Checked : Qt::Unchecked);
+	packed_cb->setToolTip(tr("Pack the converted data into one logic bus "
+		"together with the other packed channels"));
+
+	connect(packed_cb, SIGNAL(stateChanged(int)),
+		this, SLOT(on_conversion_packed_changed(int)));
+
+	layout->addRow(tr("Pack conversion"), packed_cb);
+
 	// Add the display type dropdown
 	display_type_cb_ = new QComboBox();
 
@@ -781,6 +998,15 @@ void AnalogSignal::on_conversion_changed(int index)
 	}
 }
 
+void AnalogSignal::on_conversion_packed_changed(int state)
+{
+	base_->set_conversion_group((state == Qt::Checked) ?
+		session_.conversion_group() : nullptr);
+
+	if (owner_)
+		owner_->row_item_appearance_changed(false, true);
+}
+
 void AnalogSignal::on_display_type_changed(int index)
 {
 	display_type_ = (DisplayType)(display_type_cb_->itemData(index).toInt());
@@ -34,6 +34,7 @@ namespace pv {
 namespace data {
 class Analog;
 class AnalogSegment;
+class LogicSegment;
 class SignalBase;
 }
 
@@ -50,6 +51,7 @@ private:
 	static const QColor SamplingPointColour;
 
 	static const int64_t TracePaintBlockSize;
+	static const float ReductionThreshold;
 	static const float EnvelopeThreshold;
 
 	static const int MaximumVDivs;
@@ -106,8 +108,19 @@ public:
 	 * Paints the mid-layer of the signal with a QPainter
 	 * @param p the QPainter to paint into.
 	 * @param pp the painting parameters object to paint with..
+	 * @param y the zero line of the signal.
+	 * @param state the state to paint with.
+	 * @param segments the segments to paint.
 	 */
-	void paint_mid(QPainter &p, ViewItemPaintParams &pp);
+	void paint_mid_at(QPainter &p, ViewItemPaintParams &pp, int y,
+		const PaintState &state,
+		const vector< shared_ptr<pv::data::Segment> > &segments);
+
+	/**
+	 * Gets the analog segment and the segment of the converted logic
+	 * data that the mid-layer is painted from.
+	 */
+	vector< shared_ptr<pv::data::Segment> > painted_segments() const;
 
 	/**
 	 * Paints the foreground layer of the item with a QPainter
@@ -116,20 +129,84 @@ public:
 	 */
 	void paint_fore(QPainter &p, ViewItemPaintParams &pp);
 
+	/**
+	 * Splits the samples from @c start to @c end into the pixel columns
+	 * they are painted in.
+	 * @param[out] bounds The first sample of every column, followed by
+	 * 	@c end.
+	 */
+	static void split_columns(int64_t start, int64_t end,
+		double pixels_offset, double samples_per_pixel,
+		vector<int64_t> &bounds);
+
+	/**
+	 * Reduces the samples of a pixel column to its first, smallest,
+	 * largest and last sample in the order they occur.
+	 * @param count The number of samples, at least one.
+	 * @param[out] indices The indices of the kept samples, ascending and
+	 * 	without duplicates.
+	 * @return The number of kept samples, from 1 to 4.
+	 */
+	static int reduce_column(const float *samples, int64_t count,
+		int64_t indices[4]);
+
+	/**
+	 * Finds the first occurrences of the smallest and the largest sample,
+	 * using SSE2 where available. NaNs are skipped unless the first
+	 * sample is one.
+	 * @param count The number of samples, at least one.
+	 */
+	static void find_min_max(const float *samples, int64_t count,
+		int64_t &min_index, int64_t &max_index);
+
+	/**
+	 * The scalar version of find_min_max(), the reference the vectorized
+	 * version must match.
+	 */
+	static void find_min_max_scalar(const float *samples, int64_t count,
+		int64_t &min_index, int64_t &max_index);
+
 private:
-	void paint_grid(QPainter &p, int y, int left, int right);
+	void paint_grid(QPainter &p, const ViewItemPaintParams &pp, int y);
 
-	void paint_trace(QPainter &p,
+	/**
+	 * Paints the samples as a polyline.
+	 * @param sampling_points whether the sampling points may be painted
+	 * 	if they are enabled in the display settings of @c pp.
+	 */
+	void paint_trace(QPainter &p, ViewItemPaintParams &pp,
 		const shared_ptr<pv::data::AnalogSegment> &segment,
-		int y, int left, const int64_t start, const int64_t end,
-		const double pixels_offset, const double samples_per_pixel);
+		const QColor &colour, int y, int left, const int64_t start, const int64_t end,
+		const double pixels_offset, const double samples_per_pixel,
+		bool sampling_points);
 
-	void paint_envelope(QPainter &p,
+	/**
+	 * Paints the samples like paint_trace(), but reduces the samples of
+	 * each pixel column to at most four points first, see
+	 * reduce_column(). The vertical extent painted in every column is the
+	 * same as with paint_trace(). The result isn't pixel-identical though:
+	 * antialiasing shades the partially covered pixels inside a column
+	 * from fewer line segments.
+	 */
+	void paint_reduced_trace(QPainter &p, ViewItemPaintParams &pp,
 		const shared_ptr<pv::data::AnalogSegment> &segment,
-		int y, int left, const int64_t start, const int64_t end,
+		const QColor &colour, int y, int left, const int64_t start, const int64_t end,
 		const double pixels_offset, const double samples_per_pixel);
 
-	void paint_logic_mid(QPainter &p, ViewItemPaintParams &pp);
+	/**
+	 * Paints the envelope of the samples.
+	 * @param min_length the minimum number of samples that an envelope
+	 * 	sample must cover, selects the envelope level.
+	 */
+	void paint_envelope(QPainter &p, ViewItemPaintParams &pp,
+		const shared_ptr<pv::data::AnalogSegment> &segment,
+		const QColor &colour, int y, int left, const int64_t start, const int64_t end,
+		const double pixels_offset, const double samples_per_pixel,
+		float min_length);
+
+	void paint_logic_mid(QPainter &p, ViewItemPaintParams &pp, int y,
+		const PaintState &state,
+		const shared_ptr<pv::data::LogicSegment> &segment);
 
 	void paint_logic_caps(QPainter &p, QLineF *const lines,
 		vector< pair<int64_t, bool> > &edges,
@@ -162,6 +239,8 @@ private Q_SLOTS:
 
 	void on_conversion_changed(int index);
 
+	void on_conversion_packed_changed(int state);
+
 	void on_display_type_changed(int index);
 
 private:
@@ -32,6 +32,7 @@ extern "C" {
 #include <QAction>
 #include <QApplication>
 #include <QComboBox>
+#include <QElapsedTimer>
 #include <QFormLayout>
 #include <QLabel>
 #include <QMenu>
@@ -197,6 +198,10 @@ void DecodeTrace::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 
 	// Set default pen to allow for text width calculation
 	p.setPen(Qt::black);
+	text_cache_.set_font(p.font());
+
+	const uint64_t text_hits = text_cache_.hits();
+	const uint64_t text_misses = text_cache_.misses();
 
 	// Iterate through the rows
 	int y = get_visual_y();
@@ -225,9 +230,17 @@ void DecodeTrace::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 		boost::hash_combine(base_colour, row.row());
 		base_colour >>= 16;
 
+		QElapsedTimer fetch_timer;
+		if (pp.profiling())
+			fetch_timer.start();
+
 		vector<Annotation> annotations;
 		decoder_stack->get_annotation_subset(annotations, row,
 			sample_range.first, sample_range.second);
+
+		if (pp.profiling())
+			pp.add_fetched(annotations.size(), fetch_timer.nsecsElapsed());
+
 		if (!annotations.empty()) {
 			draw_annotations(annotations, p, annotation_height, pp, y,
 				base_colour, row_title_width);
@@ -241,6 +254,9 @@ void DecodeTrace::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 	// Draw the hatching
 	draw_unresolved_period(p, annotation_height, pp.left(), pp.right());
 
+	pp.add_cache_lookups(text_cache_.hits() - text_hits,
+		text_cache_.misses() - text_misses);
+
 	if ((int)visible_rows_.size() > max_visible_rows_)
 		owner_->extents_changed(false, true);
 
@@ -387,7 +403,7 @@ void DecodeTrace::draw_annotations(vector<pv::data::decode::Annotation> annotati
 		// Annotation wider than the threshold for a useful label width?
 		if (a_width >= min_useful_label_width_) {
 			for (const QString &ann_text : a.annotations()) {
-				const int w = p.boundingRect(QRectF(), 0, ann_text).width();
+				const int w = text_cache_.width(ann_text);
 				// Annotation wide enough to fit a label? Don't put it in a block then
 				if (w <= a_width) {
 					a_is_separate = true;
@@ -430,7 +446,7 @@ void DecodeTrace::draw_annotations(vector<pv::data::decode::Annotation> annotati
 
 void DecodeTrace::draw_annotation(const pv::data::decode::Annotation &a,
 	QPainter &p, int h, const ViewItemPaintParams &pp, int y,
-	size_t base_colour, int row_title_width) const
+	size_t base_colour, int row_title_width)
 {
 	double samples_per_pixel, pixels_offset;
 	tie(pixels_offset, samples_per_pixel) =
@@ -498,27 +514,26 @@ void DecodeTrace::draw_annotation_block(
 }
 
 void DecodeTrace::draw_instant(const pv::data::decode::Annotation &a, QPainter &p,
-	int h, double x, int y) const
+	int h, double x, int y)
 {
 	const QString text = a.annotations().empty() ?
 		QString() : a.annotations().back();
-	const double w = min((double)p.boundingRect(QRectF(), 0, text).width(),
-		0.0) + h;
+	const double w = min((double)text_cache_.width(text), 0.0) + h;
 	const QRectF rect(x - w / 2, y - h / 2, w, h);
 
 	p.drawRoundedRect(rect, h / 2, h / 2);
 
 	p.setPen(Qt::black);
-	p.drawText(rect, Qt::AlignCenter | Qt::AlignVCenter, text);
+	draw_centered_text(p, rect.center(), text);
 }
 
 void DecodeTrace::draw_range(const pv::data::decode::Annotation &a, QPainter &p,
 	int h, double start, double end, int y, const ViewItemPaintParams &pp,
-	int row_title_width) const
+	int row_title_width)
 {
 	const double top = y + .5 - h / 2;
 	const double bottom = y + .5 + h / 2;
-	const vector<QString> annotations = a.annotations();
+	const vector<QString> &annotations = a.annotations();
 
 	// If the two ends are within 1 pixel, draw a vertical line
 	if (start + 1.0 > end) {
@@ -560,17 +575,28 @@ void DecodeTrace::draw_range(const pv::data::decode::Annotation &a, QPainter &p,
 	int best_width = 0;
 
 	for (const QString &a : annotations) {
-		const int w = p.boundingRect(QRectF(), 0, a).width();
+		const int w = text_cache_.width(a);
 		if (w <= rect.width() && w > best_width)
 			best_annotation = a, best_width = w;
 	}
 
-	if (best_annotation.isEmpty())
-		best_annotation = annotations.back();
+	if (!best_annotation.isEmpty()) {
+		draw_centered_text(p, rect.center(), best_annotation);
+		return;
+	}
 
 	// If not ellide the last in the list
 	p.drawText(rect, Qt::AlignCenter, p.fontMetrics().elidedText(
-		best_annotation, Qt::ElideRight, rect.width()));
+		annotations.back(), Qt::ElideRight, rect.width()));
+}
+
+void DecodeTrace::draw_centered_text(QPainter &p, const QPointF &centre,
+	const QString &text)
+{
+	const QStaticText &static_text = text_cache_.static_text(text);
+	const QSizeF size = static_text.size();
+	p.drawStaticText(centre - QPointF(size.width(), size.height()) / 2,
+		static_text);
 }
 
 void DecodeTrace::draw_error(QPainter &p, const QString &message,
@@ -33,6 +33,8 @@
 #include <pv/data/decode/row.hpp>
 #include <pv/data/signalbase.hpp>
 
+#include "textcache.hpp"
+
 using std::list;
 using std::map;
 using std::pair;
@@ -141,17 +143,24 @@ private:
 
 	void draw_annotation(const pv::data::decode::Annotation &a, QPainter &p,
 		int h, const ViewItemPaintParams &pp, int y,
-		size_t base_colour, int row_title_width) const;
+		size_t base_colour, int row_title_width);
 
 	void draw_annotation_block(vector<pv::data::decode::Annotation> annotations,
 		QPainter &p, int h, int y, size_t base_colour) const;
 
 	void draw_instant(const pv::data::decode::Annotation &a, QPainter &p,
-		int h, double x, int y) const;
+		int h, double x, int y);
 
 	void draw_range(const pv::data::decode::Annotation &a, QPainter &p,
 		int h, double start, double end, int y, const ViewItemPaintParams &pp,
-		int row_title_width) const;
+		int row_title_width);
+
+	/**
+	 * Draws text centered on a point, using the laid out text from the
+	 * text cache.
+	 */
+	void draw_centered_text(QPainter &p, const QPointF &centre,
+		const QString &text);
 
 	void draw_error(QPainter &p, const QString &message,
 		const ViewItemPaintParams &pp);
@@ -214,6 +223,7 @@ private:
 	vector<pv::widgets::DecoderGroupBox*> decoder_forms_;
 
 	map<data::decode::Row, int> row_title_widths_;
+	TextCache text_cache_;
 	int row_height_, max_visible_rows_;
 
 	int min_useful_label_width_;
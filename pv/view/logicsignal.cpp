@@ -25,6 +25,7 @@
 #include <algorithm>
 
 #include <QApplication>
+#include <QElapsedTimer>
 #include <QFormLayout>
 #include <QToolBar>
 
@@ -36,13 +37,11 @@
 #include <pv/data/signalbase.hpp>
 #include <pv/devicemanager.hpp>
 #include <pv/devices/device.hpp>
-#include <pv/globalsettings.hpp>
 #include <pv/session.hpp>
 #include <pv/view/view.hpp>
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
-using std::deque;
 using std::max;
 using std::make_pair;
 using std::min;
@@ -154,30 +153,25 @@ void LogicSignal::scale_handle_dragged(int offset)
 	signal_height_ = ((units < 1) ? 1 : units) * font_height;
 }
 
-void LogicSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
+void LogicSignal::paint_mid_at(QPainter &p, ViewItemPaintParams &pp, int y,
+	const PaintState &state,
+	const vector< shared_ptr<pv::data::Segment> > &segments)
 {
 	QLineF *line;
 
 	vector< pair<int64_t, bool> > edges;
 
-	assert(base_);
-	assert(owner_);
-
-	const int y = get_visual_y();
-
-	if (!base_->enabled())
+	if (!state.enabled)
 		return;
 
-	const float high_offset = y - signal_height_ + 0.5f;
+	const float high_offset = y - state.height + 0.5f;
 	const float low_offset = y + 0.5f;
 
-	const deque< shared_ptr<pv::data::LogicSegment> > &segments =
-		base_->logic_data()->logic_segments();
-	if (segments.empty())
+	const shared_ptr<pv::data::LogicSegment> segment =
+		find_segment<pv::data::LogicSegment>(segments);
+	if (!segment)
 		return;
 
-	const shared_ptr<pv::data::LogicSegment> &segment = segments.front();
-
 	double samplerate = segment->samplerate();
 
 	// Show sample rate as 1Hz when it is unknown
@@ -185,21 +179,29 @@ void LogicSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 		samplerate = 1.0;
 
 	const double pixels_offset = pp.pixels_offset();
-	const pv::util::Timestamp& start_time = segment->start_time();
 	const int64_t last_sample = segment->get_sample_count() - 1;
 	const double samples_per_pixel = samplerate * pp.scale();
-	const pv::util::Timestamp start = samplerate * (pp.offset() - start_time);
-	const pv::util::Timestamp end = start + samples_per_pixel * pp.width();
+	const double start = samplerate *
+		(pp.fixed_offset() - segment->fixed_start_time()).to_double();
+	const double end = start + samples_per_pixel * pp.width();
 
-	const int64_t start_sample = min(max(floor(start).convert_to<int64_t>(),
+	const int64_t start_sample = min(max((int64_t)floor(start),
 		(int64_t)0), last_sample);
-	const uint64_t end_sample = min(max(ceil(end).convert_to<int64_t>(),
+	const uint64_t end_sample = min(max((int64_t)ceil(end),
 		(int64_t)0), last_sample);
 
+	QElapsedTimer fetch_timer;
+	if (pp.profiling())
+		fetch_timer.start();
+
 	segment->get_subsampled_edges(edges, start_sample, end_sample,
-		samples_per_pixel / Oversampling, base_->index());
+		samples_per_pixel * pp.detail_reduction() / Oversampling,
+		state.logic_bit_index);
 	assert(edges.size() >= 2);
 
+	if (pp.profiling())
+		pp.add_fetched(edges.size(), fetch_timer.nsecsElapsed());
+
 	// Paint the edges
 	const unsigned int edge_count = edges.size() - 2;
 	QLineF *const edge_lines = new QLineF[edge_count];
@@ -229,11 +231,9 @@ void LogicSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 	delete[] cap_lines;
 
 	// Return if we don't need to paint the sampling points
-	GlobalSettings settings;
-	const bool show_sampling_points =
-		settings.value(GlobalSettings::Key_View_ShowSamplingPoints).toBool();
-
-	if (!show_sampling_points || (samples_per_pixel >= 0.25))
+	if (!pp.display_settings().show_sampling_points ||
+		(samples_per_pixel >= 0.25) ||
+		(pp.quality() != ViewItemPaintParams::QualityFull))
 		return;
 
 	// Paint the sampling points
@@ -253,6 +253,13 @@ void LogicSignal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
 	delete[] sampling_points;
 }
 
+Signal::PaintState LogicSignal::paint_state() const
+{
+	PaintState state = Signal::paint_state();
+	state.height = signal_height_;
+	return state;
+}
+
 void LogicSignal::paint_fore(QPainter &p, ViewItemPaintParams &pp)
 {
 	// Draw the trigger marker
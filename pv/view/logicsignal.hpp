@@ -99,8 +99,15 @@ public:
 	 * Paints the mid-layer of the signal with a QPainter
 	 * @param p the QPainter to paint into.
 	 * @param pp the painting parameters object to paint with..
+	 * @param y the zero line of the signal.
+	 * @param state the state to paint with.
+	 * @param segments the segments to paint.
 	 */
-	void paint_mid(QPainter &p, ViewItemPaintParams &pp);
+	void paint_mid_at(QPainter &p, ViewItemPaintParams &pp, int y,
+		const PaintState &state,
+		const vector< shared_ptr<pv::data::Segment> > &segments);
+
+	PaintState paint_state() const;
 
 	/**
 	 * Paints the foreground layer of the signal with a QPainter
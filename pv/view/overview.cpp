@@ -0,0 +1,314 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <QMouseEvent>
+#include <QPainter>
+
+#include "logicsignal.hpp"
+#include "overview.hpp"
+#include "view.hpp"
+
+#include <pv/globalsettings.hpp>
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/notificationscheduler.hpp>
+#include <pv/data/signalbase.hpp>
+#include <pv/data/signaldata.hpp>
+
+using std::dynamic_pointer_cast;
+using std::floor;
+using std::max;
+using std::min;
+using std::move;
+using std::pair;
+using std::sort;
+
+using pv::data::AnalogSegment;
+using pv::data::LogicSegment;
+using pv::data::Segment;
+using pv::util::Timestamp;
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+const int Overview::StripHeight = 24;
+const uint64_t Overview::MaxSummaryLength = 4096;
+
+Overview::Overview(View &parent) :
+	QWidget(&parent),
+	view_(parent)
+{
+	setAttribute(Qt::WA_OpaquePaintEvent, true);
+	setCursor(Qt::PointingHandCursor);
+
+	connect(&view_, SIGNAL(offset_changed()), this, SLOT(update()));
+	connect(&view_, SIGNAL(scale_changed()), this, SLOT(update()));
+
+	connect(&summary_updater_, SIGNAL(timeout()),
+		this, SLOT(on_summary_update_timeout()));
+	summary_updater_.setSingleShot(true);
+}
+
+QSize Overview::sizeHint() const
+{
+	return QSize(0, StripHeight);
+}
+
+void Overview::update_summaries()
+{
+	map<const Segment*, Summary> summaries;
+
+	for (const shared_ptr<Signal> &signal : view_.signals()) {
+		const shared_ptr<Segment> segment = shown_segment(signal);
+		if (!segment || summaries.count(segment.get()))
+			continue;
+
+		const shared_ptr<LogicSegment> logic =
+			dynamic_pointer_cast<LogicSegment>(segment);
+		const shared_ptr<AnalogSegment> analog =
+			dynamic_pointer_cast<AnalogSegment>(segment);
+		if (!logic && !analog)
+			continue;
+
+		// Pick up the summary of the last update unless its segment is
+		// gone and another one took its place
+		Summary s;
+		const auto iter = summaries_.find(segment.get());
+		if (iter != summaries_.end() && iter->second.segment.lock() == segment)
+			s = move(iter->second);
+		else {
+			s.segment = segment;
+			s.level = 0;
+			s.min_value = s.max_value = 0;
+		}
+
+		uint64_t (*const level_scale)(unsigned int) = logic ?
+			LogicSegment::mipmap_scale : AnalogSegment::envelope_scale;
+		const unsigned int level_count = logic ?
+			LogicSegment::mipmap_level_count() :
+			AnalogSegment::envelope_level_count();
+
+		// Use the finest level that is short enough. As the segment only
+		// grows, the level only ever gets coarser
+		const uint64_t sample_count = segment->get_sample_count();
+		unsigned int level = s.level;
+		while (level + 1 < level_count &&
+			sample_count / level_scale(level) > MaxSummaryLength)
+			level++;
+
+		if (level != s.level) {
+			s.level = level;
+			s.logic.clear();
+			s.analog.clear();
+		}
+
+		s.scale = level_scale(level);
+		s.start_time = segment->start_time().convert_to<double>();
+		s.samplerate = segment->samplerate();
+		s.samplerate = (s.samplerate <= 0.0) ? 1.0 : s.samplerate;
+
+		if (logic)
+			logic->get_mipmap_samples(level, s.logic.size(), s.logic);
+		else {
+			const pair<float, float> min_max = analog->get_min_max();
+			s.min_value = min_max.first;
+			s.max_value = min_max.second;
+			analog->get_envelope_samples(level, s.analog.size(), s.analog);
+		}
+
+		summaries[segment.get()] = move(s);
+	}
+
+	summaries_.swap(summaries);
+}
+
+void Overview::schedule_summary_update()
+{
+	if (summary_updater_.isActive())
+		return;
+
+	GlobalSettings settings;
+	const int rate = settings.value(GlobalSettings::Key_Data_NotificationRate,
+		pv::data::NotificationScheduler::DefaultRate).toInt();
+	summary_updater_.start(1000 / max(rate,
+		pv::data::NotificationScheduler::MinRate));
+}
+
+shared_ptr<Segment> Overview::shown_segment(const shared_ptr<Signal> &signal)
+{
+	const shared_ptr<pv::data::SignalData> data = signal->data();
+	if (!data)
+		return nullptr;
+
+	const vector< shared_ptr<Segment> > segments = data->segments();
+	return segments.empty() ? nullptr : segments.front();
+}
+
+void Overview::paint_logic(QPainter &p, const QRectF &band, const Summary &s,
+	unsigned int bit, const QColor &colour, double t0, double tpp) const
+{
+	const uint64_t mask = (uint64_t)1 << bit;
+	const int64_t length = s.logic.size();
+	const double samples_per_pixel = tpp * s.samplerate / s.scale;
+	const double first = (t0 - s.start_time) * s.samplerate / s.scale;
+
+	for (int x = 0; x < width(); x++) {
+		const int64_t start = max<int64_t>(
+			floor(first + x * samples_per_pixel), 0);
+		const int64_t end = min(max<int64_t>(
+			floor(first + (x + 1) * samples_per_pixel), start + 1), length);
+		if (start >= end)
+			continue;
+
+		int64_t changes = 0;
+		for (int64_t i = start; i < end; i++)
+			if (s.logic[i] & mask)
+				changes++;
+		if (changes == 0)
+			continue;
+
+		// The more of the column the channel is active in, the more
+		// opaque it is drawn
+		QColor c(colour);
+		c.setAlphaF(0.25 + 0.75 * changes / (end - start));
+		p.fillRect(QRectF(x, band.top(), 1, band.height()), c);
+	}
+}
+
+void Overview::paint_analog(QPainter &p, const QRectF &band, const Summary &s,
+	const QColor &colour, double t0, double tpp) const
+{
+	const int64_t length = s.analog.size();
+	const double samples_per_pixel = tpp * s.samplerate / s.scale;
+	const double first = (t0 - s.start_time) * s.samplerate / s.scale;
+	const float range = (s.max_value > s.min_value) ?
+		(s.max_value - s.min_value) : 1.0f;
+	const double y_scale = band.height() / range;
+
+	for (int x = 0; x < width(); x++) {
+		const int64_t start = max<int64_t>(
+			floor(first + x * samples_per_pixel), 0);
+		const int64_t end = min(max<int64_t>(
+			floor(first + (x + 1) * samples_per_pixel), start + 1), length);
+		if (start >= end)
+			continue;
+
+		float min_value = s.analog[start].min;
+		float max_value = s.analog[start].max;
+		for (int64_t i = start + 1; i < end; i++) {
+			min_value = min(min_value, s.analog[i].min);
+			max_value = max(max_value, s.analog[i].max);
+		}
+
+		const double top = band.bottom() -
+			(max_value - s.min_value) * y_scale;
+		const double bottom = band.bottom() -
+			(min_value - s.min_value) * y_scale;
+		p.fillRect(QRectF(x, top, 1, max(bottom - top, 1.0)), colour);
+	}
+}
+
+void Overview::navigate_to(int x)
+{
+	const pair<Timestamp, Timestamp> extents = view_.get_time_extents();
+	if (extents.second <= extents.first || width() <= 0)
+		return;
+
+	// The strip is as wide as the viewport
+	const Timestamp t = extents.first +
+		(extents.second - extents.first) * x / width();
+	view_.set_scale_offset(view_.scale(), t - view_.scale() * width() / 2);
+}
+
+void Overview::paintEvent(QPaintEvent*)
+{
+	QPainter p(this);
+	p.fillRect(rect(), palette().color(QPalette::Base));
+
+	const pair<Timestamp, Timestamp> extents = view_.get_time_extents();
+	if (extents.second <= extents.first || width() <= 0)
+		return;
+
+	const double t0 = extents.first.convert_to<double>();
+	const double tpp = (extents.second - extents.first).convert_to<double>() /
+		width();
+
+	// Stack the bands in the order of the traces
+	vector< shared_ptr<Signal> > signals;
+	for (const shared_ptr<Signal> &signal : view_.signals())
+		if (signal->enabled() &&
+			summaries_.count(shown_segment(signal).get()))
+			signals.push_back(signal);
+
+	sort(signals.begin(), signals.end(),
+		[](const shared_ptr<Signal> &a, const shared_ptr<Signal> &b) {
+			return a->get_visual_y() < b->get_visual_y(); });
+
+	const double band_height = (double)height() /
+		max<size_t>(signals.size(), 1);
+
+	for (size_t i = 0; i < signals.size(); i++) {
+		const shared_ptr<Signal> &signal = signals[i];
+		const Summary &s = summaries_.at(shown_segment(signal).get());
+		const QRectF band(0, i * band_height, width(), band_height);
+		const QColor colour = signal->base()->colour();
+
+		if (dynamic_pointer_cast<LogicSignal>(signal))
+			paint_logic(p, band, s, signal->base()->logic_bit_index(),
+				colour, t0, tpp);
+		else
+			paint_analog(p, band, s, colour, t0, tpp);
+	}
+
+	// Mark the part of the capture that the view shows
+	const QColor highlight = palette().color(QPalette::Highlight);
+	QColor fill(highlight);
+	fill.setAlpha(48);
+
+	const double x = (view_.offset().convert_to<double>() - t0) / tpp;
+	const double w = view_.scale() * width() / tpp;
+
+	p.setPen(highlight);
+	p.setBrush(fill);
+	p.drawRect(QRectF(x, 0, max(w, 1.0), height() - 1));
+}
+
+void Overview::mousePressEvent(QMouseEvent *event)
+{
+	if (event->button() == Qt::LeftButton)
+		navigate_to(event->x());
+}
+
+void Overview::mouseMoveEvent(QMouseEvent *event)
+{
+	if (event->buttons() & Qt::LeftButton)
+		navigate_to(event->x());
+}
+
+void Overview::on_summary_update_timeout()
+{
+	update_summaries();
+	update();
+}
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_VIEWS_TRACEVIEW_OVERVIEW_HPP
+#define PULSEVIEW_PV_VIEWS_TRACEVIEW_OVERVIEW_HPP
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <QTimer>
+#include <QWidget>
+
+#include <pv/data/analogsegment.hpp>
+
+using std::map;
+using std::shared_ptr;
+using std::vector;
+using std::weak_ptr;
+
+class QPainter;
+
+namespace pv {
+
+namespace data {
+class Segment;
+}
+
+namespace views {
+namespace TraceView {
+
+class Signal;
+class View;
+
+/**
+ * A strip above the ruler that shows the activity of all traces over the
+ * whole capture and the part of it that the view shows. Clicking or
+ * dragging on it moves the view.
+ *
+ * The strip is drawn from summaries of the coarsest mip-map and envelope
+ * levels that still have enough samples, which are only extended by the
+ * newly completed samples while capturing.
+ */
+class Overview : public QWidget
+{
+	Q_OBJECT
+
+private:
+	/// Height of the strip in pixels
+	static const int StripHeight;
+
+	/// The largest number of samples a summary is made of
+	static const uint64_t MaxSummaryLength;
+
+	struct Summary
+	{
+		weak_ptr<pv::data::Segment> segment;
+		unsigned int level;
+		double scale;
+		double start_time;
+		double samplerate;
+		float min_value, max_value;
+		vector<uint64_t> logic;
+		vector<pv::data::AnalogSegment::EnvelopeSample> analog;
+	};
+
+public:
+	Overview(View &parent);
+
+public:
+	QSize sizeHint() const override;
+
+	/**
+	 * Extends the summaries by the samples that were added to the
+	 * segments since the last update and drops those of segments that
+	 * are no longer shown.
+	 */
+	void update_summaries();
+
+	/**
+	 * Updates the summaries and repaints the strip after one interval of
+	 * the notification rate, so that new data doesn't rebuild them more
+	 * often than it is delivered.
+	 */
+	void schedule_summary_update();
+
+private:
+	/**
+	 * Returns the segment of a signal that the overview shows.
+	 */
+	static shared_ptr<pv::data::Segment> shown_segment(
+		const shared_ptr<Signal> &signal);
+
+	void paint_logic(QPainter &p, const QRectF &band, const Summary &s,
+		unsigned int bit, const QColor &colour, double t0,
+		double tpp) const;
+
+	void paint_analog(QPainter &p, const QRectF &band, const Summary &s,
+		const QColor &colour, double t0, double tpp) const;
+
+	/**
+	 * Moves the view so that its centre shows the time at @c x.
+	 */
+	void navigate_to(int x);
+
+private:
+	void paintEvent(QPaintEvent *event) override;
+
+	void mousePressEvent(QMouseEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+
+private Q_SLOTS:
+	void on_summary_update_timeout();
+
+private:
+	View &view_;
+
+	map<const pv::data::Segment*, Summary> summaries_;
+	QTimer summary_updater_;
+};
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEWS_TRACEVIEW_OVERVIEW_HPP
@@ -0,0 +1,296 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QStringList>
+
+#include "renderprofile.hpp"
+#include "signal.hpp"
+#include "timemarker.hpp"
+#include "trace.hpp"
+
+using std::max;
+using std::min;
+using std::sort;
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+const char *const RenderProfile::LogVariable = "PULSEVIEW_RENDER_PROFILE";
+const unsigned int RenderProfile::OverlayItemCount = 12;
+
+/**
+ * Formats a hit rate in percent, or a dash if there were no lookups.
+ */
+static QString hit_rate(uint64_t hits, uint64_t misses)
+{
+	if (hits + misses == 0)
+		return QString("-");
+	return QString("%1%").arg(100.0 * hits / (hits + misses), 0, 'f', 1);
+}
+
+RenderProfile::RenderProfile() :
+	overlay_shown_(false),
+	frame_(0),
+	item_start_{0, 0, 0, 0},
+	layout_time_(0),
+	paint_time_(0),
+	tile_hits_(0),
+	tile_misses_(0)
+{
+	const QByteArray path = qgetenv(LogVariable);
+	if (path.isEmpty())
+		return;
+
+	if (path == "-")
+		log_.open(stderr, QIODevice::WriteOnly);
+	else {
+		log_.setFileName(QString::fromLocal8Bit(path));
+		log_.open(QIODevice::WriteOnly | QIODevice::Append);
+	}
+
+	if (!log_.isOpen())
+		qWarning("Failed to open the render profile log %s",
+			path.constData());
+}
+
+bool RenderProfile::enabled() const
+{
+	return overlay_shown_ || log_.isOpen();
+}
+
+bool RenderProfile::overlay_shown() const
+{
+	return overlay_shown_;
+}
+
+void RenderProfile::set_overlay_shown(bool shown)
+{
+	overlay_shown_ = shown;
+}
+
+void RenderProfile::begin_frame()
+{
+	frame_++;
+	items_.clear();
+	layout_time_ = paint_time_ = 0;
+	tile_hits_ = tile_misses_ = 0;
+
+	frame_timer_.start();
+}
+
+void RenderProfile::end_layout()
+{
+	layout_time_ = frame_timer_.nsecsElapsed() / 1e6;
+}
+
+void RenderProfile::begin_item(const ViewItemPaintParams &pp)
+{
+	item_start_ = pp.statistics();
+	item_timer_.start();
+}
+
+void RenderProfile::end_item(const ViewItem &item, Layer layer,
+	const ViewItemPaintParams &pp)
+{
+	const double time = item_timer_.nsecsElapsed() / 1e6;
+	const ViewItemPaintParams::Statistics &s = pp.statistics();
+
+	Item &i = items_[&item];
+	if (i.name.isNull())
+		i.name = item_name(item);
+
+	i.layer_time[layer] += time;
+	i.paint.fetched += s.fetched - item_start_.fetched;
+	i.paint.fetch_time += s.fetch_time - item_start_.fetch_time;
+	i.paint.cache_hits += s.cache_hits - item_start_.cache_hits;
+	i.paint.cache_misses += s.cache_misses - item_start_.cache_misses;
+}
+
+void RenderProfile::add_tiles(unsigned int hits, unsigned int misses,
+	const map<const Signal*, TileCache::RenderStatistics> &rendered)
+{
+	tile_hits_ += hits;
+	tile_misses_ += misses;
+
+	// Tiles of signals that are no longer painted are left out, as the
+	// signals may be gone
+	for (const auto &r : rendered) {
+		const auto iter = items_.find(r.first);
+		if (iter == items_.end())
+			continue;
+
+		TileCache::RenderStatistics &s = iter->second.render;
+		s.tiles += r.second.tiles;
+		s.render_time += r.second.render_time;
+		s.paint.fetched += r.second.paint.fetched;
+		s.paint.fetch_time += r.second.paint.fetch_time;
+		s.paint.cache_hits += r.second.paint.cache_hits;
+		s.paint.cache_misses += r.second.paint.cache_misses;
+	}
+}
+
+void RenderProfile::end_frame(QPainter &p, const QRect &rect)
+{
+	paint_time_ = frame_timer_.nsecsElapsed() / 1e6;
+
+	vector<const Item*> items;
+	items.reserve(items_.size());
+	for (const auto &i : items_)
+		items.push_back(&i.second);
+
+	sort(items.begin(), items.end(), [](const Item *a, const Item *b) {
+		return item_cost(*a) > item_cost(*b); });
+
+	if (log_.isOpen())
+		log_frame(items);
+
+	if (overlay_shown_)
+		paint_overlay(p, rect, items);
+}
+
+QString RenderProfile::item_name(const ViewItem &item)
+{
+	const Trace *const trace = dynamic_cast<const Trace*>(&item);
+	if (trace)
+		return trace->name();
+
+	const TimeMarker *const marker = dynamic_cast<const TimeMarker*>(&item);
+	if (marker)
+		return marker->get_text();
+
+	return QString("(item)");
+}
+
+double RenderProfile::item_cost(const Item &item)
+{
+	double cost = item.render.render_time;
+	for (int layer = 0; layer < LayerCount; layer++)
+		cost += item.layer_time[layer];
+	return cost;
+}
+
+void RenderProfile::log_frame(const vector<const Item*> &items)
+{
+	QJsonArray items_json;
+	for (const Item *i : items) {
+		QJsonObject item;
+		item["name"] = i->name;
+		item["back_ms"] = i->layer_time[LayerBack];
+		item["mid_ms"] = i->layer_time[LayerMid];
+		item["fore_ms"] = i->layer_time[LayerFore];
+		item["render_ms"] = i->render.render_time;
+		item["tiles_rendered"] = (double)i->render.tiles;
+		item["fetched"] = (double)(i->paint.fetched +
+			i->render.paint.fetched);
+		item["fetch_ms"] = (i->paint.fetch_time +
+			i->render.paint.fetch_time) / 1e6;
+		item["cache_hits"] = (double)(i->paint.cache_hits +
+			i->render.paint.cache_hits);
+		item["cache_misses"] = (double)(i->paint.cache_misses +
+			i->render.paint.cache_misses);
+		items_json.append(item);
+	}
+
+	QJsonObject frame;
+	frame["frame"] = (double)frame_;
+	frame["paint_ms"] = paint_time_;
+	frame["layout_ms"] = layout_time_;
+	frame["tile_hits"] = (double)tile_hits_;
+	frame["tile_misses"] = (double)tile_misses_;
+	frame["items"] = items_json;
+
+	log_.write(QJsonDocument(frame).toJson(QJsonDocument::Compact));
+	log_.write("\n");
+	log_.flush();
+}
+
+void RenderProfile::paint_overlay(QPainter &p, const QRect &rect,
+	const vector<const Item*> &items) const
+{
+	const int Margin = 4;
+
+	uint64_t cache_hits = 0, cache_misses = 0;
+	for (const Item *i : items) {
+		cache_hits += i->paint.cache_hits + i->render.paint.cache_hits;
+		cache_misses += i->paint.cache_misses + i->render.paint.cache_misses;
+	}
+
+	QStringList lines;
+	lines << QString("Frame %1: %2 ms, layout %3 ms")
+		.arg((qulonglong)frame_)
+		.arg(paint_time_, 0, 'f', 2)
+		.arg(layout_time_, 0, 'f', 2);
+	lines << QString("Tiles: %1 hits, text: %2 hits")
+		.arg(hit_rate(tile_hits_, tile_misses_))
+		.arg(hit_rate(cache_hits, cache_misses));
+	lines << QString("%1 %2 %3 %4 %5 %6 %7")
+		.arg("Item", -12).arg("back", 7).arg("mid", 7).arg("fore", 7)
+		.arg("render", 7).arg("fetch", 7).arg("fetched", 9);
+
+	const size_t count = min<size_t>(items.size(), OverlayItemCount);
+	for (size_t n = 0; n < count; n++) {
+		const Item *const i = items[n];
+		lines << QString("%1 %2 %3 %4 %5 %6 %7")
+			.arg(i->name.left(12), -12)
+			.arg(i->layer_time[LayerBack], 7, 'f', 2)
+			.arg(i->layer_time[LayerMid], 7, 'f', 2)
+			.arg(i->layer_time[LayerFore], 7, 'f', 2)
+			.arg(i->render.render_time, 7, 'f', 2)
+			.arg((i->paint.fetch_time + i->render.paint.fetch_time) / 1e6,
+				7, 'f', 2)
+			.arg((qulonglong)(i->paint.fetched + i->render.paint.fetched),
+				9);
+	}
+
+	p.save();
+
+	const QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+	const QFontMetrics metrics(font);
+
+	int width = 0;
+	for (const QString &line : lines)
+		width = max(width, metrics.width(line));
+
+	const QRect box(rect.left() + Margin, rect.top() + Margin,
+		width + Margin * 2, metrics.height() * lines.size() + Margin * 2);
+
+	p.setFont(font);
+	p.fillRect(box, QColor(0, 0, 0, 176));
+	p.setPen(Qt::white);
+
+	int y = box.top() + Margin + metrics.ascent();
+	for (const QString &line : lines) {
+		p.drawText(box.left() + Margin, y, line);
+		y += metrics.height();
+	}
+
+	p.restore();
+}
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
@@ -0,0 +1,163 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_VIEWS_TRACEVIEW_RENDERPROFILE_HPP
+#define PULSEVIEW_PV_VIEWS_TRACEVIEW_RENDERPROFILE_HPP
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+#include "tilecache.hpp"
+#include "viewitempaintparams.hpp"
+
+using std::map;
+using std::vector;
+
+class QPainter;
+class QRect;
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+class Signal;
+class ViewItem;
+
+/**
+ * Measures where the time of painting the viewport goes: laying out the
+ * rows, painting each layer of each item, fetching the data that the items
+ * paint, and rendering the tiles of the signals. The hit rates of the tile
+ * and text caches show whether the work could have been avoided.
+ *
+ * The measurements of a frame can be shown as an overlay on the viewport,
+ * and are written to a log file as a JSON object per line if the
+ * environment variable named by @c LogVariable is set.
+ */
+class RenderProfile
+{
+public:
+	enum Layer {
+		LayerBack,
+		LayerMid,
+		LayerFore,
+		LayerCount
+	};
+
+	/// The environment variable naming the log file, or "-" for stderr
+	static const char *const LogVariable;
+
+	/// The number of the most costly items that the overlay lists
+	static const unsigned int OverlayItemCount;
+
+private:
+	struct Item
+	{
+		QString name;
+		/// The time in milliseconds spent painting each layer
+		double layer_time[LayerCount];
+		ViewItemPaintParams::Statistics paint;
+		TileCache::RenderStatistics render;
+	};
+
+public:
+	RenderProfile();
+
+	/**
+	 * Returns true if the frames are measured, i.e. if the overlay is
+	 * shown or the frames are logged.
+	 */
+	bool enabled() const;
+
+	bool overlay_shown() const;
+
+	void set_overlay_shown(bool shown);
+
+	/**
+	 * Starts measuring a frame.
+	 */
+	void begin_frame();
+
+	/**
+	 * Records the time from the start of the frame as the time it took to
+	 * lay out the rows.
+	 */
+	void end_layout();
+
+	/**
+	 * Starts measuring an item painting a layer.
+	 * @param pp the painting parameters the item paints with.
+	 */
+	void begin_item(const ViewItemPaintParams &pp);
+
+	/**
+	 * Records the time an item took to paint a layer since begin_item()
+	 * and the data it fetched.
+	 */
+	void end_item(const ViewItem &item, Layer layer,
+		const ViewItemPaintParams &pp);
+
+	/**
+	 * Records the tiles painted by the frame and the tiles that the render
+	 * threads rendered since the previous frame.
+	 */
+	void add_tiles(unsigned int hits, unsigned int misses,
+		const map<const Signal*, TileCache::RenderStatistics> &rendered);
+
+	/**
+	 * Finishes measuring the frame. Logs it and paints the overlay if it
+	 * is shown.
+	 * @param p the painter of the viewport.
+	 * @param rect the area of the viewport.
+	 */
+	void end_frame(QPainter &p, const QRect &rect);
+
+private:
+	static QString item_name(const ViewItem &item);
+
+	/**
+	 * Returns the time in milliseconds that an item cost the frame.
+	 */
+	static double item_cost(const Item &item);
+
+	void log_frame(const vector<const Item*> &items);
+
+	void paint_overlay(QPainter &p, const QRect &rect,
+		const vector<const Item*> &items) const;
+
+private:
+	bool overlay_shown_;
+	QFile log_;
+
+	uint64_t frame_;
+	QElapsedTimer frame_timer_, item_timer_;
+	ViewItemPaintParams::Statistics item_start_;
+
+	double layout_time_, paint_time_;
+	unsigned int tile_hits_, tile_misses_;
+	map<const ViewItem*, Item> items_;
+};
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEWS_TRACEVIEW_RENDERPROFILE_HPP
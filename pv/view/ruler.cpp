@@ -17,6 +17,8 @@
  * along with this program; if not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cmath>
+
 #include <extdef.h>
 
 #include <QApplication>
@@ -28,7 +30,7 @@
 
 using namespace Qt;
 
-using std::function;
+using std::map;
 using std::shared_ptr;
 using std::vector;
 
@@ -42,7 +44,8 @@ const int Ruler::MinorTickSubdivision = 4;
 const float Ruler::HoverArrowSize = 0.5f; // x Text Height
 
 Ruler::Ruler(View &parent) :
-	MarginWidget(parent)
+	MarginWidget(parent),
+	minor_tick_dx_(0)
 {
 	setMouseTracking(true);
 
@@ -51,15 +54,15 @@ Ruler::Ruler(View &parent) :
 	connect(&view_, SIGNAL(offset_changed()),
 		this, SLOT(invalidate_tick_position_cache()));
 	connect(&view_, SIGNAL(scale_changed()),
-		this, SLOT(invalidate_tick_position_cache()));
+		this, SLOT(invalidate_tick_scale()));
 	connect(&view_, SIGNAL(tick_prefix_changed()),
-		this, SLOT(invalidate_tick_position_cache()));
+		this, SLOT(invalidate_tick_labels()));
 	connect(&view_, SIGNAL(tick_precision_changed()),
-		this, SLOT(invalidate_tick_position_cache()));
+		this, SLOT(invalidate_tick_labels()));
 	connect(&view_, SIGNAL(tick_period_changed()),
-		this, SLOT(invalidate_tick_position_cache()));
+		this, SLOT(invalidate_tick_labels()));
 	connect(&view_, SIGNAL(time_unit_changed()),
-		this, SLOT(invalidate_tick_position_cache()));
+		this, SLOT(invalidate_tick_labels()));
 }
 
 QSize Ruler::sizeHint() const
@@ -129,21 +132,23 @@ shared_ptr<ViewItem> Ruler::get_mouse_over_item(const QPoint &pt)
 void Ruler::paintEvent(QPaintEvent*)
 {
 	if (!tick_position_cache_) {
-		auto ffunc = [this](const pv::util::Timestamp& t) {
-			return format_time_with_distance(
-				this->view_.tick_period(),
-				t,
-				this->view_.tick_prefix(),
-				this->view_.time_unit(),
-				this->view_.tick_precision());
-		};
-
-		tick_position_cache_ = calculate_tick_positions(
-			view_.tick_period(),
-			view_.offset(),
-			view_.scale(),
-			width(),
-			ffunc);
+		const pv::util::Timestamp& period = view_.tick_period();
+
+		if (!tick_origin_) {
+			tick_origin_ = calculate_tick_origin(period, view_.offset());
+			label_cache_.clear();
+		}
+
+		if (minor_tick_dx_ == 0)
+			minor_tick_dx_ = calculate_minor_tick_dx(period, view_.scale());
+
+		// Scrolling only moves the origin, so this is all that has to be
+		// calculated while the view follows the incoming samples
+		const double x0 = (tick_origin_->fixed_time -
+			view_.fixed_offset()).to_double() / view_.scale();
+
+		tick_position_cache_ = layout_ticks(x0, minor_tick_dx_, width());
+		update_tick_labels();
 	}
 
 	const int ValueMargin = 3;
@@ -159,8 +164,9 @@ void Ruler::paintEvent(QPaintEvent*)
 	p.setPen(palette().color(foregroundRole()));
 
 	for (const auto& tick: tick_position_cache_->major) {
-		p.drawText(tick.first, ValueMargin, 0, text_height,
-				AlignCenter | AlignTop | TextDontClip, tick.second);
+		const QStaticText &label = label_cache_[tick.second];
+		p.drawStaticText(QPointF(tick.first - label.size().width() / 2,
+			ValueMargin), label);
 		p.drawLine(QPointF(tick.first, major_tick_y1),
 			QPointF(tick.first, ruler_height));
 	}
@@ -189,41 +195,68 @@ void Ruler::paintEvent(QPaintEvent*)
 	}
 }
 
-Ruler::TickPositions Ruler::calculate_tick_positions(
+Ruler::TickOrigin Ruler::calculate_tick_origin(
 	const pv::util::Timestamp& major_period,
-	const pv::util::Timestamp& offset,
-	const double scale,
-	const int width,
-	function<QString(const pv::util::Timestamp&)> format_function)
+	const pv::util::Timestamp& offset)
 {
-	TickPositions tp;
+	const pv::util::Timestamp t = floor(offset / major_period) * major_period;
+	return TickOrigin{t, pv::util::FixedTimestamp(t)};
+}
 
-	const pv::util::Timestamp minor_period = major_period / MinorTickSubdivision;
-	const pv::util::Timestamp first_major_division = floor(offset / major_period);
-	const pv::util::Timestamp first_minor_division = ceil(offset / minor_period);
-	const pv::util::Timestamp t0 = first_major_division * major_period;
+double Ruler::calculate_minor_tick_dx(
+	const pv::util::Timestamp& major_period, double scale)
+{
+	return (major_period / scale).convert_to<double>() /
+		MinorTickSubdivision;
+}
 
-	int division = (round(first_minor_division -
-		first_major_division * MinorTickSubdivision)).convert_to<int>() - 1;
+Ruler::TickLayout Ruler::layout_ticks(double x0, double minor_dx, int width)
+{
+	TickLayout tl;
 
+	if (minor_dx <= 0)
+		return tl;
+
+	// Start with the last minor tick left of the ruler
+	int64_t division = (int64_t)ceil(-x0 / minor_dx) - 1;
 	double x;
 
 	do {
-		pv::util::Timestamp t = t0 + division * minor_period;
-		x = ((t - offset) / scale).convert_to<double>();
-
-		if (division % MinorTickSubdivision == 0) {
-			// Recalculate 't' without using 'minor_period' which is a fraction
-			t = t0 + division / MinorTickSubdivision * major_period;
-			tp.major.emplace_back(x, format_function(t));
-		} else {
-			tp.minor.emplace_back(x);
-		}
+		x = x0 + division * minor_dx;
+
+		if (division % MinorTickSubdivision == 0)
+			tl.major.emplace_back(x, division / MinorTickSubdivision);
+		else
+			tl.minor.emplace_back(x);
 
 		division++;
 	} while (x < width);
 
-	return tp;
+	return tl;
+}
+
+void Ruler::update_tick_labels()
+{
+	map<int64_t, QStaticText> labels;
+
+	for (const auto& tick : tick_position_cache_->major) {
+		const auto iter = label_cache_.find(tick.second);
+		if (iter != label_cache_.end()) {
+			labels[tick.second] = iter->second;
+			continue;
+		}
+
+		const pv::util::Timestamp t = tick_origin_->time +
+			tick.second * view_.tick_period();
+
+		QStaticText label(format_time_with_distance(view_.tick_period(), t,
+			view_.tick_prefix(), view_.time_unit(), view_.tick_precision()));
+		label.setTextFormat(PlainText);
+		label.prepare(QTransform(), font());
+		labels[tick.second] = label;
+	}
+
+	label_cache_.swap(labels);
 }
 
 void Ruler::mouseDoubleClickEvent(QMouseEvent *event)
@@ -266,6 +299,28 @@ void Ruler::invalidate_tick_position_cache()
 	tick_position_cache_ = boost::none;
 }
 
+void Ruler::invalidate_tick_scale()
+{
+	minor_tick_dx_ = 0;
+	invalidate_tick_position_cache();
+}
+
+void Ruler::invalidate_tick_labels()
+{
+	tick_origin_ = boost::none;
+	label_cache_.clear();
+	invalidate_tick_scale();
+}
+
+void Ruler::changeEvent(QEvent *event)
+{
+	// The labels are prepared with the font of the ruler
+	if (event->type() == QEvent::FontChange)
+		invalidate_tick_labels();
+
+	MarginWidget::changeEvent(event);
+}
+
 void Ruler::resizeEvent(QResizeEvent*)
 {
 	// the tick calculation depends on the width of this widget
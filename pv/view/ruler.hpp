@@ -20,15 +20,18 @@
 #ifndef PULSEVIEW_PV_VIEWS_TRACEVIEW_RULER_HPP
 #define PULSEVIEW_PV_VIEWS_TRACEVIEW_RULER_HPP
 
-#include <functional>
+#include <cstdint>
+#include <map>
 #include <memory>
 
 #include <boost/optional.hpp>
 
+#include <QStaticText>
+
 #include "marginwidget.hpp"
 #include <pv/util.hpp>
 
-using std::function;
+using std::map;
 using std::pair;
 using std::shared_ptr;
 using std::vector;
@@ -136,38 +139,86 @@ private:
 
 	int calculate_text_height() const;
 
-	struct TickPositions
+	/**
+	 * The tick positions of the ruler, with the major ticks identified by
+	 * their number counted from the tick origin.
+	 */
+	struct TickLayout
 	{
-		vector<pair<double, QString>> major;
+		vector<pair<double, int64_t>> major;
 		vector<double> minor;
 	};
 
+	/**
+	 * A major tick that the ticks are counted from. It stays the same while
+	 * scrolling, so only the position of the origin has to be recalculated.
+	 */
+	struct TickOrigin
+	{
+		pv::util::Timestamp time;
+		pv::util::FixedTimestamp fixed_time;
+	};
+
 	/**
 	 * Holds the tick positions so that they don't have to be recalculated on
 	 * every redraw. Set by 'paintEvent()' when needed.
 	 */
-	boost::optional<TickPositions> tick_position_cache_;
+	boost::optional<TickLayout> tick_position_cache_;
+
+	/**
+	 * The origin of the tick numbers. Reset when the tick period changes.
+	 */
+	boost::optional<TickOrigin> tick_origin_;
+
+	/**
+	 * The distance between the minor ticks in pixels, or zero if it has to
+	 * be recalculated after a change of the scale or the tick period.
+	 */
+	double minor_tick_dx_;
+
+	/**
+	 * The labels of the major ticks in view, keyed by the tick number.
+	 * Cleared when the tick origin or the label format changes.
+	 */
+	map<int64_t, QStaticText> label_cache_;
 
 	/**
-	 * Calculates the major and minor tick positions.
+	 * Calculates the tick origin, the last major tick left of the ruler.
 	 *
 	 * @param major_period The period between the major ticks.
 	 * @param offset The time at the left border of the ruler.
+	 */
+	static TickOrigin calculate_tick_origin(
+		const pv::util::Timestamp& major_period,
+		const pv::util::Timestamp& offset);
+
+	/**
+	 * Calculates the distance between the minor ticks in pixels.
+	 *
+	 * @param major_period The period between the major ticks.
 	 * @param scale The scale in seconds per pixel.
+	 */
+	static double calculate_minor_tick_dx(
+		const pv::util::Timestamp& major_period, double scale);
+
+	/**
+	 * Lays out the ticks from the position of a major tick.
+	 *
+	 * @param x0 The position of major tick number zero in pixels.
+	 * @param minor_dx The distance between the minor ticks in pixels.
 	 * @param width the Width of the ruler.
-	 * @param format_function A function used to format the major tick times.
-	 * @return An object of type 'TickPositions' that contains the major tick
-	 *         positions together with the labels at that ticks, and the minor
-	 *         tick positions.
 	 */
-	static TickPositions calculate_tick_positions(
-		const pv::util::Timestamp& major_period,
-		const pv::util::Timestamp& offset,
-		const double scale,
-		const int width,
-		function<QString(const pv::util::Timestamp&)> format_function);
+	static TickLayout layout_ticks(double x0, double minor_dx, int width);
+
+	/**
+	 * Fills the label cache with the labels of the major ticks in view,
+	 * formatting only the labels that are not in the cache yet.
+	 */
+	void update_tick_labels();
 
 protected:
+	void changeEvent(QEvent *event) override;
+
 	void resizeEvent(QResizeEvent*) override;
 
 private Q_SLOTS:
@@ -175,6 +226,12 @@ private Q_SLOTS:
 
 	// Resets the 'tick_position_cache_'.
 	void invalidate_tick_position_cache();
+
+	// Resets the tick positions and the minor tick distance.
+	void invalidate_tick_scale();
+
+	// Resets the tick positions, the tick origin and the label cache.
+	void invalidate_tick_labels();
 };
 
 } // namespace TraceView
@@ -30,13 +30,17 @@
 
 #include <libsigrokcxx/libsigrokcxx.hpp>
 
+#include "pv/data/segment.hpp"
 #include "pv/data/signalbase.hpp"
+#include "pv/data/signaldata.hpp"
+#include "pv/session.hpp"
 
 #include "signal.hpp"
 #include "view.hpp"
 
 using std::shared_ptr;
 using std::make_shared;
+using std::vector;
 
 namespace pv {
 namespace views {
@@ -112,6 +116,33 @@ void Signal::paint_back(QPainter &p, ViewItemPaintParams &pp)
 		Trace::paint_back(p, pp);
 }
 
+void Signal::paint_mid(QPainter &p, ViewItemPaintParams &pp)
+{
+	paint_mid_at(p, pp, get_visual_y(), paint_state(), painted_segments());
+}
+
+Signal::PaintState Signal::paint_state() const
+{
+	const PaintState state = {base_->enabled(), base_->colour(),
+		base_->logic_bit_index(), 0};
+	return state;
+}
+
+vector< shared_ptr<pv::data::Segment> > Signal::painted_segments() const
+{
+	vector< shared_ptr<pv::data::Segment> > painted;
+
+	const shared_ptr<pv::data::SignalData> d = data();
+	if (!d)
+		return painted;
+
+	const vector< shared_ptr<pv::data::Segment> > segments(d->segments());
+	if (!segments.empty())
+		painted.push_back(segments.front());
+
+	return painted;
+}
+
 void Signal::populate_popup_form(QWidget *parent, QFormLayout *form)
 {
 	name_widget_ = new QComboBox(parent);
@@ -172,7 +203,11 @@ void Signal::on_name_changed(const QString &text)
 
 void Signal::on_disable()
 {
-	base_->set_enabled(false);
+	// Math channels don't belong to the device and are removed instead
+	if (base_->type() == data::SignalBase::MathChannel)
+		session_.remove_math_signal(base_);
+	else
+		base_->set_enabled(false);
 }
 
 void Signal::on_enabled_changed(bool enabled)
@@ -21,7 +21,9 @@
 #define PULSEVIEW_PV_VIEWS_TRACEVIEW_SIGNAL_HPP
 
 #include <memory>
+#include <vector>
 
+#include <QColor>
 #include <QComboBox>
 #include <QWidgetAction>
 
@@ -31,13 +33,16 @@
 #include "trace.hpp"
 #include "viewitemowner.hpp"
 
+using std::dynamic_pointer_cast;
 using std::shared_ptr;
+using std::vector;
 
 namespace pv {
 
 class Session;
 
 namespace data {
+class Segment;
 class SignalBase;
 class SignalData;
 }
@@ -49,6 +54,22 @@ class Signal : public Trace, public ViewItemOwner
 {
 	Q_OBJECT
 
+public:
+	/**
+	 * The state of the signal that the mid-layer is painted with. It is
+	 * read in the GUI thread like the painted segments, as the signal
+	 * base may change while a render thread paints.
+	 */
+	struct PaintState
+	{
+		bool enabled;
+		QColor colour;
+		/// The bit of the logic data that is painted
+		unsigned int logic_bit_index;
+		/// The height of logic traces
+		int height;
+	};
+
 protected:
 	Signal(pv::Session &session, shared_ptr<data::SignalBase> channel);
 
@@ -78,6 +99,37 @@ public:
 
 	void paint_back(QPainter &p, ViewItemPaintParams &pp);
 
+	/**
+	 * Paints the mid-layer of the signal at its visual position.
+	 */
+	void paint_mid(QPainter &p, ViewItemPaintParams &pp);
+
+	/**
+	 * Paints the mid-layer of the signal with its zero line at @c y.
+	 * This is also called by the render threads of the viewport, so
+	 * implementations must paint from the given state and segments,
+	 * never from the signal base or the data of the signal.
+	 * @param state the state returned by paint_state() when the painting
+	 * 	was requested in the GUI thread.
+	 * @param segments the segments returned by painted_segments() when
+	 * 	the painting was requested in the GUI thread.
+	 */
+	virtual void paint_mid_at(QPainter &p, ViewItemPaintParams &pp, int y,
+		const PaintState &state,
+		const vector< shared_ptr<pv::data::Segment> > &segments) = 0;
+
+	/**
+	 * Gets the state that the mid-layer of the signal is painted with.
+	 * Must be called from the GUI thread.
+	 */
+	virtual PaintState paint_state() const;
+
+	/**
+	 * Gets the segments that the mid-layer of the signal is painted from.
+	 * Must be called from the GUI thread.
+	 */
+	virtual vector< shared_ptr<pv::data::Segment> > painted_segments() const;
+
 	virtual void populate_popup_form(QWidget *parent, QFormLayout *form);
 
 	QMenu* create_context_menu(QWidget *parent);
@@ -107,6 +159,23 @@ protected Q_SLOTS:
 
 	void on_enabled_changed(bool enabled);
 
+protected:
+	/**
+	 * Finds the first segment of type @c T among the painted segments.
+	 */
+	template<class T>
+	static shared_ptr<T> find_segment(
+		const vector< shared_ptr<pv::data::Segment> > &segments)
+	{
+		for (const shared_ptr<pv::data::Segment> &s : segments) {
+			const shared_ptr<T> segment =
+				dynamic_pointer_cast<T>(s);
+			if (segment)
+				return segment;
+		}
+		return nullptr;
+	}
+
 protected:
 	pv::Session &session_;
 
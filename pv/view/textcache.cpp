@@ -0,0 +1,96 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QFontMetricsF>
+#include <QTransform>
+
+#include "textcache.hpp"
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+const int TextCache::MaxEntries = 4096;
+
+TextCache::TextCache() :
+	hits_(0),
+	misses_(0)
+{
+}
+
+void TextCache::set_font(const QFont &font)
+{
+	if (font == font_)
+		return;
+
+	font_ = font;
+	entries_.clear();
+}
+
+int TextCache::width(const QString &text)
+{
+	return entry(text).width;
+}
+
+const QStaticText& TextCache::static_text(const QString &text)
+{
+	Entry &e = entry(text);
+
+	if (!e.laid_out) {
+		e.static_text.setText(text);
+		e.static_text.setTextFormat(Qt::PlainText);
+		e.static_text.prepare(QTransform(), font_);
+		e.laid_out = true;
+	}
+
+	return e.static_text;
+}
+
+uint64_t TextCache::hits() const
+{
+	return hits_;
+}
+
+uint64_t TextCache::misses() const
+{
+	return misses_;
+}
+
+TextCache::Entry& TextCache::entry(const QString &text)
+{
+	const auto iter = entries_.find(text);
+	if (iter != entries_.end()) {
+		hits_++;
+		return *iter;
+	}
+
+	misses_++;
+
+	// Decoders mostly repeat a small set of strings, so when that doesn't
+	// hold simply starting over is good enough
+	if (entries_.size() >= MaxEntries)
+		entries_.clear();
+
+	const Entry e = {
+		(int)QFontMetricsF(font_).boundingRect(QRectF(), 0, text).width(),
+		QStaticText(), false};
+	return *entries_.insert(text, e);
+}
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
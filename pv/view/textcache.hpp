@@ -0,0 +1,89 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_VIEWS_TRACEVIEW_TEXTCACHE_HPP
+#define PULSEVIEW_PV_VIEWS_TRACEVIEW_TEXTCACHE_HPP
+
+#include <cstdint>
+
+#include <QFont>
+#include <QHash>
+#include <QStaticText>
+#include <QString>
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+/**
+ * Caches the measured widths and the laid out text of strings that are
+ * drawn over and over again with the same font, such as the annotations
+ * of a decoder.
+ */
+class TextCache
+{
+public:
+	/// The number of strings at which the cache is cleared
+	static const int MaxEntries;
+
+public:
+	TextCache();
+
+	/**
+	 * Sets the font the strings are drawn with. Clears the cache if the
+	 * font is different from the font of the cached strings.
+	 */
+	void set_font(const QFont &font);
+
+	/**
+	 * Gets the width of a string, measured the way
+	 * @c QPainter::boundingRect() measures it.
+	 */
+	int width(const QString &text);
+
+	/**
+	 * Gets the string as text that is laid out for drawing.
+	 */
+	const QStaticText& static_text(const QString &text);
+
+	/// The number of lookups that found the string in the cache
+	uint64_t hits() const;
+
+	/// The number of lookups that had to measure the string
+	uint64_t misses() const;
+
+private:
+	struct Entry
+	{
+		int width;
+		QStaticText static_text;
+		bool laid_out;
+	};
+
+	Entry& entry(const QString &text);
+
+private:
+	QFont font_;
+	QHash<QString, Entry> entries_;
+	uint64_t hits_, misses_;
+};
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEWS_TRACEVIEW_TEXTCACHE_HPP
@@ -0,0 +1,420 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <tuple>
+
+#include <QPainter>
+
+#include "signal.hpp"
+#include "tilecache.hpp"
+
+#include <pv/data/segment.hpp>
+
+using std::back_inserter;
+using std::floor;
+using std::lock_guard;
+using std::lround;
+using std::make_pair;
+using std::max;
+using std::move;
+using std::numeric_limits;
+using std::thread;
+using std::tie;
+using std::unique_lock;
+
+namespace pv {
+namespace views {
+namespace TraceView {
+
+const int TileCache::TileWidth = 256;
+const size_t TileCache::MemoryBudget = 64 * 1024 * 1024;
+const int TileCache::AppendMargin = 8;
+
+typedef std::chrono::steady_clock Clock;
+
+static size_t tile_size(const QImage &image)
+{
+	return image.bytesPerLine() * image.height();
+}
+
+bool TileCache::Key::operator<(const Key &other) const
+{
+	return tie(signal, scale, index) <
+		tie(other.signal, other.scale, other.index);
+}
+
+TileCache::TileCache() :
+	quit_(false),
+	memory_used_(0),
+	active_job_count_(0),
+	generation_(1),
+	cleared_generation_(1),
+	frame_(0),
+	frame_job_count_(0),
+	frame_tile_hits_(0),
+	frame_tile_misses_(0),
+	profiling_(false),
+	tile_render_time_(0),
+	update_pending_(false)
+{
+	// Leave one core to the GUI thread
+	const unsigned int thread_count =
+		max(thread::hardware_concurrency(), 2U) - 1;
+
+	for (unsigned int i = 0; i < thread_count; i++)
+		threads_.emplace_back(&TileCache::render_proc, this);
+}
+
+TileCache::~TileCache()
+{
+	{
+		lock_guard<mutex> lock(mutex_);
+		quit_ = true;
+	}
+	jobs_cond_.notify_all();
+
+	for (thread &t : threads_)
+		t.join();
+}
+
+void TileCache::begin_frame()
+{
+	// Declared before the lock so that the jobs are released after it
+	vector<Job> jobs;
+
+	update_pending_ = false;
+
+	lock_guard<mutex> lock(mutex_);
+
+	frame_++;
+	frame_job_count_ = 0;
+	frame_tile_hits_ = frame_tile_misses_ = 0;
+
+	jobs.swap(retired_);
+	move(jobs_.begin(), jobs_.end(), back_inserter(jobs));
+	jobs_.clear();
+}
+
+void TileCache::paint(QPainter &p, const ViewItemPaintParams &pp,
+	const shared_ptr<Signal> &signal)
+{
+	assert(signal);
+
+	if (!signal->enabled())
+		return;
+
+	const int y = signal->get_visual_y();
+	const pair<int, int> extents = signal->v_extents();
+
+	if (y + extents.second < pp.top() || y + extents.first > pp.bottom())
+		return;
+
+	const Signal::PaintState state = signal->paint_state();
+	const vector< shared_ptr<pv::data::Segment> > segments =
+		signal->painted_segments();
+	const vector<SegmentExtent> data = data_extents(segments);
+
+	const double pixels_offset = pp.pixels_offset();
+	const int64_t first = floor(pixels_offset / TileWidth);
+	const int64_t last = floor((pixels_offset + pp.width() - 1) / TileWidth);
+
+	vector< pair<QPoint, QImage> > images;
+	bool queued = false;
+
+	{
+		lock_guard<mutex> lock(mutex_);
+
+		for (int64_t i = first; i <= last; i++) {
+			const Key key = {signal.get(), pp.scale(), i};
+
+			auto iter = tiles_.find(key);
+			if (iter == tiles_.end()) {
+				lru_.push_front(key);
+				const Tile tile = {QImage(), extents, data,
+					ViewItemPaintParams::QualityDraft, 0, 0, frame_,
+					lru_.begin()};
+				iter = tiles_.insert(make_pair(key, tile)).first;
+			}
+
+			Tile &tile = iter->second;
+			tile.last_frame = frame_;
+			lru_.splice(lru_.begin(), lru_, tile.lru_pos);
+
+			// Tiles are placed on whole pixels, so that adjacent
+			// tiles line up exactly
+			if (!tile.image.isNull())
+				images.emplace_back(QPoint(
+					lround(i * TileWidth - pixels_offset) + pp.left(),
+					y + tile.extents.first), tile.image);
+
+			const bool current = !tile.image.isNull() &&
+				tile.generation == generation_ &&
+				tile.extents == extents &&
+				tile.quality >= pp.quality() &&
+				data_current(tile.data, data,
+					((i + 1) * TileWidth + AppendMargin) * pp.scale());
+
+			if (current)
+				frame_tile_hits_++;
+			else
+				frame_tile_misses_++;
+
+			if (!current && tile.rendering_generation != generation_) {
+				const Job job = {key, signal, state, segments,
+					pv::util::Timestamp(pp.scale()) * (i * TileWidth),
+					extents, data, pp.quality(), pp.display_settings(),
+					pp.profiling(), generation_};
+				jobs_.push_back(job);
+				frame_job_count_++;
+				queued = true;
+			}
+		}
+	}
+
+	if (queued)
+		jobs_cond_.notify_all();
+
+	for (const pair<QPoint, QImage> &image : images)
+		p.drawImage(image.first, image.second);
+}
+
+void TileCache::invalidate()
+{
+	lock_guard<mutex> lock(mutex_);
+	generation_++;
+}
+
+void TileCache::clear()
+{
+	vector<Job> jobs;
+
+	lock_guard<mutex> lock(mutex_);
+
+	// Renders that are in progress are discarded when they finish
+	cleared_generation_ = ++generation_;
+
+	tiles_.clear();
+	lru_.clear();
+	memory_used_ = 0;
+
+	jobs.swap(retired_);
+	move(jobs_.begin(), jobs_.end(), back_inserter(jobs));
+	jobs_.clear();
+}
+
+vector<TileCache::SegmentExtent> TileCache::data_extents(
+	const vector< shared_ptr<pv::data::Segment> > &segments)
+{
+	vector<SegmentExtent> extents;
+
+	for (const shared_ptr<pv::data::Segment> &s : segments) {
+		const SegmentExtent e = {s.get(), s->fixed_start_time().to_double(),
+			s->samplerate(), s->get_sample_count()};
+		extents.push_back(e);
+	}
+
+	return extents;
+}
+
+bool TileCache::data_current(const vector<SegmentExtent> &rendered,
+	const vector<SegmentExtent> &current, double tile_end)
+{
+	if (rendered.size() != current.size())
+		return false;
+
+	for (size_t i = 0; i < rendered.size(); i++) {
+		const SegmentExtent &r = rendered[i], &c = current[i];
+
+		if (r.segment != c.segment || r.start_time != c.start_time ||
+			r.samplerate != c.samplerate ||
+			r.sample_count > c.sample_count)
+			return false;
+
+		// Appended samples only change the tiles at the end of the samples
+		if (r.sample_count != c.sample_count && (r.samplerate <= 0 ||
+			tile_end > r.start_time + r.sample_count / r.samplerate))
+			return false;
+	}
+
+	return true;
+}
+
+double TileCache::frame_render_time()
+{
+	lock_guard<mutex> lock(mutex_);
+	return frame_job_count_ * tile_render_time_ / threads_.size();
+}
+
+bool TileCache::busy()
+{
+	lock_guard<mutex> lock(mutex_);
+	return !jobs_.empty() || active_job_count_ > 0;
+}
+
+void TileCache::frame_tile_counts(unsigned int &hits, unsigned int &misses)
+{
+	lock_guard<mutex> lock(mutex_);
+	hits = frame_tile_hits_;
+	misses = frame_tile_misses_;
+}
+
+void TileCache::set_profiling(bool profiling)
+{
+	lock_guard<mutex> lock(mutex_);
+	profiling_ = profiling;
+	render_statistics_.clear();
+}
+
+map<const Signal*, TileCache::RenderStatistics>
+	TileCache::take_render_statistics()
+{
+	map<const Signal*, RenderStatistics> statistics;
+
+	lock_guard<mutex> lock(mutex_);
+	statistics.swap(render_statistics_);
+	return statistics;
+}
+
+void TileCache::render_proc()
+{
+	unique_lock<mutex> lock(mutex_);
+
+	while (true) {
+		jobs_cond_.wait(lock, [&] { return quit_ || !jobs_.empty(); });
+		if (quit_)
+			return;
+
+		Job job = move(jobs_.front());
+		jobs_.pop_front();
+
+		auto iter = tiles_.find(job.key);
+		if (iter == tiles_.end()) {
+			retired_.push_back(move(job));
+			continue;
+		}
+
+		iter->second.rendering_generation = job.generation;
+		active_job_count_++;
+
+		lock.unlock();
+
+		const Clock::time_point start = Clock::now();
+
+		const int height = job.extents.second - job.extents.first + 1;
+		QImage image(TileWidth, height, QImage::Format_ARGB32_Premultiplied);
+		image.fill(Qt::transparent);
+
+		ViewItemPaintParams pp(QRect(0, 0, TileWidth, height),
+			job.key.scale, job.offset, job.quality);
+		pp.set_display_settings(job.display_settings);
+		pp.set_profiling(job.profiling);
+
+		{
+			QPainter p(&image);
+			p.setRenderHint(QPainter::Antialiasing,
+				job.quality == ViewItemPaintParams::QualityFull);
+			job.signal->paint_mid_at(p, pp, -job.extents.first,
+				job.state, job.segments);
+		}
+
+		const double time = std::chrono::duration<double, std::milli>(
+			Clock::now() - start).count();
+
+		lock.lock();
+
+		tile_render_time_ += (time - tile_render_time_) / 8;
+
+		if (profiling_) {
+			RenderStatistics &s = render_statistics_[job.key.signal];
+			const ViewItemPaintParams::Statistics &paint = pp.statistics();
+			s.tiles++;
+			s.render_time += time;
+			s.paint.fetched += paint.fetched;
+			s.paint.fetch_time += paint.fetch_time;
+			s.paint.cache_hits += paint.cache_hits;
+			s.paint.cache_misses += paint.cache_misses;
+		}
+
+		store(job, image);
+		retired_.push_back(move(job));
+		active_job_count_--;
+
+		if (!update_pending_.exchange(true))
+			tiles_ready();
+	}
+}
+
+void TileCache::store(const Job &job, const QImage &image)
+{
+	if (job.generation < cleared_generation_)
+		return;
+
+	auto iter = tiles_.find(job.key);
+	if (iter == tiles_.end())
+		return;
+
+	Tile &tile = iter->second;
+
+	if (tile.rendering_generation == job.generation)
+		tile.rendering_generation = 0;
+
+	// Don't replace a tile that was rendered by a more recent job, or by
+	// a job of the same generation and samples at a higher quality
+	if (!tile.image.isNull() && (tile.generation > job.generation ||
+		(tile.generation == job.generation && tile.quality > job.quality &&
+		data_current(job.data, tile.data,
+			numeric_limits<double>::infinity()))))
+		return;
+
+	memory_used_ -= tile_size(tile.image);
+	memory_used_ += tile_size(image);
+
+	tile.image = image;
+	tile.extents = job.extents;
+	tile.data = job.data;
+	tile.quality = job.quality;
+	tile.generation = job.generation;
+
+	evict();
+}
+
+void TileCache::evict()
+{
+	while (memory_used_ > MemoryBudget && !lru_.empty()) {
+		auto iter = tiles_.find(lru_.back());
+		assert(iter != tiles_.end());
+
+		// Keep the tiles of the current frame, they are all at the
+		// front of the list
+		if (iter->second.last_frame == frame_)
+			break;
+
+		memory_used_ -= tile_size(iter->second.image);
+		tiles_.erase(iter);
+		lru_.pop_back();
+	}
+}
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
@@ -0,0 +1,288 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PULSEVIEW_PV_VIEWS_TRACEVIEW_TILECACHE_HPP
+#define PULSEVIEW_PV_VIEWS_TRACEVIEW_TILECACHE_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <QImage>
+#include <QObject>
+
+#include "pv/util.hpp"
+#include "viewitempaintparams.hpp"
+
+using std::atomic;
+using std::condition_variable;
+using std::deque;
+using std::list;
+using std::map;
+using std::mutex;
+using std::pair;
+using std::shared_ptr;
+using std::vector;
+
+class QPainter;
+
+namespace pv {
+
+namespace data {
+class Segment;
+}
+
+namespace views {
+namespace TraceView {
+
+class Signal;
+
+/**
+ * Renders the mid-layer of signals into cached image tiles on background
+ * threads, so that the viewport only has to composite them.
+ *
+ * A tile covers @c TileWidth pixels of one signal at one zoom level. As tiles
+ * are aligned to absolute pixel positions, scrolling reuses the tiles that
+ * are already rendered. When the tiles are invalidated they are still shown
+ * until their replacement has been rendered, so that the view is refreshed
+ * progressively rather than blanked. In the same way, tiles that were
+ * rendered at a lower quality are shown until they have been rendered at the
+ * requested quality.
+ *
+ * Appending samples to the segments that a signal is painted from does not
+ * invalidate its tiles. Only the tiles that reach the end of the samples
+ * that they were rendered from are rendered again, so the cost of following
+ * a running capture depends on the amount of new samples rather than on the
+ * size of the view.
+ */
+class TileCache : public QObject
+{
+	Q_OBJECT
+
+public:
+	static const int TileWidth;
+	static const size_t MemoryBudget;
+
+	/// The distance in pixels from the end of the samples within which
+	/// tiles are rendered again when samples are appended
+	static const int AppendMargin;
+
+	/// What the render threads did for a signal, for the render profile
+	struct RenderStatistics
+	{
+		unsigned int tiles;
+		/// The time in milliseconds spent rendering the tiles
+		double render_time;
+		ViewItemPaintParams::Statistics paint;
+	};
+
+private:
+	struct Key
+	{
+		const Signal *signal;
+		double scale;
+		int64_t index;
+
+		bool operator<(const Key &other) const;
+	};
+
+	/// The samples of a segment that a tile was rendered from
+	struct SegmentExtent
+	{
+		const pv::data::Segment *segment;
+		double start_time;
+		double samplerate;
+		uint64_t sample_count;
+	};
+
+	struct Tile
+	{
+		QImage image;
+		pair<int, int> extents;
+		vector<SegmentExtent> data;
+		ViewItemPaintParams::Quality quality;
+		uint64_t generation;
+		uint64_t rendering_generation;
+		uint64_t last_frame;
+		list<Key>::iterator lru_pos;
+	};
+
+	/**
+	 * A tile to render. Everything the render thread needs is gathered
+	 * in the GUI thread, so that it never reads the live data or the
+	 * settings, which the GUI thread may change at any time.
+	 */
+	struct Job
+	{
+		Key key;
+		shared_ptr<Signal> signal;
+		Signal::PaintState state;
+		/// The segments to paint, they are kept alive by the job
+		vector< shared_ptr<pv::data::Segment> > segments;
+		pv::util::Timestamp offset;
+		pair<int, int> extents;
+		vector<SegmentExtent> data;
+		ViewItemPaintParams::Quality quality;
+		ViewItemPaintParams::DisplaySettings display_settings;
+		bool profiling;
+		uint64_t generation;
+	};
+
+public:
+	TileCache();
+	~TileCache();
+
+	/**
+	 * Starts painting a new frame. Drops the render jobs that were queued
+	 * for the previous frame and have not been started yet.
+	 */
+	void begin_frame();
+
+	/**
+	 * Paints the mid-layer of a signal from its tiles and queues the tiles
+	 * that are missing or out of date for rendering.
+	 * @param p the QPainter to paint into.
+	 * @param pp the painting parameters of the viewport. The tiles are
+	 * 	rendered at the quality of the parameters.
+	 * @param signal the signal to paint.
+	 */
+	void paint(QPainter &p, const ViewItemPaintParams &pp,
+		const shared_ptr<Signal> &signal);
+
+	/**
+	 * Marks all tiles as out of date. They are shown until they have been
+	 * rendered again.
+	 */
+	void invalidate();
+
+	/**
+	 * Discards all tiles.
+	 */
+	void clear();
+
+	/**
+	 * Estimates the time in milliseconds that the render threads need to
+	 * render the tiles queued by the current frame.
+	 */
+	double frame_render_time();
+
+	/**
+	 * Returns true if tiles are queued or being rendered.
+	 */
+	bool busy();
+
+	/**
+	 * Gets the number of tiles painted by the current frame that were
+	 * current, and that were missing or out of date.
+	 */
+	void frame_tile_counts(unsigned int &hits, unsigned int &misses);
+
+	/**
+	 * Starts or stops collecting the statistics of the rendered tiles.
+	 */
+	void set_profiling(bool profiling);
+
+	/**
+	 * Takes the statistics of the tiles rendered since the last call.
+	 */
+	map<const Signal*, RenderStatistics> take_render_statistics();
+
+Q_SIGNALS:
+	/**
+	 * Emitted from a render thread when tiles have been rendered.
+	 */
+	void tiles_ready();
+
+private:
+	/**
+	 * Gets the extents of the samples of the segments that a signal is
+	 * painted from.
+	 */
+	static vector<SegmentExtent> data_extents(
+		const vector< shared_ptr<pv::data::Segment> > &segments);
+
+	/**
+	 * Checks that a tile still shows the samples it was rendered from,
+	 * i.e. that they have not changed, or that samples have only been
+	 * appended beyond the end of the tile.
+	 * @param rendered the extents of the samples of the tile.
+	 * @param current the extents of the samples now.
+	 * @param tile_end the time of the right edge of the tile.
+	 */
+	static bool data_current(const vector<SegmentExtent> &rendered,
+		const vector<SegmentExtent> &current, double tile_end);
+
+	void render_proc();
+
+	void store(const Job &job, const QImage &image);
+
+	/**
+	 * Evicts the least recently used tiles until the cache fits into the
+	 * memory budget again. Must be called with @c mutex_ held.
+	 */
+	void evict();
+
+private:
+	mutex mutex_;
+	condition_variable jobs_cond_;
+	bool quit_;
+
+	map<Key, Tile> tiles_;
+	list<Key> lru_;
+	size_t memory_used_;
+
+	deque<Job> jobs_;
+
+	/// The number of jobs that the render threads are working on
+	unsigned int active_job_count_;
+
+	/// The finished jobs. They are released in the GUI thread as their
+	/// signal and segments must not be destroyed by a render thread.
+	vector<Job> retired_;
+
+	uint64_t generation_, cleared_generation_;
+	uint64_t frame_;
+
+	/// The number of tiles queued by the current frame
+	unsigned int frame_job_count_;
+
+	unsigned int frame_tile_hits_, frame_tile_misses_;
+
+	bool profiling_;
+	map<const Signal*, RenderStatistics> render_statistics_;
+
+	/// Moving average of the time in milliseconds to render a tile
+	double tile_render_time_;
+
+	atomic<bool> update_pending_;
+
+	vector<std::thread> threads_;
+};
+
+} // namespace TraceView
+} // namespace views
+} // namespace pv
+
+#endif // PULSEVIEW_PV_VIEWS_TRACEVIEW_TILECACHE_HPP
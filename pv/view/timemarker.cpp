@@ -48,6 +48,7 @@ TimeMarker::TimeMarker(
 	TimeItem(view),
 	colour_(colour),
 	time_(time),
+	fixed_time_(time),
 	value_action_(nullptr),
 	value_widget_(nullptr),
 	updating_value_widget_(false)
@@ -62,6 +63,7 @@ const pv::util::Timestamp& TimeMarker::time() const
 void TimeMarker::set_time(const pv::util::Timestamp& time)
 {
 	time_ = time;
+	fixed_time_ = pv::util::FixedTimestamp(time);
 
 	if (value_widget_) {
 		updating_value_widget_ = true;
@@ -74,7 +76,8 @@ void TimeMarker::set_time(const pv::util::Timestamp& time)
 
 float TimeMarker::get_x() const
 {
-	return std::roundf(((time_ - view_.offset()) / view_.scale()).convert_to<float>()) + 0.5f;
+	return std::roundf((fixed_time_ - view_.fixed_offset()).to_double() /
+		view_.scale()) + 0.5f;
 }
 
 QPoint TimeMarker::point(const QRect &rect) const
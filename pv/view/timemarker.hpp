@@ -119,6 +119,7 @@ protected:
 	const QColor &colour_;
 
 	pv::util::Timestamp time_;
+	pv::util::FixedTimestamp fixed_time_;
 
 	QSizeF text_size_;
 
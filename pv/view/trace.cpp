@@ -223,6 +223,11 @@ void Trace::populate_popup_form(QWidget *parent, QFormLayout *form)
 	add_colour_option(parent, form);
 }
 
+QString Trace::name() const
+{
+	return base_->name();
+}
+
 void Trace::set_name(QString name)
 {
 	base_->set_name(name);
@@ -60,6 +60,11 @@ protected:
 	Trace(shared_ptr<data::SignalBase> channel);
 
 public:
+	/**
+	 * Gets the name of the signal.
+	 */
+	QString name() const;
+
 	/**
 	 * Sets the name of the signal.
 	 */
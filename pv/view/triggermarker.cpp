@@ -28,13 +28,15 @@ const QColor TriggerMarker::Colour(0x00, 0x00, 0xB0);
 
 TriggerMarker::TriggerMarker(View &view, const pv::util::Timestamp& time) :
 	TimeItem(view),
-	time_(time)
+	time_(time),
+	fixed_time_(time)
 {
 }
 
 TriggerMarker::TriggerMarker(const TriggerMarker &marker) :
 	TimeItem(marker.view_),
-	time_(marker.time_)
+	time_(marker.time_),
+	fixed_time_(marker.fixed_time_)
 {
 }
 
@@ -51,13 +53,14 @@ bool TriggerMarker::is_draggable() const
 void TriggerMarker::set_time(const pv::util::Timestamp& time)
 {
 	time_ = time;
+	fixed_time_ = pv::util::FixedTimestamp(time);
 
 	view_.time_item_appearance_changed(true, true);
 }
 
 float TriggerMarker::get_x() const
 {
-	return ((time_ - view_.offset()) / view_.scale()).convert_to<float>();
+	return (fixed_time_ - view_.fixed_offset()).to_double() / view_.scale();
 }
 
 QPoint TriggerMarker::point(const QRect &rect) const
@@ -78,6 +78,7 @@ public:
 
 private:
 	pv::util::Timestamp time_;
+	pv::util::FixedTimestamp fixed_time_;
 };
 
 } // namespace TraceView
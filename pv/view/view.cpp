@@ -47,6 +47,7 @@
 #include "analogsignal.hpp"
 #include "header.hpp"
 #include "logicsignal.hpp"
+#include "overview.hpp"
 #include "ruler.hpp"
 #include "signal.hpp"
 #include "tracegroup.hpp"
@@ -132,6 +133,7 @@ bool CustomAbstractScrollArea::viewportEvent(QEvent *event)
 View::View(Session &session, bool is_main_view, QWidget *parent) :
 	ViewBase(session, is_main_view, parent),
 	viewport_(new Viewport(*this)),
+	overview_(new Overview(*this)),
 	ruler_(new Ruler(*this)),
 	header_(new Header(*this)),
 	scrollarea_(this),
@@ -200,6 +202,7 @@ View::View(Session &session, bool is_main_view, QWidget *parent) :
 	signals_changed();
 
 	// make sure the transparent widgets are on the top
+	overview_->raise();
 	ruler_->raise();
 	header_->raise();
 
@@ -232,6 +235,21 @@ void View::add_signal(const shared_ptr<Signal> signal)
 	signals_.insert(signal);
 }
 
+void View::add_math_signal(shared_ptr<data::SignalBase> signalbase)
+{
+	signals_.insert(make_shared<AnalogSignal>(session_, signalbase));
+}
+
+void View::remove_math_signal(shared_ptr<data::SignalBase> signalbase)
+{
+	for (auto i = signals_.begin(); i != signals_.end(); i++)
+		if ((*i)->base() == signalbase) {
+			signals_.erase(i);
+			signals_changed();
+			return;
+		}
+}
+
 #ifdef ENABLE_DECODE
 void View::clear_decode_signals()
 {
@@ -359,10 +377,16 @@ const Timestamp& View::offset() const
 	return offset_;
 }
 
+const pv::util::FixedTimestamp& View::fixed_offset() const
+{
+	return fixed_offset_;
+}
+
 void View::set_offset(const pv::util::Timestamp& offset)
 {
 	if (offset_ != offset) {
 		offset_ = offset;
+		fixed_offset_ = pv::util::FixedTimestamp(offset);
 		Q_EMIT offset_changed();
 	}
 }
@@ -558,6 +582,7 @@ void View::enable_show_sampling_points(bool state)
 {
 	(void)state;
 
+	viewport_->invalidate_tiles();
 	viewport_->update();
 }
 
@@ -565,9 +590,15 @@ void View::enable_show_analog_minor_grid(bool state)
 {
 	(void)state;
 
+	viewport_->invalidate_tiles();
 	viewport_->update();
 }
 
+void View::enable_show_render_profile(bool state)
+{
+	viewport_->show_render_profile(state);
+}
+
 void View::enable_coloured_bg(bool state)
 {
 	coloured_bg_ = state;
@@ -829,10 +860,14 @@ void View::set_scroll_default()
 
 void View::update_layout()
 {
+	const int overview_height = overview_->sizeHint().height();
+
 	scrollarea_.setViewportMargins(
 		header_->sizeHint().width() - Header::BaselineOffset,
-		ruler_->sizeHint().height(), 0, 0);
-	ruler_->setGeometry(viewport_->x(), 0,
+		overview_height + ruler_->sizeHint().height(), 0, 0);
+	overview_->setGeometry(viewport_->x(), 0,
+		viewport_->width(), overview_height);
+	ruler_->setGeometry(viewport_->x(), overview_height,
 		viewport_->width(), ruler_->extended_size_hint().height());
 	header_->setGeometry(0, viewport_->y(),
 		header_->extended_size_hint().width(), viewport_->height());
@@ -973,10 +1008,15 @@ void View::resizeEvent(QResizeEvent*)
 
 void View::row_item_appearance_changed(bool label, bool content)
 {
+	// The items may have been moved
+	viewport_->row_items_changed();
+
 	if (label)
 		header_->update();
-	if (content)
+	if (content) {
+		viewport_->invalidate_tiles();
 		viewport_->update();
+	}
 }
 
 void View::time_item_appearance_changed(bool label, bool content)
@@ -989,6 +1029,8 @@ void View::time_item_appearance_changed(bool label, bool content)
 
 void View::extents_changed(bool horz, bool vert)
 {
+	viewport_->row_items_changed();
+
 	sticky_events_ |=
 		(horz ? TraceTreeItemHExtentsChanged : 0) |
 		(vert ? TraceTreeItemVExtentsChanged : 0);
@@ -1040,6 +1082,9 @@ void View::signals_changed()
 		(scrollarea_.verticalScrollBar()->minimum() ==
 			scrollarea_.verticalScrollBar()->maximum());
 
+	viewport_->clear_tiles();
+	viewport_->row_items_changed();
+
 	if (!session_.device()) {
 		reset_scroll();
 		signals_.clear();
@@ -1192,6 +1237,8 @@ void View::signals_changed()
 
 	update_layout();
 
+	overview_->update_summaries();
+	overview_->update();
 	header_->update();
 	viewport_->update();
 
@@ -1237,6 +1284,13 @@ void View::capture_state_updated(int state)
 
 void View::data_updated()
 {
+	// While capturing, samples are only appended, which the viewport
+	// detects by itself so that it only renders the end of the samples
+	if (session_.get_capture_state() != Session::Running)
+		viewport_->invalidate_tiles();
+
+	overview_->schedule_summary_update();
+
 	if (always_zoom_to_fit_ || sticky_scrolling_) {
 		if (!delayed_view_updater_.isActive())
 			delayed_view_updater_.start();
@@ -61,6 +61,7 @@ namespace TraceView {
 class CursorHeader;
 class DecodeTrace;
 class Header;
+class Overview;
 class Ruler;
 class Signal;
 class Trace;
@@ -111,6 +112,10 @@ public:
 
 	virtual void add_signal(const shared_ptr<Signal> signal);
 
+	virtual void add_math_signal(shared_ptr<data::SignalBase> signalbase);
+
+	virtual void remove_math_signal(shared_ptr<data::SignalBase> signalbase);
+
 #ifdef ENABLE_DECODE
 	virtual void clear_decode_signals();
 
@@ -153,6 +158,11 @@ public:
 	 */
 	const pv::util::Timestamp& offset() const;
 
+	/**
+	 * Returns the time offset as a fixed-point value for painting.
+	 */
+	const pv::util::FixedTimestamp& fixed_offset() const;
+
 	/**
 	 * Returns the vertical scroll offset.
 	 */
@@ -227,6 +237,11 @@ public:
 	 */
 	void enable_show_analog_minor_grid(bool state);
 
+	/**
+	 * Enable or disable showing the render profile overlay.
+	 */
+	void enable_show_render_profile(bool state);
+
 	/**
 	 * Returns true if cursors are displayed. false otherwise.
 	 */
@@ -398,6 +413,7 @@ private Q_SLOTS:
 
 private:
 	Viewport *viewport_;
+	Overview *overview_;
 	Ruler *ruler_;
 	Header *header_;
 
@@ -414,6 +430,7 @@ private:
 
 	/// The view time offset in seconds.
 	pv::util::Timestamp offset_;
+	pv::util::FixedTimestamp fixed_offset_;
 
 	bool updating_scroll_;
 	bool sticky_scrolling_;
@@ -28,12 +28,21 @@ namespace pv {
 namespace views {
 namespace TraceView {
 
+const float ViewItemPaintParams::DraftDetailReduction = 4.0f;
+
 ViewItemPaintParams::ViewItemPaintParams(
-	const QRect &rect, double scale, const pv::util::Timestamp& offset) :
+	const QRect &rect, double scale, const pv::util::Timestamp& offset,
+	Quality quality) :
 	rect_(rect),
 	scale_(scale),
 	offset_(offset),
-	bg_colour_state_(false)
+	fixed_offset_(offset),
+	pixels_offset_(fixed_offset_.to_double() / scale),
+	quality_(quality),
+	display_settings_{false, false},
+	bg_colour_state_(false),
+	profiling_(false),
+	statistics_{0, 0, 0, 0}
 {
 	assert(scale > 0.0);
 }
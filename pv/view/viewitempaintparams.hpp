@@ -22,6 +22,8 @@
 
 #include "pv/util.hpp"
 
+#include <cstdint>
+
 #include <QFont>
 #include <QRect>
 
@@ -31,9 +33,50 @@ namespace TraceView {
 
 class ViewItemPaintParams
 {
+public:
+	/**
+	 * The fidelity that the items are painted with. The lower levels are
+	 * used to keep the view responsive while the user is interacting.
+	 */
+	enum Quality {
+		/// No antialiasing or sampling points, coarser data levels
+		QualityDraft,
+		/// No antialiasing or sampling points
+		QualityFast,
+		QualityFull
+	};
+
+	/// The factor by which the draft quality reduces the data detail
+	static const float DraftDetailReduction;
+
+	/**
+	 * What the items did to paint, for the render profile.
+	 */
+	struct Statistics
+	{
+		/// The number of edges, samples or annotations fetched
+		uint64_t fetched;
+		/// The time in nanoseconds spent fetching them
+		int64_t fetch_time;
+		uint64_t cache_hits;
+		uint64_t cache_misses;
+	};
+
+	/**
+	 * The display settings that items are painted with. They are read
+	 * once per frame by the viewport, as the render threads must not
+	 * access the settings.
+	 */
+	struct DisplaySettings
+	{
+		bool show_sampling_points;
+		bool show_analog_minor_grid;
+	};
+
 public:
 	ViewItemPaintParams(
-		const QRect &rect, double scale, const pv::util::Timestamp& offset);
+		const QRect &rect, double scale, const pv::util::Timestamp& offset,
+		Quality quality = QualityFull);
 
 	QRect rect() const {
 		return rect_;
@@ -47,6 +90,10 @@ public:
 		return offset_;
 	}
 
+	const pv::util::FixedTimestamp& fixed_offset() const {
+		return fixed_offset_;
+	}
+
 	int left() const {
 		return rect_.left();
 	}
@@ -72,7 +119,57 @@ public:
 	}
 
 	double pixels_offset() const {
-		return (offset_ / scale_).convert_to<double>();
+		return pixels_offset_;
+	}
+
+	Quality quality() const {
+		return quality_;
+	}
+
+	/**
+	 * Gets the factor by which items may reduce the detail of the data
+	 * they paint, e.g. by using a coarser mipmap level.
+	 */
+	float detail_reduction() const {
+		return (quality_ == QualityDraft) ? DraftDetailReduction : 1.0f;
+	}
+
+	const DisplaySettings& display_settings() const {
+		return display_settings_;
+	}
+
+	void set_display_settings(const DisplaySettings &settings) {
+		display_settings_ = settings;
+	}
+
+	/**
+	 * Returns true if the items should record what they did to paint,
+	 * see add_fetched().
+	 */
+	bool profiling() const {
+		return profiling_;
+	}
+
+	void set_profiling(bool profiling) {
+		profiling_ = profiling;
+	}
+
+	const Statistics& statistics() const {
+		return statistics_;
+	}
+
+	/**
+	 * Records that @c count edges, samples or annotations were fetched
+	 * from the data in @c nsecs nanoseconds.
+	 */
+	void add_fetched(uint64_t count, int64_t nsecs) {
+		statistics_.fetched += count;
+		statistics_.fetch_time += nsecs;
+	}
+
+	void add_cache_lookups(uint64_t hits, uint64_t misses) {
+		statistics_.cache_hits += hits;
+		statistics_.cache_misses += misses;
 	}
 
 	bool next_bg_colour_state() {
@@ -90,7 +187,13 @@ private:
 	QRect rect_;
 	double scale_;
 	pv::util::Timestamp offset_;
+	pv::util::FixedTimestamp fixed_offset_;
+	double pixels_offset_;
+	Quality quality_;
+	DisplaySettings display_settings_;
 	bool bg_colour_state_;
+	bool profiling_;
+	Statistics statistics_;
 };
 
 } // namespace TraceView
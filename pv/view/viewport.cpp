@@ -27,8 +27,10 @@
 #include "viewitempaintparams.hpp"
 #include "viewport.hpp"
 
+#include <pv/globalsettings.hpp>
 #include <pv/session.hpp>
 
+#include <QElapsedTimer>
 #include <QMouseEvent>
 
 #include <QDebug>
@@ -38,6 +40,7 @@ using std::back_inserter;
 using std::copy;
 using std::dynamic_pointer_cast;
 using std::none_of; // Used in assert()s.
+using std::pair;
 using std::shared_ptr;
 using std::stable_sort;
 using std::vector;
@@ -46,12 +49,53 @@ namespace pv {
 namespace views {
 namespace TraceView {
 
+const double Viewport::FrameBudget = 1000.0 / 30;
+const int Viewport::IdleDelay = 250;
+
 Viewport::Viewport(View &parent) :
 	ViewWidget(parent),
-	pinch_zoom_active_(false)
+	pinch_zoom_active_(false),
+	interactive_(false),
+	interactive_quality_(ViewItemPaintParams::QualityFast),
+	row_items_dirty_(true)
 {
 	setAutoFillBackground(true);
 	setBackgroundRole(QPalette::Base);
+
+	connect(&tile_cache_, SIGNAL(tiles_ready()), this, SLOT(update()));
+	tile_cache_.set_profiling(render_profile_.enabled());
+
+	idle_timer_.setSingleShot(true);
+	idle_timer_.setInterval(IdleDelay);
+	connect(&idle_timer_, SIGNAL(timeout()), this, SLOT(on_input_idle()));
+}
+
+void Viewport::invalidate_tiles()
+{
+	tile_cache_.invalidate();
+}
+
+void Viewport::clear_tiles()
+{
+	tile_cache_.clear();
+}
+
+void Viewport::row_items_changed()
+{
+	row_items_.clear();
+	row_items_dirty_ = true;
+}
+
+void Viewport::show_render_profile(bool show)
+{
+	render_profile_.set_overlay_shown(show);
+	tile_cache_.set_profiling(render_profile_.enabled());
+	update();
+}
+
+bool Viewport::rendering()
+{
+	return tile_cache_.busy();
 }
 
 shared_ptr<ViewItem> Viewport::get_mouse_over_item(const QPoint &pt)
@@ -84,6 +128,8 @@ void Viewport::drag_by(const QPoint &delta)
 	if (drag_offset_ == boost::none)
 		return;
 
+	input_active();
+
 	view_.set_scale_offset(view_.scale(),
 		(*drag_offset_ - delta.x() * view_.scale()));
 
@@ -125,6 +171,8 @@ bool Viewport::touch_event(QTouchEvent *event)
 		pinch_zoom_active_ = true;
 	}
 
+	input_active();
+
 	double w = touchPoint1.pos().x() - touchPoint0.pos().x();
 	if (abs(w) >= 1.0) {
 		const double scale =
@@ -151,6 +199,20 @@ bool Viewport::touch_event(QTouchEvent *event)
 	return true;
 }
 
+void Viewport::input_active()
+{
+	interactive_ = true;
+	idle_timer_.start();
+}
+
+void Viewport::adapt_quality(double frame_time)
+{
+	if (frame_time > FrameBudget)
+		interactive_quality_ = ViewItemPaintParams::QualityDraft;
+	else if (frame_time < FrameBudget / 2)
+		interactive_quality_ = ViewItemPaintParams::QualityFast;
+}
+
 void Viewport::paintEvent(QPaintEvent*)
 {
 	typedef void (ViewItem::*LayerPaintFunc)(
@@ -159,33 +221,125 @@ void Viewport::paintEvent(QPaintEvent*)
 		&ViewItem::paint_back, &ViewItem::paint_mid,
 		&ViewItem::paint_fore, nullptr};
 
-	vector< shared_ptr<RowItem> > row_items(view_.list_by_type<RowItem>());
-	assert(none_of(row_items.begin(), row_items.end(),
-		[](const shared_ptr<RowItem> &r) { return !r; }));
+	const bool profiling = render_profile_.enabled();
+	if (profiling)
+		render_profile_.begin_frame();
+
+	if (row_items_dirty_) {
+		row_items_ = view_.list_by_type<RowItem>();
+		assert(none_of(row_items_.begin(), row_items_.end(),
+			[](const shared_ptr<RowItem> &r) { return !r; }));
+
+		stable_sort(row_items_.begin(), row_items_.end(),
+			[](const shared_ptr<RowItem> &a, const shared_ptr<RowItem> &b) {
+				return a->point(QRect()).y() < b->point(QRect()).y(); });
 
-	stable_sort(row_items.begin(), row_items.end(),
-		[](const shared_ptr<RowItem> &a, const shared_ptr<RowItem> &b) {
-			return a->point(QRect()).y() < b->point(QRect()).y(); });
+		row_items_dirty_ = false;
+	}
+
+	// Skip the trace tree items that are scrolled out of view
+	vector<bool> row_visible;
+	row_visible.reserve(row_items_.size());
+	for (const shared_ptr<RowItem> &r : row_items_) {
+		const shared_ptr<TraceTreeItem> t =
+			dynamic_pointer_cast<TraceTreeItem>(r);
+		if (t) {
+			const int y = t->get_visual_y();
+			const pair<int, int> extents = t->v_extents();
+			row_visible.push_back(y + extents.second >= 0 &&
+				y + extents.first < height());
+		} else
+			row_visible.push_back(true);
+	}
 
 	const vector< shared_ptr<TimeItem> > time_items(view_.time_items());
 	assert(none_of(time_items.begin(), time_items.end(),
 		[](const shared_ptr<TimeItem> &t) { return !t; }));
 
+	if (profiling)
+		render_profile_.end_layout();
+
+	const ViewItemPaintParams::Quality quality = interactive_ ?
+		interactive_quality_ : ViewItemPaintParams::QualityFull;
+
+	GlobalSettings settings;
+	const ViewItemPaintParams::DisplaySettings display_settings = {
+		settings.value(GlobalSettings::Key_View_ShowSamplingPoints).toBool(),
+		settings.value(GlobalSettings::Key_View_ShowAnalogMinorGrid).toBool()};
+
+	QElapsedTimer frame_timer;
+	frame_timer.start();
+
+	tile_cache_.begin_frame();
+
 	QPainter p(this);
-	p.setRenderHint(QPainter::Antialiasing);
+	p.setRenderHint(QPainter::Antialiasing,
+		quality == ViewItemPaintParams::QualityFull);
 
 	for (LayerPaintFunc *paint_func = layer_paint_funcs;
 			*paint_func; paint_func++) {
-		ViewItemPaintParams time_pp(rect(), view_.scale(), view_.offset());
-		for (const shared_ptr<TimeItem> t : time_items)
+		const RenderProfile::Layer layer =
+			(RenderProfile::Layer)(paint_func - layer_paint_funcs);
+
+		ViewItemPaintParams time_pp(rect(), view_.scale(), view_.offset(),
+			quality);
+		time_pp.set_profiling(profiling);
+		for (const shared_ptr<TimeItem> t : time_items) {
+			if (profiling)
+				render_profile_.begin_item(time_pp);
+
 			(t.get()->*(*paint_func))(p, time_pp);
 
-		ViewItemPaintParams row_pp(rect(), view_.scale(), view_.offset());
-		for (const shared_ptr<RowItem> r : row_items)
-			(r.get()->*(*paint_func))(p, row_pp);
+			if (profiling)
+				render_profile_.end_item(*t, layer, time_pp);
+		}
+
+		// The mid-layer of signals is composited from the tile cache
+		ViewItemPaintParams row_pp(rect(), view_.scale(), view_.offset(),
+			quality);
+		row_pp.set_display_settings(display_settings);
+		row_pp.set_profiling(profiling);
+		for (size_t i = 0; i < row_items_.size(); i++) {
+			const shared_ptr<RowItem> &r = row_items_[i];
+
+			if (!row_visible[i]) {
+				// Keep the alternating background colours in step
+				if (*paint_func == &ViewItem::paint_back &&
+					r->enabled() && dynamic_pointer_cast<Trace>(r))
+					row_pp.next_bg_colour_state();
+				continue;
+			}
+
+			if (profiling)
+				render_profile_.begin_item(row_pp);
+
+			const shared_ptr<Signal> s = dynamic_pointer_cast<Signal>(r);
+			if (s && *paint_func == &ViewItem::paint_mid)
+				tile_cache_.paint(p, row_pp, s);
+			else
+				(r.get()->*(*paint_func))(p, row_pp);
+
+			if (profiling)
+				render_profile_.end_item(*r, layer, row_pp);
+		}
+	}
+
+	const double paint_time = frame_timer.nsecsElapsed() / 1e6;
+
+	if (profiling) {
+		unsigned int tile_hits, tile_misses;
+		tile_cache_.frame_tile_counts(tile_hits, tile_misses);
+		render_profile_.add_tiles(tile_hits, tile_misses,
+			tile_cache_.take_render_statistics());
+		render_profile_.end_frame(p, rect());
 	}
 
 	p.end();
+
+	// The signal tiles are rendered in the background, so the time that
+	// takes counts towards the frame as well
+	if (interactive_)
+		adapt_quality(paint_time + tile_cache_.frame_render_time());
 }
 
 void Viewport::mouseDoubleClickEvent(QMouseEvent *event)
@@ -202,6 +356,8 @@ void Viewport::wheelEvent(QWheelEvent *event)
 {
 	assert(event);
 
+	input_active();
+
 	if (event->orientation() == Qt::Vertical) {
 		if (event->modifiers() & Qt::ControlModifier) {
 			// Vertical scrolling with the control key pressed
@@ -219,6 +375,12 @@ void Viewport::wheelEvent(QWheelEvent *event)
 	}
 }
 
+void Viewport::on_input_idle()
+{
+	interactive_ = false;
+	update();
+}
+
 } // namespace TraceView
 } // namespace views
 } // namespace pv
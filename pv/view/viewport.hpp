@@ -26,6 +26,9 @@
 #include <QTouchEvent>
 
 #include "pv/util.hpp"
+#include "renderprofile.hpp"
+#include "tilecache.hpp"
+#include "viewitempaintparams.hpp"
 #include "viewwidget.hpp"
 
 using std::shared_ptr;
@@ -45,9 +48,46 @@ class Viewport : public ViewWidget
 {
 	Q_OBJECT
 
+private:
+	/// The time in milliseconds that an interactive frame should take
+	static const double FrameBudget;
+
+	/// The time in milliseconds without input after which the view is
+	/// painted at full quality again
+	static const int IdleDelay;
+
 public:
 	explicit Viewport(View &parent);
 
+	/**
+	 * Marks the rendered signal tiles as out of date after the data or
+	 * the appearance of the signals has changed.
+	 */
+	void invalidate_tiles();
+
+	/**
+	 * Discards the rendered signal tiles after signals have been added
+	 * or removed.
+	 */
+	void clear_tiles();
+
+	/**
+	 * Discards the cached list of row items after items have been added,
+	 * removed or moved.
+	 */
+	void row_items_changed();
+
+	/**
+	 * Shows or hides the overlay of the render profile.
+	 */
+	void show_render_profile(bool show);
+
+	/**
+	 * Returns true while signal tiles are queued or being rendered, i.e.
+	 * until the view can be painted completely.
+	 */
+	bool rendering();
+
 private:
 	/**
 	 * Indicates when a view item is being hovered over.
@@ -91,12 +131,27 @@ private:
 	 */
 	bool touch_event(QTouchEvent *event);
 
+	/**
+	 * Paints the view at the interactive quality until there has been no
+	 * input for @c IdleDelay milliseconds.
+	 */
+	void input_active();
+
+	/**
+	 * Adapts the interactive quality to the time that a frame took.
+	 * @param frame_time the time of the frame in milliseconds.
+	 */
+	void adapt_quality(double frame_time);
+
 private:
 	void paintEvent(QPaintEvent *event);
 
 	void mouseDoubleClickEvent(QMouseEvent *event);
 	void wheelEvent(QWheelEvent *event);
 
+private Q_SLOTS:
+	void on_input_idle();
+
 private:
 	boost::optional<pv::util::Timestamp> drag_offset_;
 	int drag_v_offset_;
@@ -104,6 +159,18 @@ private:
 	double pinch_offset0_;
 	double pinch_offset1_;
 	bool pinch_zoom_active_;
+
+	TileCache tile_cache_;
+
+	QTimer idle_timer_;
+	bool interactive_;
+	ViewItemPaintParams::Quality interactive_quality_;
+
+	RenderProfile render_profile_;
+
+	/// The row items sorted by their visual position.
+	vector< shared_ptr<RowItem> > row_items_;
+	bool row_items_dirty_;
 };
 
 } // namespace TraceView
@@ -62,6 +62,16 @@ void ViewBase::clear_signals()
 {
 }
 
+void ViewBase::add_math_signal(shared_ptr<data::SignalBase> signalbase)
+{
+	(void)signalbase;
+}
+
+void ViewBase::remove_math_signal(shared_ptr<data::SignalBase> signalbase)
+{
+	(void)signalbase;
+}
+
 #ifdef ENABLE_DECODE
 void ViewBase::clear_decode_signals()
 {
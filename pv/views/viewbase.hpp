@@ -61,6 +61,10 @@ public:
 
 	virtual void clear_signals();
 
+	virtual void add_math_signal(shared_ptr<data::SignalBase> signalbase);
+
+	virtual void remove_math_signal(shared_ptr<data::SignalBase> signalbase);
+
 #ifdef ENABLE_DECODE
 	virtual void clear_decode_signals();
 
@@ -21,11 +21,13 @@
 #define PULSEVIEW_PV_WIDGETS_IMPORTMENU_HPP
 
 #include <memory>
+#include <vector>
 
 #include <QMenu>
 #include <QSignalMapper>
 
 using std::shared_ptr;
+using std::vector;
 
 namespace sigrok {
 class Context;
@@ -41,7 +43,7 @@ class ImportMenu : public QMenu
 
 public:
 	ImportMenu(QWidget *parent, shared_ptr<sigrok::Context> context,
-		QAction *open_action = nullptr);
+		vector<QAction *>open_actions = vector<QAction *>());
 
 private Q_SLOTS:
 	void on_action(QObject *action);
@@ -0,0 +1,336 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Renders the trace view offscreen at a sweep of zoom levels and channel
+ * counts, and prints the frame rates and the cost of painting each trace
+ * as JSON. Runs without a display on the offscreen Qt platform.
+ * Build with "make pulseview-bench-render".
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QThread>
+
+#include <libsigrokcxx/libsigrokcxx.hpp>
+
+#include "pv/devicemanager.hpp"
+#include "pv/session.hpp"
+#include "pv/data/signalbase.hpp"
+#include "pv/devices/textfile.hpp"
+#include "pv/view/signal.hpp"
+#include "pv/view/view.hpp"
+#include "pv/view/viewitempaintparams.hpp"
+#include "pv/view/viewport.hpp"
+
+using std::atomic;
+using std::fprintf;
+using std::make_shared;
+using std::map;
+using std::max;
+using std::pair;
+using std::printf;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+using pv::data::SignalBase;
+using pv::util::Timestamp;
+using pv::views::TraceView::Signal;
+using pv::views::TraceView::View;
+using pv::views::TraceView::ViewItemPaintParams;
+using pv::views::TraceView::Viewport;
+
+namespace {
+
+const int Width = 1920;
+const int Height = 1080;
+
+const uint64_t SampleCount = 1 << 20;
+const uint64_t SampleRate = 1000000;
+const unsigned int LogicChannelCount = 16;
+const unsigned int AnalogChannelCount = 4;
+
+/// The logic and analog channels that are enabled in the runs
+const pair<unsigned int, unsigned int> ChannelCounts[] = {
+	{1, 0}, {4, 0}, {16, 0}, {0, 1}, {0, 4}, {16, 4}};
+
+/// The zoom levels of the runs
+const double SamplesPerPixel[] = {0.25, 4, 64, 512};
+
+/// The number of frames painted from complete tiles in a run
+const int FrameCount = 50;
+
+/// The number of times the mid-layer of each trace is painted in a run
+const int TracePaintCount = 5;
+
+/**
+ * Writes the samples as CSV. Logic channel n toggles every 2^n samples,
+ * from a clock down to a few edges per view. The analog channels are sine
+ * waves of different periods with some noise.
+ */
+bool write_samples(const QString &path)
+{
+	FILE *const f = fopen(path.toLocal8Bit().constData(), "w");
+	if (!f)
+		return false;
+
+	for (unsigned int i = 0; i < LogicChannelCount; i++)
+		fprintf(f, "D%u,", i);
+	for (unsigned int i = 0; i < AnalogChannelCount; i++)
+		fprintf(f, (i + 1 < AnalogChannelCount) ? "A%u," : "A%u\n", i);
+
+	uint32_t noise = 1;
+	for (uint64_t s = 0; s < SampleCount; s++) {
+		for (unsigned int i = 0; i < LogicChannelCount; i++)
+			fprintf(f, "%d,", (int)((s >> i) & 1));
+
+		for (unsigned int i = 0; i < AnalogChannelCount; i++) {
+			noise = noise * 1103515245 + 12345;
+			const double value = sin(2 * M_PI * s / (1000 << i)) +
+				((noise >> 16) & 0xff) / 2560.0;
+			fprintf(f, (i + 1 < AnalogChannelCount) ? "%.4f," : "%.4f\n",
+				value);
+		}
+	}
+
+	return fclose(f) == 0;
+}
+
+/**
+ * Processes the events that changing the view posts, e.g. its layout.
+ */
+void settle()
+{
+	for (int i = 0; i < 10; i++) {
+		QCoreApplication::processEvents();
+		QThread::msleep(1);
+	}
+}
+
+/**
+ * Imports the samples into the session and waits until they are loaded.
+ */
+bool load(pv::Session &session, const shared_ptr<sigrok::Context> &context,
+	const QString &path)
+{
+	const map<string, Glib::VariantBase> options = {
+		{"samplerate", Glib::Variant<guint64>::create(SampleRate)}};
+
+	session.set_device(make_shared<pv::devices::TextFile>(
+		context, path.toStdString(), "csv", options));
+
+	QEventLoop loop;
+	QObject::connect(&session, &pv::Session::capture_state_changed, &loop,
+		[&](int state) {
+			if (state == pv::Session::Stopped)
+				loop.quit(); });
+
+	atomic<bool> failed(false);
+	session.start_capture([&](const QString message) {
+		fprintf(stderr, "Failed to load the samples: %s\n",
+			qPrintable(message));
+		failed = true; });
+
+	if (!failed)
+		loop.exec();
+
+	return !failed;
+}
+
+/**
+ * Enables the first @c logic_count logic and @c analog_count analog
+ * channels, and disables the others.
+ */
+void enable_channels(View &view, unsigned int logic_count,
+	unsigned int analog_count)
+{
+	for (const shared_ptr<Signal> &signal : view.signals()) {
+		const shared_ptr<SignalBase> base = signal->base();
+		if (base->type() == SignalBase::LogicChannel)
+			base->set_enabled(base->index() < logic_count);
+		else
+			base->set_enabled(
+				base->index() - LogicChannelCount < analog_count);
+	}
+
+	settle();
+}
+
+/**
+ * Measures painting the view at a zoom level.
+ */
+QJsonObject run(View &view, double samples_per_pixel)
+{
+	Viewport *const viewport = view.viewport();
+
+	// Show the middle of the samples
+	const double scale = samples_per_pixel / SampleRate;
+	const double length = (double)SampleCount / SampleRate;
+	view.set_scale_offset(scale,
+		Timestamp(max((length - scale * viewport->width()) / 2, 0.0)));
+	settle();
+
+	QImage image(viewport->size(), QImage::Format_ARGB32_Premultiplied);
+	QElapsedTimer timer;
+
+	// Paint from scratch until the tiles of all traces have been rendered
+	viewport->clear_tiles();
+	timer.start();
+	while (true) {
+		viewport->render(&image);
+		if (!viewport->rendering())
+			break;
+		while (viewport->rendering())
+			QThread::usleep(100);
+	}
+	const double complete_time = timer.nsecsElapsed() / 1e6;
+
+	// Paint from the complete tiles, as while scrolling or hovering
+	timer.start();
+	for (int i = 0; i < FrameCount; i++)
+		viewport->render(&image);
+	const double frame_time = timer.nsecsElapsed() / 1e6 / FrameCount;
+
+	// Paint the mid-layer of each trace over the whole width at once, as
+	// the render threads do for each tile
+	QJsonArray traces;
+	for (const shared_ptr<Signal> &signal : view.signals()) {
+		if (!signal->enabled())
+			continue;
+
+		const pair<int, int> extents = signal->v_extents();
+		QImage trace_image(viewport->width(),
+			extents.second - extents.first + 1,
+			QImage::Format_ARGB32_Premultiplied);
+		trace_image.fill(Qt::transparent);
+
+		ViewItemPaintParams pp(trace_image.rect(), view.scale(),
+			view.offset());
+		QPainter p(&trace_image);
+		p.setRenderHint(QPainter::Antialiasing, true);
+
+		const Signal::PaintState state = signal->paint_state();
+		const vector< shared_ptr<pv::data::Segment> > segments =
+			signal->painted_segments();
+
+		timer.start();
+		for (int i = 0; i < TracePaintCount; i++)
+			signal->paint_mid_at(p, pp, -extents.first, state,
+				segments);
+		const double paint_time = timer.nsecsElapsed() / 1e6 /
+			TracePaintCount;
+
+		const ViewItemPaintParams::Statistics &s = pp.statistics();
+
+		QJsonObject trace;
+		trace["name"] = signal->base()->name();
+		trace["type"] = (signal->base()->type() ==
+			SignalBase::LogicChannel) ? "logic" : "analog";
+		trace["paint_ms"] = paint_time;
+		trace["fetch_ms"] = s.fetch_time / 1e6 / TracePaintCount;
+		trace["fetched"] = (double)s.fetched / TracePaintCount;
+		traces.append(trace);
+	}
+
+	QJsonObject result;
+	result["samples_per_pixel"] = samples_per_pixel;
+	result["complete_ms"] = complete_time;
+	result["frame_ms"] = frame_time;
+	result["fps"] = 1000 / frame_time;
+	result["traces"] = traces;
+	return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	// Run without a display unless a platform is chosen explicitly
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+
+	// Keep the settings apart from those of PulseView
+	QApplication::setOrganizationName("sigrok");
+	QApplication::setApplicationName("PulseView-bench-render");
+
+	QTemporaryDir dir;
+	const QString path = dir.path() + "/samples.csv";
+	if (!dir.isValid() || !write_samples(path)) {
+		fprintf(stderr, "Failed to write the samples\n");
+		return 1;
+	}
+
+	const shared_ptr<sigrok::Context> context = sigrok::Context::create();
+	pv::DeviceManager device_manager(context);
+	pv::Session session(device_manager, "Benchmark");
+
+	const shared_ptr<View> view = make_shared<View>(session, true);
+	view->resize(Width, Height);
+	view->show();
+	session.register_view(view);
+
+	if (!load(session, context, path))
+		return 1;
+	settle();
+
+	QJsonArray runs;
+	for (const pair<unsigned int, unsigned int> &counts : ChannelCounts) {
+		enable_channels(*view, counts.first, counts.second);
+
+		for (const double samples_per_pixel : SamplesPerPixel) {
+			QJsonObject r = run(*view, samples_per_pixel);
+			r["logic_channels"] = (int)counts.first;
+			r["analog_channels"] = (int)counts.second;
+			runs.append(r);
+		}
+	}
+
+	QJsonObject result;
+	result["width"] = view->viewport()->width();
+	result["height"] = view->viewport()->height();
+	result["samples"] = (double)SampleCount;
+	result["samplerate"] = (double)SampleRate;
+	result["threads"] = QThread::idealThreadCount();
+	result["runs"] = runs;
+
+	printf("%s", QJsonDocument(result).toJson().constData());
+
+	session.deregister_view(view);
+
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the cost of the time calculations done while painting the view
+ * with Timestamp and with FixedTimestamp, and of generating the ruler ticks.
+ * Build with "make pulseview-bench-timestamp".
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+#include "pv/util.hpp"
+
+using std::function;
+using std::printf;
+
+using pv::util::FixedTimestamp;
+using pv::util::Timestamp;
+
+typedef std::chrono::steady_clock Clock;
+
+namespace {
+
+const int Width = 1920;
+const int MinorTickSubdivision = 4;
+
+volatile double sink;
+
+/**
+ * Runs @c func @c iterations times and prints the time per iteration.
+ */
+void measure(const char *name, unsigned int iterations, function<void()> func)
+{
+	const Clock::time_point start = Clock::now();
+	for (unsigned int i = 0; i < iterations; i++)
+		func();
+	const double ns = std::chrono::duration<double, std::nano>(
+		Clock::now() - start).count();
+
+	printf("%-32s %12.1f ns\n", name, ns / iterations);
+}
+
+// The sample range of a trace, as calculated by the painting code
+void view_math_timestamp(const Timestamp &offset, double scale,
+	const Timestamp &start_time, double samplerate)
+{
+	const double samples_per_pixel = samplerate * scale;
+	const Timestamp start = samplerate * (offset - start_time);
+	const Timestamp end = start + samples_per_pixel * Width;
+	const double pixels_offset = (offset / scale).convert_to<double>();
+
+	sink = floor(start).convert_to<int64_t>() +
+		ceil(end).convert_to<int64_t>() + pixels_offset;
+}
+
+void view_math_fixed(const FixedTimestamp &offset, double scale,
+	const FixedTimestamp &start_time, double samplerate)
+{
+	const double samples_per_pixel = samplerate * scale;
+	const double start = samplerate * (offset - start_time).to_double();
+	const double end = start + samples_per_pixel * Width;
+	const double pixels_offset = offset.to_double() / scale;
+
+	sink = (int64_t)floor(start) + (int64_t)ceil(end) + pixels_offset;
+}
+
+// The tick positions with the time of every tick calculated as Timestamp
+void ruler_ticks_timestamp(const Timestamp &major_period,
+	const Timestamp &offset, double scale)
+{
+	const Timestamp minor_period = major_period / MinorTickSubdivision;
+	const Timestamp first_major_division = floor(offset / major_period);
+	const Timestamp first_minor_division = ceil(offset / minor_period);
+	const Timestamp t0 = first_major_division * major_period;
+
+	int division = (round(first_minor_division -
+		first_major_division * MinorTickSubdivision)).convert_to<int>() - 1;
+
+	double x, sum = 0;
+	do {
+		const Timestamp t = t0 + division * minor_period;
+		x = ((t - offset) / scale).convert_to<double>();
+		sum += x;
+		division++;
+	} while (x < Width);
+
+	sink = sum;
+}
+
+// The tick positions relative to the first major tick, as the ruler does
+void ruler_ticks_relative(const Timestamp &major_period,
+	const Timestamp &offset, double scale)
+{
+	const Timestamp minor_period = major_period / MinorTickSubdivision;
+	const Timestamp first_major_division = floor(offset / major_period);
+	const Timestamp first_minor_division = ceil(offset / minor_period);
+	const Timestamp t0 = first_major_division * major_period;
+
+	int division = (round(first_minor_division -
+		first_major_division * MinorTickSubdivision)).convert_to<int>() - 1;
+
+	const double x0 = ((t0 - offset) / scale).convert_to<double>();
+	const double minor_dx = (minor_period / scale).convert_to<double>();
+
+	double x, sum = 0;
+	do {
+		x = x0 + division * minor_dx;
+		sum += x;
+		division++;
+	} while (x < Width);
+
+	sink = sum;
+}
+
+} // namespace
+
+int main()
+{
+	const Timestamp offset("3600.000000123456789");
+	const Timestamp start_time("0.5");
+	const double scale = 1e-9, samplerate = 1e9;
+
+	const FixedTimestamp fixed_offset(offset);
+	const FixedTimestamp fixed_start_time(start_time);
+
+	measure("view math, Timestamp", 100000, [&] {
+		view_math_timestamp(offset, scale, start_time, samplerate); });
+	measure("view math, FixedTimestamp", 100000, [&] {
+		view_math_fixed(fixed_offset, scale, fixed_start_time, samplerate); });
+	measure("Timestamp to FixedTimestamp", 100000, [&] {
+		sink = FixedTimestamp(offset).to_double(); });
+
+	const Timestamp major_period("0.0000001");
+	measure("ruler ticks, Timestamp", 10000, [&] {
+		ruler_ticks_timestamp(major_period, offset, scale); });
+	measure("ruler ticks, relative", 10000, [&] {
+		ruler_ticks_relative(major_period, offset, scale); });
+
+	return 0;
+}
@@ -0,0 +1,245 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/captureformat.hpp>
+#include <pv/data/capturereader.hpp>
+#include <pv/data/capturerecorder.hpp>
+#include <pv/data/packetqueue.hpp>
+
+using pv::data::CaptureReader;
+using pv::data::CaptureRecorder;
+using pv::data::QueuedPacket;
+using std::string;
+using std::vector;
+
+namespace cf = pv::data::captureformat;
+
+namespace {
+
+/**
+ * Provides the path of a temporary file, which is removed after the test
+ * case, even if it fails.
+ */
+struct TempFile
+{
+	TempFile() :
+		path((boost::filesystem::temp_directory_path() /
+			boost::filesystem::unique_path("pv-%%%%-%%%%.pvrec")).string())
+	{
+	}
+
+	~TempFile()
+	{
+		boost::system::error_code ec;
+		boost::filesystem::remove(path, ec);
+	}
+
+	const string path;
+};
+
+QueuedPacket make_packet(QueuedPacket::Type type)
+{
+	QueuedPacket packet;
+	packet.type = type;
+	packet.samplerate = 0;
+	packet.unit_size = 0;
+	packet.dropped_logic_samples = packet.dropped_analog_samples = 0;
+	return packet;
+}
+
+QueuedPacket make_logic(uint64_t first, uint64_t count)
+{
+	QueuedPacket packet = make_packet(QueuedPacket::Logic);
+	packet.unit_size = 1;
+	for (uint64_t i = first; i < first + count; i++)
+		packet.data.push_back(i * 3);
+	return packet;
+}
+
+/**
+ * Records a capture of a sample rate, a trigger and @c packets logic
+ * packets of 1001 samples each, so that the records need padding.
+ */
+void record(const string &path, unsigned int packets)
+{
+	CaptureRecorder recorder;
+	BOOST_REQUIRE(recorder.open(path, {{0, false, true, "D0"},
+		{1, false, false, "D1"}}));
+
+	QueuedPacket meta = make_packet(QueuedPacket::Meta);
+	meta.samplerate = 1000000;
+	recorder.record(meta);
+	recorder.record(make_packet(QueuedPacket::Trigger));
+
+	for (unsigned int i = 0; i < packets; i++)
+		recorder.record(make_logic(i * 1001, 1001));
+
+	BOOST_REQUIRE(recorder.close());
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CaptureRecorderTest)
+
+BOOST_FIXTURE_TEST_CASE(RoundTrip, TempFile)
+{
+	record(path, 3);
+
+	BOOST_REQUIRE(CaptureReader::is_recording(path));
+
+	CaptureReader reader;
+	BOOST_REQUIRE(reader.open(path));
+
+	BOOST_REQUIRE_EQUAL(reader.channels().size(), 2);
+	BOOST_CHECK_EQUAL(reader.channels()[0].name, "D0");
+	BOOST_CHECK(reader.channels()[0].enabled);
+	BOOST_CHECK_EQUAL(reader.channels()[1].index, 1);
+	BOOST_CHECK(!reader.channels()[1].enabled);
+	BOOST_CHECK(!reader.channels()[1].analog);
+
+	CaptureReader::Record r;
+
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::SamplerateRecord);
+	BOOST_CHECK_EQUAL(r.samplerate, 1000000);
+
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::TriggerRecord);
+
+	for (unsigned int i = 0; i < 3; i++) {
+		BOOST_REQUIRE(reader.next(r));
+		BOOST_CHECK_EQUAL(r.type, cf::LogicRecord);
+		BOOST_CHECK_EQUAL(r.unit_size, 1);
+
+		const vector<uint8_t> expected = make_logic(i * 1001, 1001).data;
+		BOOST_CHECK(r.data == expected);
+	}
+
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::EndRecord);
+	BOOST_CHECK(reader.complete());
+	BOOST_CHECK(!reader.next(r));
+	BOOST_CHECK(reader.error().empty());
+
+	BOOST_CHECK_EQUAL(reader.position(),
+		boost::filesystem::file_size(path));
+
+	reader.close();
+}
+
+BOOST_FIXTURE_TEST_CASE(Truncated, TempFile)
+{
+	record(path, 3);
+
+	// Cut the file in the middle of the last logic record
+	const uint64_t size = boost::filesystem::file_size(path);
+	boost::filesystem::resize_file(path, size -
+		sizeof(cf::RecordHeader) - 500);
+
+	CaptureReader reader;
+	BOOST_REQUIRE(reader.open(path));
+
+	CaptureReader::Record r;
+	unsigned int logic_records = 0;
+	while (reader.next(r)) {
+		BOOST_CHECK_NE(r.type, cf::EndRecord);
+		if (r.type == cf::LogicRecord)
+			logic_records++;
+	}
+
+	BOOST_CHECK_EQUAL(logic_records, 2);
+	BOOST_CHECK(!reader.complete());
+	BOOST_CHECK(reader.error().empty());
+
+	// Everything up to the start of the cut record was read
+	BOOST_CHECK_EQUAL(reader.position(), size - 2 * sizeof(cf::RecordHeader) -
+		sizeof(cf::LogicHeader) - cf::padded(1001));
+
+	reader.close();
+}
+
+BOOST_FIXTURE_TEST_CASE(Gap, TempFile)
+{
+	{
+		CaptureRecorder recorder;
+		BOOST_REQUIRE(recorder.open(path, {{0, false, true, "D0"}}));
+
+		recorder.record(make_logic(0, 10));
+
+		QueuedPacket packet = make_logic(50, 10);
+		packet.dropped_logic_samples = 40;
+		recorder.record(packet);
+
+		BOOST_REQUIRE(recorder.close());
+	}
+
+	CaptureReader reader;
+	BOOST_REQUIRE(reader.open(path));
+
+	CaptureReader::Record r;
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::LogicRecord);
+
+	// The gap is marked right before the packet that followed it
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::GapRecord);
+	BOOST_CHECK_EQUAL(r.gap_logic_samples, 40);
+	BOOST_CHECK_EQUAL(r.gap_analog_samples, 0);
+
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::LogicRecord);
+	BOOST_CHECK_EQUAL(r.data.front(), 150);
+
+	BOOST_REQUIRE(reader.next(r));
+	BOOST_CHECK_EQUAL(r.type, cf::EndRecord);
+	BOOST_CHECK(reader.complete());
+
+	reader.close();
+}
+
+BOOST_FIXTURE_TEST_CASE(SlowCapture, TempFile)
+{
+	CaptureRecorder recorder;
+	BOOST_REQUIRE(recorder.open(path, {{0, false, true, "D0"}}));
+	recorder.record(make_logic(0, 10));
+
+	// Far less than a buffer is written once the interval has passed
+	std::this_thread::sleep_for(CaptureRecorder::SyncInterval * 3 / 2);
+
+	{
+		CaptureReader reader;
+		BOOST_REQUIRE(reader.open(path));
+
+		CaptureReader::Record r;
+		BOOST_REQUIRE(reader.next(r));
+		BOOST_CHECK_EQUAL(r.type, cf::LogicRecord);
+		BOOST_CHECK(!reader.next(r));
+		BOOST_CHECK(!reader.complete());
+	}
+
+	BOOST_REQUIRE(recorder.close());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/channelcompactor.hpp>
+
+using std::vector;
+
+using pv::data::ChannelCompactor;
+
+// Gathers the masked bits one at a time
+static uint64_t reference_compact(const uint8_t *sample, unsigned int unit_size,
+	uint64_t mask)
+{
+	uint64_t value = 0;
+	for (unsigned int bit = 0, out = 0; bit < unit_size * 8; bit++)
+		if (mask & (UINT64_C(1) << bit))
+			value |= (uint64_t)((sample[bit / 8] >> (bit % 8)) & 1) << out++;
+	return value;
+}
+
+static void check_compact(unsigned int unit_size, uint64_t mask)
+{
+	const uint64_t count = 1000;
+	const ChannelCompactor c(unit_size, mask);
+
+	vector<uint8_t> src(count * unit_size);
+	for (uint8_t &b : src)
+		b = rand();
+
+	vector<uint8_t> dest(count * c.unit_size());
+	c.compact(src.data(), dest.data(), count);
+
+	for (uint64_t i = 0; i < count; i++) {
+		uint64_t value = 0;
+		for (unsigned int b = 0; b < c.unit_size(); b++)
+			value |= (uint64_t)dest[i * c.unit_size() + b] << (b * 8);
+		BOOST_REQUIRE_EQUAL(value,
+			reference_compact(&src[i * unit_size], unit_size, c.mask()));
+	}
+}
+
+BOOST_AUTO_TEST_SUITE(ChannelCompactorTest)
+
+BOOST_AUTO_TEST_CASE(UnitSize)
+{
+	BOOST_CHECK_EQUAL(ChannelCompactor(4, 0x0F000000).unit_size(), 1);
+	BOOST_CHECK_EQUAL(ChannelCompactor(4, 0x00FF0100).unit_size(), 2);
+	BOOST_CHECK_EQUAL(ChannelCompactor(8, ~UINT64_C(0)).unit_size(), 8);
+	BOOST_CHECK_EQUAL(ChannelCompactor(2, 0).unit_size(), 1);
+
+	// Bits beyond the unit are ignored
+	BOOST_CHECK_EQUAL(ChannelCompactor(1, 0xFFFF).mask(), 0xFF);
+}
+
+BOOST_AUTO_TEST_CASE(Identity)
+{
+	BOOST_CHECK(ChannelCompactor(1, 0x0F).is_identity());
+	BOOST_CHECK(ChannelCompactor(2, 0xFFFF).is_identity());
+	BOOST_CHECK(!ChannelCompactor(1, 0x0E).is_identity());
+	BOOST_CHECK(!ChannelCompactor(2, 0x00FF).is_identity());
+}
+
+BOOST_AUTO_TEST_CASE(CompactedBit)
+{
+	const ChannelCompactor c(4, 0x80010204);
+
+	BOOST_CHECK_EQUAL(c.compacted_bit(2), 0);
+	BOOST_CHECK_EQUAL(c.compacted_bit(9), 1);
+	BOOST_CHECK_EQUAL(c.compacted_bit(16), 2);
+	BOOST_CHECK_EQUAL(c.compacted_bit(31), 3);
+}
+
+BOOST_AUTO_TEST_CASE(Compact)
+{
+	check_compact(1, 0xA5);
+	check_compact(2, 0x8001);
+	check_compact(4, 0x0F000000);
+	check_compact(4, 0xF0F0F0F0);
+	check_compact(8, UINT64_C(0x8000000000000001));
+	check_compact(8, ~UINT64_C(0));
+
+	for (unsigned int i = 0; i < 100; i++) {
+		const unsigned int unit_size = 1 + rand() % 8;
+		check_compact(unit_size, ((uint64_t)rand() << 32) ^ rand());
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,326 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/analog.hpp>
+#include <pv/data/analogsegment.hpp>
+#include <pv/data/containerreader.hpp>
+#include <pv/data/containerwriter.hpp>
+#include <pv/data/logic.hpp>
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/segment.hpp>
+
+using pv::data::Analog;
+using pv::data::AnalogSegment;
+using pv::data::ContainerReader;
+using pv::data::ContainerWriter;
+using pv::data::Logic;
+using pv::data::LogicSegment;
+using pv::data::Segment;
+using std::make_shared;
+using std::shared_ptr;
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * Provides the path of a temporary container, which is removed after the
+ * test case, even if it fails. This includes the partial file of a writer
+ * that wasn't closed.
+ */
+struct TempFile
+{
+	TempFile() :
+		path((boost::filesystem::temp_directory_path() /
+			boost::filesystem::unique_path("pv-%%%%-%%%%.pvcap")).string())
+	{
+	}
+
+	~TempFile()
+	{
+		boost::system::error_code ec;
+		boost::filesystem::remove(path, ec);
+		boost::filesystem::remove(path + ".part", ec);
+	}
+
+	const string path;
+};
+
+void store_logic(ContainerWriter &writer, LogicSegment &segment)
+{
+	const uint64_t count = segment.get_sample_count();
+	const uint8_t *const data = segment.get_samples(0, count);
+
+	writer.begin_segment(false, 0, segment.unit_size(), segment.samplerate());
+	writer.append_samples(data, count);
+	delete[] data;
+
+	uint64_t length;
+	const void *level;
+	for (unsigned int l = 0; (level = segment.mipmap_level(l, length)); l++)
+		writer.add_level(level, length);
+
+	writer.end_segment();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ContainerTest)
+
+BOOST_FIXTURE_TEST_CASE(LogicRoundTrip, TempFile)
+{
+	const uint64_t count = 100000;
+
+	Logic logic(16);
+	LogicSegment segment(logic, 2, 1000000);
+
+	vector<uint16_t> samples(count);
+	for (uint64_t i = 0; i < count; i++)
+		samples[i] = (i / 7) ^ (i / 1000);
+	segment.append_payload(samples.data(), count * sizeof(uint16_t));
+
+	ContainerWriter writer;
+	BOOST_REQUIRE(writer.open(path, {{0, false, true, "D0"},
+		{1, false, false, "D1"}}));
+	store_logic(writer, segment);
+	BOOST_REQUIRE(writer.close());
+
+	shared_ptr<ContainerReader> reader = make_shared<ContainerReader>();
+	BOOST_REQUIRE(ContainerReader::is_container(path));
+	BOOST_REQUIRE(reader->open(path));
+
+	BOOST_REQUIRE_EQUAL(reader->channels().size(), 2);
+	BOOST_CHECK_EQUAL(reader->channels()[1].name, "D1");
+	BOOST_CHECK(!reader->channels()[1].enabled);
+
+	BOOST_REQUIRE_EQUAL(reader->segments().size(), 1);
+	const ContainerReader::Segment &s = reader->segments().front();
+	BOOST_CHECK(!s.analog);
+	BOOST_CHECK_EQUAL(s.sample_count, count);
+	BOOST_CHECK_EQUAL(s.samplerate, 1000000);
+
+	LogicSegment mapped(logic, s.unit_size, s.samplerate);
+	BOOST_CHECK_EQUAL(s.extents.size(), 1);
+	mapped.map_payload(reader->storage(), s.extents, s.levels);
+	reader.reset();
+
+	// The segment keeps the mapping alive
+	const uint8_t *const data = mapped.get_samples(0, count);
+	BOOST_CHECK(memcmp(data, samples.data(), count * sizeof(uint16_t)) == 0);
+	delete[] data;
+
+	uint64_t length, mapped_length;
+	const void *level;
+	for (unsigned int l = 0; (level = segment.mipmap_level(l, length)); l++) {
+		const void *const mapped_level = mapped.mipmap_level(l, mapped_length);
+		BOOST_REQUIRE(mapped_level);
+		BOOST_REQUIRE_EQUAL(mapped_length, length);
+		BOOST_CHECK(memcmp(mapped_level, level, length) == 0);
+	}
+
+	vector<LogicSegment::EdgePair> edges, mapped_edges;
+	segment.get_subsampled_edges(edges, 0, count - 1, 500, 3);
+	mapped.get_subsampled_edges(mapped_edges, 0, count - 1, 500, 3);
+	BOOST_CHECK(edges == mapped_edges);
+}
+
+BOOST_FIXTURE_TEST_CASE(AnalogWithoutLevels, TempFile)
+{
+	const uint64_t count = 5000;
+
+	vector<float> samples(count);
+	for (uint64_t i = 0; i < count; i++)
+		samples[i] = (float)(i % 100) - 50;
+
+	ContainerWriter writer;
+	BOOST_REQUIRE(writer.open(path, {{4, true, true, "A0"}}));
+	writer.begin_segment(true, 4, sizeof(float), 1000, -50, 49);
+	writer.append_samples(samples.data(), count);
+	writer.end_segment();
+	BOOST_REQUIRE(writer.close());
+
+	ContainerReader reader;
+	BOOST_REQUIRE(reader.open(path));
+	BOOST_REQUIRE_EQUAL(reader.segments().size(), 1);
+
+	const ContainerReader::Segment &s = reader.segments().front();
+	BOOST_CHECK(s.analog);
+	BOOST_CHECK_EQUAL(s.channel_index, 4);
+	BOOST_CHECK(s.levels.empty());
+
+	// Without stored levels, the envelope is generated on load
+	Analog analog;
+	AnalogSegment mapped(analog, s.samplerate);
+	mapped.map_payload(reader.storage(), s.extents,
+		s.min_value, s.max_value, s.levels);
+
+	uint64_t length;
+	BOOST_CHECK(mapped.envelope_level(0, length) != nullptr);
+	BOOST_CHECK_EQUAL(length, (count / 16) * sizeof(AnalogSegment::EnvelopeSample));
+	BOOST_CHECK_EQUAL(mapped.get_min_max().first, -50);
+	BOOST_CHECK_EQUAL(mapped.get_min_max().second, 49);
+
+	vector<float> data(count);
+	mapped.get_samples(0, count, data.data());
+	BOOST_CHECK(data == samples);
+}
+
+BOOST_FIXTURE_TEST_CASE(Incremental, TempFile)
+{
+	const uint64_t chunk = Segment::chunk_samples(1);
+	const uint64_t first_count = chunk + 1000, count = 2 * chunk + 500;
+
+	vector<uint8_t> samples(count);
+	for (uint64_t i = 0; i < count; i++)
+		samples[i] = (i * 13) ^ (i >> 11);
+
+	ContainerWriter writer;
+	BOOST_REQUIRE(writer.open(path, {{0, false, true, "D0"}}));
+	writer.begin_segment(false, 0, 1, 1000000);
+	writer.append_samples(samples.data(), first_count);
+	writer.end_segment();
+	BOOST_REQUIRE(writer.close());
+
+	// The samples after the last whole chunk are written again
+	BOOST_CHECK(!writer.reopen({{0, false, true, "D1"}}));
+	BOOST_REQUIRE(writer.reopen({{0, false, true, "D0"}}));
+	BOOST_CHECK_EQUAL(writer.segment_count(), 1);
+	const uint64_t kept = writer.resume_segment(0);
+	BOOST_CHECK_EQUAL(kept, chunk);
+	writer.append_samples(samples.data() + kept, count - kept);
+	writer.end_segment();
+	writer.begin_segment(false, 0, 1, 1000000);
+	writer.append_samples(samples.data(), 100);
+	writer.end_segment();
+	BOOST_REQUIRE(writer.close());
+	BOOST_CHECK_EQUAL(writer.segment_sample_count(0), count);
+
+	shared_ptr<ContainerReader> reader = make_shared<ContainerReader>();
+	BOOST_REQUIRE(reader->open(path));
+	BOOST_REQUIRE_EQUAL(reader->segments().size(), 2);
+	BOOST_CHECK_EQUAL(reader->segments()[1].sample_count, 100);
+
+	const ContainerReader::Segment &s = reader->segments().front();
+	BOOST_CHECK_EQUAL(s.sample_count, count);
+	BOOST_REQUIRE_EQUAL(s.extents.size(), 2);
+	BOOST_CHECK_EQUAL(s.extents[0].second, chunk);
+	BOOST_CHECK_EQUAL(s.extents_in(chunk - 10, chunk + 10).size(), 2);
+	BOOST_CHECK_EQUAL(s.extents_in(chunk + 10, count).size(), 1);
+
+	Logic logic(8);
+	LogicSegment mapped(logic, s.unit_size, s.samplerate);
+	mapped.map_payload(reader->storage(), s.extents, s.levels);
+	reader.reset();
+
+	const uint8_t *const data = mapped.get_samples(0, count);
+	BOOST_CHECK(memcmp(data, samples.data(), count) == 0);
+	delete[] data;
+
+	// A file that was changed by someone else is not added to
+	FILE *const file = fopen(path.c_str(), "ab");
+	BOOST_REQUIRE(file);
+	fputc(0, file);
+	fclose(file);
+	BOOST_CHECK(!writer.reopen({{0, false, true, "D0"}}));
+	BOOST_CHECK(!writer.error().empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(IncrementalInPlace, TempFile)
+{
+	const uint64_t chunk = Segment::chunk_samples(1);
+	const uint64_t counts[] = {1000, 3000, 3000, chunk + 500};
+	const uint64_t count = counts[3];
+
+	vector<uint8_t> samples(count);
+	for (uint64_t i = 0; i < count; i++)
+		samples[i] = (i * 7) ^ (i >> 9);
+
+	ContainerWriter writer;
+	writer.set_growing(true);
+	BOOST_REQUIRE(writer.open(path, {{0, false, true, "D0"}}));
+	writer.begin_segment(false, 0, 1, 1000000);
+	writer.append_samples(samples.data(), counts[0]);
+	writer.end_segment();
+	BOOST_REQUIRE(writer.close());
+
+	// The samples that were saved are kept and the new ones are written
+	// into the space after them, only the index is added to the file
+	vector<uint64_t> sizes(1, boost::filesystem::file_size(path));
+	for (int i = 1; i < 4; i++) {
+		BOOST_REQUIRE(writer.reopen({{0, false, true, "D0"}}));
+		BOOST_CHECK_EQUAL(writer.resumed_sample_count(0), counts[i - 1]);
+		const uint64_t kept = writer.resume_segment(0);
+		BOOST_REQUIRE_EQUAL(kept, counts[i - 1]);
+		writer.append_samples(samples.data() + kept, counts[i] - kept);
+		writer.end_segment();
+		BOOST_REQUIRE(writer.close());
+		sizes.push_back(boost::filesystem::file_size(path));
+	}
+
+	BOOST_CHECK_LE(sizes[1] - sizes[0],
+		2 * pv::data::containerformat::BlobAlignment);
+
+	// The third index takes the space of the first one
+	BOOST_CHECK_EQUAL(sizes[2], sizes[1]);
+
+	shared_ptr<ContainerReader> reader = make_shared<ContainerReader>();
+	BOOST_REQUIRE(reader->open(path));
+	BOOST_REQUIRE_EQUAL(reader->segments().size(), 1);
+
+	// Once the first chunk is full, the samples continue in a new extent
+	const ContainerReader::Segment &s = reader->segments().front();
+	BOOST_CHECK_EQUAL(s.sample_count, count);
+	BOOST_REQUIRE_EQUAL(s.extents.size(), 2);
+	BOOST_CHECK_EQUAL(s.extents[0].second, chunk);
+	BOOST_CHECK_EQUAL(s.extents[1].second, 500);
+
+	Logic logic(8);
+	LogicSegment mapped(logic, s.unit_size, s.samplerate);
+	mapped.map_payload(reader->storage(), s.extents, s.levels);
+	reader.reset();
+
+	const uint8_t *const data = mapped.get_samples(0, count);
+	BOOST_CHECK(memcmp(data, samples.data(), count) == 0);
+	delete[] data;
+}
+
+BOOST_FIXTURE_TEST_CASE(Aborted, TempFile)
+{
+	{
+		ContainerWriter writer;
+		BOOST_REQUIRE(writer.open(path, {}));
+		writer.abort();
+	}
+
+	BOOST_CHECK(!boost::filesystem::exists(path));
+	BOOST_CHECK(!ContainerReader::is_container(path));
+
+	ContainerReader reader;
+	BOOST_CHECK(!reader.open(path));
+	BOOST_CHECK(!reader.error().empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,210 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/analog.hpp>
+#include <pv/data/analogsegment.hpp>
+#include <pv/data/conversiongroup.hpp>
+#include <pv/data/logic.hpp>
+#include <pv/data/logicsegment.hpp>
+#include <pv/data/signalbase.hpp>
+
+using pv::data::Analog;
+using pv::data::AnalogSegment;
+using pv::data::ConversionGroup;
+using pv::data::Logic;
+using pv::data::LogicSegment;
+using pv::data::SignalBase;
+using std::condition_variable;
+using std::lock_guard;
+using std::make_shared;
+using std::mutex;
+using std::shared_ptr;
+using std::unique_lock;
+using std::vector;
+
+namespace {
+
+const uint64_t SampleCount = 10000;
+
+/**
+ * Counts the segments the group has finished converting. The conversion
+ * worker reports them directly, from its own thread.
+ */
+class CompletionCounter
+{
+public:
+	CompletionCounter(const shared_ptr<Logic> &logic) :
+		count_(0)
+	{
+		QObject::connect(logic.get(), &Logic::samples_added,
+			[this](QObject*, uint64_t, uint64_t end_sample) {
+				if (end_sample != SampleCount)
+					return;
+				{
+					lock_guard<mutex> lock(mutex_);
+					count_++;
+				}
+				cond_.notify_all();
+			});
+	}
+
+	unsigned int count()
+	{
+		lock_guard<mutex> lock(mutex_);
+		return count_;
+	}
+
+	/**
+	 * Waits until more than the given number of segments were converted.
+	 */
+	bool wait_beyond(unsigned int count)
+	{
+		unique_lock<mutex> lock(mutex_);
+		return cond_.wait_for(lock, std::chrono::seconds(10),
+			[&] { return count_ > count; });
+	}
+
+private:
+	mutex mutex_;
+	condition_variable cond_;
+	unsigned int count_;
+};
+
+/**
+ * Creates an analog channel holding a square wave of +-1 with the given
+ * half period.
+ */
+shared_ptr<SignalBase> make_member(unsigned int half_period,
+	const shared_ptr<ConversionGroup> &group)
+{
+	shared_ptr<Analog> data = make_shared<Analog>();
+	shared_ptr<AnalogSegment> segment =
+		make_shared<AnalogSegment>(*data, 1000000);
+
+	vector<float> samples(SampleCount);
+	for (uint64_t i = 0; i < SampleCount; i++)
+		samples[i] = ((i / half_period) & 1) ? 1.0f : -1.0f;
+	segment->append_interleaved_samples(samples.data(), SampleCount, 1);
+	data->push_segment(segment);
+
+	shared_ptr<SignalBase> base =
+		make_shared<SignalBase>(nullptr, SignalBase::AnalogChannel);
+	base->set_data(data);
+	base->set_conversion_group(group);
+
+	return base;
+}
+
+/**
+ * Changes the conversion type of a member and waits until the group has
+ * converted the samples again. The worker is idle before, so only the
+ * restarted worker reports a conversion.
+ */
+bool convert(CompletionCounter &completions,
+	const shared_ptr<SignalBase> &base, SignalBase::ConversionType type)
+{
+	const unsigned int count = completions.count();
+	base->set_conversion_type(type);
+	return completions.wait_beyond(count);
+}
+
+/**
+ * Checks that a bit of the packed logic data holds the square wave.
+ */
+bool check_bit(const shared_ptr<Logic> &logic, unsigned int bit,
+	unsigned int half_period)
+{
+	BOOST_REQUIRE_EQUAL(logic->logic_segments().size(), 1);
+	const shared_ptr<LogicSegment> &segment = logic->logic_segments().front();
+	BOOST_REQUIRE_EQUAL(segment->get_sample_count(), SampleCount);
+
+	const unsigned int unit_size = segment->unit_size();
+	const uint8_t *const samples = segment->get_samples(0, SampleCount);
+
+	bool ok = true;
+	for (uint64_t i = 0; i < SampleCount; i++) {
+		const bool level = (samples[i * unit_size + bit / 8] >> (bit % 8)) & 1;
+		ok = ok && (level == (((i / half_period) & 1) != 0));
+	}
+
+	delete[] samples;
+	return ok;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ConversionGroupTest)
+
+BOOST_AUTO_TEST_CASE(StableBits)
+{
+	shared_ptr<ConversionGroup> group = make_shared<ConversionGroup>();
+	const shared_ptr<Logic> logic = group->logic_data();
+	CompletionCounter completions(logic);
+
+	shared_ptr<SignalBase> a = make_member(3, group);
+	shared_ptr<SignalBase> b = make_member(5, group);
+	shared_ptr<SignalBase> c = make_member(7, group);
+
+	BOOST_REQUIRE(convert(completions, a,
+		SignalBase::A2LConversionByTreshold));
+	BOOST_REQUIRE(convert(completions, b,
+		SignalBase::A2LConversionByTreshold));
+	BOOST_REQUIRE(convert(completions, c,
+		SignalBase::A2LConversionByTreshold));
+
+	BOOST_CHECK_EQUAL(a->logic_bit_index(), 0);
+	BOOST_CHECK_EQUAL(b->logic_bit_index(), 1);
+	BOOST_CHECK_EQUAL(c->logic_bit_index(), 2);
+	BOOST_CHECK(check_bit(logic, 2, 7));
+
+	// Removing a member keeps the other bits and the logic data
+	BOOST_REQUIRE(convert(completions, b, SignalBase::NoConversion));
+
+	BOOST_CHECK(group->logic_data() == logic);
+	BOOST_CHECK_EQUAL(a->logic_bit_index(), 0);
+	BOOST_CHECK_EQUAL(c->logic_bit_index(), 2);
+	BOOST_CHECK(check_bit(logic, 0, 3));
+	BOOST_CHECK(check_bit(logic, 2, 7));
+
+	// A new member takes the free bit
+	shared_ptr<SignalBase> d = make_member(11, group);
+	BOOST_REQUIRE(convert(completions, d,
+		SignalBase::A2LConversionByTreshold));
+
+	BOOST_CHECK_EQUAL(d->logic_bit_index(), 1);
+	BOOST_CHECK(check_bit(logic, 1, 11));
+
+	// Changing the conversion type keeps the bit
+	BOOST_REQUIRE(convert(completions, c,
+		SignalBase::A2LConversionBySchmittTrigger));
+
+	BOOST_CHECK(group->logic_data() == logic);
+	BOOST_CHECK_EQUAL(c->logic_bit_index(), 2);
+	BOOST_CHECK(check_bit(logic, 2, 7));
+	BOOST_CHECK(check_bit(logic, 0, 3));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
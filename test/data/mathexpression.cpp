@@ -0,0 +1,163 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <clocale>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/mathexpression.hpp>
+
+using std::string;
+using std::vector;
+
+using pv::data::MathExpression;
+
+namespace {
+
+int resolve(const string &name)
+{
+	if (name == "A")
+		return 0;
+	if (name == "B")
+		return 1;
+	if (name == "my probe")
+		return 2;
+	return -1;
+}
+
+vector<float> evaluate(const MathExpression &e,
+	MathExpression::Context &context, const vector< vector<float> > &inputs,
+	size_t count, double samplerate = 1)
+{
+	vector<const float*> ptrs;
+	for (const vector<float> &v : inputs)
+		ptrs.push_back(v.data());
+
+	vector<float> out(count);
+	e.evaluate(context, ptrs, out.data(), count, samplerate);
+	return out;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(MathExpressionTest)
+
+BOOST_AUTO_TEST_CASE(Arithmetic)
+{
+	MathExpression e;
+	string error;
+
+	BOOST_REQUIRE(e.parse("(A + B) * 2 - -B / 4 + \"my probe\"", resolve, error));
+	BOOST_CHECK_EQUAL(e.input_count(), 3);
+
+	const vector< vector<float> > inputs = {
+		{1, 2, 3}, {4, 8, 12}, {0.5f, 0.5f, 0.5f}};
+
+	MathExpression::Context c = e.create_context(16);
+	const vector<float> out = evaluate(e, c, inputs, 3);
+
+	for (unsigned int i = 0; i < 3; i++)
+		BOOST_CHECK_CLOSE(out[i], (inputs[0][i] + inputs[1][i]) * 2 +
+			inputs[1][i] / 4 + inputs[2][i], 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(ConstantFolding)
+{
+	MathExpression e;
+	string error;
+
+	BOOST_REQUIRE(e.parse("scale(A, 2 * 1.5) + abs(-4)", resolve, error));
+
+	const vector< vector<float> > inputs = {{1, -2}};
+
+	MathExpression::Context c = e.create_context(2);
+	const vector<float> out = evaluate(e, c, inputs, 2);
+
+	BOOST_CHECK_CLOSE(out[0], 7.0f, 1e-4);
+	BOOST_CHECK_CLOSE(out[1], -2.0f, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(NumbersIgnoreLocale)
+{
+	// Where a locale with a decimal comma is installed, strtod() would
+	// stop at the point
+	const string previous = setlocale(LC_NUMERIC, nullptr);
+	setlocale(LC_NUMERIC, "de_DE.UTF-8");
+
+	MathExpression e;
+	string error;
+	const bool parsed = e.parse("A * 2.5 + 1e-1", resolve, error);
+
+	setlocale(LC_NUMERIC, previous.c_str());
+
+	BOOST_REQUIRE(parsed);
+
+	const vector< vector<float> > inputs = {{2}};
+
+	MathExpression::Context c = e.create_context(1);
+	const vector<float> out = evaluate(e, c, inputs, 1);
+
+	BOOST_CHECK_CLOSE(out[0], 5.1f, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(Errors)
+{
+	MathExpression e;
+	string error;
+
+	BOOST_CHECK(!e.parse("A +", resolve, error));
+	BOOST_CHECK(!e.parse("C", resolve, error));
+	BOOST_CHECK(!e.parse("(A", resolve, error));
+	BOOST_CHECK(!e.parse("scale(A, B)", resolve, error));
+	BOOST_CHECK(!e.parse("lowpass(A, 0)", resolve, error));
+	BOOST_CHECK(!e.parse("foo(A)", resolve, error));
+	BOOST_CHECK(!e.parse("A B", resolve, error));
+	BOOST_CHECK(!error.empty());
+}
+
+BOOST_AUTO_TEST_CASE(IncrementalState)
+{
+	// Integrating and differentiating in blocks gives the same result as
+	// processing the whole stream at once
+	MathExpression e;
+	string error;
+
+	BOOST_REQUIRE(e.parse("derivative(integrate(A)) + lowpass(A, 10)",
+		resolve, error));
+
+	vector<float> a(100);
+	for (unsigned int i = 0; i < a.size(); i++)
+		a[i] = sinf(i * 0.1f);
+
+	MathExpression::Context whole = e.create_context(a.size());
+	const vector<float> expected = evaluate(e, whole, {a}, a.size(), 1000);
+
+	MathExpression::Context blocks = e.create_context(7);
+	for (unsigned int i = 0; i < a.size(); i += 7) {
+		const size_t n = std::min<size_t>(7, a.size() - i);
+		const vector<float> part(a.begin() + i, a.begin() + i + n);
+		const vector<float> out = evaluate(e, blocks, {part}, n, 1000);
+
+		for (unsigned int j = 0; j < n; j++)
+			BOOST_CHECK_CLOSE(out[j], expected[i + j], 1e-3);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,166 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/notificationscheduler.hpp>
+#include <pv/data/segment.hpp>
+#include <pv/data/signaldata.hpp>
+
+using pv::data::NotificationScheduler;
+using pv::data::Segment;
+using pv::data::SignalData;
+using std::make_shared;
+using std::pair;
+using std::shared_ptr;
+using std::vector;
+using std::chrono::milliseconds;
+
+namespace {
+
+/**
+ * Records the ranges it is notified of instead of emitting signals.
+ */
+class RecordingData : public SignalData
+{
+public:
+	vector< shared_ptr<Segment> > segments() const
+	{
+		return vector< shared_ptr<Segment> >();
+	}
+
+	void clear()
+	{
+		ranges.clear();
+	}
+
+	uint64_t max_sample_count() const
+	{
+		return 0;
+	}
+
+	void notify_samples_added(QObject* segment, uint64_t start_sample,
+		uint64_t end_sample)
+	{
+		(void)segment;
+		ranges.emplace_back(start_sample, end_sample);
+	}
+
+	vector< pair<uint64_t, uint64_t> > ranges;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(NotificationSchedulerTest)
+
+BOOST_AUTO_TEST_CASE(Coalescing)
+{
+	int received = 0;
+	NotificationScheduler s([&] { received++; });
+
+	const shared_ptr<RecordingData> a = make_shared<RecordingData>();
+	const shared_ptr<RecordingData> b = make_shared<RecordingData>();
+	const shared_ptr<Segment> sa = make_shared<Segment>(1, 1);
+	const shared_ptr<Segment> sb = make_shared<Segment>(1, 1);
+
+	BOOST_CHECK(!s.pending());
+
+	// Empty ranges are ignored
+	s.post(a, sa, 5, 5);
+	BOOST_CHECK(!s.pending());
+
+	s.post(a, sa, 0, 10);
+	s.post(a, sa, 10, 25);
+	s.post(b, sb, 100, 110);
+	s.post(a, sa, 25, 40);
+	BOOST_CHECK(s.pending());
+
+	s.flush();
+
+	// One merged range per segment, followed by a single batch notification
+	BOOST_REQUIRE_EQUAL(a->ranges.size(), 1);
+	BOOST_CHECK_EQUAL(a->ranges[0].first, 0);
+	BOOST_CHECK_EQUAL(a->ranges[0].second, 40);
+	BOOST_REQUIRE_EQUAL(b->ranges.size(), 1);
+	BOOST_CHECK_EQUAL(b->ranges[0].first, 100);
+	BOOST_CHECK_EQUAL(b->ranges[0].second, 110);
+	BOOST_CHECK_EQUAL(received, 1);
+	BOOST_CHECK(!s.pending());
+
+	// Nothing is delivered when there is nothing pending
+	s.flush();
+	BOOST_CHECK_EQUAL(received, 1);
+
+	// Cleared ranges are never delivered
+	s.post(a, sa, 40, 50);
+	s.clear();
+	s.flush();
+	BOOST_CHECK_EQUAL(a->ranges.size(), 1);
+	BOOST_CHECK_EQUAL(received, 1);
+}
+
+BOOST_AUTO_TEST_CASE(RateLimit)
+{
+	int received = 0;
+	NotificationScheduler s([&] { received++; });
+
+	const shared_ptr<RecordingData> d = make_shared<RecordingData>();
+	const shared_ptr<Segment> seg = make_shared<Segment>(1, 1);
+
+	BOOST_CHECK_EQUAL(s.rate(), NotificationScheduler::DefaultRate);
+
+	s.set_rate(0);
+	BOOST_CHECK_EQUAL(s.rate(), NotificationScheduler::MinRate);
+	s.set_rate(NotificationScheduler::MaxRate + 1);
+	BOOST_CHECK_EQUAL(s.rate(), NotificationScheduler::MaxRate);
+
+	s.set_rate(10);
+	s.flush();
+
+	// Within the 100ms interval after a flush nothing is due
+	s.post(d, seg, 0, 10);
+	BOOST_CHECK(s.time_until_due() > NotificationScheduler::clock::duration::zero());
+	BOOST_CHECK(s.time_until_due() <= milliseconds(100));
+	s.flush_if_due();
+	BOOST_CHECK(d->ranges.empty());
+	BOOST_CHECK_EQUAL(received, 0);
+
+	s.post(d, seg, 10, 20);
+	std::this_thread::sleep_for(milliseconds(110));
+
+	BOOST_CHECK(s.time_until_due() == NotificationScheduler::clock::duration::zero());
+	s.flush_if_due();
+	BOOST_REQUIRE_EQUAL(d->ranges.size(), 1);
+	BOOST_CHECK_EQUAL(d->ranges[0].first, 0);
+	BOOST_CHECK_EQUAL(d->ranges[0].second, 20);
+	BOOST_CHECK_EQUAL(received, 1);
+
+	// The interval restarts with every delivered batch
+	s.post(d, seg, 20, 30);
+	s.flush_if_due();
+	BOOST_CHECK_EQUAL(d->ranges.size(), 1);
+	BOOST_CHECK_EQUAL(received, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/packetqueue.hpp>
+
+using pv::data::PacketQueue;
+using pv::data::QueuedPacket;
+
+BOOST_AUTO_TEST_SUITE(PacketQueueTest)
+
+BOOST_AUTO_TEST_CASE(FullQueue)
+{
+	PacketQueue q;
+
+	for (size_t i = 0; i < PacketQueue::Capacity; i++) {
+		QueuedPacket *const p = q.begin_push();
+		BOOST_REQUIRE(p != nullptr);
+		p->samplerate = i;
+		q.end_push();
+	}
+
+	BOOST_CHECK_EQUAL(q.depth(), PacketQueue::Capacity);
+	BOOST_CHECK_EQUAL(q.max_depth(), PacketQueue::Capacity);
+	BOOST_CHECK(q.begin_push() == nullptr);
+
+	q.count_drop(100);
+	BOOST_CHECK_EQUAL(q.dropped_packets(), 1);
+	BOOST_CHECK_EQUAL(q.dropped_samples(), 100);
+
+	q.close();
+
+	for (size_t i = 0; i < PacketQueue::Capacity; i++) {
+		QueuedPacket *const p = q.wait_front();
+		BOOST_REQUIRE(p != nullptr);
+		BOOST_CHECK_EQUAL(p->samplerate, i);
+		q.pop();
+	}
+
+	BOOST_CHECK(q.wait_front() == nullptr);
+	BOOST_CHECK_EQUAL(q.depth(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(Threaded)
+{
+	const uint64_t count = 100000;
+	uint64_t expected = 0, received = 0;
+	PacketQueue q;
+
+	std::thread consumer([&] {
+		QueuedPacket *p;
+		while ((p = q.wait_front())) {
+			if (p->samplerate == expected)
+				expected++;
+			received++;
+			q.pop();
+		}
+	});
+
+	for (uint64_t i = 0; i < count; i++) {
+		QueuedPacket *const p = q.begin_push_blocking();
+		p->samplerate = i;
+		q.end_push();
+	}
+
+	q.close();
+	consumer.join();
+
+	BOOST_CHECK_EQUAL(received, count);
+	BOOST_CHECK_EQUAL(expected, count);
+	BOOST_CHECK_EQUAL(q.dropped_packets(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdint>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/samplewindow.hpp>
+
+using pv::data::SampleWindow;
+
+BOOST_AUTO_TEST_SUITE(SampleWindowTest)
+
+BOOST_AUTO_TEST_CASE(Full)
+{
+	SampleWindow w;
+	uint64_t first;
+
+	BOOST_CHECK(w.is_full());
+	BOOST_CHECK_EQUAL(w.select(12345, 1000, first), 1000);
+	BOOST_CHECK_EQUAL(first, 0);
+	BOOST_CHECK(!w.passed(1ULL << 62));
+}
+
+BOOST_AUTO_TEST_CASE(Window)
+{
+	SampleWindow w(0.001, 0.002);
+	uint64_t first;
+
+	w.resolve(1000000);
+	BOOST_CHECK_EQUAL(w.start_sample(), 1000);
+	BOOST_CHECK_EQUAL(w.end_sample(), 2000);
+
+	// Blocks before, across, inside and after the window
+	BOOST_CHECK_EQUAL(w.select(0, 500, first), 0);
+	BOOST_CHECK_EQUAL(w.select(500, 1000, first), 500);
+	BOOST_CHECK_EQUAL(first, 500);
+	BOOST_CHECK_EQUAL(w.select(1200, 100, first), 100);
+	BOOST_CHECK_EQUAL(first, 0);
+	BOOST_CHECK_EQUAL(w.select(1900, 1000, first), 100);
+	BOOST_CHECK_EQUAL(w.select(2000, 1000, first), 0);
+
+	BOOST_CHECK(!w.passed(1999));
+	BOOST_CHECK(w.passed(2000));
+}
+
+BOOST_AUTO_TEST_CASE(Decimation)
+{
+	SampleWindow w(10, -1, 4);
+	uint64_t first, kept = 0, last = 0;
+
+	// Without a sample rate, the window is given in samples
+	w.resolve(0);
+	BOOST_CHECK_EQUAL(w.start_sample(), 10);
+
+	// The kept samples stay on the same grid across blocks
+	for (uint64_t pos = 0; pos < 1000; pos += 7) {
+		const uint64_t n = w.select(pos, 7, first);
+		for (uint64_t i = 0; i < n; i++) {
+			const uint64_t index = pos + first + i * 4;
+			BOOST_CHECK_EQUAL((index - 10) % 4, 0);
+			BOOST_CHECK(kept == 0 || index == last + 4);
+			last = index;
+			kept++;
+		}
+	}
+
+	BOOST_CHECK_EQUAL(kept, (1001 - 10 + 3) / 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -290,4 +290,47 @@ BOOST_AUTO_TEST_CASE(MaxSize32MultiIterated)
 	s.end_raw_sample_iteration(it);
 }
 
+BOOST_AUTO_TEST_CASE(ContiguousSamples)
+{
+	Segment s(1, sizeof(uint32_t));
+
+	const uint32_t chunk_samples =
+		pv::data::Segment::MaxChunkSize / sizeof(uint32_t);
+	uint32_t num_samples = 2 * chunk_samples + 10;
+
+	uint32_t *data = new uint32_t[num_samples];
+	for (uint32_t i = 0; i < num_samples; i++)
+		data[i] = i;
+
+	s.append_samples(data, num_samples);
+	delete[] data;
+
+	s.pin_chunks();
+
+	//----- Samples are handed out up to the end of their chunk ----//
+	uint64_t count = num_samples;
+	const uint32_t *samples = (const uint32_t*)s.contiguous_samples(5, count);
+	BOOST_CHECK_EQUAL(count, chunk_samples - 5);
+	BOOST_CHECK_EQUAL(samples[0], 5);
+	BOOST_CHECK_EQUAL(samples[count - 1], chunk_samples - 1);
+
+	//----- ...and never past the end of the segment ----//
+	count = num_samples;
+	samples = (const uint32_t*)s.contiguous_samples(2 * chunk_samples, count);
+	BOOST_CHECK_EQUAL(count, 10);
+	BOOST_CHECK_EQUAL(samples[9], num_samples - 1);
+
+	//----- Pinned chunks are only shrunk once they are released ----//
+	s.free_unused_memory();
+	BOOST_CHECK_EQUAL(samples[9], num_samples - 1);
+	s.unpin_chunks();
+
+	count = 3;
+	s.pin_chunks();
+	samples = (const uint32_t*)s.contiguous_samples(2 * chunk_samples + 1, count);
+	BOOST_CHECK_EQUAL(count, 3);
+	BOOST_CHECK_EQUAL(samples[0], 2 * chunk_samples + 1);
+	s.unpin_chunks();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,130 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/signalbase.hpp>
+
+using pv::data::SignalBase;
+using std::vector;
+
+namespace {
+
+const float Lo = -0.5f, Hi = 0.5f;
+
+/**
+ * Returns samples that cross both thresholds, stay between them for a
+ * while and hit them exactly.
+ */
+vector<float> make_samples(size_t count)
+{
+	static const float pattern[] = {
+		-1, -0.5f, 0, 0.5f, 0.25f, 1, 0.5f, 0, -0.25f, -0.5f, -0.75f,
+		0.5f, 0.5f, -0.5f, 0.75f, 0,
+		std::numeric_limits<float>::quiet_NaN(), 2, -2, 0.1f, 0.4f, -0.4f
+	};
+	const size_t pattern_size = sizeof(pattern) / sizeof(pattern[0]);
+
+	vector<float> samples(count);
+	for (size_t i = 0; i < count; i++) {
+		// Long runs on one side of the band exercise the block fills
+		const size_t block = (i / 37) % 4;
+		samples[i] = (block == 1) ? 3 : (block == 3) ? -3 :
+			pattern[(i * 7) % pattern_size];
+	}
+
+	return samples;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SignalBaseTest)
+
+BOOST_AUTO_TEST_CASE(ThresholdMatchesScalar)
+{
+	const vector<float> samples = make_samples(300);
+
+	// Every length and misalignment around the vector size
+	for (size_t offset = 0; offset < 4; offset++)
+		for (size_t count = 0; count + offset <= 80; count++)
+			for (const float threshold : {0.0f, 0.5f, -0.5f}) {
+				vector<uint8_t> vectorized(count + 1, 0xAA);
+				vector<uint8_t> scalar(count + 1, 0xAA);
+
+				SignalBase::convert_a2l_threshold(threshold,
+					samples.data() + offset, vectorized.data(), count);
+				SignalBase::convert_a2l_threshold_scalar(threshold,
+					samples.data() + offset, scalar.data(), count);
+
+				BOOST_REQUIRE(vectorized == scalar);
+			}
+}
+
+BOOST_AUTO_TEST_CASE(SchmittTriggerMatchesScalar)
+{
+	const vector<float> samples = make_samples(300);
+
+	for (size_t offset = 0; offset < 4; offset++)
+		for (size_t count = 0; count + offset <= 80; count++)
+			for (uint8_t initial = 0; initial < 2; initial++) {
+				vector<uint8_t> vectorized(count + 1, 0xAA);
+				vector<uint8_t> scalar(count + 1, 0xAA);
+				uint8_t vectorized_state = initial, scalar_state = initial;
+
+				SignalBase::convert_a2l_schmitt_trigger(Lo, Hi,
+					samples.data() + offset, vectorized.data(), count,
+					vectorized_state);
+				SignalBase::convert_a2l_schmitt_trigger_scalar(Lo, Hi,
+					samples.data() + offset, scalar.data(), count,
+					scalar_state);
+
+				BOOST_REQUIRE(vectorized == scalar);
+				BOOST_REQUIRE_EQUAL(vectorized_state, scalar_state);
+			}
+}
+
+BOOST_AUTO_TEST_CASE(SchmittTriggerStateAcrossCalls)
+{
+	const size_t count = 300;
+	const vector<float> samples = make_samples(count);
+
+	vector<uint8_t> whole(count);
+	uint8_t whole_state = 0;
+	SignalBase::convert_a2l_schmitt_trigger_scalar(Lo, Hi, samples.data(),
+		whole.data(), count, whole_state);
+
+	// Converting in pieces of odd sizes must give the same levels
+	for (size_t piece = 1; piece <= 40; piece += 3) {
+		vector<uint8_t> pieces(count);
+		uint8_t state = 0;
+
+		for (size_t i = 0; i < count; i += piece)
+			SignalBase::convert_a2l_schmitt_trigger(Lo, Hi,
+				samples.data() + i, pieces.data() + i,
+				std::min(piece, count - i), state);
+
+		BOOST_REQUIRE(pieces == whole);
+		BOOST_REQUIRE_EQUAL(state, whole_state);
+	}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,293 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <pv/data/csvimporter.hpp>
+#include <pv/data/vcdimporter.hpp>
+
+using pv::data::CsvImporter;
+using pv::data::TextImporter;
+using pv::data::VcdImporter;
+using std::atomic;
+using std::string;
+using std::vector;
+
+namespace {
+
+struct Result
+{
+	vector<uint8_t> logic;
+	vector< vector<float> > analog;
+};
+
+string write_temp(const string &text, const char *extension)
+{
+	const string path = (boost::filesystem::temp_directory_path() /
+		boost::filesystem::unique_path(string("pv-%%%%-%%%%") +
+			extension)).string();
+
+	FILE *const f = fopen(path.c_str(), "wb");
+	fwrite(text.data(), 1, text.size(), f);
+	fclose(f);
+
+	return path;
+}
+
+Result import(TextImporter &importer)
+{
+	Result r;
+	atomic<bool> interrupt(false);
+
+	r.analog.resize(importer.analog_channel_count());
+
+	BOOST_REQUIRE(importer.run(
+		[&](const uint8_t *data, uint64_t count) {
+			r.logic.insert(r.logic.end(), data,
+				data + count * importer.unit_size()); },
+		[&](unsigned int index, const float *data, uint64_t count) {
+			r.analog[index].insert(r.analog[index].end(), data,
+				data + count); },
+		interrupt));
+
+	return r;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TextImporterTest)
+
+BOOST_AUTO_TEST_CASE(Csv)
+{
+	const string path = write_temp(
+		"; A comment\n"
+		"Time,D0,D1,Voltage\n"
+		"0.000,0,1,1.5\n"
+		"0.001,1,1,-2.25e-1\r\n"
+		"\n"
+		"0.002,1,0,3\n"
+		"0.003,0,0\n", ".csv");
+
+	CsvImporter importer;
+	BOOST_REQUIRE(importer.open(path));
+
+	BOOST_REQUIRE_EQUAL(importer.channels().size(), 3);
+	BOOST_CHECK_EQUAL(importer.channels()[0].name, "D0");
+	BOOST_CHECK_EQUAL(importer.channels()[1].name, "D1");
+	BOOST_CHECK(importer.channels()[2].analog);
+	BOOST_CHECK_EQUAL(importer.logic_channel_count(), 2);
+	BOOST_CHECK_CLOSE(importer.samplerate(), 1000, 0.001);
+
+	const Result r = import(importer);
+
+	const vector<uint8_t> logic = {2, 3, 1, 0};
+	BOOST_CHECK(r.logic == logic);
+
+	BOOST_REQUIRE_EQUAL(r.analog[0].size(), 4);
+	BOOST_CHECK_CLOSE(r.analog[0][0], 1.5f, 0.001);
+	BOOST_CHECK_CLOSE(r.analog[0][1], -0.225f, 0.001);
+	BOOST_CHECK_CLOSE(r.analog[0][2], 3.0f, 0.001);
+	BOOST_CHECK_EQUAL(r.analog[0][3], 0.0f);
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(CsvLarge)
+{
+	// Large enough to be parsed in several pieces
+	const uint64_t count = 3 * TextImporter::PieceSize / 8;
+	string text;
+	for (uint64_t i = 0; i < count; i++)
+		text += std::to_string(i & 1) + ";" + std::to_string(i % 1000) + "\n";
+
+	const string path = write_temp(text, ".csv");
+
+	CsvImporter importer(1000000);
+	BOOST_REQUIRE(importer.open(path));
+	BOOST_CHECK_EQUAL(importer.samplerate(), 1000000);
+
+	const Result r = import(importer);
+
+	BOOST_REQUIRE_EQUAL(r.logic.size(), count);
+	BOOST_REQUIRE_EQUAL(r.analog[0].size(), count);
+
+	bool ok = true;
+	for (uint64_t i = 0; i < count; i++)
+		ok = ok && r.logic[i] == (i & 1) && r.analog[0][i] == (i % 1000);
+	BOOST_CHECK(ok);
+	BOOST_CHECK_EQUAL(importer.bytes_processed(), importer.file_size());
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(CsvLateAnalog)
+{
+	// The second column only leaves 0 and 1 far into the file
+	string text;
+	for (unsigned int i = 0; i < 5000; i++)
+		text += "1," + std::to_string(i & 1) + "\n";
+	text += "1,0.5\n";
+
+	const string path = write_temp(text, ".csv");
+
+	CsvImporter importer;
+	BOOST_REQUIRE(importer.open(path));
+
+	BOOST_REQUIRE_EQUAL(importer.channels().size(), 2);
+	BOOST_CHECK(!importer.channels()[0].analog);
+	BOOST_CHECK(importer.channels()[1].analog);
+
+	const Result r = import(importer);
+	BOOST_REQUIRE_EQUAL(r.analog[0].size(), 5001);
+	BOOST_CHECK_EQUAL(r.analog[0][5000], 0.5f);
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(Vcd)
+{
+	const string path = write_temp(
+		"$date today $end\n"
+		"$timescale 1 us $end\n"
+		"$scope module top $end\n"
+		"$var wire 1 ! clk $end\n"
+		"$var wire 4 \"# data [3:0] $end\n"
+		"$var real 64 $ level $end\n"
+		"$var wire 1 ! clk_alias $end\n"
+		"$upscope $end\n"
+		"$enddefinitions $end\n"
+		"#0\n"
+		"$dumpvars\n"
+		"0!\n"
+		"b1010 \"#\n"
+		"r0.5 $\n"
+		"$end\n"
+		"#2\n"
+		"1!\n"
+		"$comment 1! is ignored $end\n"
+		"#3\n"
+		"0!\n"
+		"b11 \"#\n"
+		"r-1 $\n", ".vcd");
+
+	VcdImporter importer;
+	BOOST_REQUIRE(importer.open(path));
+
+	BOOST_REQUIRE_EQUAL(importer.channels().size(), 6);
+	BOOST_CHECK_EQUAL(importer.channels()[0].name, "clk");
+	BOOST_CHECK_EQUAL(importer.channels()[1].name, "data[0]");
+	BOOST_CHECK_EQUAL(importer.channels()[5].name, "level");
+	BOOST_CHECK_EQUAL(importer.logic_channel_count(), 5);
+	BOOST_CHECK_CLOSE(importer.samplerate(), 1000000, 0.001);
+
+	const Result r = import(importer);
+
+	// Samples at 0, 1, 2 and the final values at 3
+	const vector<uint8_t> logic = {0x14, 0x14, 0x15, 0x06};
+	BOOST_CHECK(r.logic == logic);
+
+	const vector<float> analog = {0.5, 0.5, 0.5, -1};
+	BOOST_CHECK(r.analog[0] == analog);
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(VcdLongIdentifiers)
+{
+	const string path = write_temp(
+		"$timescale 1 ns $end\n"
+		"$var wire 1 identifier_a a $end\n"
+		"$var wire 1 identifier_b b $end\n"
+		"$enddefinitions $end\n"
+		"#0\n"
+		"1identifier_a\n"
+		"0identifier_b\n"
+		"#1\n"
+		"1identifier_b\n", ".vcd");
+
+	VcdImporter importer;
+	BOOST_REQUIRE(importer.open(path));
+	BOOST_CHECK_EQUAL(importer.channels().size(), 2);
+
+	const Result r = import(importer);
+
+	const vector<uint8_t> logic = {0x1, 0x3};
+	BOOST_CHECK(r.logic == logic);
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(VcdCompress)
+{
+	const string path = write_temp(
+		"$timescale 1 ns $end\n"
+		"$var wire 1 ! clk $end\n"
+		"$enddefinitions $end\n"
+		"#0\n"
+		"1!\n"
+		"#1000000000\n"
+		"0!\n"
+		"#1000000002\n"
+		"1!\n", ".vcd");
+
+	// The idle second shrinks to 4 samples, the short gap is kept
+	VcdImporter importer(1, 4);
+	BOOST_REQUIRE(importer.open(path));
+
+	const Result r = import(importer);
+
+	const vector<uint8_t> logic = {1, 1, 1, 1, 0, 0, 1};
+	BOOST_CHECK(r.logic == logic);
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(VcdTooWide)
+{
+	// Rejected rather than imported without the second vector
+	const string path = write_temp(
+		"$timescale 1 ns $end\n"
+		"$var wire 60 ! a $end\n"
+		"$var wire 8 \" b $end\n"
+		"$enddefinitions $end\n"
+		"#0\n", ".vcd");
+
+	VcdImporter importer;
+	BOOST_CHECK(!importer.open(path));
+	BOOST_CHECK(!importer.error().empty());
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(VcdMissingDefinitions)
+{
+	const string path = write_temp("$timescale 1ns $end\n#0\n", ".vcd");
+
+	VcdImporter importer;
+	BOOST_CHECK(!importer.open(path));
+	BOOST_CHECK(!importer.error().empty());
+
+	boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
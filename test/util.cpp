@@ -238,4 +238,40 @@ BOOST_AUTO_TEST_CASE(format_time_minutes_test)
 	BOOST_CHECK_EQUAL(format_time_minutes(ts(-100), 0, false), "-1:40");
 }
 
+BOOST_AUTO_TEST_CASE(fixed_timestamp_test)
+{
+	using fts = pv::util::FixedTimestamp;
+
+	// Conversions
+	BOOST_CHECK_EQUAL(fts(ts("0.5")).to_double(), 0.5);
+	BOOST_CHECK_EQUAL(fts(ts("-0.25")).to_double(), -0.25);
+	BOOST_CHECK_EQUAL(fts(ts(3600)).to_double(), 3600.0);
+	BOOST_CHECK(abs(fts(ts("1234.567890123456789")).to_timestamp() -
+		ts("1234.567890123456789")) < ts("1e-18"));
+	BOOST_CHECK(abs(fts(ts("-1234.567890123456789")).to_timestamp() -
+		ts("-1234.567890123456789")) < ts("1e-18"));
+
+	// Differences of large values keep their precision
+	const fts a(ts("100000.000000000001"));
+	const fts b(ts("100000"));
+	BOOST_CHECK_CLOSE((a - b).to_double(), 1e-12, 1e-3);
+	BOOST_CHECK_CLOSE((b - a).to_double(), -1e-12, 1e-3);
+
+	// Carries between the fraction and the seconds
+	BOOST_CHECK_EQUAL((fts(ts("0.75")) + fts(ts("0.75"))).to_double(), 1.5);
+	BOOST_CHECK_EQUAL((fts(ts("0.25")) - fts(ts("0.75"))).to_double(), -0.5);
+	BOOST_CHECK_EQUAL((-fts(ts("1.25"))).to_double(), -1.25);
+	BOOST_CHECK_EQUAL((-fts()).to_double(), 0.0);
+
+	// Comparisons
+	BOOST_CHECK(fts(ts("-0.5")) < fts(ts("-0.25")));
+	BOOST_CHECK(fts(ts("-0.5")) < fts(ts(0)));
+	BOOST_CHECK(fts(ts("0.25")) < fts(ts("0.5")));
+	BOOST_CHECK(fts(ts(1)) > fts(ts("0.999")));
+	BOOST_CHECK(fts(ts(2)) >= fts(ts(2)));
+	BOOST_CHECK(fts(ts(2)) <= fts(ts(2)));
+	BOOST_CHECK(fts(ts("1.5")) == fts(ts("0.75")) + fts(ts("0.75")));
+	BOOST_CHECK(fts(ts("1.5")) != fts(ts("0.75")));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
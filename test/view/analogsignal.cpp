@@ -0,0 +1,145 @@
+/*
+ * This file is part of the PulseView project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "pv/view/analogsignal.hpp"
+
+using pv::views::TraceView::AnalogSignal;
+using std::vector;
+
+namespace {
+
+/**
+ * Returns a wandering signal with repeated values, so that the extremes
+ * of a column often occur more than once.
+ */
+vector<float> make_samples(size_t count)
+{
+	vector<float> samples(count);
+	float value = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		value += (float)((int)((i * 2654435761u) >> 28) - 8) / 4;
+		samples[i] = value;
+	}
+
+	return samples;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(AnalogSignalTest)
+
+BOOST_AUTO_TEST_CASE(FindMinMaxMatchesScalar)
+{
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+
+	vector<float> samples = make_samples(100);
+	vector<float> with_nans = samples;
+	for (size_t i = 1; i < with_nans.size(); i += 5)
+		with_nans[i] = nan;
+	vector<float> leading_nan = samples;
+	leading_nan[0] = nan;
+
+	// Every length and misalignment around the vector size
+	for (const vector<float> *s : {&samples, &with_nans, &leading_nan})
+		for (size_t offset = 0; offset < 4; offset++)
+			for (size_t count = 1; count + offset <= 80; count++) {
+				int64_t min_index, max_index;
+				int64_t scalar_min_index, scalar_max_index;
+
+				AnalogSignal::find_min_max(s->data() + offset, count,
+					min_index, max_index);
+				AnalogSignal::find_min_max_scalar(s->data() + offset,
+					count, scalar_min_index, scalar_max_index);
+
+				BOOST_REQUIRE_EQUAL(min_index, scalar_min_index);
+				BOOST_REQUIRE_EQUAL(max_index, scalar_max_index);
+			}
+}
+
+BOOST_AUTO_TEST_CASE(ReducedTraceMatchesFull)
+{
+	const vector<float> samples = make_samples(4000);
+	const int64_t start = 3, end = samples.size() - 5;
+
+	for (const double samples_per_pixel : {4.0, 4.5, 7.3, 16.0, 63.9})
+		for (const double pixels_offset : {0.0, 0.25, 0.7, -3.4}) {
+			vector<int64_t> bounds;
+			AnalogSignal::split_columns(start, end, pixels_offset,
+				samples_per_pixel, bounds);
+
+			BOOST_REQUIRE(bounds.size() >= 2);
+			BOOST_CHECK_EQUAL(bounds.front(), start);
+			BOOST_CHECK_EQUAL(bounds.back(), end);
+
+			size_t points = 0;
+
+			for (size_t c = 0; c + 1 < bounds.size(); c++) {
+				const int64_t first = bounds[c];
+				const int64_t count = bounds[c + 1] - first;
+				BOOST_REQUIRE(count > 0);
+
+				// All samples of a column are painted in the same pixel
+				// column, and the next column starts a new one
+				const double column = floor(
+					first / samples_per_pixel - pixels_offset + 1e-9);
+				BOOST_CHECK_EQUAL(floor((first + count - 1) /
+					samples_per_pixel - pixels_offset + 1e-9), column);
+				if (c + 2 < bounds.size())
+					BOOST_CHECK_EQUAL(floor(bounds[c + 1] /
+						samples_per_pixel - pixels_offset + 1e-9),
+						column + 1);
+
+				int64_t indices[4];
+				const int n = AnalogSignal::reduce_column(
+					samples.data() + first, count, indices);
+				BOOST_REQUIRE(n >= 1 && n <= 4);
+				points += n;
+
+				// The reduced polyline starts and ends where the full
+				// one does and spans the same values
+				BOOST_CHECK_EQUAL(indices[0], 0);
+				BOOST_CHECK_EQUAL(indices[n - 1], count - 1);
+				for (int i = 1; i < n; i++)
+					BOOST_CHECK(indices[i - 1] < indices[i]);
+
+				const auto full = std::minmax_element(
+					samples.begin() + first,
+					samples.begin() + first + count);
+				float lo = samples[first + indices[0]], hi = lo;
+				for (int i = 1; i < n; i++) {
+					lo = std::min(lo, samples[first + indices[i]]);
+					hi = std::max(hi, samples[first + indices[i]]);
+				}
+
+				BOOST_CHECK_EQUAL(lo, *full.first);
+				BOOST_CHECK_EQUAL(hi, *full.second);
+			}
+
+			BOOST_CHECK(points <= 4 * (bounds.size() - 1));
+		}
+}
+
+BOOST_AUTO_TEST_SUITE_END()
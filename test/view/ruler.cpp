@@ -43,8 +43,11 @@ BOOST_AUTO_TEST_CASE(tick_position_test_0)
 	const double scale(0.001);
 	const int width(500);
 
-	const Ruler::TickPositions ts = Ruler::calculate_tick_positions(
-		major_period, offset, scale, width, format);
+	const Ruler::TickOrigin origin =
+		Ruler::calculate_tick_origin(major_period, offset);
+	const Ruler::TickLayout ts = Ruler::layout_ticks(
+		((origin.time - offset) / scale).convert_to<double>(),
+		Ruler::calculate_minor_tick_dx(major_period, scale), width);
 
 	BOOST_REQUIRE_EQUAL(ts.major.size(), 6);
 
@@ -55,12 +58,18 @@ BOOST_AUTO_TEST_CASE(tick_position_test_0)
 	BOOST_CHECK_CLOSE(ts.major[4].first, 400, e);
 	BOOST_CHECK_CLOSE(ts.major[5].first, 500, e);
 
-	BOOST_CHECK_EQUAL(ts.major[0].second,  "0.000000 s");
-	BOOST_CHECK_EQUAL(ts.major[1].second, "+0.100000 s");
-	BOOST_CHECK_EQUAL(ts.major[2].second, "+0.200000 s");
-	BOOST_CHECK_EQUAL(ts.major[3].second, "+0.300000 s");
-	BOOST_CHECK_EQUAL(ts.major[4].second, "+0.400000 s");
-	BOOST_CHECK_EQUAL(ts.major[5].second, "+0.500000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[0].second * major_period), "0.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[1].second * major_period), "+0.100000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[2].second * major_period), "+0.200000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[3].second * major_period), "+0.300000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[4].second * major_period), "+0.400000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[5].second * major_period), "+0.500000 s");
 
 	BOOST_REQUIRE_EQUAL(ts.minor.size(), 16);
 
@@ -89,8 +98,11 @@ BOOST_AUTO_TEST_CASE(tick_position_test_1)
 	const double scale(0.001);
 	const int width(500);
 
-	const Ruler::TickPositions ts = Ruler::calculate_tick_positions(
-		major_period, offset, scale, width, format);
+	const Ruler::TickOrigin origin =
+		Ruler::calculate_tick_origin(major_period, offset);
+	const Ruler::TickLayout ts = Ruler::layout_ticks(
+		((origin.time - offset) / scale).convert_to<double>(),
+		Ruler::calculate_minor_tick_dx(major_period, scale), width);
 
 	BOOST_REQUIRE_EQUAL(ts.major.size(), 5);
 
@@ -100,11 +112,16 @@ BOOST_AUTO_TEST_CASE(tick_position_test_1)
 	BOOST_CHECK_CLOSE(ts.major[3].first,  363, e);
 	BOOST_CHECK_CLOSE(ts.major[4].first,  463, e);
 
-	BOOST_CHECK_EQUAL(ts.major[0].second, "-0.400000 s");
-	BOOST_CHECK_EQUAL(ts.major[1].second, "-0.300000 s");
-	BOOST_CHECK_EQUAL(ts.major[2].second, "-0.200000 s");
-	BOOST_CHECK_EQUAL(ts.major[3].second, "-0.100000 s");
-	BOOST_CHECK_EQUAL(ts.major[4].second,  "0.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[0].second * major_period), "-0.400000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[1].second * major_period), "-0.300000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[2].second * major_period), "-0.200000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[3].second * major_period), "-0.100000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[4].second * major_period), "0.000000 s");
 
 	BOOST_REQUIRE_EQUAL(ts.minor.size(), 17);
 	BOOST_CHECK_CLOSE(ts.minor[ 0], -12, e);
@@ -133,8 +150,11 @@ BOOST_AUTO_TEST_CASE(tick_position_test_2)
 	const double scale(0.129746);
 	const int width(580);
 
-	const Ruler::TickPositions ts = Ruler::calculate_tick_positions(
-		major_period, offset, scale, width, format);
+	const Ruler::TickOrigin origin =
+		Ruler::calculate_tick_origin(major_period, offset);
+	const Ruler::TickLayout ts = Ruler::layout_ticks(
+		((origin.time - offset) / scale).convert_to<double>(),
+		Ruler::calculate_minor_tick_dx(major_period, scale), width);
 
 	const double mp = 5;
 	const int off = 8;
@@ -146,10 +166,14 @@ BOOST_AUTO_TEST_CASE(tick_position_test_2)
 	BOOST_CHECK_CLOSE(ts.major[2].first, (12 * mp - off) / scale, e);
 	BOOST_CHECK_CLOSE(ts.major[3].first, (16 * mp - off) / scale, e);
 
-	BOOST_CHECK_EQUAL(ts.major[0].second, "+20.000000 s");
-	BOOST_CHECK_EQUAL(ts.major[1].second, "+40.000000 s");
-	BOOST_CHECK_EQUAL(ts.major[2].second, "+60.000000 s");
-	BOOST_CHECK_EQUAL(ts.major[3].second, "+80.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[0].second * major_period), "+20.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[1].second * major_period), "+40.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[2].second * major_period), "+60.000000 s");
+	BOOST_CHECK_EQUAL(format(origin.time +
+		ts.major[3].second * major_period), "+80.000000 s");
 
 	BOOST_REQUIRE_EQUAL(ts.minor.size(), 13);
 